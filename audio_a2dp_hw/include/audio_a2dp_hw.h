@@ -86,6 +86,7 @@ typedef enum {
   A2DP_CTRL_SET_OUTPUT_AUDIO_CONFIG,
   A2DP_CTRL_CMD_OFFLOAD_START,
   A2DP_CTRL_GET_PRESENTATION_POSITION,
+  A2DP_CTRL_CMD_SETUP_RING,
 } tA2DP_CTRL_CMD;
 
 typedef enum {
@@ -151,6 +152,10 @@ size_t audio_a2dp_hw_stream_compute_buffer_size(
 // Returns whether the delay reporting property is set.
 bool delay_reporting_enabled();
 
+// Returns whether the audio may be written to the stack through a shared
+// memory ring instead of the data socket.
+bool a2dp_ring_enabled();
+
 // Returns a string representation of |event|.
 const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event);
 
@@ -49,6 +49,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_a2dp_hw.h"
+#include "uipc_ring.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -125,6 +126,7 @@ struct a2dp_stream_common {
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
+  tUIPC_RING ring;  // set when the stack reads the audio from shared memory
 };
 
 struct a2dp_stream_out {
@@ -332,6 +334,23 @@ static int skt_write(int fd, const void* p, size_t len) {
   return (int)count;
 }
 
+// Writes the audio to the shared memory ring of the stack, waiting as long as
+// skt_write() would for the stack to read it.
+// On success, returns the number of octets written, otherwise -1.
+static int ring_write(tUIPC_RING* ring, const void* p, size_t len) {
+  FNLOG();
+
+  ts_log("ring_write", len, NULL);
+
+  uint32_t written = uipc_ring_write(ring, static_cast<const uint8_t*>(p),
+                                     len, SOCK_SEND_TIMEOUT_MS);
+  if (written < len) {
+    WARN("write timeout exceeded or ring closed, sent %u bytes", written);
+    return -1;
+  }
+  return (int)written;
+}
+
 static int skt_disconnect(int fd) {
   INFO("fd %d", fd);
 
@@ -780,6 +799,32 @@ static int a2dp_get_presentation_position_cmd(struct a2dp_stream_common* common,
   return 0;
 }
 
+// Asks the stack for a shared memory ring to write the audio of stream
+// |common| to, instead of its data socket. The stack replies with no ring if
+// it cannot create one, and a stack that does not know the command fails it.
+// A ring received is acked back, so the stack reads the data socket unless
+// the ring could be mapped here. Returns 0 if the ring is used, otherwise -1.
+static int a2dp_setup_ring(struct a2dp_stream_common* common) {
+  uint32_t size = common->buffer_sz;
+
+  uipc_ring_close(&common->ring);
+  if (!a2dp_ring_enabled()) return -1;
+
+  if (a2dp_command(common, A2DP_CTRL_CMD_SETUP_RING) < 0) {
+    INFO("no ring support, writing to the data socket");
+    return -1;
+  }
+  if (a2dp_ctrl_send(common, &size, sizeof(size)) < 0) return -1;
+  /* acks the ring, whether it could be mapped or not */
+  if (!uipc_ring_receive(common->ctrl_fd, &common->ring)) {
+    INFO("no ring, writing to the data socket");
+    return -1;
+  }
+
+  INFO("writing to a ring of %u bytes", size);
+  return 0;
+}
+
 static void a2dp_open_ctrl_path(struct a2dp_stream_common* common) {
   int i;
 
@@ -821,11 +866,15 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   /* manages max capacity of socket pipe */
   common->buffer_sz = AUDIO_STREAM_OUTPUT_BUFFER_SZ;
+
+  uipc_ring_init(&common->ring);
 }
 
 static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
   FNLOG();
 
+  uipc_ring_close(&common->ring);
+
   delete common->mutex;
   common->mutex = NULL;
 }
@@ -886,6 +935,9 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   skt_disconnect(common->audio_fd);
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
 
+  /* wake up a write in progress; the ring is unmapped by the next start */
+  uipc_ring_shutdown(&common->ring);
+
   return 0;
 }
 
@@ -907,6 +959,9 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
 
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
 
+  /* wake up a write in progress; the ring is unmapped by the next start */
+  uipc_ring_shutdown(&common->ring);
+
   return 0;
 }
 
@@ -921,6 +976,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   struct a2dp_stream_out* out = (struct a2dp_stream_out*)stream;
   int sent = -1;
   size_t write_bytes = bytes;
+  bool use_ring;
 
   DEBUG("write %zu bytes (fd %d)", bytes, out->common.audio_fd);
 
@@ -937,6 +993,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
     if (start_audio_datapath(&out->common) < 0) {
       goto finish;
     }
+    a2dp_setup_ring(&out->common);
   } else if (out->common.state != AUDIO_A2DP_STATE_STARTED) {
     ERROR("stream not in stopped or standby");
     goto finish;
@@ -955,13 +1012,19 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
+  use_ring = uipc_ring_is_open(&out->common.ring);
   lock.unlock();
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (use_ring) {
+    sent = ring_write(&out->common.ring, buffer, write_bytes);
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   lock.lock();
 
   if (sent == -1) {
     skt_disconnect(out->common.audio_fd);
     out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    uipc_ring_close(&out->common.ring);
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
         (out->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       out->common.state = AUDIO_A2DP_STATE_STOPPED;
@@ -35,6 +35,7 @@ const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event) {
     CASE_RETURN_STR(A2DP_CTRL_SET_OUTPUT_AUDIO_CONFIG)
     CASE_RETURN_STR(A2DP_CTRL_CMD_OFFLOAD_START)
     CASE_RETURN_STR(A2DP_CTRL_GET_PRESENTATION_POSITION)
+    CASE_RETURN_STR(A2DP_CTRL_CMD_SETUP_RING)
   }
 
   return "UNKNOWN A2DP_CTRL_CMD";
@@ -43,3 +44,7 @@ const char* audio_a2dp_hw_dump_ctrl_event(tA2DP_CTRL_CMD event) {
 bool delay_reporting_enabled() {
   return !osi_property_get_bool("persist.bluetooth.disabledelayreports", false);
 }
+
+bool a2dp_ring_enabled() {
+  return !osi_property_get_bool("persist.bluetooth.disableuipcring", false);
+}
@@ -85,6 +85,7 @@ typedef enum {
   HEARING_AID_CTRL_GET_OUTPUT_AUDIO_CONFIG,
   HEARING_AID_CTRL_SET_OUTPUT_AUDIO_CONFIG,
   HEARING_AID_CTRL_CMD_OFFLOAD_START,
+  HEARING_AID_CTRL_CMD_SETUP_RING,
 } tHEARING_AID_CTRL_CMD;
 
 typedef enum {
@@ -147,4 +148,8 @@ extern size_t audio_ha_hw_stream_compute_buffer_size(
 // Returns a string representation of |event|.
 extern const char* audio_ha_hw_dump_ctrl_event(tHEARING_AID_CTRL_CMD event);
 
+// Returns whether the audio may be written to the stack through a shared
+// memory ring instead of the data socket.
+extern bool audio_ha_hw_ring_enabled();
+
 #endif /* AUDIO_HEARING_AID_HW_H */
@@ -43,6 +43,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_hearing_aid_hw.h"
+#include "uipc_ring.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -112,6 +113,7 @@ struct ha_stream_common {
   size_t buffer_sz;
   struct ha_config cfg;
   ha_state_t state;
+  tUIPC_RING ring;  // set when the stack reads the audio from shared memory
 };
 
 struct ha_stream_out {
@@ -316,6 +318,23 @@ static int skt_write(int fd, const void* p, size_t len) {
   return (int)count;
 }
 
+// Writes the audio to the shared memory ring of the stack, waiting as long as
+// skt_write() would for the stack to read it.
+// On success, returns the number of octets written, otherwise -1.
+static int ring_write(tUIPC_RING* ring, const void* p, size_t len) {
+  FNLOG();
+
+  ts_log("ring_write", len, NULL);
+
+  uint32_t written = uipc_ring_write(ring, static_cast<const uint8_t*>(p),
+                                     len, SOCK_SEND_TIMEOUT_MS);
+  if (written < len) {
+    WARN("write timeout exceeded or ring closed, sent %u bytes", written);
+    return -1;
+  }
+  return (int)written;
+}
+
 static int skt_disconnect(int fd) {
   INFO("fd %d", fd);
 
@@ -738,6 +757,32 @@ static int ha_write_output_audio_config(struct ha_stream_common* common) {
   return 0;
 }
 
+// Asks the stack for a shared memory ring to write the audio of stream
+// |common| to, instead of its data socket. The stack replies with no ring if
+// it cannot create one, and a stack that does not know the command fails it.
+// A ring received is acked back, so the stack reads the data socket unless
+// the ring could be mapped here. Returns 0 if the ring is used, otherwise -1.
+static int ha_setup_ring(struct ha_stream_common* common) {
+  uint32_t size = common->buffer_sz;
+
+  uipc_ring_close(&common->ring);
+  if (!audio_ha_hw_ring_enabled()) return -1;
+
+  if (ha_command(common, HEARING_AID_CTRL_CMD_SETUP_RING) < 0) {
+    INFO("no ring support, writing to the data socket");
+    return -1;
+  }
+  if (ha_ctrl_send(common, &size, sizeof(size)) < 0) return -1;
+  /* acks the ring, whether it could be mapped or not */
+  if (!uipc_ring_receive(common->ctrl_fd, &common->ring)) {
+    INFO("no ring, writing to the data socket");
+    return -1;
+  }
+
+  INFO("writing to a ring of %u bytes", size);
+  return 0;
+}
+
 static void ha_open_ctrl_path(struct ha_stream_common* common) {
   int i;
 
@@ -780,11 +825,15 @@ static void ha_stream_common_init(struct ha_stream_common* common) {
 
   /* manages max capacity of socket pipe */
   common->buffer_sz = AUDIO_STREAM_OUTPUT_BUFFER_SZ;
+
+  uipc_ring_init(&common->ring);
 }
 
 static void ha_stream_common_destroy(struct ha_stream_common* common) {
   FNLOG();
 
+  uipc_ring_close(&common->ring);
+
   delete common->mutex;
   common->mutex = NULL;
 }
@@ -841,6 +890,9 @@ static int stop_audio_datapath(struct ha_stream_common* common) {
   skt_disconnect(common->audio_fd);
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
 
+  /* wake up a write in progress; the ring is unmapped by the next start */
+  uipc_ring_shutdown(&common->ring);
+
   return 0;
 }
 
@@ -862,6 +914,9 @@ static int suspend_audio_datapath(struct ha_stream_common* common,
 
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
 
+  /* wake up a write in progress; the ring is unmapped by the next start */
+  uipc_ring_shutdown(&common->ring);
+
   return 0;
 }
 
@@ -876,6 +931,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
   struct ha_stream_out* out = (struct ha_stream_out*)stream;
   int sent = -1;
   size_t write_bytes = bytes;
+  bool use_ring;
 
   DEBUG("write %zu bytes (fd %d)", bytes, out->common.audio_fd);
 
@@ -892,6 +948,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
     if (start_audio_datapath(&out->common) < 0) {
       goto finish;
     }
+    ha_setup_ring(&out->common);
   } else if (out->common.state != AUDIO_HA_STATE_STARTED) {
     ERROR("stream not in stopped or standby");
     goto finish;
@@ -910,13 +967,19 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
+  use_ring = uipc_ring_is_open(&out->common.ring);
   lock.unlock();
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (use_ring) {
+    sent = ring_write(&out->common.ring, buffer, write_bytes);
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   lock.lock();
 
   if (sent == -1) {
     skt_disconnect(out->common.audio_fd);
     out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    uipc_ring_close(&out->common.ring);
     if ((out->common.state != AUDIO_HA_STATE_SUSPENDED) &&
         (out->common.state != AUDIO_HA_STATE_STOPPING)) {
       out->common.state = AUDIO_HA_STATE_STOPPED;
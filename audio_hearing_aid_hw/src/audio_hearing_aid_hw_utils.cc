@@ -17,6 +17,7 @@
  ******************************************************************************/
 
 #include "audio_hearing_aid_hw.h"
+#include "osi/include/properties.h"
 
 #define CASE_RETURN_STR(const) \
   case const:                  \
@@ -33,9 +34,14 @@ const char* audio_ha_hw_dump_ctrl_event(tHEARING_AID_CTRL_CMD event) {
     CASE_RETURN_STR(HEARING_AID_CTRL_GET_OUTPUT_AUDIO_CONFIG)
     CASE_RETURN_STR(HEARING_AID_CTRL_SET_OUTPUT_AUDIO_CONFIG)
     CASE_RETURN_STR(HEARING_AID_CTRL_CMD_OFFLOAD_START)
+    CASE_RETURN_STR(HEARING_AID_CTRL_CMD_SETUP_RING)
     default:
       break;
   }
 
   return "UNKNOWN HEARING_AID_CTRL_CMD";
 }
+
+bool audio_ha_hw_ring_enabled() {
+  return !osi_property_get_bool("persist.bluetooth.disableuipcring", false);
+}
@@ -530,6 +530,45 @@ void bta_av_sink_data_cback(uint8_t handle, BT_HDR* p_pkt, uint32_t time_stamp,
   osi_free(p_pkt);
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_av_flush_l2c
+ *
+ * Description      Drop the media packets queued in L2CAP. L2CAP reports them
+ *                  to bta_av_tx_complete_cback() as sent, so a source stream
+ *                  tells first that they are dropped.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_flush_l2c(tBTA_AV_SCB* p_scb) {
+  if (p_scb->seps[p_scb->sep_idx].tsep == AVDT_TSEP_SRC) {
+    bta_av_co_audio_flush(p_scb->hndl, p_scb->PeerAddress());
+  }
+  L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_ALL);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_tx_complete_cback
+ *
+ * Description      This is the AVDTP callback function for media packets
+ *                  sent to the controller by a source stream.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_tx_complete_cback(uint8_t handle, uint16_t num_sdu) {
+  for (int index = 0; index < BTA_AV_NUM_STRS; index++) {
+    tBTA_AV_SCB* p_scb = bta_av_cb.p_scb[index];
+    if ((p_scb != NULL) && (p_scb->avdt_handle == handle) &&
+        (p_scb->seps[p_scb->sep_idx].tsep == AVDT_TSEP_SRC)) {
+      bta_av_co_audio_tx_complete(p_scb->hndl, p_scb->PeerAddress(), num_sdu);
+      return;
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         bta_av_a2dp_sdp_cback
@@ -1380,7 +1419,7 @@ void bta_av_do_close(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
   p_scb->use_rtp_header_marker_bit = false;
 
   /* drop the buffers queued in L2CAP */
-  L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_ALL);
+  bta_av_flush_l2c(p_scb);
 
   AVDT_CloseReq(p_scb->avdt_handle);
   /* just in case that the link is congested, link is flow controled by peer or
@@ -1977,7 +2016,7 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 
     /* drop the audio buffers queued in L2CAP */
     if (p_data && p_data->api_stop.flush)
-      L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_ALL);
+      bta_av_flush_l2c(p_scb);
   }
 
   suspend_rsp.chnl = p_scb->chnl;
@@ -2103,7 +2142,7 @@ void bta_av_reconfig(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
       bta_av_str_stopped(p_scb, NULL);
     }
     // Drop the buffers queued in L2CAP
-    L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_ALL);
+    bta_av_flush_l2c(p_scb);
     AVDT_CloseReq(p_scb->avdt_handle);
   }
 }
@@ -2203,6 +2242,10 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
         // Reset the RTP Marker bit for all fragments except the last one
         m_pt &= ~AVDT_MARKER_SET;
       }
+      // Report the write first: L2CAP may send the packet right away
+      bta_av_co_audio_write(p_scb->hndl, p_scb->PeerAddress(),
+                            extra_fragments.size() + 1, p_scb->l2c_bufs,
+                            list_length(p_scb->a2dp_list));
       AVDT_WriteReqOpt(p_scb->avdt_handle, p_buf, timestamp, m_pt, opt);
       for (size_t i = 0; i < extra_fragments.size(); i++) {
         if (i + 1 == extra_fragments.size()) {
@@ -2800,7 +2843,7 @@ void bta_av_suspend_cont(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
         p_scb->suspend_sup = false;
       }
       /* drop the buffers queued in L2CAP */
-      L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_ALL);
+      bta_av_flush_l2c(p_scb);
 
       AVDT_CloseReq(p_scb->avdt_handle);
     }
@@ -2858,7 +2901,7 @@ void bta_av_rcfg_cfm(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
     }
     /* started flag is false when reconfigure command is sent */
     /* drop the buffers queued in L2CAP */
-    L2CA_FlushChannel(p_scb->l2c_cid, L2CAP_FLUSH_CHANS_ALL);
+    bta_av_flush_l2c(p_scb);
     AVDT_CloseReq(p_scb->avdt_handle);
   } else {
     /* update the codec info after rcfg cfm */
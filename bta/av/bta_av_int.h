@@ -664,6 +664,7 @@ extern const tBTA_AV_SACT bta_av_a2dp_action[];
 extern const tBTA_AV_CO_FUNCTS bta_av_a2dp_cos;
 extern void bta_av_sink_data_cback(uint8_t handle, BT_HDR* p_pkt,
                                    uint32_t time_stamp, uint8_t m_pt);
+extern void bta_av_tx_complete_cback(uint8_t handle, uint16_t num_sdu);
 
 /*****************************************************************************
  *  Function prototypes
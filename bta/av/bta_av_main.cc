@@ -662,6 +662,7 @@ static void bta_av_api_register(tBTA_AV_DATA* p_data) {
 
     if (profile_initialized == UUID_SERVCLASS_AUDIO_SOURCE) {
       avdtp_stream_config.tsep = AVDT_TSEP_SRC;
+      avdtp_stream_config.p_tx_complete_cback = bta_av_tx_complete_cback;
       codec_index_min = BTAV_A2DP_CODEC_INDEX_SOURCE_MIN;
       codec_index_max = BTAV_A2DP_CODEC_INDEX_SOURCE_MAX;
     } else if (profile_initialized == UUID_SERVCLASS_AUDIO_SINK) {
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "gatt/database.h"
+#include "gatt/database_builder.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+using gatt::Characteristic;
+using gatt::Database;
+using gatt::DatabaseBuilder;
+using gatt::Descriptor;
+using gatt::Service;
+using gatt::StoredAttribute;
+
+// Each service holds this many characteristics, each with a CCC descriptor,
+// so a peer with N services has N * (1 + 2 * 8) stored attributes.
+#define CHARACTERISTICS_PER_SERVICE 8
+#define CACHE_VERSION 5
+
+namespace {
+
+Database build_database(int num_services) {
+  DatabaseBuilder builder;
+  uint16_t handle = 0x0001;
+  for (int s = 0; s < num_services; s++) {
+    uint16_t service_handle = handle;
+    uint16_t end_handle = service_handle + 3 * CHARACTERISTICS_PER_SERVICE;
+    builder.AddService(service_handle, end_handle, Uuid::From16Bit(0x1800 + s),
+                       true);
+    for (int c = 0; c < CHARACTERISTICS_PER_SERVICE; c++) {
+      uint16_t declaration = service_handle + 1 + 3 * c;
+      builder.AddCharacteristic(declaration, declaration + 1,
+                                Uuid::From16Bit(0x2a00 + c), 0x1a);
+      builder.AddDescriptor(declaration + 2, Uuid::From16Bit(0x2902));
+    }
+    handle = end_handle + 1;
+  }
+  return builder.Build();
+}
+
+std::string write_cache_file(const Database& database) {
+  char path[] = "/tmp/gatt_cache_benchmark_XXXXXX";
+  int fd = mkstemp(path);
+  std::vector<StoredAttribute> attr = database.Serialize();
+  uint16_t header[2] = {CACHE_VERSION, static_cast<uint16_t>(attr.size())};
+  write(fd, header, sizeof(header));
+  write(fd, attr.data(), attr.size() * sizeof(StoredAttribute));
+  close(fd);
+  return path;
+}
+
+// The cache load as it used to be: read the file into a vector first.
+Database load_with_fread(const std::string& path) {
+  FILE* fd = fopen(path.c_str(), "rb");
+  uint16_t header[2];
+  fread(header, sizeof(header), 1, fd);
+  std::vector<StoredAttribute> attr(header[1]);
+  fread(attr.data(), sizeof(StoredAttribute), attr.size(), fd);
+  fclose(fd);
+  bool success;
+  return Database::Deserialize(attr, &success);
+}
+
+Database load_with_mmap(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  fstat(fd, &st);
+  void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  const uint8_t* data = static_cast<const uint8_t*>(map);
+  uint16_t num_attr;
+  memcpy(&num_attr, data + sizeof(uint16_t), sizeof(uint16_t));
+  bool success;
+  Database database = Database::Deserialize(
+      reinterpret_cast<const StoredAttribute*>(data + 2 * sizeof(uint16_t)),
+      num_attr, &success);
+  munmap(map, st.st_size);
+  return database;
+}
+
+// The characteristic and descriptor lookups as they were before the handle
+// index: find the service, then walk its attributes.
+const Characteristic* linear_find_characteristic(const Database& database,
+                                                 uint16_t handle) {
+  for (const Service& service : database.Services()) {
+    if (handle < service.handle || handle > service.end_handle) continue;
+    for (const Characteristic& charac : service.characteristics) {
+      if (handle == charac.value_handle) return &charac;
+    }
+    return nullptr;
+  }
+  return nullptr;
+}
+
+const Descriptor* linear_find_descriptor(const Database& database,
+                                         uint16_t handle) {
+  for (const Service& service : database.Services()) {
+    if (handle < service.handle || handle > service.end_handle) continue;
+    for (const Characteristic& charac : service.characteristics) {
+      for (const Descriptor& desc : charac.descriptors) {
+        if (handle == desc.handle) return &desc;
+      }
+    }
+    return nullptr;
+  }
+  return nullptr;
+}
+
+// Looks every characteristic value and descriptor up once, as a client
+// enabling notifications and reading values after reconnecting would.
+template <typename FindCharacteristic, typename FindDescriptor>
+void lookup_all(const Database& database, FindCharacteristic find_charac,
+                FindDescriptor find_desc) {
+  for (const Service& service : database.Services()) {
+    for (const Characteristic& charac : service.characteristics) {
+      benchmark::DoNotOptimize(find_charac(charac.value_handle));
+      for (const Descriptor& desc : charac.descriptors) {
+        benchmark::DoNotOptimize(find_desc(desc.handle));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// Reconnects to a peer with state.range(0) services: loads its cache file
+// and looks every attribute up once. state.range(1) selects the previous
+// fread and linear lookup path (0) or the mapped load and handle index (1).
+static void BM_GattCacheReconnect(State& state) {
+  Database original = build_database(state.range(0));
+  std::string path = write_cache_file(original);
+  bool indexed = state.range(1) != 0;
+
+  for (auto _ : state) {
+    if (indexed) {
+      Database database = load_with_mmap(path);
+      lookup_all(
+          database,
+          [&](uint16_t h) { return database.FindCharacteristic(h); },
+          [&](uint16_t h) { return database.FindDescriptor(h, nullptr); });
+    } else {
+      Database database = load_with_fread(path);
+      lookup_all(
+          database,
+          [&](uint16_t h) { return linear_find_characteristic(database, h); },
+          [&](uint16_t h) { return linear_find_descriptor(database, h); });
+    }
+  }
+
+  unlink(path.c_str());
+  state.counters["attributes"] = original.Serialize().size();
+}
+
+BENCHMARK(BM_GattCacheReconnect)
+    ->Args({20, 0})
+    ->Args({20, 1})
+    ->Args({40, 0})
+    ->Args({40, 1});
+
+// Per lookup cost on an already loaded cache of state.range(0) services.
+static void BM_GattHandleLookup(State& state) {
+  Database database = build_database(state.range(0));
+  bool indexed = state.range(1) != 0;
+
+  for (auto _ : state) {
+    if (indexed) {
+      lookup_all(
+          database,
+          [&](uint16_t h) { return database.FindCharacteristic(h); },
+          [&](uint16_t h) { return database.FindDescriptor(h, nullptr); });
+    } else {
+      lookup_all(
+          database,
+          [&](uint16_t h) { return linear_find_characteristic(database, h); },
+          [&](uint16_t h) { return linear_find_descriptor(database, h); });
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          CHARACTERISTICS_PER_SERVICE * 2);
+}
+
+BENCHMARK(BM_GattHandleLookup)
+    ->Args({20, 0})
+    ->Args({20, 1})
+    ->Args({40, 0})
+    ->Args({40, 1});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "hearing_aid/hearing_aid_encoder.h"
+
+using ::benchmark::State;
+using bluetooth::hearing_aid::DeinterleavePcm;
+using bluetooth::hearing_aid::HearingAidEncoder;
+
+// 16 kHz, 16-bit stereo, as delivered by the hearing aid audio source
+#define HEARING_AID_BENCHMARK_SAMPLE_RATE 16000
+// G.722 at 64 kbit/s: one byte per two samples
+#define HEARING_AID_BENCHMARK_BYTES_PER_MS 8
+
+namespace {
+
+// One tick of two tones with some noise
+std::vector<uint8_t> make_tick(int interval_ms) {
+  int num_samples = HEARING_AID_BENCHMARK_SAMPLE_RATE / 1000 * interval_ms;
+  std::vector<uint8_t> data(num_samples * 4);
+  uint32_t seed = 1;
+  for (int i = 0; i < num_samples; i++) {
+    double t = static_cast<double>(i) / HEARING_AID_BENCHMARK_SAMPLE_RATE;
+    seed = seed * 1103515245 + 12345;
+    int noise = static_cast<int16_t>(seed >> 16) >> 4;
+    int16_t left = 12000 * sin(2 * M_PI * 440 * t) + noise;
+    int16_t right = 12000 * sin(2 * M_PI * 1250 * t) - noise;
+    memcpy(&data[i * 4], &left, sizeof(left));
+    memcpy(&data[i * 4 + 2], &right, sizeof(right));
+  }
+  return data;
+}
+
+// Stands for the L2CAP SDU allocated for each packet in both paths
+uint8_t* send_packet(const uint8_t* encoded_data, uint16_t packet_size) {
+  uint8_t* packet = static_cast<uint8_t*>(malloc(packet_size + 1));
+  packet[0] = 0;
+  if (encoded_data != nullptr) memcpy(packet + 1, encoded_data, packet_size);
+  return packet;
+}
+
+}  // namespace
+
+// The binaural encode path as it was before HearingAidEncoder: PCM pushed into
+// fresh vectors, encoded into 4000 byte scratch buffers with heap allocated
+// G.722 states, then copied into the packets. state.range(0) is the audio
+// tick interval in milliseconds.
+static void BM_LegacyTick(State& state) {
+  int interval_ms = state.range(0);
+  std::vector<uint8_t> data = make_tick(interval_ms);
+  int num_samples = data.size() / 4;
+  uint16_t packet_size = HEARING_AID_BENCHMARK_BYTES_PER_MS * interval_ms;
+  g722_encode_state_t* encoder_state_left =
+      g722_encode_init(nullptr, 64000, G722_PACKED);
+  g722_encode_state_t* encoder_state_right =
+      g722_encode_init(nullptr, 64000, G722_PACKED);
+
+  for (auto _ : state) {
+    std::vector<uint16_t> chan_left;
+    std::vector<uint16_t> chan_right;
+    for (int i = 0; i < num_samples; i++) {
+      const uint8_t* sample = data.data() + i * 4;
+      uint16_t left = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
+      chan_left.push_back(left);
+      sample += 2;
+      uint16_t right = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
+      chan_right.push_back(right);
+    }
+
+    std::vector<uint8_t> encoded_data_left;
+    encoded_data_left.resize(4000);
+    int encoded_size =
+        g722_encode(encoder_state_left, encoded_data_left.data(),
+                    (const int16_t*)chan_left.data(), chan_left.size());
+    encoded_data_left.resize(encoded_size);
+
+    std::vector<uint8_t> encoded_data_right;
+    encoded_data_right.resize(4000);
+    encoded_size =
+        g722_encode(encoder_state_right, encoded_data_right.data(),
+                    (const int16_t*)chan_right.data(), chan_right.size());
+    encoded_data_right.resize(encoded_size);
+
+    for (size_t i = 0; i < encoded_data_left.size(); i += packet_size) {
+      uint8_t* left = send_packet(encoded_data_left.data() + i, packet_size);
+      uint8_t* right = send_packet(encoded_data_right.data() + i, packet_size);
+      benchmark::DoNotOptimize(left);
+      benchmark::DoNotOptimize(right);
+      free(left);
+      free(right);
+    }
+  }
+
+  g722_encode_release(encoder_state_left);
+  g722_encode_release(encoder_state_right);
+  state.SetItemsProcessed(state.iterations() * num_samples);
+}
+
+// The same tick through HearingAidEncoder, encoding straight into the packets
+static void BM_Tick(State& state) {
+  int interval_ms = state.range(0);
+  std::vector<uint8_t> data = make_tick(interval_ms);
+  int num_samples = data.size() / 4;
+  uint16_t packet_size = HEARING_AID_BENCHMARK_BYTES_PER_MS * interval_ms;
+  HearingAidEncoder encoder_left;
+  HearingAidEncoder encoder_right;
+
+  for (auto _ : state) {
+    int16_t* pcm_left = encoder_left.StartTick(num_samples);
+    int16_t* pcm_right = encoder_right.StartTick(num_samples);
+    DeinterleavePcm(data.data(), num_samples, pcm_left, pcm_right);
+
+    while (encoder_left.RemainingBytes() > 0) {
+      uint8_t* left = send_packet(nullptr, packet_size);
+      encoder_left.EncodeNext(left + 1, packet_size);
+      uint8_t* right = send_packet(nullptr, packet_size);
+      encoder_right.EncodeNext(right + 1, packet_size);
+      benchmark::DoNotOptimize(left);
+      benchmark::DoNotOptimize(right);
+      free(left);
+      free(right);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * num_samples);
+}
+
+BENCHMARK(BM_LegacyTick)->Arg(10)->Arg(20);
+BENCHMARK(BM_Tick)->Arg(10)->Arg(20);
+
+BENCHMARK_MAIN();
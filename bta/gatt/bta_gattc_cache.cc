@@ -28,8 +28,11 @@
 #include "bt_target.h"
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <sstream>
 
@@ -73,6 +76,12 @@ static void bta_gattc_explore_srvc_finished(uint16_t conn_id,
 #define GATT_CACHE_PREFIX "/data/misc/bluetooth/gatt_cache_"
 #define GATT_CACHE_VERSION 5
 
+// Cache files hold the version and attribute count as uint16_t, followed by
+// the StoredAttribute array, which stays suitably aligned for in place reads.
+#define GATT_CACHE_HEADER_SIZE (2 * sizeof(uint16_t))
+static_assert(GATT_CACHE_HEADER_SIZE % alignof(StoredAttribute) == 0,
+              "GATT cache attributes must be aligned in the cache file");
+
 static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
                                                const RawAddress& bda) {
   snprintf(buffer, buffer_len, "%s%02x%02x%02x%02x%02x%02x", GATT_CACHE_PREFIX,
@@ -119,16 +128,6 @@ void bta_gattc_init_cache(tBTA_GATTC_SERV* p_srvc_cb) {
   p_srvc_cb->pending_discovery.Clear();
 }
 
-const Service* bta_gattc_find_matching_service(
-    const std::list<Service>& services, uint16_t handle) {
-  for (const Service& service : services) {
-    if (handle >= service.handle && handle <= service.end_handle)
-      return &service;
-  }
-
-  return nullptr;
-}
-
 /** Start primary service discovery */
 tGATT_STATUS bta_gattc_discover_pri_service(uint16_t conn_id,
                                             tBTA_GATTC_SERV* p_server_cb,
@@ -437,31 +436,22 @@ const std::list<Service>* bta_gattc_get_services(uint16_t conn_id) {
 
 const Service* bta_gattc_get_service_for_handle_srcb(tBTA_GATTC_SERV* p_srcb,
                                                      uint16_t handle) {
-  const std::list<Service>* services = bta_gattc_get_services_srcb(p_srcb);
-  if (services == NULL) return NULL;
-  return bta_gattc_find_matching_service(*services, handle);
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.FindServiceForHandle(handle);
 }
 
 const Service* bta_gattc_get_service_for_handle(uint16_t conn_id,
                                                 uint16_t handle) {
-  const std::list<Service>* services = bta_gattc_get_services(conn_id);
-  if (services == NULL) return NULL;
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+  if (p_clcb == NULL) return NULL;
 
-  return bta_gattc_find_matching_service(*services, handle);
+  return bta_gattc_get_service_for_handle_srcb(p_clcb->p_srcb, handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic_srcb(tBTA_GATTC_SERV* p_srcb,
                                                         uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) return NULL;
-
-  for (const Characteristic& charac : service->characteristics) {
-    if (handle == charac.value_handle) return &charac;
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.FindCharacteristic(handle);
 }
 
 const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
@@ -476,20 +466,8 @@ const Characteristic* bta_gattc_get_characteristic(uint16_t conn_id,
 
 const Descriptor* bta_gattc_get_descriptor_srcb(tBTA_GATTC_SERV* p_srcb,
                                                 uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) {
-    return NULL;
-  }
-
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &desc;
-    }
-  }
-
-  return NULL;
+  if (!p_srcb) return NULL;
+  return p_srcb->gatt_database.FindDescriptor(handle, NULL);
 }
 
 const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
@@ -503,18 +481,11 @@ const Descriptor* bta_gattc_get_descriptor(uint16_t conn_id, uint16_t handle) {
 
 const Characteristic* bta_gattc_get_owning_characteristic_srcb(
     tBTA_GATTC_SERV* p_srcb, uint16_t handle) {
-  const Service* service =
-      bta_gattc_get_service_for_handle_srcb(p_srcb, handle);
-
-  if (!service) return NULL;
+  if (!p_srcb) return NULL;
 
-  for (const Characteristic& charac : service->characteristics) {
-    for (const Descriptor& desc : charac.descriptors) {
-      if (handle == desc.handle) return &charac;
-    }
-  }
-
-  return NULL;
+  const Characteristic* owner = NULL;
+  p_srcb->gatt_database.FindDescriptor(handle, &owner);
+  return owner;
 }
 
 const Characteristic* bta_gattc_get_owning_characteristic(uint16_t conn_id,
@@ -712,46 +683,51 @@ bool bta_gattc_cache_load(tBTA_GATTC_SERV* p_srcb) {
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), p_srcb->server_bda);
 
-  FILE* fd = fopen(fname, "rb");
-  if (!fd) {
+  int fd = open(fname, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
     LOG(ERROR) << __func__ << ": can't open GATT cache file " << fname
                << " for reading, error: " << strerror(errno);
     return false;
   }
 
-  uint16_t cache_ver = 0;
-  bool success = false;
-  uint16_t num_attr = 0;
-
-  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << fname;
-    goto done;
-  }
-
-  if (cache_ver != GATT_CACHE_VERSION) {
-    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
-    goto done;
+  struct stat st;
+  if (fstat(fd, &st) == -1 || st.st_size < (off_t)GATT_CACHE_HEADER_SIZE) {
+    LOG(ERROR) << __func__ << ": can't read GATT cache header from: " << fname;
+    close(fd);
+    return false;
   }
 
-  if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't read number of GATT attributes: " << fname;
-    goto done;
+  // The attributes are deserialized straight from the mapping, without
+  // copying the file into an intermediate buffer first.
+  size_t file_size = st.st_size;
+  void* map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    LOG(ERROR) << __func__ << ": can't map GATT cache file " << fname
+               << ", error: " << strerror(errno);
+    return false;
   }
 
-  {
-    std::vector<StoredAttribute> attr(num_attr);
-
-    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-      LOG(ERROR) << __func__ << "s: can't read GATT attributes: " << fname;
-      goto done;
-    }
+  const uint8_t* data = static_cast<const uint8_t*>(map);
+  uint16_t cache_ver;
+  uint16_t num_attr;
+  memcpy(&cache_ver, data, sizeof(uint16_t));
+  memcpy(&num_attr, data + sizeof(uint16_t), sizeof(uint16_t));
 
-    p_srcb->gatt_database = gatt::Database::Deserialize(attr, &success);
+  bool success = false;
+  if (cache_ver != GATT_CACHE_VERSION) {
+    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
+  } else if (file_size !=
+             GATT_CACHE_HEADER_SIZE + num_attr * sizeof(StoredAttribute)) {
+    LOG(ERROR) << __func__ << ": can't read GATT attributes: " << fname;
+  } else {
+    p_srcb->gatt_database = gatt::Database::Deserialize(
+        reinterpret_cast<const StoredAttribute*>(data +
+                                                 GATT_CACHE_HEADER_SIZE),
+        num_attr, &success);
   }
 
-done:
-  fclose(fd);
+  munmap(map, file_size);
   return success;
 }
 
@@ -21,6 +21,7 @@
 #include "stack/include/gattdefs.h"
 
 #include <base/logging.h>
+#include <algorithm>
 #include <list>
 #include <memory>
 #include <sstream>
@@ -49,6 +50,82 @@ Service* FindService(std::list<Service>& services, uint16_t handle) {
   return nullptr;
 }
 
+Database::Database(const Database& other) : services(other.services) {
+  BuildIndex();
+}
+
+Database& Database::operator=(const Database& other) {
+  if (this != &other) {
+    services = other.services;
+    BuildIndex();
+  }
+  return *this;
+}
+
+void Database::BuildIndex() {
+  service_index.clear();
+  handle_index.clear();
+  service_index.reserve(services.size());
+
+  for (const Service& service : services) {
+    service_index.push_back(&service);
+    for (const Characteristic& charac : service.characteristics) {
+      handle_index.push_back({charac.value_handle, &charac, nullptr});
+      for (const Descriptor& desc : charac.descriptors) {
+        handle_index.push_back({desc.handle, &charac, &desc});
+      }
+    }
+  }
+
+  // Services are kept in handle order and attributes are discovered in order,
+  // so sorting is only needed for unusual databases.
+  auto service_less = [](const Service* a, const Service* b) {
+    return a->handle < b->handle;
+  };
+  auto entry_less = [](const IndexEntry& a, const IndexEntry& b) {
+    return a.handle < b.handle;
+  };
+  if (!std::is_sorted(service_index.begin(), service_index.end(),
+                      service_less)) {
+    std::sort(service_index.begin(), service_index.end(), service_less);
+  }
+  if (!std::is_sorted(handle_index.begin(), handle_index.end(), entry_less)) {
+    std::sort(handle_index.begin(), handle_index.end(), entry_less);
+  }
+}
+
+const Service* Database::FindServiceForHandle(uint16_t handle) const {
+  // Last service starting at or before |handle|
+  auto it = std::upper_bound(
+      service_index.begin(), service_index.end(), handle,
+      [](uint16_t handle, const Service* s) { return handle < s->handle; });
+  if (it == service_index.begin()) return nullptr;
+  --it;
+  return HandleInRange(**it, handle) ? *it : nullptr;
+}
+
+const Database::IndexEntry* Database::FindIndexEntry(uint16_t handle) const {
+  auto it = std::lower_bound(
+      handle_index.begin(), handle_index.end(), handle,
+      [](const IndexEntry& e, uint16_t handle) { return e.handle < handle; });
+  if (it == handle_index.end() || it->handle != handle) return nullptr;
+  return &*it;
+}
+
+const Characteristic* Database::FindCharacteristic(uint16_t handle) const {
+  const IndexEntry* entry = FindIndexEntry(handle);
+  if (!entry || entry->descriptor) return nullptr;
+  return entry->characteristic;
+}
+
+const Descriptor* Database::FindDescriptor(
+    uint16_t handle, const Characteristic** owner) const {
+  const IndexEntry* entry = FindIndexEntry(handle);
+  if (!entry || !entry->descriptor) return nullptr;
+  if (owner) *owner = entry->characteristic;
+  return entry->descriptor;
+}
+
 std::string Database::ToString() const {
   std::stringstream tmp;
 
@@ -120,11 +197,17 @@ std::vector<StoredAttribute> Database::Serialize() const {
 
 Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
                                bool* success) {
+  return Deserialize(nv_attr.data(), nv_attr.size(), success);
+}
+
+Database Database::Deserialize(const StoredAttribute* nv_attr, size_t count,
+                               bool* success) {
   // clear reallocating
   Database result;
-  auto it = nv_attr.cbegin();
+  const StoredAttribute* it = nv_attr;
+  const StoredAttribute* end = nv_attr + count;
 
-  for (; it != nv_attr.cend(); ++it) {
+  for (; it != end; ++it) {
     const auto& attr = *it;
     if (attr.type != PRIMARY_SERVICE && attr.type != SECONDARY_SERVICE) break;
     result.services.emplace_back(Service{
@@ -136,7 +219,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
   }
 
   auto current_service_it = result.services.begin();
-  for (; it != nv_attr.cend(); it++) {
+  for (; it != end; it++) {
     const auto& attr = *it;
 
     // go to the service this attribute belongs to; attributes are stored in
@@ -181,6 +264,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
           Descriptor{.handle = attr.handle, .uuid = attr.type});
     }
   }
+  result.BuildIndex();
   *success = true;
   return result;
 }
@@ -97,16 +97,37 @@ class DatabaseBuilder;
 
 class Database {
  public:
+  Database() = default;
+  Database(const Database& other);
+  Database& operator=(const Database& other);
+  Database(Database&& other) = default;
+  Database& operator=(Database&& other) = default;
+
   /* Return true if there are no services in this database. */
   bool IsEmpty() const { return services.empty(); }
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::list<Service>().swap(services); }
+  void Clear() {
+    std::list<Service>().swap(services);
+    std::vector<const Service*>().swap(service_index);
+    std::vector<IndexEntry>().swap(handle_index);
+  }
 
   /* Return list of services available in this database */
   const std::list<Service>& Services() const { return services; }
 
+  /* Return the service whose handle range contains |handle|, or nullptr */
+  const Service* FindServiceForHandle(uint16_t handle) const;
+
+  /* Return the characteristic with value handle |handle|, or nullptr */
+  const Characteristic* FindCharacteristic(uint16_t handle) const;
+
+  /* Return the descriptor with |handle|, or nullptr. If |owner| is set, it
+   * receives the characteristic the descriptor belongs to. */
+  const Descriptor* FindDescriptor(uint16_t handle,
+                                   const Characteristic** owner) const;
+
   std::string ToString() const;
 
   std::vector<gatt::StoredAttribute> Serialize() const;
@@ -114,10 +135,35 @@ class Database {
   static Database Deserialize(const std::vector<gatt::StoredAttribute>& nv_attr,
                               bool* success);
 
+  /* Deserialize |count| attributes read in place, i.e. from a memory mapped
+   * cache file. */
+  static Database Deserialize(const gatt::StoredAttribute* nv_attr,
+                              size_t count, bool* success);
+
   friend class DatabaseBuilder;
 
  private:
+  /* Characteristic value or descriptor handle. |descriptor| is nullptr for
+   * characteristic values. */
+  struct IndexEntry {
+    uint16_t handle;
+    const Characteristic* characteristic;
+    const Descriptor* descriptor;
+  };
+
+  /* Rebuild the handle indexes below. Must be called whenever |services|
+   * changes, as they point into it. */
+  void BuildIndex();
+
+  const IndexEntry* FindIndexEntry(uint16_t handle) const;
+
   std::list<Service> services;
+
+  /* Services and attribute handles sorted by handle, so that lookups done on
+   * every GATT operation are a binary search instead of a walk over all
+   * services and characteristics. */
+  std::vector<const Service*> service_index;
+  std::vector<IndexEntry> handle_index;
 };
 
 /* Find a service that should contain handle. Helper method for internal use
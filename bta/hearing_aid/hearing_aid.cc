@@ -22,9 +22,9 @@
 #include "bta_gatt_queue.h"
 #include "btm_int.h"
 #include "device/include/controller.h"
-#include "embdrv/g722/g722_enc_dec.h"
 #include "gap_api.h"
 #include "gatt_api.h"
+#include "hearing_aid_encoder.h"
 #include "osi/include/properties.h"
 
 #include <base/bind.h>
@@ -36,6 +36,9 @@
 using base::Closure;
 using bluetooth::Uuid;
 using bluetooth::hearing_aid::ConnectionState;
+using bluetooth::hearing_aid::DeinterleavePcm;
+using bluetooth::hearing_aid::DownmixPcm;
+using bluetooth::hearing_aid::HearingAidEncoder;
 
 // The MIN_CE_LEN parameter for Connection Parameters based on the current
 // Connection Interval
@@ -203,24 +206,24 @@ static void write_rpt_ctl_cfg_cb(uint16_t conn_id, tGATT_STATUS status,
   }
 }
 
-g722_encode_state_t* encoder_state_left = nullptr;
-g722_encode_state_t* encoder_state_right = nullptr;
+HearingAidEncoder* encoder_left = nullptr;
+HearingAidEncoder* encoder_right = nullptr;
 
 inline void encoder_state_init() {
-  if (encoder_state_left != nullptr) {
+  if (encoder_left != nullptr) {
     LOG(WARNING) << __func__ << ": encoder already initialized";
     return;
   }
-  encoder_state_left = g722_encode_init(nullptr, 64000, G722_PACKED);
-  encoder_state_right = g722_encode_init(nullptr, 64000, G722_PACKED);
+  encoder_left = new HearingAidEncoder();
+  encoder_right = new HearingAidEncoder();
 }
 
 inline void encoder_state_release() {
-  if (encoder_state_left != nullptr) {
-    g722_encode_release(encoder_state_left);
-    encoder_state_left = nullptr;
-    g722_encode_release(encoder_state_right);
-    encoder_state_right = nullptr;
+  if (encoder_left != nullptr) {
+    delete encoder_left;
+    encoder_left = nullptr;
+    delete encoder_right;
+    encoder_right = nullptr;
   }
 }
 
@@ -975,7 +978,7 @@ class HearingAidImpl : public HearingAid {
   void StartSendingAudio(const HearingDevice& hearingDevice) {
     VLOG(0) << __func__ << ": device=" << hearingDevice.address;
 
-    if (encoder_state_left == nullptr) {
+    if (encoder_left == nullptr) {
       encoder_state_init();
       seq_counter = 0;
 
@@ -1163,51 +1166,20 @@ class HearingAidImpl : public HearingAid {
       return;
     }
 
-    std::vector<uint16_t> chan_left;
-    std::vector<uint16_t> chan_right;
+    // The samples of each side go to the buffers of their encoder, which are
+    // reused from tick to tick.
+    int16_t* pcm_left = left ? encoder_left->StartTick(num_samples) : nullptr;
+    int16_t* pcm_right =
+        right ? encoder_right->StartTick(num_samples) : nullptr;
     if (left == nullptr || right == nullptr) {
-      for (int i = 0; i < num_samples; i++) {
-        const uint8_t* sample = data.data() + i * 4;
-
-        int16_t left = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-
-        sample += 2;
-        int16_t right = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-
-        uint16_t mono_data = (int16_t)(((uint32_t)left + (uint32_t)right) >> 1);
-        chan_left.push_back(mono_data);
-        chan_right.push_back(mono_data);
-      }
+      DownmixPcm(data.data(), num_samples, left ? pcm_left : pcm_right);
     } else {
-      for (int i = 0; i < num_samples; i++) {
-        const uint8_t* sample = data.data() + i * 4;
-
-        uint16_t left = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-        chan_left.push_back(left);
-
-        sample += 2;
-        uint16_t right = (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
-        chan_right.push_back(right);
-      }
+      DeinterleavePcm(data.data(), num_samples, pcm_left, pcm_right);
     }
 
     // TODO: monural, binarual check
 
-    // divide encoded data into packets, add header, send.
-
-    // TODO: make those buffers static and global to prevent constant
-    // reallocations
-    // TODO: this should basically fit the encoded data, tune the size later
-    std::vector<uint8_t> encoded_data_left;
     if (left) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_left.resize(4000);
-      int encoded_size =
-          g722_encode(encoder_state_left, encoded_data_left.data(),
-                      (const int16_t*)chan_left.data(), chan_left.size());
-      encoded_data_left.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1222,16 +1194,7 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(left);
     }
 
-    std::vector<uint8_t> encoded_data_right;
     if (right) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_right.resize(4000);
-      int encoded_size =
-          g722_encode(encoder_state_right, encoded_data_right.data(),
-                      (const int16_t*)chan_right.data(), chan_right.size());
-      encoded_data_right.resize(encoded_size);
-
       uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
       uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
       if (packets_to_flush) {
@@ -1246,20 +1209,19 @@ class HearingAidImpl : public HearingAid {
       check_and_do_rssi_read(right);
     }
 
-    size_t encoded_data_size =
-        std::max(encoded_data_left.size(), encoded_data_right.size());
-
+    // divide encoded data into packets, add header, send.
+    HearingAidEncoder* encoder = left ? encoder_left : encoder_right;
     uint16_t packet_size =
         CalcCompressedAudioPacketSize(codec_in_use, default_data_interval_ms);
 
-    for (size_t i = 0; i < encoded_data_size; i += packet_size) {
+    while (encoder->RemainingBytes() > 0) {
       if (left) {
         left->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_left.data() + i, packet_size, left);
+        SendAudio(encoder_left, packet_size, left);
       }
       if (right) {
         right->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_right.data() + i, packet_size, right);
+        SendAudio(encoder_right, packet_size, right);
       }
       seq_counter++;
     }
@@ -1267,13 +1229,15 @@ class HearingAidImpl : public HearingAid {
     if (right) right->audio_stats.frame_send_count++;
   }
 
-  void SendAudio(uint8_t* encoded_data, uint16_t packet_size,
+  // Encodes the next packet of |encoder| directly into the L2CAP SDU
+  void SendAudio(HearingAidEncoder* encoder, uint16_t packet_size,
                  HearingDevice* hearingAid) {
     if (!hearingAid->playback_started || !hearingAid->command_acked) {
       VLOG(2) << __func__
               << ": Playback stalled, device=" << hearingAid->address
               << ", cmd send=" << hearingAid->playback_started
               << ", cmd acked=" << hearingAid->command_acked;
+      encoder->SkipNext(packet_size);
       return;
     }
 
@@ -1281,7 +1245,7 @@ class HearingAidImpl : public HearingAid {
     uint8_t* p = get_l2cap_sdu_start_ptr(audio_packet);
     *p = seq_counter;
     p++;
-    memcpy(p, encoded_data, packet_size);
+    encoder->EncodeNext(p, packet_size);
 
     DVLOG(2) << hearingAid->address << " : " << base::HexEncode(p, packet_size);
 
@@ -1359,9 +1323,7 @@ class HearingAidImpl : public HearingAid {
         // TODO: make it into function
         HearingAidAudioSource::Stop();
         // TODO: kill the encoder only if all hearing aids are down.
-        // g722_encode_release(encoder_state);
-        // encoder_state_left = nulllptr;
-        // encoder_state_right = nulllptr;
+        // encoder_state_release();
         break;
       case GAP_EVT_CONN_UNCONGESTED:
         DVLOG(2) << "GAP_EVT_CONN_UNCONGESTED";
@@ -278,6 +278,23 @@ void hearing_aid_recv_ctrl_data() {
       break;
     }
 
+    case HEARING_AID_CTRL_CMD_SETUP_RING: {
+      uint32_t ring_size;
+
+      hearing_aid_send_ack(HEARING_AID_CTRL_ACK_SUCCESS);
+      if (UIPC_Read(*uipc_hearing_aid, UIPC_CH_ID_AV_CTRL, 0,
+                    reinterpret_cast<uint8_t*>(&ring_size),
+                    sizeof(ring_size)) != sizeof(ring_size)) {
+        LOG(ERROR) << __func__ << "Error reading ring size from audio HAL";
+        break;
+      }
+      // Replies with the ring, or with no ring if the audio HAL has to keep
+      // writing to the data socket
+      UIPC_OpenRing(*uipc_hearing_aid, UIPC_CH_ID_AV_AUDIO, ring_size,
+                    UIPC_CH_ID_AV_CTRL);
+      break;
+    }
+
     default:
       LOG(ERROR) << __func__ << "UNSUPPORTED CMD: " << cmd;
       hearing_aid_send_ack(HEARING_AID_CTRL_ACK_FAILURE);
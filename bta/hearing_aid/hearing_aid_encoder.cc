@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "hearing_aid_encoder.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace bluetooth {
+namespace hearing_aid {
+
+namespace {
+
+/* The hearing aids take 15-bit samples */
+inline int16_t read_sample(const uint8_t* sample) {
+  return (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
+}
+
+#if defined(__SSE2__)
+/* Splits 8 stereo frames into the 8 halved samples of each channel */
+inline void deinterleave8(const uint8_t* pcm, __m128i* left, __m128i* right) {
+  __m128i a = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)pcm), 1);
+  __m128i b = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)(pcm + 16)), 1);
+  *left = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a, 16), 16),
+                          _mm_srai_epi32(_mm_slli_epi32(b, 16), 16));
+  *right = _mm_packs_epi32(_mm_srai_epi32(a, 16), _mm_srai_epi32(b, 16));
+}
+#endif
+
+}  // namespace
+
+void DeinterleavePcm(const uint8_t* pcm, size_t num_samples, int16_t* left,
+                     int16_t* right) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 8 <= num_samples; i += 8) {
+    __m128i l, r;
+    deinterleave8(pcm + i * 4, &l, &r);
+    _mm_storeu_si128((__m128i*)(left + i), l);
+    _mm_storeu_si128((__m128i*)(right + i), r);
+  }
+#elif defined(__aarch64__)
+  for (; i + 8 <= num_samples; i += 8) {
+    int16x8x2_t frames = vld2q_s16((const int16_t*)(pcm + i * 4));
+    vst1q_s16(left + i, vshrq_n_s16(frames.val[0], 1));
+    vst1q_s16(right + i, vshrq_n_s16(frames.val[1], 1));
+  }
+#endif
+  for (; i < num_samples; i++) {
+    left[i] = read_sample(pcm + i * 4);
+    right[i] = read_sample(pcm + i * 4 + 2);
+  }
+}
+
+void DownmixPcm(const uint8_t* pcm, size_t num_samples, int16_t* mono) {
+  size_t i = 0;
+  /* The halved samples cannot overflow 16 bits when added */
+#if defined(__SSE2__)
+  for (; i + 8 <= num_samples; i += 8) {
+    __m128i l, r;
+    deinterleave8(pcm + i * 4, &l, &r);
+    _mm_storeu_si128((__m128i*)(mono + i),
+                     _mm_srai_epi16(_mm_add_epi16(l, r), 1));
+  }
+#elif defined(__aarch64__)
+  for (; i + 8 <= num_samples; i += 8) {
+    int16x8x2_t frames = vld2q_s16((const int16_t*)(pcm + i * 4));
+    int16x8_t sum = vaddq_s16(vshrq_n_s16(frames.val[0], 1),
+                              vshrq_n_s16(frames.val[1], 1));
+    vst1q_s16(mono + i, vshrq_n_s16(sum, 1));
+  }
+#endif
+  for (; i < num_samples; i++) {
+    int16_t left = read_sample(pcm + i * 4);
+    int16_t right = read_sample(pcm + i * 4 + 2);
+    mono[i] = (int16_t)(((uint32_t)left + (uint32_t)right) >> 1);
+  }
+}
+
+HearingAidEncoder::HearingAidEncoder() { Reset(); }
+
+void HearingAidEncoder::Reset() {
+  g722_encode_init(&state_, 64000, G722_PACKED);
+  num_samples_ = 0;
+  next_sample_ = 0;
+}
+
+int16_t* HearingAidEncoder::StartTick(size_t num_samples) {
+  // Only grows, so that every tick after the first one reuses the buffer
+  if (pcm_.size() < num_samples) pcm_.resize(num_samples);
+  num_samples_ = num_samples;
+  next_sample_ = 0;
+  return pcm_.data();
+}
+
+void HearingAidEncoder::EncodeNext(uint8_t* out, size_t size) {
+  // G.722 encodes two samples into each byte
+  size_t num_samples = std::min(size * 2, num_samples_ - next_sample_);
+  size_t encoded = g722_encode(&state_, out, pcm_.data() + next_sample_,
+                               num_samples);
+  next_sample_ += num_samples;
+  memset(out + encoded, 0, size - encoded);
+}
+
+void HearingAidEncoder::SkipNext(size_t size) {
+  if (skipped_.size() < size) skipped_.resize(size);
+  EncodeNext(skipped_.data(), size);
+}
+
+}  // namespace hearing_aid
+}  // namespace bluetooth
@@ -0,0 +1,76 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "embdrv/g722/g722_enc_dec.h"
+
+namespace bluetooth {
+namespace hearing_aid {
+
+/* Splits |num_samples| frames of 16-bit little endian stereo PCM into the
+ * 15-bit samples of the left and right hearing aids. */
+void DeinterleavePcm(const uint8_t* pcm, size_t num_samples, int16_t* left,
+                     int16_t* right);
+
+/* Mixes |num_samples| frames of 16-bit little endian stereo PCM down to the
+ * 15-bit samples of a single hearing aid. */
+void DownmixPcm(const uint8_t* pcm, size_t num_samples, int16_t* mono);
+
+/* The G.722 encode path of one side of the stream. The PCM of each audio tick
+ * goes to a buffer allocated once for the whole stream, and is encoded one
+ * packet at a time, straight into the L2CAP SDUs. */
+class HearingAidEncoder {
+ public:
+  HearingAidEncoder();
+  HearingAidEncoder(const HearingAidEncoder&) = delete;
+  HearingAidEncoder& operator=(const HearingAidEncoder&) = delete;
+
+  /* Starts the stream over, from a fresh G.722 state */
+  void Reset();
+
+  /* Returns the buffer of the |num_samples| samples of a new tick, to be
+   * filled by DeinterleavePcm() or DownmixPcm(). */
+  int16_t* StartTick(size_t num_samples);
+
+  /* Number of G.722 bytes of the tick not encoded yet */
+  size_t RemainingBytes() const { return (num_samples_ - next_sample_) / 2; }
+
+  /* Encodes the next |size| bytes of the tick into |out|, padded with zeros
+   * past the end of the tick. */
+  void EncodeNext(uint8_t* out, size_t size);
+
+  /* Encodes the next |size| bytes of the tick and drops them, to keep the
+   * encoder in step with the audio while the device is not playing. */
+  void SkipNext(size_t size);
+
+ private:
+  g722_encode_state_t state_;
+  std::vector<int16_t> pcm_;
+  std::vector<uint8_t> skipped_;
+  size_t num_samples_;
+  size_t next_sample_;
+};
+
+}  // namespace hearing_aid
+}  // namespace bluetooth
@@ -193,6 +193,52 @@ BT_HDR* bta_av_co_audio_source_data_path(const uint8_t* p_codec_info,
 void bta_av_co_audio_drop(tBTA_AV_HNDL bta_av_handle,
                           const RawAddress& peer_address);
 
+/*******************************************************************************
+ *
+ * Function         bta_av_co_audio_write
+ *
+ * Description      An Audio packet is passed to L2CAP as |num_sdu| media
+ *                  packets. |l2c_queued| media packets are still queued in
+ *                  L2CAP for the connected headset with this handle, and
+ *                  |av_queued| audio packets wait in AV behind this one.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_co_audio_write(tBTA_AV_HNDL bta_av_handle,
+                           const RawAddress& peer_address, uint16_t num_sdu,
+                           uint16_t l2c_queued, uint16_t av_queued);
+
+/*******************************************************************************
+ *
+ * Function         bta_av_co_audio_tx_complete
+ *
+ * Description      L2CAP has sent |num_sdu| media packets to the controller.
+ *                  The controller takes them when it has room for them, so
+ *                  this tells how fast the link to the connected headset with
+ *                  this handle moves the audio.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_co_audio_tx_complete(tBTA_AV_HNDL bta_av_handle,
+                                 const RawAddress& peer_address,
+                                 uint16_t num_sdu);
+
+/*******************************************************************************
+ *
+ * Function         bta_av_co_audio_flush
+ *
+ * Description      L2CAP is about to drop the media packets it holds for the
+ *                  connected headset with this handle. It reports them to
+ *                  bta_av_co_audio_tx_complete() as sent when it drops them.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_co_audio_flush(tBTA_AV_HNDL bta_av_handle,
+                           const RawAddress& peer_address);
+
 /*******************************************************************************
  *
  * Function         bta_av_co_audio_delay
@@ -204,4 +204,43 @@ TEST(GattCacheTest, stored_attribute_to_binary_descriptor_test) {
   // LOG(ERROR) << " " << base::HexEncode(&attr, len);
   EXPECT_EQ(memcmp(binary_form, &attr, len), 0);
 }
-}  // namespace gatt
\ No newline at end of file
+
+/* This test makes sure handle lookups find every attribute and survive
+ * copying and deserializing the database */
+TEST(GattDatabaseTest, handle_lookup_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0020, 0x002f, SERVICE_2_UUID, true);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddCharacteristic(0x0022, 0x0023, SERVICE_1_CHAR_1_UUID, 0x10);
+  builder.AddDescriptor(0x0024, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  Database built = builder.Build();
+  bool success = false;
+  Database deserialized = Database::Deserialize(built.Serialize(), &success);
+  ASSERT_TRUE(success);
+  Database copied;
+  copied = deserialized;
+
+  for (const Database* db : {&built, &deserialized, &copied}) {
+    EXPECT_EQ(db->FindServiceForHandle(0x0005)->handle, 0x0001);
+    EXPECT_EQ(db->FindServiceForHandle(0x002f)->handle, 0x0020);
+    EXPECT_EQ(db->FindServiceForHandle(0x0010), nullptr);
+    EXPECT_EQ(db->FindServiceForHandle(0x0030), nullptr);
+
+    const Characteristic* charac = db->FindCharacteristic(0x0023);
+    ASSERT_NE(charac, nullptr);
+    EXPECT_EQ(charac->declaration_handle, 0x0022);
+    EXPECT_EQ(db->FindCharacteristic(0x0022), nullptr);
+    EXPECT_EQ(db->FindCharacteristic(0x0024), nullptr);
+
+    const Characteristic* owner = nullptr;
+    const Descriptor* desc = db->FindDescriptor(0x0005, &owner);
+    ASSERT_NE(desc, nullptr);
+    EXPECT_EQ(desc->uuid, SERVICE_1_CHAR_1_DESC_1_UUID);
+    EXPECT_EQ(owner, &db->Services().front().characteristics.front());
+    EXPECT_EQ(db->FindDescriptor(0x0004, &owner), nullptr);
+  }
+}
+}  // namespace gatt
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <vector>
+
+#include "hearing_aid/hearing_aid_encoder.h"
+
+using bluetooth::hearing_aid::DeinterleavePcm;
+using bluetooth::hearing_aid::DownmixPcm;
+using bluetooth::hearing_aid::HearingAidEncoder;
+
+namespace {
+
+// Frame counts around the 8 frames the SSE2 and NEON loops take at a time,
+// and the 10 and 20 ms ticks at 16 kHz
+const size_t kNumSamples[] = {0, 1, 7, 8, 9, 15, 16, 17, 31, 33, 160, 320};
+
+// Random frames, then frames at both ends of the 16-bit range
+std::vector<uint8_t> make_pcm(size_t num_samples) {
+  std::vector<uint8_t> pcm(num_samples * 4);
+  uint32_t seed = num_samples;
+  for (size_t i = 0; i < num_samples * 2; i++) {
+    seed = seed * 1103515245 + 12345;
+    int16_t sample = static_cast<int16_t>(seed >> 16);
+    if (i >= num_samples) sample = (seed & 0x10000) ? 32767 : -32768;
+    memcpy(&pcm[i * 2], &sample, sizeof(sample));
+  }
+  return pcm;
+}
+
+// The per sample conversions of OnAudioDataReady before HearingAidEncoder
+int16_t reference_sample(const uint8_t* sample) {
+  return (int16_t)((*(sample + 1) << 8) + *sample) >> 1;
+}
+
+int16_t reference_mono(const uint8_t* frame) {
+  int16_t left = reference_sample(frame);
+  int16_t right = reference_sample(frame + 2);
+  return (int16_t)(((uint32_t)left + (uint32_t)right) >> 1);
+}
+
+}  // namespace
+
+TEST(HearingAidEncoderTest, deinterleave_matches_reference) {
+  for (size_t num_samples : kNumSamples) {
+    SCOPED_TRACE(testing::Message() << "num_samples " << num_samples);
+    std::vector<uint8_t> pcm = make_pcm(num_samples);
+    std::vector<int16_t> left(num_samples + 1, 0x5555);
+    std::vector<int16_t> right(num_samples + 1, 0x5555);
+    DeinterleavePcm(pcm.data(), num_samples, left.data(), right.data());
+    for (size_t i = 0; i < num_samples; i++) {
+      ASSERT_EQ(reference_sample(&pcm[i * 4]), left[i]) << i;
+      ASSERT_EQ(reference_sample(&pcm[i * 4 + 2]), right[i]) << i;
+    }
+    EXPECT_EQ(0x5555, left[num_samples]);
+    EXPECT_EQ(0x5555, right[num_samples]);
+  }
+}
+
+TEST(HearingAidEncoderTest, downmix_matches_reference) {
+  for (size_t num_samples : kNumSamples) {
+    SCOPED_TRACE(testing::Message() << "num_samples " << num_samples);
+    std::vector<uint8_t> pcm = make_pcm(num_samples);
+    std::vector<int16_t> mono(num_samples + 1, 0x5555);
+    DownmixPcm(pcm.data(), num_samples, mono.data());
+    for (size_t i = 0; i < num_samples; i++) {
+      ASSERT_EQ(reference_mono(&pcm[i * 4]), mono[i]) << i;
+    }
+    EXPECT_EQ(0x5555, mono[num_samples]);
+  }
+}
+
+TEST(HearingAidEncoderTest, packets_match_one_g722_encode) {
+  for (size_t num_samples : kNumSamples) {
+    SCOPED_TRACE(testing::Message() << "num_samples " << num_samples);
+    std::vector<uint8_t> pcm = make_pcm(num_samples);
+    std::vector<int16_t> mono(num_samples);
+    DownmixPcm(pcm.data(), num_samples, mono.data());
+
+    // An odd last sample is dropped by G.722, and the last packet is padded
+    std::vector<uint8_t> expected((num_samples / 32 + 1) * 16, 0);
+    g722_encode_state_t state;
+    g722_encode_init(&state, 64000, G722_PACKED);
+    ASSERT_EQ(num_samples / 2, (size_t)g722_encode(&state, expected.data(),
+                                                   mono.data(), num_samples));
+
+    HearingAidEncoder encoder;
+    DownmixPcm(pcm.data(), num_samples, encoder.StartTick(num_samples));
+    EXPECT_EQ(num_samples / 2, encoder.RemainingBytes());
+    std::vector<uint8_t> packets(expected.size(), 0xAA);
+    for (size_t offset = 0; offset < packets.size(); offset += 16) {
+      encoder.EncodeNext(&packets[offset], 16);
+    }
+    EXPECT_EQ(0u, encoder.RemainingBytes());
+    EXPECT_EQ(expected, packets);
+  }
+}
+
+TEST(HearingAidEncoderTest, skipped_packets_keep_the_encoder_in_step) {
+  const size_t num_samples = 320;
+  std::vector<uint8_t> pcm = make_pcm(num_samples);
+  std::vector<int16_t> mono(num_samples);
+  DownmixPcm(pcm.data(), num_samples, mono.data());
+
+  std::vector<uint8_t> expected(num_samples / 2);
+  g722_encode_state_t state;
+  g722_encode_init(&state, 64000, G722_PACKED);
+  g722_encode(&state, expected.data(), mono.data(), num_samples);
+
+  HearingAidEncoder encoder;
+  DownmixPcm(pcm.data(), num_samples, encoder.StartTick(num_samples));
+  encoder.SkipNext(40);
+  std::vector<uint8_t> packet(120);
+  encoder.EncodeNext(packet.data(), packet.size());
+  EXPECT_EQ(std::vector<uint8_t>(expected.begin() + 40, expected.end()),
+            packet);
+}
@@ -360,6 +360,38 @@ class BtaAvCo {
   void DataPacketWasDropped(tBTA_AV_HNDL bta_av_handle,
                             const RawAddress& peer_address);
 
+  /**
+   * An audio packet has been passed to L2CAP.
+   *
+   * @param bta_av_handle the BTA AV handle to identify the peer
+   * @param peer_address the peer address
+   * @param num_sdu the number of media packets the audio packet was split in
+   * @param l2c_queued the number of media packets still queued in L2CAP
+   * @param av_queued the number of audio packets waiting behind it
+   */
+  void DataPacketWasWritten(tBTA_AV_HNDL bta_av_handle,
+                            const RawAddress& peer_address, uint16_t num_sdu,
+                            uint16_t l2c_queued, uint16_t av_queued);
+
+  /**
+   * Media packets have been sent to the controller.
+   *
+   * @param bta_av_handle the BTA AV handle to identify the peer
+   * @param peer_address the peer address
+   * @param num_sdu the number of media packets sent
+   */
+  void DataPacketsWereSent(tBTA_AV_HNDL bta_av_handle,
+                           const RawAddress& peer_address, uint16_t num_sdu);
+
+  /**
+   * The media packets queued in L2CAP are about to be dropped.
+   *
+   * @param bta_av_handle the BTA AV handle to identify the peer
+   * @param peer_address the peer address
+   */
+  void DataPacketsWillBeFlushed(tBTA_AV_HNDL bta_av_handle,
+                                const RawAddress& peer_address);
+
   /**
    * Process AVDTP Audio Delay when the initial delay report is received by
    * the Source.
@@ -1397,6 +1429,39 @@ void BtaAvCo::DataPacketWasDropped(tBTA_AV_HNDL bta_av_handle,
                                    const RawAddress& peer_address) {
   APPL_TRACE_ERROR("%s: peer %s dropped audio packet on handle 0x%x", __func__,
                    peer_address.ToString().c_str(), bta_av_handle);
+
+  if (active_peer_ != nullptr &&
+      active_peer_->BtaAvHandle() == bta_av_handle) {
+    btif_a2dp_source_on_packet_dropped();
+  }
+}
+
+void BtaAvCo::DataPacketWasWritten(tBTA_AV_HNDL bta_av_handle,
+                                   const RawAddress& peer_address,
+                                   uint16_t num_sdu, uint16_t l2c_queued,
+                                   uint16_t av_queued) {
+  // Only the active peer streams the packets of the A2DP Source
+  if (active_peer_ == nullptr || active_peer_->BtaAvHandle() != bta_av_handle)
+    return;
+
+  btif_a2dp_source_on_packet_written(num_sdu, l2c_queued, av_queued);
+}
+
+void BtaAvCo::DataPacketsWereSent(tBTA_AV_HNDL bta_av_handle,
+                                  const RawAddress& peer_address,
+                                  uint16_t num_sdu) {
+  if (active_peer_ == nullptr || active_peer_->BtaAvHandle() != bta_av_handle)
+    return;
+
+  btif_a2dp_source_on_packets_sent(num_sdu);
+}
+
+void BtaAvCo::DataPacketsWillBeFlushed(tBTA_AV_HNDL bta_av_handle,
+                                       const RawAddress& peer_address) {
+  if (active_peer_ == nullptr || active_peer_->BtaAvHandle() != bta_av_handle)
+    return;
+
+  btif_a2dp_source_on_packets_flushed();
 }
 
 void BtaAvCo::ProcessAudioDelay(tBTA_AV_HNDL bta_av_handle,
@@ -2168,6 +2233,24 @@ void bta_av_co_audio_drop(tBTA_AV_HNDL bta_av_handle,
   bta_av_co_cb.DataPacketWasDropped(bta_av_handle, peer_address);
 }
 
+void bta_av_co_audio_write(tBTA_AV_HNDL bta_av_handle,
+                           const RawAddress& peer_address, uint16_t num_sdu,
+                           uint16_t l2c_queued, uint16_t av_queued) {
+  bta_av_co_cb.DataPacketWasWritten(bta_av_handle, peer_address, num_sdu,
+                                    l2c_queued, av_queued);
+}
+
+void bta_av_co_audio_tx_complete(tBTA_AV_HNDL bta_av_handle,
+                                 const RawAddress& peer_address,
+                                 uint16_t num_sdu) {
+  bta_av_co_cb.DataPacketsWereSent(bta_av_handle, peer_address, num_sdu);
+}
+
+void bta_av_co_audio_flush(tBTA_AV_HNDL bta_av_handle,
+                           const RawAddress& peer_address) {
+  bta_av_co_cb.DataPacketsWillBeFlushed(bta_av_handle, peer_address);
+}
+
 void bta_av_co_audio_delay(tBTA_AV_HNDL bta_av_handle,
                            const RawAddress& peer_address, uint16_t delay) {
   bta_av_co_cb.ProcessAudioDelay(bta_av_handle, peer_address, delay);
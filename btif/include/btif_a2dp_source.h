@@ -121,6 +121,23 @@ void btif_a2dp_source_set_tx_flush(bool enable);
 // Returns the next A2DP buffer to send if available, otherwise NULL.
 BT_HDR* btif_a2dp_source_audio_readbuf(void);
 
+// Process a buffer returned by btif_a2dp_source_audio_readbuf() that is passed
+// to L2CAP as |num_sdu| media packets. |l2c_queued| media packets are still
+// queued in L2CAP, and |av_queued| buffers wait in BTA behind this one.
+void btif_a2dp_source_on_packet_written(uint16_t num_sdu, uint16_t l2c_queued,
+                                        uint16_t av_queued);
+
+// Process a buffer returned by btif_a2dp_source_audio_readbuf() that is
+// dropped before it is passed to L2CAP.
+void btif_a2dp_source_on_packet_dropped(void);
+
+// Process the media packets L2CAP is about to drop. L2CAP reports them as
+// sent when it drops them.
+void btif_a2dp_source_on_packets_flushed(void);
+
+// Process |num_sdu| media packets sent by L2CAP to the controller.
+void btif_a2dp_source_on_packets_sent(uint16_t num_sdu);
+
 // Dump debug-related information for the A2DP Source module.
 // |fd| is the file descriptor to use for writing the ASCII formatted
 // information.
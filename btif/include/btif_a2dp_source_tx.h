@@ -0,0 +1,197 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+
+class LatencyHistogram {
+ public:
+  static constexpr size_t kNumBuckets = 10;
+  // Upper bounds of the buckets (in ms), the last bucket has none
+  static const uint64_t kBucketLimitsMs[kNumBuckets - 1];
+
+  LatencyHistogram() { Reset(); }
+  void Reset();
+  void Update(uint64_t latency_us);
+  void Accumulate(const LatencyHistogram& src);
+
+  // Counter for total samples
+  size_t count;
+
+  // Accumulated latency (in us)
+  uint64_t total_us;
+
+  // Max. latency (in us)
+  uint64_t max_us;
+
+  // Counter for samples per bucket
+  size_t buckets[kNumBuckets];
+};
+
+class TxLatencyStats {
+ public:
+  TxLatencyStats() { Reset(); }
+  void Reset();
+
+  uint64_t session_start_us;
+  uint64_t session_end_us;
+
+  // From the audio HAL read to passing the buffer to L2CAP
+  LatencyHistogram hal_to_l2cap;
+
+  // From the audio HAL read to sending the last media packet of the buffer
+  // to the controller
+  LatencyHistogram hal_to_hci;
+};
+
+// What the lower layers tell about the link while streaming. Updated on the
+// BTA thread, and taken once per window by the media task.
+class TxLinkStats {
+ public:
+  TxLinkStats() { Reset(); }
+  void Reset();
+
+  // |num_queued| media packets are left in L2CAP and BTA after a write
+  void OnPacketWritten(size_t num_queued);
+  void OnPacketDropped() { dropped_packets++; }
+  // The controller read |counter| from the Failed Contact Counter of the link
+  void OnFailedContactCounter(uint16_t counter);
+  // A buffer waited |l2cap_time_us| in L2CAP for the controller
+  void OnPacketsSent(uint64_t l2cap_time_us);
+
+  // Media packets queued below us (last/max.)
+  std::atomic<size_t> queued;
+  std::atomic<size_t> max_queued;
+
+  // Counter for buffers dropped by BTA
+  std::atomic<size_t> dropped_packets;
+
+  // Increments of the Failed Contact Counter of the link
+  std::atomic<size_t> failed_contacts;
+  std::atomic<int> last_failed_contact_counter;
+
+  // Max. time a buffer waited in L2CAP for the controller (in us)
+  std::atomic<uint64_t> max_l2cap_time_us;
+};
+
+// Sizes the tx queue from how the link behaves over windows of ticks: one
+// tick of buffers more after a window in which the link fell behind, one tick
+// less after a few windows in which it kept up. Used by the media task only,
+// the limit and ticks may be read from any thread.
+class TxQueueSizer {
+ public:
+  static constexpr size_t kMinTicks = 2;
+  static constexpr size_t kMaxTicks = 10;
+  static constexpr size_t kInitialTicks = 4;
+  static constexpr uint64_t kWindowMs = 500;
+  static constexpr size_t kShrinkWindows = 4;
+  // Media packets queued below us from which BTA holds the audio back
+  static constexpr size_t kCongestedQueue = 3;
+
+  // What the link did in the last window
+  struct Window {
+    size_t ticks;
+    size_t buffers;
+    size_t dropouts;
+    size_t max_queued;
+    size_t dropped_packets;
+    size_t failed_contacts;
+    uint64_t max_l2cap_time_us;
+    bool congested;
+  };
+
+  // |initial_limit| is used until the buffers per tick are known
+  explicit TxQueueSizer(size_t initial_limit);
+  void Reset();
+
+  size_t Limit() const { return limit_; }
+  size_t Ticks() const { return ticks_; }
+  const Window& LastWindow() const { return last_window_; }
+
+  // Oldest buffers to drop from a queue of |queue_length| buffers to make
+  // room for one more
+  size_t DropCount(size_t queue_length) const;
+
+  void OnBufferEnqueued() { window_buffers_++; }
+  void OnDropout() { window_dropouts_++; }
+
+  // Count a tick of |interval_us| at |now_us|, and resize the queue from
+  // |link_stats| when a window is over. Returns true if it was.
+  bool OnTick(uint64_t now_us, uint64_t interval_us, TxLinkStats* link_stats);
+
+ private:
+  const size_t initial_limit_;
+  std::atomic<size_t> limit_;
+  std::atomic<size_t> ticks_;
+  uint64_t window_start_us_;
+  size_t window_ticks_;
+  size_t window_buffers_;
+  size_t window_dropouts_;
+  size_t clean_windows_; /* Windows in a row the link kept up */
+  Window last_window_;
+};
+
+// Follows the buffers from the audio HAL to the controller, with the time the
+// audio of each was read: in the tx queue, in BTA, and as media packets in
+// L2CAP. Not thread-safe.
+class TxLatencyTracker {
+ public:
+  // Buffers followed at most in BTA and in L2CAP
+  static constexpr size_t kMaxTracked = 64;
+
+  void Reset();
+
+  // The tx queue
+  void OnEnqueued(uint64_t read_us) { tx_queue_read_us_.push_back(read_us); }
+  void OnOldestDropped();
+  void OnTxQueueFlushed() { tx_queue_read_us_.clear(); }
+  // BTA took the oldest buffer of the tx queue
+  void OnReadBuf();
+
+  // BTA dropped its oldest buffer
+  void OnBtaDropped();
+  // BTA passed its oldest buffer to L2CAP as |num_sdu| media packets, and
+  // |l2c_queued| media packets are left in L2CAP
+  void OnWritten(uint16_t num_sdu, uint16_t l2c_queued, uint64_t now_us,
+                 TxLatencyStats* stats);
+  // L2CAP drops the media packets it holds. It reports them as sent then.
+  void OnL2capFlushed() { l2cap_buffers_.clear(); }
+  // L2CAP sent |num_sdu| media packets to the controller. Returns the max.
+  // time the buffers sent waited in L2CAP.
+  uint64_t OnSent(uint16_t num_sdu, uint64_t now_us, TxLatencyStats* stats);
+
+  size_t TxQueueLength() const { return tx_queue_read_us_.size(); }
+  size_t BtaLength() const { return bta_read_us_.size(); }
+  size_t L2capLength() const { return l2cap_buffers_.size(); }
+  size_t UnsentSdu() const;
+
+ private:
+  // A buffer passed to L2CAP and not sent to the controller yet
+  struct L2capBuffer {
+    uint64_t read_us;
+    uint64_t write_us;
+    uint16_t unsent_sdu;
+  };
+
+  std::deque<uint64_t> tx_queue_read_us_;
+  std::deque<uint64_t> bta_read_us_;
+  std::deque<L2capBuffer> l2cap_buffers_;
+};
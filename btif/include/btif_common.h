@@ -26,6 +26,7 @@
 #include <base/location.h>
 #include <base/message_loop/message_loop.h>
 #include <hardware/bluetooth.h>
+#include <vector>
 
 #include "bt_types.h"
 #include "bta/include/bta_api.h"
@@ -210,7 +211,8 @@ void btif_adapter_properties_evt(bt_status_t status, uint32_t num_props,
 void btif_remote_properties_evt(bt_status_t status, RawAddress* remote_addr,
                                 uint32_t num_props, bt_property_t* p_props);
 
-void bte_load_did_conf(const char* p_path);
+std::vector<tBTA_DI_RECORD> bte_parse_did_conf(const char* p_path);
+void bte_set_did_records(const std::vector<tBTA_DI_RECORD>& records);
 void bte_main_boot_entry(void);
 void bte_main_enable(void);
 void bte_main_disable(void);
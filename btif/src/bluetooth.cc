@@ -63,9 +63,11 @@
 #include "btif_storage.h"
 #include "btsnoop.h"
 #include "btsnoop_mem.h"
+#include "buffer_allocator.h"
 #include "common/address_obfuscator.h"
 #include "common/metric_id_allocator.h"
 #include "common/metrics.h"
+#include "common/startup_trace.h"
 #include "device/include/interop.h"
 #include "main/shim/dumpsys.h"
 #include "main/shim/shim.h"
@@ -75,6 +77,7 @@
 #include "osi/include/osi.h"
 #include "osi/include/wakelock.h"
 #include "stack/gatt/connection_manager.h"
+#include "stack/include/btm_ble_api.h"
 #include "stack_manager.h"
 
 using bluetooth::hearing_aid::HearingAidInterface;
@@ -337,13 +340,17 @@ static void dump(int fd, const char** arguments) {
   bta_debug_av_dump(fd);
   stack_debug_avdtp_api_dump(fd);
   bluetooth::avrcp::AvrcpService::DebugDump(fd);
+  bluetooth::common::StartupTrace::GetInstance().Dump(fd);
   btif_debug_config_dump(fd);
   BTA_HfClientDumpStatistics(fd);
   wakelock_debug_dump(fd);
   osi_allocator_debug_dump(fd);
+  buffer_allocator_debug_dump(fd);
+  btsnoop_debug_dump(fd);
   alarm_debug_dump(fd);
   HearingAid::DebugDump(fd);
   connection_manager::dump(fd);
+  btm_ble_adv_cache_debug_dump(fd);
   bluetooth::bqr::DebugDump(fd);
   if (bluetooth::shim::is_gd_shim_enabled()) {
     bluetooth::shim::Dump(fd);
@@ -302,6 +302,25 @@ static void btif_a2dp_recv_ctrl_data(void) {
                 sizeof(nsec));
       break;
     }
+
+    case A2DP_CTRL_CMD_SETUP_RING: {
+      uint32_t ring_size;
+
+      btif_a2dp_command_ack(A2DP_CTRL_ACK_SUCCESS);
+      if (UIPC_Read(*a2dp_uipc, UIPC_CH_ID_AV_CTRL, 0,
+                    reinterpret_cast<uint8_t*>(&ring_size),
+                    sizeof(ring_size)) != sizeof(ring_size)) {
+        APPL_TRACE_ERROR("%s: Error reading ring size from audio HAL",
+                         __func__);
+        break;
+      }
+      // Replies with the ring, or with no ring if the audio HAL has to keep
+      // writing to the data socket
+      UIPC_OpenRing(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, ring_size,
+                    UIPC_CH_ID_AV_CTRL);
+      break;
+    }
+
     default:
       APPL_TRACE_ERROR("%s: UNSUPPORTED CMD (%d)", __func__, cmd);
       btif_a2dp_command_ack(A2DP_CTRL_ACK_FAILURE);
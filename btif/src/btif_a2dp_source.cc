@@ -28,6 +28,9 @@
 #include <limits.h>
 #include <string.h>
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
 
 #include "audio_a2dp_hw/include/audio_a2dp_hw.h"
 #include "audio_hal_interface/a2dp_encoding.h"
@@ -37,6 +40,7 @@
 #include "btif_a2dp_audio_interface.h"
 #include "btif_a2dp_control.h"
 #include "btif_a2dp_source.h"
+#include "btif_a2dp_source_tx.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_util.h"
@@ -47,6 +51,7 @@
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/wakelock.h"
 #include "uipc.h"
 
@@ -63,6 +68,20 @@ extern std::unique_ptr<tUIPC_STATE> a2dp_uipc;
  */
 #define MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
 
+/**
+ * In adaptive mode the tx queue holds the buffers of a number of ticks that
+ * follows the link (see TxQueueSizer). When the queue is full, only the
+ * oldest buffers needed to make room are dropped. The buffers are also
+ * followed down to the controller for the latency histograms in the dump.
+ * Only the queue depth adapts: the media timer keeps the encoder interval,
+ * since the encoders size the audio of a tick from it.
+ */
+#define ADAPTIVE_TX_PROPERTY "persist.bluetooth.a2dp_source.adaptive_tx"
+#define ADAPTIVE_TX_FAILED_CONTACT_POLL_MS 1000
+
+/* Sessions kept for the latency histograms in the dump */
+#define TX_LATENCY_MAX_SESSIONS 5
+
 class SchedulingStats {
  public:
   SchedulingStats() { Reset(); }
@@ -180,6 +199,12 @@ class BtifA2dpSource {
         tx_flush(false),
         encoder_interface(nullptr),
         encoder_interval_ms(0),
+        tx_read_us(0),
+        adaptive_tx(false),
+        tx_queue_sizer(MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ),
+        last_failed_contact_poll_us(0),
+        failed_contact_read_pending(false),
+        failed_contact_read_logged(false),
         state_(kStateOff) {}
 
   void Reset() {
@@ -192,9 +217,33 @@ class BtifA2dpSource {
     encoder_interval_ms = 0;
     stats.Reset();
     accumulated_stats.Reset();
+    tx_read_us = 0;
+    adaptive_tx = false;
+    ResetAdaptiveTx();
+    {
+      std::lock_guard<std::mutex> lock(tx_latency_mutex);
+      tx_latency_tracker.Reset();
+      latency_stats.Reset();
+      accumulated_latency_stats.Reset();
+      latency_history.clear();
+    }
     state_ = kStateOff;
   }
 
+  // Start over the adaptive tx queue sizing, with the legacy limit until the
+  // buffers per tick are known
+  void ResetAdaptiveTx() {
+    tx_queue_sizer.Reset();
+    last_failed_contact_poll_us = 0;
+    link_stats.Reset();
+  }
+
+  // Lock tx_latency_mutex if the buffers are followed, i.e. in adaptive mode
+  std::unique_lock<std::mutex> LockTxLatency() {
+    if (!adaptive_tx) return std::unique_lock<std::mutex>();
+    return std::unique_lock<std::mutex>(tx_latency_mutex);
+  }
+
   BtifA2dpSource::RunState State() const { return state_; }
   std::string StateStr() const {
     switch (state_) {
@@ -218,6 +267,23 @@ class BtifA2dpSource {
   uint64_t encoder_interval_ms; /* Local copy of the encoder interval */
   BtifMediaStats stats;
   BtifMediaStats accumulated_stats;
+  uint64_t tx_read_us; /* First audio HAL read for the next buffer */
+
+  /* Size the tx queue from the state of the link. Set at startup only. */
+  std::atomic<bool> adaptive_tx;
+  TxQueueSizer tx_queue_sizer;
+  uint64_t last_failed_contact_poll_us;
+  TxLinkStats link_stats;
+  /* BTM reads the Failed Contact Counter for one caller at a time */
+  std::atomic<bool> failed_contact_read_pending;
+  std::atomic<bool> failed_contact_read_logged; /* Log the pending read */
+
+  // Guards the latency tracking, used in adaptive mode only
+  std::mutex tx_latency_mutex;
+  TxLatencyTracker tx_latency_tracker;
+  TxLatencyStats latency_stats;
+  TxLatencyStats accumulated_latency_stats;
+  std::deque<TxLatencyStats> latency_history;
 
  private:
   BtifA2dpSource::RunState state_;
@@ -261,6 +327,15 @@ static void update_scheduling_stats(SchedulingStats* stats, uint64_t now_us,
 // Update the A2DP Source related metrics.
 // This function should be called before collecting the metrics.
 static void btif_a2dp_source_update_metrics(void);
+// Resize the tx queue in adaptive mode from what the link did in the last
+// window. The encoder interval is left as is.
+static void btif_a2dp_source_adapt_tx_queue(uint64_t now_us);
+// Read the Failed Contact Counter of the link to |peer_address|, together
+// with the read in flight if any. |log_result| logs what is read.
+static void btif_a2dp_source_read_failed_contact_counter(
+    const RawAddress& peer_address, bool log_result);
+static void btif_a2dp_source_dump_latency(int fd,
+                                          const TxLatencyStats& stats);
 static void btm_read_rssi_cb(void* data);
 static void btm_read_failed_contact_counter_cb(void* data);
 static void btm_read_automatic_flush_timeout_cb(void* data);
@@ -343,6 +418,10 @@ bool btif_a2dp_source_startup(void) {
   btif_a2dp_source_cb.Reset();
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateStartingUp);
   btif_a2dp_source_cb.tx_audio_queue = fixed_queue_new(SIZE_MAX);
+  btif_a2dp_source_cb.adaptive_tx =
+      osi_property_get_bool(ADAPTIVE_TX_PROPERTY, false);
+  LOG_INFO(LOG_TAG, "%s: adaptive tx queue is %s", __func__,
+           btif_a2dp_source_cb.adaptive_tx ? "enabled" : "disabled");
 
   // Schedule the rest of the operations
   btif_a2dp_source_thread.DoInThread(
@@ -510,8 +589,12 @@ static void btif_a2dp_source_shutdown_delayed(void) {
   } else {
     btif_a2dp_control_cleanup();
   }
-  fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, nullptr);
-  btif_a2dp_source_cb.tx_audio_queue = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+    fixed_queue_free(btif_a2dp_source_cb.tx_audio_queue, nullptr);
+    btif_a2dp_source_cb.tx_audio_queue = nullptr;
+    btif_a2dp_source_cb.tx_latency_tracker.Reset();
+  }
 
   btif_a2dp_source_cb.SetState(BtifA2dpSource::kStateOff);
 }
@@ -821,6 +904,15 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
   if (codec_config != nullptr) {
     btif_a2dp_source_cb.stats.codec_index = codec_config->codecIndex();
   }
+
+  btif_a2dp_source_cb.tx_read_us = 0;
+  btif_a2dp_source_cb.ResetAdaptiveTx();
+  std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+  // Buffers BTA and L2CAP dropped when the last session stopped
+  btif_a2dp_source_cb.tx_latency_tracker.Reset();
+  btif_a2dp_source_cb.latency_stats.Reset();
+  btif_a2dp_source_cb.latency_stats.session_start_us =
+      btif_a2dp_source_cb.stats.session_start_us;
 }
 
 static void btif_a2dp_source_audio_tx_stop_event(void) {
@@ -837,6 +929,21 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
   btif_a2dp_source_update_metrics();
   btif_a2dp_source_accumulate_stats(&btif_a2dp_source_cb.stats,
                                     &btif_a2dp_source_cb.accumulated_stats);
+  {
+    std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+    TxLatencyStats& latency_stats = btif_a2dp_source_cb.latency_stats;
+    if (latency_stats.session_start_us != 0) {
+      latency_stats.session_end_us = btif_a2dp_source_cb.stats.session_end_us;
+      TxLatencyStats& accumulated =
+          btif_a2dp_source_cb.accumulated_latency_stats;
+      accumulated.hal_to_l2cap.Accumulate(latency_stats.hal_to_l2cap);
+      accumulated.hal_to_hci.Accumulate(latency_stats.hal_to_hci);
+      btif_a2dp_source_cb.latency_history.push_back(latency_stats);
+      if (btif_a2dp_source_cb.latency_history.size() > TX_LATENCY_MAX_SESSIONS)
+        btif_a2dp_source_cb.latency_history.pop_front();
+    }
+    latency_stats.Reset();
+  }
 
   uint8_t p_buf[AUDIO_STREAM_OUTPUT_BUFFER_SZ * 2];
   uint16_t event;
@@ -900,6 +1007,11 @@ static void btif_a2dp_source_audio_handle_timer(void) {
 #ifndef OS_GENERIC
   ATRACE_INT("btif TX queue", transmit_queue_length);
 #endif
+  if (btif_a2dp_source_cb.adaptive_tx) {
+    btif_a2dp_source_adapt_tx_queue(timestamp_us);
+    // Let the encoder see the audio held back below us too
+    transmit_queue_length += btif_a2dp_source_cb.link_stats.queued;
+  }
   if (btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length !=
       nullptr) {
     btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length(
@@ -922,6 +1034,11 @@ static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len) {
     bytes_read = UIPC_Read(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, &event, p_buf, len);
   }
 
+  if (btif_a2dp_source_cb.tx_read_us == 0) {
+    btif_a2dp_source_cb.tx_read_us =
+        bluetooth::common::time_get_os_boottime_us();
+  }
+
   if (bytes_read < len) {
     LOG_WARN(LOG_TAG, "%s: UNDERFLOW: ONLY READ %d BYTES OUT OF %d", __func__,
              bytes_read, len);
@@ -942,6 +1059,10 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
                                               uint32_t bytes_read) {
   uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
   btif_a2dp_control_log_bytes_read(bytes_read);
+  uint64_t read_us =
+      btif_a2dp_source_cb.tx_read_us != 0 ? btif_a2dp_source_cb.tx_read_us
+                                          : now_us;
+  btif_a2dp_source_cb.tx_read_us = 0;
 
   /* Check if timer was stopped (media task stopped) */
   if (!btif_a2dp_source_cb.media_alarm.IsScheduled()) {
@@ -953,44 +1074,63 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
   if (btif_a2dp_source_cb.tx_flush) {
     LOG_VERBOSE(LOG_TAG, "%s: tx suspended, discarded frame", __func__);
 
+    auto lock = btif_a2dp_source_cb.LockTxLatency();
     btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
         fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
     btif_a2dp_source_cb.stats.tx_queue_last_flushed_us = now_us;
     fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+    if (lock.owns_lock())
+      btif_a2dp_source_cb.tx_latency_tracker.OnTxQueueFlushed();
 
     osi_free(p_buf);
     return false;
   }
 
   // Check for TX queue overflow
-  // TODO: Using frames_n here is probably wrong: should be "+ 1" instead.
-  if (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue) + frames_n >
-      MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ) {
-    LOG_WARN(LOG_TAG, "%s: TX queue buffer size now=%u adding=%u max=%d",
-             __func__,
-             (uint32_t)fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue),
-             (uint32_t)frames_n, MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ);
+  size_t queue_length = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+  size_t queue_max;
+  size_t drop_n;
+  bool overflow;
+  if (btif_a2dp_source_cb.adaptive_tx) {
+    // Drop only the oldest buffers to make room for this one
+    queue_max = btif_a2dp_source_cb.tx_queue_sizer.Limit();
+    drop_n = btif_a2dp_source_cb.tx_queue_sizer.DropCount(queue_length);
+    overflow = drop_n > 0;
+  } else {
+    // TODO: Using frames_n here is probably wrong: should be "+ 1" instead.
+    queue_max = MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ;
+    overflow = queue_length + frames_n > queue_max;
+    // Flush all queued buffers
+    drop_n = queue_length;
+  }
+  if (overflow) {
+    LOG_WARN(LOG_TAG, "%s: TX queue buffer size now=%u adding=%u max=%u",
+             __func__, (uint32_t)queue_length, (uint32_t)frames_n,
+             (uint32_t)queue_max);
     // Keep track of drop-outs
     btif_a2dp_source_cb.stats.tx_queue_dropouts++;
     btif_a2dp_source_cb.stats.tx_queue_last_dropouts_us = now_us;
+    btif_a2dp_source_cb.tx_queue_sizer.OnDropout();
 
-    // Flush all queued buffers
-    size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
     btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages = std::max(
         drop_n, btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages);
     int num_dropped_encoded_bytes = 0;
     int num_dropped_encoded_frames = 0;
-    while (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue)) {
-      btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
+    auto lock = btif_a2dp_source_cb.LockTxLatency();
+    for (size_t i = 0; i < drop_n; i++) {
       void* p_data =
           fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
-      if (p_data != nullptr) {
-        auto p_dropped_buf = static_cast<BT_HDR*>(p_data);
-        num_dropped_encoded_bytes += p_dropped_buf->len;
-        num_dropped_encoded_frames += p_dropped_buf->layer_specific;
-        osi_free(p_data);
-      }
+      // BTA took the buffer meanwhile
+      if (p_data == nullptr) break;
+      btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
+      if (lock.owns_lock())
+        btif_a2dp_source_cb.tx_latency_tracker.OnOldestDropped();
+      auto p_dropped_buf = static_cast<BT_HDR*>(p_data);
+      num_dropped_encoded_bytes += p_dropped_buf->len;
+      num_dropped_encoded_frames += p_dropped_buf->layer_specific;
+      osi_free(p_data);
     }
+    if (lock.owns_lock()) lock.unlock();
     bluetooth::common::LogA2dpAudioOverrunEvent(
         btif_av_source_active_peer(), drop_n,
         btif_a2dp_source_cb.encoder_interval_ms, num_dropped_encoded_frames,
@@ -1002,12 +1142,7 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     if (status != BTM_CMD_STARTED) {
       LOG_WARN(LOG_TAG, "%s: Cannot read RSSI: status %d", __func__, status);
     }
-    status = BTM_ReadFailedContactCounter(peer_bda,
-                                          btm_read_failed_contact_counter_cb);
-    if (status != BTM_CMD_STARTED) {
-      LOG_WARN(LOG_TAG, "%s: Cannot read Failed Contact Counter: status %d",
-               __func__, status);
-    }
+    btif_a2dp_source_read_failed_contact_counter(peer_bda, true);
     status = BTM_ReadAutomaticFlushTimeout(peer_bda,
                                            btm_read_automatic_flush_timeout_cb);
     if (status != BTM_CMD_STARTED) {
@@ -1027,8 +1162,12 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
   btif_a2dp_source_cb.stats.tx_queue_max_frames_per_packet = std::max(
       frames_n, btif_a2dp_source_cb.stats.tx_queue_max_frames_per_packet);
   CHECK(btif_a2dp_source_cb.encoder_interface != nullptr);
+  btif_a2dp_source_cb.tx_queue_sizer.OnBufferEnqueued();
 
+  auto lock = btif_a2dp_source_cb.LockTxLatency();
   fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
+  if (lock.owns_lock())
+    btif_a2dp_source_cb.tx_latency_tracker.OnEnqueued(read_us);
 
   return true;
 }
@@ -1042,11 +1181,16 @@ static void btif_a2dp_source_audio_tx_flush_event(void) {
   if (btif_a2dp_source_cb.encoder_interface != nullptr)
     btif_a2dp_source_cb.encoder_interface->feeding_flush();
 
+  auto lock = btif_a2dp_source_cb.LockTxLatency();
   btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
       fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
   btif_a2dp_source_cb.stats.tx_queue_last_flushed_us =
       bluetooth::common::time_get_os_boottime_us();
   fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+  if (lock.owns_lock()) {
+    btif_a2dp_source_cb.tx_latency_tracker.OnTxQueueFlushed();
+    lock.unlock();
+  }
 
   if (!bluetooth::audio::a2dp::is_hal_2_0_enabled() && a2dp_uipc != nullptr) {
     UIPC_Ioctl(*a2dp_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, nullptr);
@@ -1064,8 +1208,13 @@ static bool btif_a2dp_source_audio_tx_flush_req(void) {
 
 BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  auto lock = btif_a2dp_source_cb.LockTxLatency();
   BT_HDR* p_buf =
       (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
+  if (lock.owns_lock()) {
+    if (p_buf != nullptr) btif_a2dp_source_cb.tx_latency_tracker.OnReadBuf();
+    lock.unlock();
+  }
 
   btif_a2dp_source_cb.stats.tx_queue_total_readbuf_calls++;
   btif_a2dp_source_cb.stats.tx_queue_last_readbuf_us = now_us;
@@ -1079,6 +1228,89 @@ BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   return p_buf;
 }
 
+void btif_a2dp_source_on_packet_written(uint16_t num_sdu, uint16_t l2c_queued,
+                                        uint16_t av_queued) {
+  if (!btif_a2dp_source_cb.adaptive_tx) return;
+
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  btif_a2dp_source_cb.link_stats.OnPacketWritten(l2c_queued + av_queued);
+
+  std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+  btif_a2dp_source_cb.tx_latency_tracker.OnWritten(
+      num_sdu, l2c_queued, now_us, &btif_a2dp_source_cb.latency_stats);
+}
+
+void btif_a2dp_source_on_packet_dropped(void) {
+  if (!btif_a2dp_source_cb.adaptive_tx) return;
+
+  btif_a2dp_source_cb.link_stats.OnPacketDropped();
+
+  std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+  btif_a2dp_source_cb.tx_latency_tracker.OnBtaDropped();
+}
+
+void btif_a2dp_source_on_packets_flushed(void) {
+  if (!btif_a2dp_source_cb.adaptive_tx) return;
+
+  std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+  btif_a2dp_source_cb.tx_latency_tracker.OnL2capFlushed();
+}
+
+void btif_a2dp_source_on_packets_sent(uint16_t num_sdu) {
+  if (!btif_a2dp_source_cb.adaptive_tx) return;
+
+  uint64_t now_us = bluetooth::common::time_get_os_boottime_us();
+  std::unique_lock<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+  uint64_t max_l2cap_time_us = btif_a2dp_source_cb.tx_latency_tracker.OnSent(
+      num_sdu, now_us, &btif_a2dp_source_cb.latency_stats);
+  lock.unlock();
+
+  btif_a2dp_source_cb.link_stats.OnPacketsSent(max_l2cap_time_us);
+}
+
+static void btif_a2dp_source_adapt_tx_queue(uint64_t now_us) {
+  BtifA2dpSource& cb = btif_a2dp_source_cb;
+
+  // Ask the controller how often it could not reach the peer
+  if (now_us - cb.last_failed_contact_poll_us >=
+      ADAPTIVE_TX_FAILED_CONTACT_POLL_MS * 1000) {
+    cb.last_failed_contact_poll_us = now_us;
+    btif_a2dp_source_read_failed_contact_counter(btif_av_source_active_peer(),
+                                                 false);
+  }
+
+  if (!cb.tx_queue_sizer.OnTick(now_us, cb.encoder_interval_ms * 1000,
+                                &cb.link_stats))
+    return;
+
+  const TxQueueSizer::Window& window = cb.tx_queue_sizer.LastWindow();
+  APPL_TRACE_DEBUG(
+      "%s: congested=%s (dropouts=%zu dropped=%zu failed_contacts=%zu "
+      "max_queued=%zu max_l2cap_time_us=%" PRIu64 ") limit=%zu ticks=%zu",
+      __func__, window.congested ? "true" : "false", window.dropouts,
+      window.dropped_packets, window.failed_contacts, window.max_queued,
+      window.max_l2cap_time_us, cb.tx_queue_sizer.Limit(),
+      cb.tx_queue_sizer.Ticks());
+}
+
+static void btif_a2dp_source_read_failed_contact_counter(
+    const RawAddress& peer_address, bool log_result) {
+  BtifA2dpSource& cb = btif_a2dp_source_cb;
+  if (log_result) cb.failed_contact_read_logged = true;
+  // The read in flight serves this caller too
+  if (cb.failed_contact_read_pending.exchange(true)) return;
+
+  tBTM_STATUS status = BTM_ReadFailedContactCounter(
+      peer_address, btm_read_failed_contact_counter_cb);
+  if (status != BTM_CMD_STARTED) {
+    cb.failed_contact_read_pending = false;
+    if (cb.failed_contact_read_logged.exchange(false)) {
+      LOG_WARN(LOG_TAG, "%s: Cannot read Failed Contact Counter: status %d",
+               __func__, status);
+    }
+  }
+}
+
 static void log_tstamps_us(const char* comment, uint64_t timestamp_us) {
   static uint64_t prev_us = 0;
   APPL_TRACE_DEBUG("%s: [%s] ts %08" PRIu64 ", diff : %08" PRIu64
@@ -1290,6 +1522,78 @@ void btif_a2dp_source_debug_dump(int fd) {
       (unsigned long long)dequeue_stats->max_premature_scheduling_delta_us /
           1000,
       (unsigned long long)ave_time_us / 1000);
+
+  dprintf(fd,
+          "  Adaptive queue (enabled/max buffers/ticks)              : %s / "
+          "%zu / %zu\n",
+          btif_a2dp_source_cb.adaptive_tx ? "true" : "false",
+          btif_a2dp_source_cb.tx_queue_sizer.Limit(),
+          btif_a2dp_source_cb.tx_queue_sizer.Ticks());
+
+  //
+  // Latency from the audio HAL to the controller
+  //
+  if (!btif_a2dp_source_cb.adaptive_tx) {
+    dprintf(fd, "  Latency: not followed, set %s to follow it\n",
+            ADAPTIVE_TX_PROPERTY);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(btif_a2dp_source_cb.tx_latency_mutex);
+  TxLatencyStats total_latency = btif_a2dp_source_cb.accumulated_latency_stats;
+  total_latency.hal_to_l2cap.Accumulate(
+      btif_a2dp_source_cb.latency_stats.hal_to_l2cap);
+  total_latency.hal_to_hci.Accumulate(
+      btif_a2dp_source_cb.latency_stats.hal_to_hci);
+  dprintf(fd, "  Latency (all sessions):\n");
+  btif_a2dp_source_dump_latency(fd, total_latency);
+  for (const TxLatencyStats& latency_stats :
+       btif_a2dp_source_cb.latency_history) {
+    dprintf(fd,
+            "  Latency (session started/ended time ago in ms)          : "
+            "%llu / %llu\n",
+            (unsigned long long)(now_us - latency_stats.session_start_us) /
+                1000,
+            (unsigned long long)(now_us - latency_stats.session_end_us) /
+                1000);
+    btif_a2dp_source_dump_latency(fd, latency_stats);
+  }
+  if (btif_a2dp_source_cb.latency_stats.session_start_us != 0) {
+    dprintf(fd,
+            "  Latency (current session started time ago in ms)        : "
+            "%llu\n",
+            (unsigned long long)(now_us - btif_a2dp_source_cb.latency_stats
+                                              .session_start_us) /
+                1000);
+    btif_a2dp_source_dump_latency(fd, btif_a2dp_source_cb.latency_stats);
+  }
+}
+
+static void btif_a2dp_source_dump_histogram(int fd, const char* name,
+                                            const LatencyHistogram& histogram) {
+  uint64_t ave_time_us = 0;
+  if (histogram.count != 0) ave_time_us = histogram.total_us / histogram.count;
+  dprintf(fd, "    %-54s: %zu / %llu / %llu\n",
+          (std::string(name) + " in ms (count/ave/max)").c_str(),
+          histogram.count, (unsigned long long)ave_time_us / 1000,
+          (unsigned long long)histogram.max_us / 1000);
+
+  const size_t last = LatencyHistogram::kNumBuckets - 1;
+  std::string buckets;
+  for (size_t i = 0; i < last; i++) {
+    buckets += "<" + std::to_string(LatencyHistogram::kBucketLimitsMs[i]) +
+               ":" + std::to_string(histogram.buckets[i]) + " ";
+  }
+  buckets += ">=" +
+             std::to_string(LatencyHistogram::kBucketLimitsMs[last - 1]) + ":" +
+             std::to_string(histogram.buckets[last]);
+  dprintf(fd, "    %-54s: %s\n",
+          (std::string(name) + " histogram in ms").c_str(), buckets.c_str());
+}
+
+static void btif_a2dp_source_dump_latency(int fd,
+                                          const TxLatencyStats& stats) {
+  btif_a2dp_source_dump_histogram(fd, "HAL read to L2CAP", stats.hal_to_l2cap);
+  btif_a2dp_source_dump_histogram(fd, "HAL read to HCI", stats.hal_to_hci);
 }
 
 static void btif_a2dp_source_update_metrics(void) {
@@ -1360,19 +1664,33 @@ static void btm_read_rssi_cb(void* data) {
 }
 
 static void btm_read_failed_contact_counter_cb(void* data) {
+  btif_a2dp_source_cb.failed_contact_read_pending = false;
+  // Only the reads asked for when the tx queue overflows are logged
+  bool log_result =
+      btif_a2dp_source_cb.failed_contact_read_logged.exchange(false);
+
   if (data == nullptr) {
-    LOG_ERROR(LOG_TAG, "%s: Read Failed Contact Counter request timed out",
-              __func__);
+    if (log_result) {
+      LOG_ERROR(LOG_TAG, "%s: Read Failed Contact Counter request timed out",
+                __func__);
+    }
     return;
   }
 
   tBTM_FAILED_CONTACT_COUNTER_RESULT* result =
       (tBTM_FAILED_CONTACT_COUNTER_RESULT*)data;
   if (result->status != BTM_SUCCESS) {
-    LOG_ERROR(LOG_TAG, "%s: unable to read Failed Contact Counter (status %d)",
-              __func__, result->status);
+    if (log_result) {
+      LOG_ERROR(LOG_TAG,
+                "%s: unable to read Failed Contact Counter (status %d)",
+                __func__, result->status);
+    }
     return;
   }
+  btif_a2dp_source_cb.link_stats.OnFailedContactCounter(
+      result->failed_contact_counter);
+  if (!log_result) return;
+
   bluetooth::common::LogReadFailedContactCounterResult(
       result->rem_bda, bluetooth::common::kUnknownConnectionHandle,
       result->hci_status, result->failed_contact_counter);
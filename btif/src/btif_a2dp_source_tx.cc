@@ -0,0 +1,218 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif/include/btif_a2dp_source_tx.h"
+
+#include <algorithm>
+#include <iterator>
+
+const uint64_t LatencyHistogram::kBucketLimitsMs[] = {10,  20,  40,  60, 80,
+                                                      100, 150, 200, 300};
+
+void LatencyHistogram::Reset() {
+  count = 0;
+  total_us = 0;
+  max_us = 0;
+  std::fill(std::begin(buckets), std::end(buckets), 0);
+}
+
+void LatencyHistogram::Update(uint64_t latency_us) {
+  size_t i = 0;
+  while (i < kNumBuckets - 1 && latency_us >= kBucketLimitsMs[i] * 1000) i++;
+  buckets[i]++;
+  count++;
+  total_us += latency_us;
+  max_us = std::max(max_us, latency_us);
+}
+
+void LatencyHistogram::Accumulate(const LatencyHistogram& src) {
+  for (size_t i = 0; i < kNumBuckets; i++) buckets[i] += src.buckets[i];
+  count += src.count;
+  total_us += src.total_us;
+  max_us = std::max(max_us, src.max_us);
+}
+
+void TxLatencyStats::Reset() {
+  session_start_us = 0;
+  session_end_us = 0;
+  hal_to_l2cap.Reset();
+  hal_to_hci.Reset();
+}
+
+void TxLinkStats::Reset() {
+  queued = 0;
+  max_queued = 0;
+  dropped_packets = 0;
+  failed_contacts = 0;
+  last_failed_contact_counter = -1;
+  max_l2cap_time_us = 0;
+}
+
+void TxLinkStats::OnPacketWritten(size_t num_queued) {
+  queued = num_queued;
+  size_t last_max = max_queued;
+  while (num_queued > last_max &&
+         !max_queued.compare_exchange_weak(last_max, num_queued)) {
+  }
+}
+
+void TxLinkStats::OnFailedContactCounter(uint16_t counter) {
+  int last_counter = last_failed_contact_counter.exchange(counter);
+  // The counter starts over when the link is reset
+  if (last_counter >= 0 && counter > last_counter) {
+    failed_contacts += counter - last_counter;
+  }
+}
+
+void TxLinkStats::OnPacketsSent(uint64_t l2cap_time_us) {
+  uint64_t last_max_us = max_l2cap_time_us;
+  while (l2cap_time_us > last_max_us &&
+         !max_l2cap_time_us.compare_exchange_weak(last_max_us,
+                                                  l2cap_time_us)) {
+  }
+}
+
+TxQueueSizer::TxQueueSizer(size_t initial_limit)
+    : initial_limit_(initial_limit) {
+  Reset();
+}
+
+void TxQueueSizer::Reset() {
+  limit_ = initial_limit_;
+  ticks_ = kInitialTicks;
+  window_start_us_ = 0;
+  window_ticks_ = 0;
+  window_buffers_ = 0;
+  window_dropouts_ = 0;
+  clean_windows_ = 0;
+  last_window_ = {};
+}
+
+size_t TxQueueSizer::DropCount(size_t queue_length) const {
+  size_t limit = limit_;
+  return queue_length + 1 > limit ? queue_length + 1 - limit : 0;
+}
+
+bool TxQueueSizer::OnTick(uint64_t now_us, uint64_t interval_us,
+                          TxLinkStats* link_stats) {
+  if (window_start_us_ == 0) window_start_us_ = now_us;
+  window_ticks_++;
+  if (now_us - window_start_us_ < kWindowMs * 1000) return false;
+
+  Window& window = last_window_;
+  window.ticks = window_ticks_;
+  window.buffers = window_buffers_;
+  window.dropouts = window_dropouts_;
+  window.max_queued = link_stats->max_queued.exchange(0);
+  window.dropped_packets = link_stats->dropped_packets.exchange(0);
+  window.failed_contacts = link_stats->failed_contacts.exchange(0);
+  window.max_l2cap_time_us = link_stats->max_l2cap_time_us.exchange(0);
+
+  // The link fell behind if the buffers piled up below or in front of us, or
+  // the controller took longer than a tick to take a buffer
+  window.congested = window.dropouts > 0 || window.dropped_packets > 0 ||
+                     window.failed_contacts > 0 ||
+                     window.max_queued >= kCongestedQueue ||
+                     window.max_l2cap_time_us > interval_us;
+  size_t ticks = ticks_;
+  if (window.congested) {
+    ticks = std::min(ticks + 1, kMaxTicks);
+    clean_windows_ = 0;
+  } else if (++clean_windows_ >= kShrinkWindows) {
+    ticks = std::max(ticks - 1, kMinTicks);
+    clean_windows_ = 0;
+  }
+  ticks_ = ticks;
+
+  if (window_buffers_ > 0) {
+    size_t buffers_per_tick =
+        (window_buffers_ + window_ticks_ - 1) / window_ticks_;
+    limit_ = buffers_per_tick * ticks;
+  }
+
+  window_start_us_ = now_us;
+  window_ticks_ = 0;
+  window_buffers_ = 0;
+  window_dropouts_ = 0;
+  return true;
+}
+
+void TxLatencyTracker::Reset() {
+  tx_queue_read_us_.clear();
+  bta_read_us_.clear();
+  l2cap_buffers_.clear();
+}
+
+void TxLatencyTracker::OnOldestDropped() {
+  if (!tx_queue_read_us_.empty()) tx_queue_read_us_.pop_front();
+}
+
+void TxLatencyTracker::OnReadBuf() {
+  if (tx_queue_read_us_.empty()) return;
+  bta_read_us_.push_back(tx_queue_read_us_.front());
+  tx_queue_read_us_.pop_front();
+  if (bta_read_us_.size() > kMaxTracked) bta_read_us_.pop_front();
+}
+
+void TxLatencyTracker::OnBtaDropped() {
+  if (!bta_read_us_.empty()) bta_read_us_.pop_front();
+}
+
+void TxLatencyTracker::OnWritten(uint16_t num_sdu, uint16_t l2c_queued,
+                                 uint64_t now_us, TxLatencyStats* stats) {
+  // Forget the media packets L2CAP no longer has but did not report as sent,
+  // e.g. when AVDTP dropped them
+  size_t unsent_sdu = UnsentSdu();
+  while (unsent_sdu > l2c_queued) {
+    L2capBuffer& buffer = l2cap_buffers_.front();
+    size_t forget =
+        std::min<size_t>(unsent_sdu - l2c_queued, buffer.unsent_sdu);
+    buffer.unsent_sdu -= forget;
+    unsent_sdu -= forget;
+    if (buffer.unsent_sdu == 0) l2cap_buffers_.pop_front();
+  }
+
+  if (bta_read_us_.empty()) return;
+  uint64_t read_us = bta_read_us_.front();
+  bta_read_us_.pop_front();
+  stats->hal_to_l2cap.Update(now_us - read_us);
+  l2cap_buffers_.push_back({read_us, now_us, num_sdu});
+  if (l2cap_buffers_.size() > kMaxTracked) l2cap_buffers_.pop_front();
+}
+
+uint64_t TxLatencyTracker::OnSent(uint16_t num_sdu, uint64_t now_us,
+                                  TxLatencyStats* stats) {
+  uint64_t max_l2cap_time_us = 0;
+  while (num_sdu > 0 && !l2cap_buffers_.empty()) {
+    L2capBuffer& buffer = l2cap_buffers_.front();
+    uint16_t sent = std::min(num_sdu, buffer.unsent_sdu);
+    num_sdu -= sent;
+    buffer.unsent_sdu -= sent;
+    if (buffer.unsent_sdu > 0) break;
+
+    stats->hal_to_hci.Update(now_us - buffer.read_us);
+    max_l2cap_time_us = std::max(max_l2cap_time_us, now_us - buffer.write_us);
+    l2cap_buffers_.pop_front();
+  }
+  return max_l2cap_time_us;
+}
+
+size_t TxLatencyTracker::UnsentSdu() const {
+  size_t unsent_sdu = 0;
+  for (const L2capBuffer& buffer : l2cap_buffers_)
+    unsent_sdu += buffer.unsent_sdu;
+  return unsent_sdu;
+}
@@ -86,12 +86,17 @@ static const char* CONFIG_LEGACY_FILE_PATH =
     "/data/misc/bluedroid/bt_config.xml";
 #endif  // defined(OS_GENERIC)
 static const uint64_t CONFIG_SETTLE_PERIOD_MS = 3000;
+// The config file is rewritten, and its journal dropped, once the journal has
+// grown past this size.
+static const size_t CONFIG_JOURNAL_COMPACT_SIZE = 64 * 1024;
 
 static void timer_config_save_cb(void* data);
 static void btif_config_write(uint16_t event, char* p_param);
 static bool is_factory_reset(void);
 static void delete_config_files(void);
 static std::unique_ptr<config_t> btif_config_open(const char* filename);
+static bool btif_config_journal_enabled(void);
+static bool btif_config_compact(const config_t& config, bool keep_backup);
 
 // Key attestation
 static bool config_checksum_pass(int check_bit) {
@@ -270,6 +275,11 @@ static alarm_t* config_timer;
 // limited btif config cache capacity
 static BtifConfigCache btif_config_cache(TEMPORARY_SECTION_CAPACITY);
 
+// The config as it is on disk, i.e. the config file with its journal
+// replayed. New changes are journaled relative to it. NULL when the next write
+// has to rewrite the whole file.
+static std::unique_ptr<config_t> btif_config_persisted;
+
 // Module lifecycle functions
 
 static future_t* init(void) {
@@ -310,6 +320,25 @@ static future_t* init(void) {
     file_source = "Empty";
   }
 
+  // Replay the changes journaled since the file was last compacted. If the
+  // file was lost during a compaction, the journal still applies on top of the
+  // backup, which is the file it was journaled against. In NIAP mode the
+  // journal is not covered by the config checksum, so it is not trusted.
+  if (!btif_is_niap_mode() &&
+      (btif_config_source == ORIGINAL || btif_config_source == BACKUP)) {
+    size_t records = config_journal_replay(config.get(), CONFIG_FILE_PATH);
+    if (records > 0) {
+      LOG_INFO(LOG_TAG, "%s replayed %zu journaled config changes", __func__,
+               records);
+    }
+    // After a fallback to the backup, rewrite the file on the next write.
+    if (btif_config_source == ORIGINAL && btif_config_journal_enabled()) {
+      btif_config_persisted = config_new_clone(*config);
+    }
+  } else {
+    config_journal_remove(CONFIG_FILE_PATH);
+  }
+
   // move persistent config data from btif_config file to btif config cache
   btif_config_cache.Init(std::move(config));
 
@@ -357,6 +386,7 @@ static future_t* init(void) {
 error:
   alarm_free(config_timer);
   config.reset();
+  btif_config_persisted.reset();
   btif_config_cache.Clear();
   config_timer = NULL;
   btif_config_source = NOT_LOADED;
@@ -391,6 +421,7 @@ static future_t* clean_up(void) {
   get_bluetooth_keystore_interface()->clear_map();
   MetricIdAllocator::GetInstance().Close();
   btif_config_cache.Clear();
+  btif_config_persisted.reset();
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -584,7 +615,7 @@ bool btif_config_set_bin(const std::string& section, const std::string& key,
   return true;
 }
 
-const std::list<section_t>& btif_config_sections() {
+const section_list_t& btif_config_sections() {
   return btif_config_cache.GetPersistentSections();
 }
 
@@ -618,8 +649,8 @@ bool btif_config_clear(void) {
   std::unique_lock<std::recursive_mutex> lock(config_lock);
 
   btif_config_cache.Clear();
-  bool ret = storage_config_get_interface()->config_save(
-      btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
+  bool ret = btif_config_compact(btif_config_cache.PersistentSectionCopy(),
+                                 false);
   btif_config_source = RESET;
 
   return ret;
@@ -637,15 +668,49 @@ static void btif_config_write(UNUSED_ATTR uint16_t event,
   CHECK(config_timer != NULL);
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
-  rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
-  storage_config_get_interface()->config_save(
-      btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
+  config_t config = btif_config_cache.PersistentSectionCopy();
+  if (btif_config_journal_enabled() && btif_config_persisted &&
+      config_journal_size(CONFIG_FILE_PATH) < CONFIG_JOURNAL_COMPACT_SIZE &&
+      config_journal_append(*btif_config_persisted, config, CONFIG_FILE_PATH)) {
+    *btif_config_persisted = std::move(config);
+    return;
+  }
+
+  btif_config_compact(config, true);
   if (btif_is_niap_mode()) {
     get_bluetooth_keystore_interface()->set_encrypt_key_or_remove_key(
         CONFIG_FILE_PREFIX, CONFIG_FILE_HASH);
   }
 }
 
+// Journaling is off in NIAP mode, where the config checksum only covers the
+// config file, and with the GD stack, which has its own storage.
+static bool btif_config_journal_enabled(void) {
+  return !bluetooth::shim::is_gd_stack_started_up() && !btif_is_niap_mode() &&
+         osi_property_get_bool("persist.bluetooth.config_journal", true);
+}
+
+// Rewrites the config file with |config| and drops the journal. The journal is
+// brought up to date first, so that whichever of the new file or the backup
+// survives a crash, replaying the journal onto it still gives |config|.
+static bool btif_config_compact(const config_t& config, bool keep_backup) {
+  if (btif_config_journal_enabled() && btif_config_persisted) {
+    config_journal_append(*btif_config_persisted, config, CONFIG_FILE_PATH);
+  }
+  btif_config_persisted.reset();
+
+  if (keep_backup) rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
+  if (!storage_config_get_interface()->config_save(config, CONFIG_FILE_PATH)) {
+    return false;
+  }
+
+  if (config_journal_remove(CONFIG_FILE_PATH) &&
+      btif_config_journal_enabled()) {
+    btif_config_persisted = config_new_clone(config);
+  }
+  return true;
+}
+
 void btif_debug_config_dump(int fd) {
   dprintf(fd, "\nBluetooth Config:\n");
 
@@ -680,6 +745,8 @@ void btif_debug_config_dump(int fd) {
           btif_config_cache.GetPersistentSections().size());
   dprintf(fd, "  File created/tagged: %s\n", btif_config_time_created);
   dprintf(fd, "  File source: %s\n", file_source->c_str());
+  dprintf(fd, "  Journal size: %zu bytes\n",
+          config_journal_size(CONFIG_FILE_PATH));
 }
 
 static bool is_factory_reset(void) {
@@ -691,5 +758,6 @@ static bool is_factory_reset(void) {
 static void delete_config_files(void) {
   remove(CONFIG_FILE_PATH);
   remove(CONFIG_BACKUP_PATH);
+  config_journal_remove(CONFIG_FILE_PATH);
   osi_property_set("persist.bluetooth.factoryreset", "false");
 }
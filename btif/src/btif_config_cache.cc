@@ -154,7 +154,7 @@ config_t BtifConfigCache::PersistentSectionCopy() {
   return paired_devices_list_;
 }
 
-const std::list<section_t>& BtifConfigCache::GetPersistentSections() {
+const section_list_t& BtifConfigCache::GetPersistentSections() {
   return paired_devices_list_.sections;
 }
 
@@ -58,6 +58,7 @@
 #include "btif_util.h"
 #include "btu.h"
 #include "common/message_loop_thread.h"
+#include "common/startup_trace.h"
 #include "device/include/controller.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/future.h"
@@ -69,6 +70,7 @@
 using base::PlatformThread;
 using bluetooth::Uuid;
 using bluetooth::common::MessageLoopThread;
+using bluetooth::common::ScopedStartupTrace;
 
 /*******************************************************************************
  *  Constants & Macros
@@ -131,12 +133,15 @@ static uint8_t btif_dut_mode = 0;
 static MessageLoopThread jni_thread("bt_jni_thread");
 static base::AtExitManager* exit_manager;
 static uid_set_t* uid_set;
+// Device ID records parsed while the controller is brought up
+static std::vector<tBTA_DI_RECORD> did_records;
 
 /*******************************************************************************
  *  Static functions
  ******************************************************************************/
 static void btif_jni_associate();
 static void btif_jni_disassociate();
+static void btif_prepare_profiles();
 
 /* sends message to btif task */
 static void btif_sendmsg(void* p_msg);
@@ -270,6 +275,39 @@ void btif_init_ok(UNUSED_ATTR uint16_t event, UNUSED_ATTR char* p_param) {
   BTIF_TRACE_DEBUG("btif_task: received trigger stack init event");
   btif_dm_load_ble_local_keys();
   BTA_EnableBluetooth(bte_dm_evt);
+
+  // The controller is now brought up on the main and module threads. The
+  // enable event comes back to this thread, so what is prepared here while
+  // the controller answers its init commands is done before
+  // btif_enable_bluetooth_evt() runs.
+  btif_prepare_profiles();
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_prepare_profiles
+ *
+ * Description      Sets up the profile state that does not need the
+ *                  controller, ahead of btif_enable_bluetooth_evt().
+ *                  bt_config.conf is already parsed at init. Loading the
+ *                  bonded devices and enabling PAN and the other profiles
+ *                  need BTA DM to be enabled, so they stay after the
+ *                  enable event.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btif_prepare_profiles() {
+  ScopedStartupTrace trace("btif", __func__);
+
+  uid_set = uid_set_create();
+
+  btif_dm_init(uid_set);
+
+  /* init rfcomm & l2cap api */
+  btif_sock_init(uid_set);
+
+  did_records = bte_parse_did_conf(BTE_DID_CONF_FILE);
 }
 
 /*******************************************************************************
@@ -344,6 +382,7 @@ bt_status_t btif_init_bluetooth() {
 
 void btif_enable_bluetooth_evt(tBTA_STATUS status) {
   LOG_INFO(LOG_TAG, "%s entered: status %d", __func__, status);
+  ScopedStartupTrace trace("btif", __func__);
 
   /* Fetch the local BD ADDR */
   RawAddress local_bd_addr = *controller_get_interface()->get_address();
@@ -372,18 +411,12 @@ void btif_enable_bluetooth_evt(tBTA_STATUS status) {
 
   /* callback to HAL */
   if (status == BTA_SUCCESS) {
-    uid_set = uid_set_create();
-
-    btif_dm_init(uid_set);
-
-    /* init rfcomm & l2cap api */
-    btif_sock_init(uid_set);
-
     /* init pan */
     btif_pan_init();
 
-    /* load did configuration */
-    bte_load_did_conf(BTE_DID_CONF_FILE);
+    /* register did records */
+    bte_set_did_records(did_records);
+    did_records.clear();
 
 #ifdef BTIF_DM_OOB_TEST
     btif_dm_load_local_oob();
@@ -396,6 +429,8 @@ void btif_enable_bluetooth_evt(tBTA_STATUS status) {
 
     btif_pan_cleanup();
 
+    did_records.clear();
+
     future_ready(stack_manager_get_hack_future(), FUTURE_FAIL);
   }
 
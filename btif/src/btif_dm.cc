@@ -62,6 +62,7 @@
 #include "btu.h"
 #include "common/metric_id_allocator.h"
 #include "common/metrics.h"
+#include "common/startup_trace.h"
 #include "device/include/controller.h"
 #include "device/include/interop.h"
 #include "internal_include/stack_config.h"
@@ -74,6 +75,7 @@
 
 using bluetooth::Uuid;
 using bluetooth::common::MetricIdAllocator;
+using bluetooth::common::ScopedStartupTrace;
 /******************************************************************************
  *  Constants & Macros
  *****************************************************************************/
@@ -1649,7 +1651,10 @@ static void btif_dm_upstreams_evt(uint16_t event, char* p_param) {
       /* This function will also trigger the adapter_properties_cb
       ** and bonded_devices_info_cb
       */
-      btif_storage_load_bonded_devices();
+      {
+        ScopedStartupTrace trace("btif", "btif_storage_load_bonded_devices");
+        btif_storage_load_bonded_devices();
+      }
       bluetooth::bqr::EnableBtQualityReport(true);
       btif_enable_bluetooth_evt(p_data->enable.status);
     } break;
@@ -27,9 +27,11 @@
 #include "btif_api.h"
 #include "btif_common.h"
 #include "common/message_loop_thread.h"
+#include "common/startup_trace.h"
 #include "device/include/controller.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/semaphore.h"
 
 // Temp includes
@@ -38,6 +40,12 @@
 #include "btif_profile_queue.h"
 
 using bluetooth::common::MessageLoopThread;
+using bluetooth::common::ScopedStartupTrace;
+using bluetooth::common::StartupTrace;
+
+#define STARTUP_TRACE_PATH_PROPERTY "persist.bluetooth.startuptracepath"
+#define DEFAULT_STARTUP_TRACE_PATH \
+  "/data/misc/bluetooth/logs/startup_trace.json"
 
 static MessageLoopThread management_thread("bt_stack_manager_thread");
 
@@ -54,6 +62,7 @@ static void event_clean_up_stack(void* context);
 
 static void event_signal_stack_up(void* context);
 static void event_signal_stack_down(void* context);
+static void write_startup_trace();
 
 // Unvetted includes/imports, etc which should be removed or vetted in the
 // future
@@ -141,6 +150,7 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
     return;
   }
 
+  StartupTrace::GetInstance().Start();
   ensure_stack_is_initialized();
 
   LOG_INFO(LOG_TAG, "%s is bringing up the stack", __func__);
@@ -149,10 +159,21 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
 
   // Include this for now to put btif config into a shutdown-able state
   module_start_up(get_module(BTIF_CONFIG_MODULE));
-  bte_main_enable();
+  {
+    ScopedStartupTrace trace("stack", "bte_main_enable");
+    bte_main_enable();
+  }
+
+  void* stack_up;
+  {
+    ScopedStartupTrace trace("stack", "wait_for_stack_up");
+    stack_up = future_await(local_hack_future);
+  }
+  StartupTrace::GetInstance().Stop();
 
-  if (future_await(local_hack_future) != FUTURE_SUCCESS) {
+  if (stack_up != FUTURE_SUCCESS) {
     LOG_ERROR(LOG_TAG, "%s failed to start up the stack", __func__);
+    write_startup_trace();
     stack_is_running = true;  // So stack shutdown actually happens
     event_shut_down_stack(nullptr);
     return;
@@ -161,6 +182,18 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
   stack_is_running = true;
   LOG_INFO(LOG_TAG, "%s finished", __func__);
   do_in_jni_thread(FROM_HERE, base::Bind(event_signal_stack_up, nullptr));
+  write_startup_trace();
+}
+
+// Saves the startup trace for chrome://tracing or Perfetto
+static void write_startup_trace() {
+  char path[PROPERTY_VALUE_MAX];
+  osi_property_get(STARTUP_TRACE_PATH_PROPERTY, path,
+                   DEFAULT_STARTUP_TRACE_PATH);
+  if (!StartupTrace::GetInstance().WriteChromeTrace(path)) {
+    LOG_WARN(LOG_TAG, "%s unable to write the startup trace to %s", __func__,
+             path);
+  }
 }
 
 // Synchronous function to shut down the stack
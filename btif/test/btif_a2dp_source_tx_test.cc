@@ -0,0 +1,362 @@
+/*
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "btif/include/btif_a2dp_source_tx.h"
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+namespace {
+
+const size_t kInitialLimit = 6;
+const uint64_t kIntervalUs = 20000;
+const uint64_t kWindowUs = TxQueueSizer::kWindowMs * 1000;
+// Ticks of kIntervalUs from the first of a window to the one that ends it
+const size_t kTicksPerWindow = kWindowUs / kIntervalUs + 1;
+
+class TxQueueSizerTest : public ::testing::Test {
+ protected:
+  TxQueueSizerTest() : sizer_(kInitialLimit) {}
+
+  // Run a window of ticks with |buffers_per_tick| buffers each. Returns the
+  // ticks of the window, the last of which ends it.
+  size_t RunWindow(size_t buffers_per_tick) {
+    for (size_t ticks = 1;; ticks++) {
+      for (size_t i = 0; i < buffers_per_tick; i++) sizer_.OnBufferEnqueued();
+      now_us_ += kIntervalUs;
+      if (sizer_.OnTick(now_us_, kIntervalUs, &link_stats_)) return ticks;
+    }
+  }
+
+  TxQueueSizer sizer_;
+  TxLinkStats link_stats_;
+  uint64_t now_us_ = 1000000;
+};
+
+TEST_F(TxQueueSizerTest, starts_with_the_initial_limit) {
+  EXPECT_EQ(sizer_.Limit(), kInitialLimit);
+  EXPECT_EQ(sizer_.Ticks(), TxQueueSizer::kInitialTicks);
+  EXPECT_EQ(sizer_.DropCount(kInitialLimit - 1), 0u);
+}
+
+TEST_F(TxQueueSizerTest, drops_only_the_oldest_buffers_that_do_not_fit) {
+  EXPECT_EQ(sizer_.DropCount(0), 0u);
+  EXPECT_EQ(sizer_.DropCount(kInitialLimit - 1), 0u);
+  EXPECT_EQ(sizer_.DropCount(kInitialLimit), 1u);
+  EXPECT_EQ(sizer_.DropCount(kInitialLimit + 3), 4u);
+}
+
+TEST_F(TxQueueSizerTest, window_ends_after_500_ms) {
+  EXPECT_EQ(RunWindow(1), kTicksPerWindow);
+  EXPECT_EQ(sizer_.LastWindow().ticks, kTicksPerWindow);
+  EXPECT_EQ(sizer_.LastWindow().buffers, kTicksPerWindow);
+
+  // The tick that ends a window starts the next one
+  for (size_t i = 1; i < kTicksPerWindow - 1; i++) {
+    now_us_ += kIntervalUs;
+    EXPECT_FALSE(sizer_.OnTick(now_us_, kIntervalUs, &link_stats_)) << i;
+  }
+  now_us_ += kIntervalUs;
+  EXPECT_TRUE(sizer_.OnTick(now_us_, kIntervalUs, &link_stats_));
+  EXPECT_EQ(sizer_.LastWindow().ticks, kTicksPerWindow - 1);
+  EXPECT_EQ(sizer_.LastWindow().buffers, 0u);
+}
+
+TEST_F(TxQueueSizerTest, late_tick_ends_the_window) {
+  EXPECT_FALSE(sizer_.OnTick(now_us_, kIntervalUs, &link_stats_));
+  EXPECT_FALSE(sizer_.OnTick(now_us_ + kWindowUs - 1, kIntervalUs,
+                             &link_stats_));
+  EXPECT_TRUE(sizer_.OnTick(now_us_ + kWindowUs, kIntervalUs, &link_stats_));
+}
+
+TEST_F(TxQueueSizerTest, limit_follows_the_buffers_per_tick) {
+  RunWindow(2);
+  EXPECT_FALSE(sizer_.LastWindow().congested);
+  EXPECT_EQ(sizer_.Ticks(), TxQueueSizer::kInitialTicks);
+  EXPECT_EQ(sizer_.Limit(), 2 * TxQueueSizer::kInitialTicks);
+  EXPECT_EQ(sizer_.DropCount(2 * TxQueueSizer::kInitialTicks), 1u);
+
+  // A partial buffer per tick counts as a whole one
+  for (size_t i = 0; i < kTicksPerWindow + 1; i++) sizer_.OnBufferEnqueued();
+  RunWindow(0);
+  EXPECT_EQ(sizer_.Limit(), 2 * TxQueueSizer::kInitialTicks);
+}
+
+TEST_F(TxQueueSizerTest, window_without_buffers_keeps_the_limit) {
+  RunWindow(0);
+  EXPECT_EQ(sizer_.Limit(), kInitialLimit);
+}
+
+TEST_F(TxQueueSizerTest, congestion_grows_the_queue_up_to_10_ticks) {
+  for (size_t ticks = TxQueueSizer::kInitialTicks + 1;
+       ticks <= TxQueueSizer::kMaxTicks + 2; ticks++) {
+    sizer_.OnDropout();
+    RunWindow(1);
+    EXPECT_TRUE(sizer_.LastWindow().congested);
+    EXPECT_EQ(sizer_.Ticks(), std::min(ticks, TxQueueSizer::kMaxTicks));
+    EXPECT_EQ(sizer_.Limit(), sizer_.Ticks());
+  }
+  EXPECT_EQ(sizer_.Ticks(), 10u);
+}
+
+TEST_F(TxQueueSizerTest, clean_windows_shrink_the_queue_down_to_2_ticks) {
+  size_t windows = 0;
+  while (sizer_.Ticks() > TxQueueSizer::kMinTicks) {
+    size_t ticks = sizer_.Ticks();
+    for (size_t i = 1; i < TxQueueSizer::kShrinkWindows; i++) {
+      RunWindow(1);
+      EXPECT_EQ(sizer_.Ticks(), ticks);
+    }
+    RunWindow(1);
+    EXPECT_EQ(sizer_.Ticks(), ticks - 1);
+    windows += TxQueueSizer::kShrinkWindows;
+  }
+  EXPECT_EQ(windows, (TxQueueSizer::kInitialTicks - TxQueueSizer::kMinTicks) *
+                         TxQueueSizer::kShrinkWindows);
+
+  for (size_t i = 0; i < 2 * TxQueueSizer::kShrinkWindows; i++) RunWindow(1);
+  EXPECT_EQ(sizer_.Ticks(), 2u);
+  EXPECT_EQ(sizer_.Limit(), 2u);
+}
+
+TEST_F(TxQueueSizerTest, congestion_starts_over_the_clean_windows) {
+  for (size_t i = 1; i < TxQueueSizer::kShrinkWindows; i++) RunWindow(1);
+  link_stats_.OnPacketDropped();
+  RunWindow(1);
+  EXPECT_EQ(sizer_.Ticks(), TxQueueSizer::kInitialTicks + 1);
+  for (size_t i = 1; i < TxQueueSizer::kShrinkWindows; i++) RunWindow(1);
+  EXPECT_EQ(sizer_.Ticks(), TxQueueSizer::kInitialTicks + 1);
+  RunWindow(1);
+  EXPECT_EQ(sizer_.Ticks(), TxQueueSizer::kInitialTicks);
+}
+
+TEST_F(TxQueueSizerTest, link_stats_make_a_window_congested) {
+  RunWindow(1);
+  EXPECT_FALSE(sizer_.LastWindow().congested);
+
+  link_stats_.OnPacketWritten(TxQueueSizer::kCongestedQueue - 1);
+  link_stats_.OnPacketsSent(kIntervalUs);
+  RunWindow(1);
+  EXPECT_FALSE(sizer_.LastWindow().congested);
+
+  link_stats_.OnPacketWritten(TxQueueSizer::kCongestedQueue);
+  link_stats_.OnPacketWritten(0);
+  RunWindow(1);
+  EXPECT_TRUE(sizer_.LastWindow().congested);
+  EXPECT_EQ(sizer_.LastWindow().max_queued, TxQueueSizer::kCongestedQueue);
+  EXPECT_EQ(link_stats_.queued.load(), 0u);
+
+  link_stats_.OnPacketsSent(kIntervalUs + 1);
+  link_stats_.OnPacketsSent(1);
+  RunWindow(1);
+  EXPECT_TRUE(sizer_.LastWindow().congested);
+  EXPECT_EQ(sizer_.LastWindow().max_l2cap_time_us, kIntervalUs + 1);
+
+  // The first read only sets where the counter starts
+  link_stats_.OnFailedContactCounter(7);
+  RunWindow(1);
+  EXPECT_FALSE(sizer_.LastWindow().congested);
+  link_stats_.OnFailedContactCounter(9);
+  RunWindow(1);
+  EXPECT_TRUE(sizer_.LastWindow().congested);
+  EXPECT_EQ(sizer_.LastWindow().failed_contacts, 2u);
+
+  // The counter starts over when the link is reset
+  link_stats_.OnFailedContactCounter(1);
+  RunWindow(1);
+  EXPECT_FALSE(sizer_.LastWindow().congested);
+}
+
+TEST_F(TxQueueSizerTest, reset_starts_over) {
+  sizer_.OnDropout();
+  RunWindow(3);
+  sizer_.OnTick(now_us_ + kIntervalUs, kIntervalUs, &link_stats_);
+  sizer_.Reset();
+  EXPECT_EQ(sizer_.Limit(), kInitialLimit);
+  EXPECT_EQ(sizer_.Ticks(), TxQueueSizer::kInitialTicks);
+  EXPECT_EQ(RunWindow(1), kTicksPerWindow);
+  EXPECT_EQ(sizer_.LastWindow().dropouts, 0u);
+}
+
+class TxLatencyTrackerTest : public ::testing::Test {
+ protected:
+  TxLatencyTracker tracker_;
+  TxLatencyStats stats_;
+};
+
+TEST_F(TxLatencyTrackerTest, follows_a_buffer_down_to_the_controller) {
+  tracker_.OnEnqueued(1000);
+  tracker_.OnReadBuf();
+  EXPECT_EQ(tracker_.TxQueueLength(), 0u);
+  EXPECT_EQ(tracker_.BtaLength(), 1u);
+
+  tracker_.OnWritten(2, 2, 16000, &stats_);
+  EXPECT_EQ(tracker_.BtaLength(), 0u);
+  EXPECT_EQ(tracker_.UnsentSdu(), 2u);
+  EXPECT_EQ(stats_.hal_to_l2cap.count, 1u);
+  EXPECT_EQ(stats_.hal_to_l2cap.max_us, 15000u);
+
+  // The buffer is sent with its last media packet
+  EXPECT_EQ(tracker_.OnSent(1, 20000, &stats_), 0u);
+  EXPECT_EQ(stats_.hal_to_hci.count, 0u);
+  EXPECT_EQ(tracker_.OnSent(1, 41000, &stats_), 25000u);
+  EXPECT_EQ(stats_.hal_to_hci.count, 1u);
+  EXPECT_EQ(stats_.hal_to_hci.max_us, 40000u);
+  EXPECT_EQ(stats_.hal_to_hci.buckets[3], 1u);
+  EXPECT_EQ(tracker_.L2capLength(), 0u);
+}
+
+TEST_F(TxLatencyTrackerTest, buffers_keep_their_order) {
+  for (uint64_t i = 1; i <= 3; i++) tracker_.OnEnqueued(i * 10000);
+  // The oldest buffer is dropped to make room
+  tracker_.OnOldestDropped();
+  tracker_.OnReadBuf();
+  tracker_.OnReadBuf();
+  tracker_.OnWritten(1, 1, 35000, &stats_);
+  tracker_.OnWritten(1, 2, 35000, &stats_);
+  EXPECT_EQ(stats_.hal_to_l2cap.total_us, 15000u + 5000u);
+
+  EXPECT_EQ(tracker_.OnSent(2, 45000, &stats_), 10000u);
+  EXPECT_EQ(stats_.hal_to_hci.total_us, 25000u + 15000u);
+}
+
+TEST_F(TxLatencyTrackerTest, tx_queue_flush_forgets_the_queued_buffers) {
+  tracker_.OnEnqueued(1000);
+  tracker_.OnReadBuf();
+  tracker_.OnEnqueued(2000);
+  tracker_.OnTxQueueFlushed();
+  EXPECT_EQ(tracker_.TxQueueLength(), 0u);
+  EXPECT_EQ(tracker_.BtaLength(), 1u);
+
+  // The buffer BTA took is still followed
+  tracker_.OnWritten(1, 1, 5000, &stats_);
+  EXPECT_EQ(stats_.hal_to_l2cap.total_us, 4000u);
+}
+
+TEST_F(TxLatencyTrackerTest, bta_drop_forgets_the_oldest_buffer) {
+  tracker_.OnEnqueued(1000);
+  tracker_.OnEnqueued(2000);
+  tracker_.OnReadBuf();
+  tracker_.OnReadBuf();
+  tracker_.OnBtaDropped();
+  tracker_.OnWritten(1, 1, 5000, &stats_);
+  EXPECT_EQ(stats_.hal_to_l2cap.total_us, 3000u);
+
+  // Nothing left to drop or write
+  tracker_.OnBtaDropped();
+  tracker_.OnWritten(1, 2, 6000, &stats_);
+  EXPECT_EQ(stats_.hal_to_l2cap.count, 1u);
+  EXPECT_EQ(tracker_.L2capLength(), 1u);
+}
+
+TEST_F(TxLatencyTrackerTest, l2cap_flush_is_not_counted_as_sent) {
+  for (uint64_t i = 1; i <= 3; i++) {
+    tracker_.OnEnqueued(i * 1000);
+    tracker_.OnReadBuf();
+    tracker_.OnWritten(2, 2 * i, 10000, &stats_);
+  }
+  EXPECT_EQ(tracker_.UnsentSdu(), 6u);
+
+  // L2CA_FlushChannel() reports the media packets it drops as sent
+  tracker_.OnL2capFlushed();
+  EXPECT_EQ(tracker_.OnSent(6, 900000, &stats_), 0u);
+  EXPECT_EQ(stats_.hal_to_hci.count, 0u);
+
+  // The buffers written after the flush are followed from scratch
+  tracker_.OnEnqueued(950000);
+  tracker_.OnReadBuf();
+  tracker_.OnWritten(1, 1, 955000, &stats_);
+  EXPECT_EQ(tracker_.OnSent(1, 960000, &stats_), 5000u);
+  EXPECT_EQ(stats_.hal_to_hci.count, 1u);
+  EXPECT_EQ(stats_.hal_to_hci.max_us, 10000u);
+}
+
+TEST_F(TxLatencyTrackerTest, forgets_the_packets_l2cap_no_longer_has) {
+  for (uint64_t i = 1; i <= 3; i++) {
+    tracker_.OnEnqueued(i * 1000);
+    tracker_.OnReadBuf();
+  }
+  tracker_.OnWritten(2, 2, 10000, &stats_);
+  tracker_.OnWritten(2, 4, 11000, &stats_);
+  // L2CAP dropped the 4 media packets without reporting them as sent
+  tracker_.OnWritten(2, 0, 12000, &stats_);
+  EXPECT_EQ(tracker_.L2capLength(), 1u);
+  EXPECT_EQ(tracker_.UnsentSdu(), 2u);
+
+  EXPECT_EQ(tracker_.OnSent(2, 20000, &stats_), 8000u);
+  EXPECT_EQ(stats_.hal_to_hci.count, 1u);
+  EXPECT_EQ(stats_.hal_to_hci.max_us, 17000u);
+
+  // A buffer partly dropped is sent with its remaining packets
+  tracker_.OnEnqueued(30000);
+  tracker_.OnReadBuf();
+  tracker_.OnWritten(3, 3, 31000, &stats_);
+  tracker_.OnEnqueued(32000);
+  tracker_.OnReadBuf();
+  tracker_.OnWritten(1, 2, 33000, &stats_);
+  EXPECT_EQ(tracker_.UnsentSdu(), 3u);
+  EXPECT_EQ(tracker_.OnSent(2, 40000, &stats_), 9000u);
+  EXPECT_EQ(stats_.hal_to_hci.count, 2u);
+  EXPECT_EQ(tracker_.UnsentSdu(), 1u);
+}
+
+TEST_F(TxLatencyTrackerTest, follows_a_bounded_number_of_buffers) {
+  for (size_t i = 0; i < 2 * TxLatencyTracker::kMaxTracked; i++) {
+    tracker_.OnEnqueued(i);
+    tracker_.OnReadBuf();
+  }
+  EXPECT_EQ(tracker_.BtaLength(), TxLatencyTracker::kMaxTracked);
+
+  for (size_t i = 0; i < 2 * TxLatencyTracker::kMaxTracked; i++) {
+    tracker_.OnEnqueued(i);
+    tracker_.OnReadBuf();
+    tracker_.OnWritten(1, UINT16_MAX, 1000000, &stats_);
+  }
+  EXPECT_EQ(tracker_.L2capLength(), TxLatencyTracker::kMaxTracked);
+}
+
+TEST_F(TxLatencyTrackerTest, sent_without_buffers_is_ignored) {
+  EXPECT_EQ(tracker_.OnSent(5, 1000, &stats_), 0u);
+  tracker_.OnReadBuf();
+  tracker_.OnOldestDropped();
+  EXPECT_EQ(tracker_.BtaLength(), 0u);
+  EXPECT_EQ(stats_.hal_to_hci.count, 0u);
+}
+
+TEST(LatencyHistogramTest, buckets_by_upper_bound) {
+  LatencyHistogram histogram;
+  histogram.Update(9999);
+  histogram.Update(10000);
+  histogram.Update(299999);
+  histogram.Update(300000);
+  histogram.Update(5000000);
+  EXPECT_EQ(histogram.buckets[0], 1u);
+  EXPECT_EQ(histogram.buckets[1], 1u);
+  EXPECT_EQ(histogram.buckets[8], 1u);
+  EXPECT_EQ(histogram.buckets[9], 2u);
+  EXPECT_EQ(histogram.count, 5u);
+  EXPECT_EQ(histogram.max_us, 5000000u);
+
+  LatencyHistogram total;
+  total.Update(1000);
+  total.Accumulate(histogram);
+  EXPECT_EQ(total.count, 6u);
+  EXPECT_EQ(total.buckets[0], 2u);
+  EXPECT_EQ(total.total_us, histogram.total_us + 1000);
+}
+
+}  // namespace
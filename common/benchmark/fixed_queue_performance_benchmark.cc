@@ -0,0 +1,150 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "osi/include/fixed_queue.h"
+#include "osi/include/thread.h"
+
+using ::benchmark::State;
+
+#define NUM_MESSAGES_TO_SEND 100000
+#define QUEUE_CAPACITY 1024
+
+namespace {
+
+struct Message {
+  std::chrono::steady_clock::time_point enqueue_time;
+};
+
+struct ConsumerState {
+  int remaining;
+  int64_t total_latency_ns;
+  int64_t max_latency_ns;
+  std::unique_ptr<std::promise<void>> done;
+};
+
+ConsumerState g_consumer;
+
+void consume_message(fixed_queue_t* queue, void* context) {
+  auto message = static_cast<Message*>(fixed_queue_try_dequeue(queue));
+  if (message == nullptr) return;
+
+  int64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() -
+                           message->enqueue_time)
+                           .count();
+  g_consumer.total_latency_ns += latency_ns;
+  if (latency_ns > g_consumer.max_latency_ns)
+    g_consumer.max_latency_ns = latency_ns;
+  if (--g_consumer.remaining == 0) g_consumer.done->set_value();
+}
+
+}  // namespace
+
+// Measures throughput and per-item latency of fixed_queue_t from one or more
+// producers to a single reactor consumer. state.range(0) selects the queue
+// implementation (0: mutex and semaphores, 1: lock-free ring) and
+// state.range(1) is the number of producer threads.
+class BM_FixedQueue : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    bool lockfree = st.range(0) != 0;
+    int producers = st.range(1);
+    queue_ = lockfree ? fixed_queue_new_lockfree(QUEUE_CAPACITY, producers > 1)
+                      : fixed_queue_new(QUEUE_CAPACITY);
+    consumer_thread_ = thread_new("BM_FixedQueue consumer");
+    fixed_queue_register_dequeue(queue_, thread_get_reactor(consumer_thread_),
+                                 consume_message, nullptr);
+    messages_.resize(NUM_MESSAGES_TO_SEND);
+  }
+
+  void TearDown(State& st) override {
+    fixed_queue_unregister_dequeue(queue_);
+    thread_free(consumer_thread_);
+    consumer_thread_ = nullptr;
+    fixed_queue_free(queue_, nullptr);
+    queue_ = nullptr;
+    messages_.clear();
+    g_consumer.done.reset(nullptr);
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  fixed_queue_t* queue_ = nullptr;
+  thread_t* consumer_thread_ = nullptr;
+  std::vector<Message> messages_;
+};
+
+BENCHMARK_DEFINE_F(BM_FixedQueue, throughput)(State& state) {
+  int producers = state.range(1);
+  int64_t total_latency_ns = 0;
+  int64_t max_latency_ns = 0;
+  for (auto _ : state) {
+    g_consumer.remaining = NUM_MESSAGES_TO_SEND;
+    g_consumer.total_latency_ns = 0;
+    g_consumer.max_latency_ns = 0;
+    g_consumer.done = std::make_unique<std::promise<void>>();
+    std::future<void> done_future = g_consumer.done->get_future();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+      threads.emplace_back([this, p, producers]() {
+        for (int i = p; i < NUM_MESSAGES_TO_SEND; i += producers) {
+          messages_[i].enqueue_time = std::chrono::steady_clock::now();
+          fixed_queue_enqueue(queue_, &messages_[i]);
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    done_future.wait();
+
+    total_latency_ns += g_consumer.total_latency_ns;
+    if (g_consumer.max_latency_ns > max_latency_ns)
+      max_latency_ns = g_consumer.max_latency_ns;
+  }
+
+  int64_t items = state.iterations() * NUM_MESSAGES_TO_SEND;
+  state.SetItemsProcessed(items);
+  state.counters["avg_latency_ns"] = static_cast<double>(total_latency_ns) /
+                                     static_cast<double>(items);
+  state.counters["max_latency_ns"] = max_latency_ns;
+};
+
+BENCHMARK_REGISTER_F(BM_FixedQueue, throughput)
+    ->Args({0, 1})
+    ->Args({1, 1})
+    ->Args({0, 4})
+    ->Args({1, 4})
+    ->UseRealTime();
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -19,6 +19,7 @@
 #include <base/threading/thread.h>
 #include <benchmark/benchmark.h>
 #include <future>
+#include <vector>
 
 #include "common/message_loop_thread.h"
 #include "common/once_timer.h"
@@ -46,6 +47,20 @@ int g_task_counter;
 
 void TimerFire(void*) { g_promise->set_value(); }
 
+void AlarmNoop(void*) {}
+
+void AlarmCountDelayedTime(void* data) {
+  auto end_time_us = time_get_os_boottime_us();
+  auto deadline_us = g_start_time + reinterpret_cast<uintptr_t>(data) * 1000;
+  auto delay_ms =
+      end_time_us > deadline_us ? (end_time_us - deadline_us) / 1000 : 0;
+  g_map[delay_ms]++;
+  g_task_counter++;
+  if (g_task_counter >= g_scheduled_tasks) {
+    g_promise->set_value();
+  }
+}
+
 void AlarmSleepAndCountDelayedTime(void*) {
   auto end_time_us = time_get_os_boottime_us();
   auto time_after_start_ms = (end_time_us - g_start_time) / 1000;
@@ -99,6 +114,82 @@ BENCHMARK_REGISTER_F(BM_OsiAlarmTimer, timer_performance_ms)
     ->Iterations(1)
     ->UseManualTime();
 
+// Keeps state.range(0) alarms pending at the same time to measure how the
+// cost of scheduling and canceling grows with the number of pending alarms.
+class BM_OsiConcurrentAlarms : public ::benchmark::Fixture {
+ protected:
+  void SetUp(State& st) override {
+    ::benchmark::Fixture::SetUp(st);
+    for (int i = 0; i < st.range(0); i++) {
+      alarms_.push_back(alarm_new("osi_concurrent_alarm_test"));
+    }
+    g_map.clear();
+    g_promise = std::make_shared<std::promise<void>>();
+    g_scheduled_tasks = 0;
+    g_task_counter = 0;
+  }
+
+  void TearDown(State& st) override {
+    g_promise = nullptr;
+    for (alarm_t* alarm : alarms_) {
+      alarm_free(alarm);
+    }
+    alarms_.clear();
+    ::benchmark::Fixture::TearDown(st);
+  }
+
+  std::vector<alarm_t*> alarms_;
+};
+
+BENCHMARK_DEFINE_F(BM_OsiConcurrentAlarms, set_and_cancel)(State& state) {
+  const size_t count = alarms_.size();
+  for (auto _ : state) {
+    // Spread deadlines far enough in the future that nothing fires while the
+    // benchmark is running, and interleave them so inserts hit the middle.
+    for (size_t i = 0; i < count; i++) {
+      uint64_t interval_ms = 3600000 + ((i * 7919) % count) * 10;
+      alarm_set(alarms_[i], interval_ms, &AlarmNoop, nullptr);
+    }
+    for (size_t i = 0; i < count; i += 2) {
+      alarm_cancel(alarms_[i]);
+    }
+    for (size_t i = 1; i < count; i += 2) {
+      alarm_cancel(alarms_[i]);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * count * 2);
+};
+
+BENCHMARK_REGISTER_F(BM_OsiConcurrentAlarms, set_and_cancel)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->UseRealTime();
+
+BENCHMARK_DEFINE_F(BM_OsiConcurrentAlarms, fire_accuracy)(State& state) {
+  const size_t count = alarms_.size();
+  for (auto _ : state) {
+    g_scheduled_tasks = count;
+    g_start_time = time_get_os_boottime_us();
+    for (size_t i = 0; i < count; i++) {
+      uintptr_t interval_ms = 100 + (i * 7919) % 1000;
+      alarm_set(alarms_[i], interval_ms, &AlarmCountDelayedTime,
+                reinterpret_cast<void*>(interval_ms));
+    }
+    g_promise->get_future().get();
+  }
+  for (const auto& delay : g_map) {
+    state.counters[std::to_string(delay.first)] = delay.second;
+  }
+};
+
+BENCHMARK_REGISTER_F(BM_OsiConcurrentAlarms, fire_accuracy)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Iterations(1)
+    ->UseRealTime();
+
 class BM_AlarmTaskTimer : public ::benchmark::Fixture {
  protected:
   void SetUp(State& st) override {
@@ -0,0 +1,212 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "common/startup_trace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <base/threading/platform_thread.h>
+
+namespace bluetooth {
+
+namespace common {
+
+namespace {
+
+int64_t to_us(StartupTrace::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+std::string json_escape(const std::string& str) {
+  std::string escaped;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+      escaped += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char buf[8];
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      escaped += buf;
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+}  // namespace
+
+StartupTrace& StartupTrace::GetInstance() {
+  static StartupTrace instance;
+  return instance;
+}
+
+void StartupTrace::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  spans_.clear();
+  thread_names_.clear();
+  start_ = Clock::now();
+  stop_ = start_;
+  recording_ = true;
+}
+
+void StartupTrace::Stop() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!recording_) return;
+  stop_ = Clock::now();
+  recording_ = false;
+}
+
+void StartupTrace::AddSpan(const std::string& category, const std::string& name,
+                           Clock::time_point begin, Clock::time_point end) {
+  if (!recording_) return;
+  int thread_id = base::PlatformThread::CurrentId();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!recording_) return;
+  // Work that was already running when the trace started is cut at the start
+  spans_.push_back({category, name, thread_id, std::max(begin, start_),
+                    std::max(end, start_)});
+  if (thread_names_.find(thread_id) == thread_names_.end()) {
+    char thread_name[16] = "";
+    pthread_getname_np(pthread_self(), thread_name, sizeof(thread_name));
+    thread_names_[thread_id] = thread_name;
+  }
+}
+
+std::vector<StartupTrace::Span> StartupTrace::GetSpans() const {
+  std::vector<Span> spans;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    spans = spans_;
+  }
+  // Spans are added when they end, so the enclosing ones come last
+  std::stable_sort(spans.begin(), spans.end(),
+                   [](const Span& a, const Span& b) {
+                     if (a.begin != b.begin) return a.begin < b.begin;
+                     return a.end > b.end;
+                   });
+  return spans;
+}
+
+void StartupTrace::Dump(int fd) const {
+  std::vector<Span> spans = GetSpans();
+  Clock::time_point start, stop;
+  bool recording;
+  std::map<int, std::string> thread_names;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    start = start_;
+    stop = recording_ ? Clock::now() : stop_;
+    recording = recording_;
+    thread_names = thread_names_;
+  }
+
+  dprintf(fd, "\nStack Startup Trace:\n");
+  if (start == Clock::time_point()) {
+    dprintf(fd, "  The stack was not started\n");
+    return;
+  }
+  dprintf(fd, "  Total: %.3f ms%s\n", to_us(stop - start) / 1000.0,
+          recording ? " (in progress)" : "");
+
+  std::map<std::string, std::pair<size_t, int64_t>> categories;
+  for (const Span& span : spans) {
+    auto& category = categories[span.category];
+    category.first++;
+    category.second += to_us(span.end - span.begin);
+  }
+  for (const auto& category : categories) {
+    dprintf(fd, "  %-12s %4zu spans, %10.3f ms\n", category.first.c_str(),
+            category.second.first, category.second.second / 1000.0);
+  }
+
+  dprintf(fd, "  %10s %10s  %-16s %-12s %s\n", "Start(ms)", "Time(ms)",
+          "Thread", "Category", "Name");
+  for (const Span& span : spans) {
+    dprintf(fd, "  %10.3f %10.3f  %-16s %-12s %s\n",
+            to_us(span.begin - start) / 1000.0,
+            to_us(span.end - span.begin) / 1000.0,
+            thread_names[span.thread_id].c_str(), span.category.c_str(),
+            span.name.c_str());
+  }
+}
+
+std::string StartupTrace::ToChromeTraceJson() const {
+  std::vector<Span> spans = GetSpans();
+  Clock::time_point start;
+  std::map<int, std::string> thread_names;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    start = start_;
+    thread_names = thread_names_;
+  }
+
+  int pid = getpid();
+  std::ostringstream json;
+  json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (const auto& thread : thread_names) {
+    json << (first ? "" : ",") << "{\"name\":\"thread_name\",\"ph\":\"M\","
+         << "\"pid\":" << pid << ",\"tid\":" << thread.first
+         << ",\"args\":{\"name\":\"" << json_escape(thread.second) << "\"}}";
+    first = false;
+  }
+  for (const Span& span : spans) {
+    json << (first ? "" : ",") << "{\"name\":\"" << json_escape(span.name)
+         << "\",\"cat\":\"" << json_escape(span.category)
+         << "\",\"ph\":\"X\",\"ts\":" << to_us(span.begin - start)
+         << ",\"dur\":" << to_us(span.end - span.begin) << ",\"pid\":" << pid
+         << ",\"tid\":" << span.thread_id << "}";
+    first = false;
+  }
+  json << "]}\n";
+  return json.str();
+}
+
+bool StartupTrace::WriteChromeTrace(const std::string& path) const {
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file) return false;
+  file << ToChromeTraceJson();
+  return static_cast<bool>(file.flush());
+}
+
+ScopedStartupTrace::ScopedStartupTrace(const std::string& category,
+                                       const std::string& name)
+    : recording_(StartupTrace::GetInstance().IsRecording()) {
+  if (!recording_) return;
+  category_ = category;
+  name_ = name;
+  begin_ = StartupTrace::Clock::now();
+}
+
+ScopedStartupTrace::~ScopedStartupTrace() {
+  if (!recording_) return;
+  StartupTrace::GetInstance().AddSpan(category_, name_, begin_,
+                                      StartupTrace::Clock::now());
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,141 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * Records where the time goes while the stack is brought up: module life
+ * cycle calls, HCI commands and the other steps between the stack manager
+ * starting the stack and reporting it up.
+ *
+ * Spans are only kept between Start() and Stop(), so callers on hot paths
+ * such as the HCI layer can report every span and check IsRecording() first
+ * to skip the work once the stack is up.
+ */
+class StartupTrace {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Span {
+    std::string category;
+    std::string name;
+    int thread_id;
+    Clock::time_point begin;
+    Clock::time_point end;
+  };
+
+  /**
+   * Get the instance of singleton
+   *
+   * @return StartupTrace&
+   */
+  static StartupTrace& GetInstance();
+
+  /**
+   * Drop the previous trace and start recording a new one
+   */
+  void Start();
+
+  /**
+   * Stop recording. The trace is kept until the next Start().
+   */
+  void Stop();
+
+  /**
+   * @return true if spans are recorded
+   */
+  bool IsRecording() const { return recording_; }
+
+  /**
+   * Record a span that ran on the calling thread
+   *
+   * @param category kind of work, e.g. "module" or "hci"
+   * @param name what was done
+   * @param begin when it started
+   * @param end when it finished
+   */
+  void AddSpan(const std::string& category, const std::string& name,
+               Clock::time_point begin, Clock::time_point end);
+
+  /**
+   * @return the recorded spans, ordered by their beginning
+   */
+  std::vector<Span> GetSpans() const;
+
+  /**
+   * Write the trace as a table for dumpsys
+   *
+   * @param fd file descriptor to write to
+   */
+  void Dump(int fd) const;
+
+  /**
+   * @return the trace in the Chrome trace event JSON format, which
+   * chrome://tracing and Perfetto can open
+   */
+  std::string ToChromeTraceJson() const;
+
+  /**
+   * Write ToChromeTraceJson() to a file, replacing it
+   *
+   * @param path file to write
+   * @return true on success
+   */
+  bool WriteChromeTrace(const std::string& path) const;
+
+ private:
+  StartupTrace() = default;
+
+  mutable std::mutex mutex_;
+  std::atomic<bool> recording_{false};
+  Clock::time_point start_;
+  Clock::time_point stop_;
+  std::vector<Span> spans_;
+  std::map<int, std::string> thread_names_;
+};
+
+/**
+ * Records a span covering its own lifetime on the calling thread
+ */
+class ScopedStartupTrace {
+ public:
+  ScopedStartupTrace(const std::string& category, const std::string& name);
+  ~ScopedStartupTrace();
+
+ private:
+  std::string category_;
+  std::string name_;
+  StartupTrace::Clock::time_point begin_;
+  bool recording_;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,127 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+#include "common/startup_trace.h"
+
+using bluetooth::common::ScopedStartupTrace;
+using bluetooth::common::StartupTrace;
+
+class StartupTraceTest : public ::testing::Test {
+ protected:
+  void TearDown() override { StartupTrace::GetInstance().Stop(); }
+
+  StartupTrace& trace_ = StartupTrace::GetInstance();
+};
+
+TEST_F(StartupTraceTest, spans_are_dropped_when_not_recording) {
+  trace_.Start();
+  trace_.Stop();
+  { ScopedStartupTrace scoped("module", "late_module"); }
+  auto now = StartupTrace::Clock::now();
+  trace_.AddSpan("hci", "HCI 0x0c03", now, now);
+  EXPECT_TRUE(trace_.GetSpans().empty());
+}
+
+TEST_F(StartupTraceTest, scoped_trace_records_span) {
+  trace_.Start();
+  {
+    ScopedStartupTrace scoped("module", "hci_module");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  auto spans = trace_.GetSpans();
+  ASSERT_EQ(1u, spans.size());
+  EXPECT_EQ("module", spans[0].category);
+  EXPECT_EQ("hci_module", spans[0].name);
+  EXPECT_GE(spans[0].end - spans[0].begin, std::chrono::milliseconds(2));
+}
+
+TEST_F(StartupTraceTest, start_drops_previous_trace) {
+  trace_.Start();
+  { ScopedStartupTrace scoped("module", "first_run"); }
+  trace_.Stop();
+  EXPECT_EQ(1u, trace_.GetSpans().size());
+  trace_.Start();
+  EXPECT_TRUE(trace_.GetSpans().empty());
+}
+
+TEST_F(StartupTraceTest, spans_are_ordered_by_beginning) {
+  trace_.Start();
+  {
+    ScopedStartupTrace outer("stack", "outer");
+    { ScopedStartupTrace inner("module", "inner"); }
+    std::thread([] {
+      ScopedStartupTrace other("module", "other_thread");
+    }).join();
+  }
+  auto spans = trace_.GetSpans();
+  ASSERT_EQ(3u, spans.size());
+  EXPECT_EQ("outer", spans[0].name);
+  EXPECT_EQ("inner", spans[1].name);
+  EXPECT_EQ("other_thread", spans[2].name);
+  EXPECT_EQ(spans[0].thread_id, spans[1].thread_id);
+  EXPECT_NE(spans[0].thread_id, spans[2].thread_id);
+}
+
+TEST_F(StartupTraceTest, span_begun_before_start_is_cut_at_start) {
+  auto before = StartupTrace::Clock::now();
+  trace_.Start();
+  trace_.AddSpan("hci", "HCI 0x0c03", before, StartupTrace::Clock::now());
+  auto spans = trace_.GetSpans();
+  ASSERT_EQ(1u, spans.size());
+  EXPECT_GE(spans[0].begin, before);
+  EXPECT_LE(spans[0].begin, spans[0].end);
+}
+
+TEST_F(StartupTraceTest, chrome_trace_json) {
+  trace_.Start();
+  { ScopedStartupTrace scoped("module", "name with \"quotes\""); }
+  trace_.Stop();
+  std::string json = trace_.ToChromeTraceJson();
+  EXPECT_EQ(0u, json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, json.find("\"ph\":\"M\""));
+  EXPECT_NE(std::string::npos,
+            json.find("{\"name\":\"name with \\\"quotes\\\"\","
+                      "\"cat\":\"module\",\"ph\":\"X\",\"ts\":"));
+  EXPECT_EQ("]}\n", json.substr(json.size() - 3));
+}
+
+TEST_F(StartupTraceTest, dump) {
+  trace_.Start();
+  { ScopedStartupTrace scoped("module", "btif_config_module"); }
+  trace_.Stop();
+
+  FILE* file = tmpfile();
+  ASSERT_NE(nullptr, file);
+  trace_.Dump(fileno(file));
+  std::string dump(4096, '\0');
+  rewind(file);
+  dump.resize(fread(&dump[0], 1, dump.size(), file));
+  fclose(file);
+
+  EXPECT_NE(std::string::npos, dump.find("Stack Startup Trace:"));
+  EXPECT_NE(std::string::npos, dump.find("Total: "));
+  EXPECT_NE(std::string::npos, dump.find("btif_config_module"));
+  EXPECT_EQ(std::string::npos, dump.find("in progress"));
+}
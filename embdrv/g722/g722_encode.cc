@@ -32,6 +32,12 @@
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #if !defined(FALSE)
 #define FALSE 0
 #endif
@@ -259,17 +265,91 @@ static int16_t qm2[4] =
 {
     -7408,  -1616,   7408,   1616
 };
-static int16_t qmf_coeffs[12] =
+/* The transmit QMF coefficients
+       3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11
+   over the 24 most recent samples, oldest first: coefficient i on sample 2*i
+   and coefficient 11 - i on sample 2*i + 1, the two sums being added for the
+   low band and subtracted for the high band. */
+static const int16_t qmf_sum[24] =
 {
-       3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
+       3,  -11,  -11,   53,   12, -156,   32,  362, -210, -805,  951, 3876,
+    3876,  951, -805, -210,  362,   32, -156,   12,   53,  -11,  -11,    3,
+};
+static const int16_t qmf_diff[24] =
+{
+      -3,  -11,   11,   53,  -12, -156,  -32,  362,  210, -805, -951, 3876,
+   -3876,  951,  805, -210, -362,   32,  156,   12,  -53,  -11,   11,    3,
 };
 static int16_t ihn[3] = {0, 1, 0};
 static int16_t ihp[3] = {0, 3, 2};
 static int16_t wh[3] = {0, -214, 798};
 static int16_t rh2[4] = {2, 1, 2, 1};
 
-int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
-                       const int16_t amp[], int len)
+/* Sample pairs run through the transmit QMF per copy of the signal history */
+#define QMF_BLOCK_PAIRS 64
+
+/* Apply the transmit QMF to the 24 samples at x, oldest first, and discard
+   every other output */
+static __inline void qmf_transmit(const int16_t *x, int *xlow, int *xhigh)
+{
+#if defined(__SSE2__)
+    __m128i sum;
+    __m128i diff;
+    __m128i v;
+    int i;
+
+    sum = _mm_setzero_si128();
+    diff = _mm_setzero_si128();
+    for (i = 0;  i < 24;  i += 8)
+    {
+        v = _mm_loadu_si128((const __m128i *) (x + i));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(v,
+                  _mm_loadu_si128((const __m128i *) (qmf_sum + i))));
+        diff = _mm_add_epi32(diff, _mm_madd_epi16(v,
+                   _mm_loadu_si128((const __m128i *) (qmf_diff + i))));
+    }
+    v = _mm_add_epi32(_mm_unpacklo_epi64(sum, diff),
+                      _mm_unpackhi_epi64(sum, diff));
+    v = _mm_add_epi32(v, _mm_srli_epi64(v, 32));
+    *xlow = _mm_cvtsi128_si32(v) >> 14;
+    *xhigh = _mm_cvtsi128_si32(_mm_unpackhi_epi64(v, v)) >> 14;
+#elif defined(__aarch64__)
+    int32x4_t sum;
+    int32x4_t diff;
+    int16x8_t v;
+    int i;
+
+    sum = vdupq_n_s32(0);
+    diff = vdupq_n_s32(0);
+    for (i = 0;  i < 24;  i += 8)
+    {
+        v = vld1q_s16(x + i);
+        sum = vmlal_s16(sum, vget_low_s16(v), vld1_s16(qmf_sum + i));
+        sum = vmlal_s16(sum, vget_high_s16(v), vld1_s16(qmf_sum + i + 4));
+        diff = vmlal_s16(diff, vget_low_s16(v), vld1_s16(qmf_diff + i));
+        diff = vmlal_s16(diff, vget_high_s16(v), vld1_s16(qmf_diff + i + 4));
+    }
+    *xlow = vaddvq_s32(sum) >> 14;
+    *xhigh = vaddvq_s32(diff) >> 14;
+#else
+    int sum;
+    int diff;
+    int i;
+
+    sum = 0;
+    diff = 0;
+    for (i = 0;  i < 24;  i++)
+    {
+        sum += x[i]*qmf_sum[i];
+        diff += x[i]*qmf_diff[i];
+    }
+    *xlow = sum >> 14;
+    *xhigh = diff >> 14;
+#endif
+}
+/*- End of function --------------------------------------------------------*/
+
+static __inline int encode_sample(g722_encode_state_t *s, int xlow, int xhigh)
 {
     int dlow;
     int dhigh;
@@ -284,153 +364,183 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
     int eh;
     int mih;
     int i;
-    int j;
-    /* Low and high band PCM from the QMF */
-    int xlow;
-    int xhigh;
-    int g722_bytes;
-    /* Even and odd tap accumulators */
-    int sumeven;
-    int sumodd;
+    int lo;
+    int hi;
+    int det;
     int ihigh;
     int ilow;
     int code;
 
-    g722_bytes = 0;
-    xhigh = 0;
-    for (j = 0;  j < len;  )
-    {
-        if (s->itu_test_mode)
-        {
-            xlow =
-            xhigh = amp[j++] >> 1;
-        }
-        else
-        {
-            {
-                /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                //TODO: if len is odd, then this can be a buffer overrun
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
-    
-                /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
-                {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
-                }
-                /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
-                   to allow for us summing two filters, plus 1 to allow for the 15 bit
-                   input to the G.722 algorithm. */
-                xlow = (sumeven + sumodd) >> 14;
-                xhigh = (sumeven - sumodd) >> 14;
-
 #ifdef RUN_LIKE_REFERENCE_G722
-                /* The following lines are only used to verify bit-exactness
-                 * with reference implementation of G.722. Higher precision
-                 * is achieved without limiting the values.
-                 */
-                xlow = limitValues(xlow);
-                xhigh = limitValues(xhigh);
+    /* The following lines are only used to verify bit-exactness
+     * with reference implementation of G.722. Higher precision
+     * is achieved without limiting the values.
+     */
+    xlow = limitValues(xlow);
+    xhigh = limitValues(xhigh);
 #endif
-            }
-        }
-        /* Block 1L, SUBTRA */
-        el = saturate(xlow - s->band[0].s);
 
-        /* Block 1L, QUANTL */
-        wd = (el >= 0)  ?  el  :  -(el + 1);
+    /* Block 1L, SUBTRA */
+    el = saturate(xlow - s->band[0].s);
 
-        for (i = 1;  i < 30;  i++)
-        {
-            wd1 = (q6[i]*s->band[0].det) >> 12;
-            if (wd < wd1)
-                break;
-        }
-        ilow = (el < 0)  ?  iln[i]  :  ilp[i];
-
-        /* Block 2L, INVQAL */
-        ril = ilow >> 2;
-        wd2 = qm4[ril];
-        dlow = (s->band[0].det*wd2) >> 15;
-
-        /* Block 3L, LOGSCL */
-        il4 = rl42[ril];
-        wd = (s->band[0].nb*127) >> 7;
-        s->band[0].nb = wd + wl[il4];
-        if (s->band[0].nb < 0)
-            s->band[0].nb = 0;
-        else if (s->band[0].nb > 18432)
-            s->band[0].nb = 18432;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
+    /* Block 1L, QUANTL */
+    wd = (el >= 0)  ?  el  :  -(el + 1);
+
+    /* The thresholds (q6[i]*det) >> 12 only grow with i, so look for the
+       first one above wd, or 30 if there is none, by bisection */
+    det = s->band[0].det;
+    lo = 1;
+    hi = 30;
+    while (lo < hi)
+    {
+        i = (lo + hi) >> 1;
+        wd1 = (q6[i]*det) >> 12;
+        if (wd < wd1)
+            hi = i;
+        else
+            lo = i + 1;
+    }
+    i = lo;
+    ilow = (el < 0)  ?  iln[i]  :  ilp[i];
+
+    /* Block 2L, INVQAL */
+    ril = ilow >> 2;
+    wd2 = qm4[ril];
+    dlow = (s->band[0].det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    il4 = rl42[ril];
+    wd = (s->band[0].nb*127) >> 7;
+    s->band[0].nb = wd + wl[il4];
+    if (s->band[0].nb < 0)
+        s->band[0].nb = 0;
+    else if (s->band[0].nb > 18432)
+        s->band[0].nb = 18432;
+
+    /* Block 3L, SCALEL */
+    wd1 = (s->band[0].nb >> 6) & 31;
+    wd2 = 8 - (s->band[0].nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    s->band[0].det = wd3 << 2;
+
+    block4(&s->band[0], dlow);
+    {
+        int nb;
+
+        /* Block 1H, SUBTRA */
+        eh = saturate(xhigh - s->band[1].s);
+
+        /* Block 1H, QUANTH */
+        wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+        wd1 = (564*s->band[1].det) >> 12;
+        mih = (wd >= wd1)  ?  2  :  1;
+        ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
+
+        /* Block 2H, INVQAH */
+        wd2 = qm2[ihigh];
+        dhigh = (s->band[1].det*wd2) >> 15;
+
+        /* Block 3H, LOGSCH */
+        ih2 = rh2[ihigh];
+        wd = (s->band[1].nb*127) >> 7;
+
+        nb = wd + wh[ih2];
+        if (nb < 0)
+            nb = 0;
+        else if (nb > 22528)
+            nb = 22528;
+        s->band[1].nb = nb;
+
+        /* Block 3H, SCALEH */
+        wd1 = (s->band[1].nb >> 6) & 31;
+        wd2 = 10 - (s->band[1].nb >> 11);
         wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
+        s->band[1].det = wd3 << 2;
 
-        block4(&s->band[0], dlow);
-        {
-	    int nb;
-
-            /* Block 1H, SUBTRA */
-            eh = saturate(xhigh - s->band[1].s);
-
-            /* Block 1H, QUANTH */
-            wd = (eh >= 0)  ?  eh  :  -(eh + 1);
-            wd1 = (564*s->band[1].det) >> 12;
-            mih = (wd >= wd1)  ?  2  :  1;
-            ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
-
-            /* Block 2H, INVQAH */
-            wd2 = qm2[ihigh];
-            dhigh = (s->band[1].det*wd2) >> 15;
-
-            /* Block 3H, LOGSCH */
-            ih2 = rh2[ihigh];
-            wd = (s->band[1].nb*127) >> 7;
-
-            nb = wd + wh[ih2];
-            if (nb < 0)
-                nb = 0;
-            else if (nb > 22528)
-                nb = 22528;
-	    s->band[1].nb = nb;
-
-            /* Block 3H, SCALEH */
-            wd1 = (s->band[1].nb >> 6) & 31;
-            wd2 = 10 - (s->band[1].nb >> 11);
-            wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-            s->band[1].det = wd3 << 2;
-
-            block4(&s->band[1], dhigh);
+        block4(&s->band[1], dhigh);
 #if   BITS_PER_SAMPLE == 8
-            code = ((ihigh << 6) | ilow);
+        code = ((ihigh << 6) | ilow);
 #elif BITS_PER_SAMPLE == 7
-            code = ((ihigh << 6) | ilow) >> 1;
+        code = ((ihigh << 6) | ilow) >> 1;
 #elif BITS_PER_SAMPLE == 6
-            code = ((ihigh << 6) | ilow) >> 2;
+        code = ((ihigh << 6) | ilow) >> 2;
 #endif
-        }
+    }
+    return code;
+}
+/*- End of function --------------------------------------------------------*/
 
+static __inline int put_code(g722_encode_state_t *s, uint8_t g722_data[],
+                             int g722_bytes, int code)
+{
 #if PACKED_OUTPUT == 1
-            /* Pack the code bits */
-            s->out_buffer |= (code << s->out_bits);
-            s->out_bits += s->bits_per_sample;
-            if (s->out_bits >= 8)
-            {
-                g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
-                s->out_bits -= 8;
-                s->out_buffer >>= 8;
-            }
+    /* Pack the code bits */
+    s->out_buffer |= (code << s->out_bits);
+    s->out_bits += s->bits_per_sample;
+    if (s->out_bits >= 8)
+    {
+        g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
+        s->out_bits -= 8;
+        s->out_buffer >>= 8;
+    }
 #else
-            g722_data[g722_bytes++] = (uint8_t) code;
+    g722_data[g722_bytes++] = (uint8_t) code;
 #endif
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
+
+int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
+                       const int16_t amp[], int len)
+{
+    /* The 22 most recent samples of the QMF history, then the input samples
+       of the current block */
+    int16_t x[22 + 2*QMF_BLOCK_PAIRS];
+    /* Low and high band PCM from the QMF */
+    int xlow;
+    int xhigh;
+    int g722_bytes;
+    int pairs;
+    int i;
+    int j;
+
+    g722_bytes = 0;
+    if (s->itu_test_mode)
+    {
+        for (j = 0;  j < len;  j++)
+        {
+            xlow =
+            xhigh = amp[j] >> 1;
+            g722_bytes = put_code(s, g722_data, g722_bytes,
+                                  encode_sample(s, xlow, xhigh));
+        }
+        return g722_bytes;
+    }
+
+    /* The QMF consumes the samples two at a time; an odd last sample is
+       dropped. Rather than shuffling the history down for every pair, run the
+       filter along a copy of the history followed by a block of input. */
+    for (i = 0;  i < 22;  i++)
+        x[i] = (int16_t) s->x[i + 2];
+    for (j = 0;  len - j >= 2;  j += 2*pairs)
+    {
+        pairs = (len - j)/2;
+        if (pairs > QMF_BLOCK_PAIRS)
+            pairs = QMF_BLOCK_PAIRS;
+        memcpy(x + 22, amp + j, 2*pairs*sizeof(x[0]));
+        for (i = 0;  i < pairs;  i++)
+        {
+            /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
+               to allow for us summing two filters, plus 1 to allow for the 15 bit
+               input to the G.722 algorithm. */
+            qmf_transmit(x + 2*i, &xlow, &xhigh);
+            g722_bytes = put_code(s, g722_data, g722_bytes,
+                                  encode_sample(s, xlow, xhigh));
+        }
+        /* Keep the history for the next block and the next call */
+        for (i = 0;  i < 24;  i++)
+            s->x[i] = x[2*pairs - 2 + i];
+        memmove(x, x + 2*pairs, 22*sizeof(x[0]));
     }
     return g722_bytes;
 }
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <string.h>
+
+#include <vector>
+
+#include "g722_enc_dec.h"
+
+namespace {
+
+// The encoder as it was before the block QMF, the SIMD taps and the
+// bisecting quantizer: the history shifted for every pair of samples, the
+// QMF taps applied one by one and the low band thresholds scanned linearly.
+namespace reference {
+
+const int q6[32] = {0,    35,   72,   110,  150,  190,  233,  276,
+                    323,  370,  422,  473,  530,  587,  650,  714,
+                    786,  858,  940,  1023, 1121, 1219, 1339, 1458,
+                    1612, 1765, 1980, 2195, 2557, 2919, 0,    0};
+const int iln[32] = {0,  63, 62, 31, 30, 29, 28, 27, 26, 25, 24,
+                     23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13,
+                     12, 11, 10, 9,  8,  7,  6,  5,  4,  0};
+const int ilp[32] = {0,  61, 60, 59, 58, 57, 56, 55, 54, 53, 52,
+                     51, 50, 49, 48, 47, 46, 45, 44, 43, 42, 41,
+                     40, 39, 38, 37, 36, 35, 34, 33, 32, 0};
+const int wl[8] = {-60, -30, 58, 172, 334, 538, 1198, 3042};
+const int rl42[16] = {0, 7, 6, 5, 4, 3, 2, 1, 7, 6, 5, 4, 3, 2, 1, 0};
+const int ilb[32] = {2048, 2093, 2139, 2186, 2233, 2282, 2332, 2383,
+                     2435, 2489, 2543, 2599, 2656, 2714, 2774, 2834,
+                     2896, 2960, 3025, 3091, 3158, 3228, 3298, 3371,
+                     3444, 3520, 3597, 3676, 3756, 3838, 3922, 4008};
+const int qm4[16] = {0,     -20456, -12896, -8968, -6288, -4240,
+                     -2584, -1200,  20456,  12896, 8968,  6288,
+                     4240,  2584,   1200,   0};
+const int qm2[4] = {-7408, -1616, 7408, 1616};
+const int qmf_coeffs[12] = {3,   -11, 12,  32,   -210, 951,
+                            3876, -805, 362, -156, 53,   -11};
+const int ihn[3] = {0, 1, 0};
+const int ihp[3] = {0, 3, 2};
+const int wh[3] = {0, -214, 798};
+const int rh2[4] = {2, 1, 2, 1};
+
+int16_t saturate(int32_t amp) {
+  if (amp > 0x7FFF) return 0x7FFF;
+  if (amp < -0x8000) return -0x8000;
+  return amp;
+}
+
+void block4(g722_band_t* band, int d) {
+  int sg[7];
+
+  band->d[0] = d;
+  band->r[0] = saturate(band->s + d);
+  band->p[0] = saturate(band->sz + d);
+
+  for (int i = 0; i < 3; i++) sg[i] = band->p[i] >> 15;
+  int wd1 = saturate(band->a[1] << 2);
+  int wd2 = (sg[0] == sg[1]) ? -wd1 : wd1;
+  if (wd2 > 32767) wd2 = 32767;
+  int wd3 = (sg[0] == sg[2]) ? 128 : -128;
+  wd3 += (wd2 >> 7);
+  wd3 += (band->a[2] * 32512) >> 15;
+  if (wd3 > 12288) wd3 = 12288;
+  if (wd3 < -12288) wd3 = -12288;
+  band->ap[2] = wd3;
+
+  sg[0] = band->p[0] >> 15;
+  sg[1] = band->p[1] >> 15;
+  wd1 = (sg[0] == sg[1]) ? 192 : -192;
+  wd2 = (band->a[1] * 32640) >> 15;
+  band->ap[1] = saturate(wd1 + wd2);
+  wd3 = saturate(15360 - band->ap[2]);
+  if (band->ap[1] > wd3) band->ap[1] = wd3;
+  if (band->ap[1] < -wd3) band->ap[1] = -wd3;
+
+  wd1 = (d == 0) ? 0 : 128;
+  sg[0] = d >> 15;
+  for (int i = 1; i < 7; i++) {
+    sg[i] = band->d[i] >> 15;
+    wd2 = (sg[i] == sg[0]) ? wd1 : -wd1;
+    wd3 = (band->b[i] * 32640) >> 15;
+    band->bp[i] = saturate(wd2 + wd3);
+  }
+
+  for (int i = 6; i > 0; i--) {
+    band->d[i] = band->d[i - 1];
+    band->b[i] = band->bp[i];
+  }
+  for (int i = 2; i > 0; i--) {
+    band->r[i] = band->r[i - 1];
+    band->p[i] = band->p[i - 1];
+    band->a[i] = band->ap[i];
+  }
+
+  wd1 = saturate(band->r[1] + band->r[1]);
+  wd1 = (band->a[1] * wd1) >> 15;
+  wd2 = saturate(band->r[2] + band->r[2]);
+  wd2 = (band->a[2] * wd2) >> 15;
+  band->sp = saturate(wd1 + wd2);
+
+  band->sz = 0;
+  for (int i = 6; i > 0; i--) {
+    wd1 = saturate(band->d[i] + band->d[i]);
+    band->sz += (band->b[i] * wd1) >> 15;
+  }
+  band->s = saturate(band->sp + band->sz);
+}
+
+uint8_t encode_sample(g722_encode_state_t* s, int xlow, int xhigh) {
+  int el = saturate(xlow - s->band[0].s);
+  int wd = (el >= 0) ? el : -(el + 1);
+  int i;
+  for (i = 1; i < 30; i++) {
+    if (wd < ((q6[i] * s->band[0].det) >> 12)) break;
+  }
+  int ilow = (el < 0) ? iln[i] : ilp[i];
+
+  int ril = ilow >> 2;
+  int dlow = (s->band[0].det * qm4[ril]) >> 15;
+  wd = (s->band[0].nb * 127) >> 7;
+  s->band[0].nb = wd + wl[rl42[ril]];
+  if (s->band[0].nb < 0) s->band[0].nb = 0;
+  if (s->band[0].nb > 18432) s->band[0].nb = 18432;
+  int wd1 = (s->band[0].nb >> 6) & 31;
+  int wd2 = 8 - (s->band[0].nb >> 11);
+  int wd3 = (wd2 < 0) ? (ilb[wd1] << -wd2) : (ilb[wd1] >> wd2);
+  s->band[0].det = wd3 << 2;
+  block4(&s->band[0], dlow);
+
+  int eh = saturate(xhigh - s->band[1].s);
+  wd = (eh >= 0) ? eh : -(eh + 1);
+  int mih = (wd >= ((564 * s->band[1].det) >> 12)) ? 2 : 1;
+  int ihigh = (eh < 0) ? ihn[mih] : ihp[mih];
+
+  int dhigh = (s->band[1].det * qm2[ihigh]) >> 15;
+  wd = (s->band[1].nb * 127) >> 7;
+  s->band[1].nb = wd + wh[rh2[ihigh]];
+  if (s->band[1].nb < 0) s->band[1].nb = 0;
+  if (s->band[1].nb > 22528) s->band[1].nb = 22528;
+  wd1 = (s->band[1].nb >> 6) & 31;
+  wd2 = 10 - (s->band[1].nb >> 11);
+  wd3 = (wd2 < 0) ? (ilb[wd1] << -wd2) : (ilb[wd1] >> wd2);
+  s->band[1].det = wd3 << 2;
+  block4(&s->band[1], dhigh);
+
+  return (ihigh << 6) | ilow;
+}
+
+// An odd last sample is dropped, as g722_encode() does
+int encode(g722_encode_state_t* s, uint8_t* g722_data, const int16_t* amp,
+           int len) {
+  int g722_bytes = 0;
+  if (s->itu_test_mode) {
+    for (int j = 0; j < len; j++) {
+      g722_data[g722_bytes++] = encode_sample(s, amp[j] >> 1, amp[j] >> 1);
+    }
+    return g722_bytes;
+  }
+  for (int j = 0; j + 2 <= len; j += 2) {
+    for (int i = 0; i < 22; i++) s->x[i] = s->x[i + 2];
+    s->x[22] = amp[j];
+    s->x[23] = amp[j + 1];
+    int sumeven = 0;
+    int sumodd = 0;
+    for (int i = 0; i < 12; i++) {
+      sumodd += s->x[2 * i] * qmf_coeffs[i];
+      sumeven += s->x[2 * i + 1] * qmf_coeffs[11 - i];
+    }
+    g722_data[g722_bytes++] = encode_sample(s, (sumeven + sumodd) >> 14,
+                                            (sumeven - sumodd) >> 14);
+  }
+  return g722_bytes;
+}
+
+}  // namespace reference
+
+// Noise over the whole range, full scale square waves, tones and silence
+std::vector<int16_t> make_pcm(size_t num_samples) {
+  std::vector<int16_t> pcm(num_samples);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < pcm.size(); i++) {
+    seed = seed * 1103515245 + 12345;
+    int16_t noise = static_cast<int16_t>(seed >> 16);
+    switch ((i / 700) % 5) {
+      case 0:
+        pcm[i] = noise;
+        break;
+      case 1:
+        pcm[i] = ((i / 3) & 1) ? 32767 : -32768;
+        break;
+      case 2:
+        pcm[i] = (noise & 1) ? 32767 : -32768;
+        break;
+      case 3:
+        pcm[i] = 32767 * sin(0.3 * i);
+        break;
+      default:
+        pcm[i] = 0;
+        break;
+    }
+  }
+  return pcm;
+}
+
+// Encodes |pcm| in calls of the given sizes with both encoders, checking the
+// output and the state after every call.
+void expect_same_encoding(const std::vector<int16_t>& pcm,
+                          const std::vector<size_t>& call_sizes,
+                          bool itu_test_mode) {
+  g722_encode_state_t state;
+  g722_encode_state_t reference_state;
+  g722_encode_init(&state, 64000, G722_PACKED);
+  g722_encode_init(&reference_state, 64000, G722_PACKED);
+  state.itu_test_mode = itu_test_mode;
+  reference_state.itu_test_mode = itu_test_mode;
+
+  size_t offset = 0;
+  for (size_t call_size : call_sizes) {
+    ASSERT_LE(offset + call_size, pcm.size());
+    SCOPED_TRACE(testing::Message() << "offset " << offset << " size "
+                                    << call_size);
+    std::vector<uint8_t> out(call_size + 1, 0xAA);
+    std::vector<uint8_t> expected(call_size + 1, 0xAA);
+    int length = g722_encode(&state, out.data(), &pcm[offset], call_size);
+    int expected_length = reference::encode(
+        &reference_state, expected.data(), &pcm[offset], call_size);
+    ASSERT_EQ(expected_length, length);
+    ASSERT_EQ(expected, out);
+    ASSERT_EQ(0, memcmp(&reference_state, &state, sizeof(state)));
+    offset += call_size;
+  }
+}
+
+}  // namespace
+
+TEST(G722EncodeTest, matches_reference_in_one_call) {
+  std::vector<int16_t> pcm = make_pcm(7000);
+  expect_same_encoding(pcm, {pcm.size()}, false);
+}
+
+TEST(G722EncodeTest, matches_reference_across_calls) {
+  // Sizes around the 64 pair blocks of the QMF, so that the history is
+  // carried both between blocks and between calls
+  std::vector<size_t> call_sizes = {0, 2, 126, 128, 130, 256, 258, 320, 4, 160};
+  size_t total = 0;
+  for (size_t call_size : call_sizes) total += call_size;
+  expect_same_encoding(make_pcm(total), call_sizes, false);
+}
+
+TEST(G722EncodeTest, matches_reference_at_full_scale) {
+  for (int16_t level : {32767, -32768}) {
+    SCOPED_TRACE(testing::Message() << "level " << level);
+    std::vector<int16_t> pcm(2000, level);
+    expect_same_encoding(pcm, {pcm.size()}, false);
+  }
+}
+
+TEST(G722EncodeTest, odd_last_sample_is_dropped) {
+  std::vector<int16_t> pcm = make_pcm(1000);
+  // Each call encodes all but its last sample, and the next call carries on
+  // from the sample after it, as the reference does.
+  expect_same_encoding(pcm, {1, 3, 127, 129, 255, 5}, false);
+
+  g722_encode_state_t state;
+  g722_encode_init(&state, 64000, G722_PACKED);
+  uint8_t out[4] = {0xAA, 0xAA, 0xAA, 0xAA};
+  EXPECT_EQ(0, g722_encode(&state, out, pcm.data(), 1));
+  EXPECT_EQ(2, g722_encode(&state, out, pcm.data(), 5));
+  EXPECT_EQ(0xAA, out[2]);
+}
+
+TEST(G722EncodeTest, itu_test_mode_matches_reference) {
+  std::vector<int16_t> pcm = make_pcm(3000);
+  expect_same_encoding(pcm, {1, 999, 2000}, true);
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "oi_codec_sbc.h"
+#include "sbc_encoder.h"
+
+using ::benchmark::State;
+
+// The A2DP high quality configuration: joint stereo, 8 subbands, 16 blocks,
+// loudness allocation and bitpool 53.
+#define SBC_BENCHMARK_BITPOOL 53
+#define SBC_BENCHMARK_NUM_OF_SUBBANDS 8
+#define SBC_BENCHMARK_NUM_OF_BLOCKS 16
+#define SBC_BENCHMARK_NUM_OF_FRAMES 256
+// The most frames the 4-bit count of an A2DP media packet header can announce
+#define SBC_BENCHMARK_FRAMES_PER_PACKET 15
+// Larger than any frame of that configuration
+#define SBC_BENCHMARK_MAX_FRAME_SIZE 512
+
+namespace {
+
+const uint8_t kSimd[] = {OI_CODEC_SBC_SIMD_NONE, OI_CODEC_SBC_SIMD_SSE41,
+                         OI_CODEC_SBC_SIMD_AVX2, OI_CODEC_SBC_SIMD_NEON};
+const char* const kSimdNames[] = {"scalar", "sse4.1", "avx2", "neon"};
+
+// A few seconds of two tones and some noise, encoded with the SBC encoder
+std::vector<uint8_t> make_frames(int sample_rate) {
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = sample_rate == 48000 ? SBC_sf48000 : SBC_sf44100;
+  params.s16ChannelMode = SBC_JOINT_STEREO;
+  params.s16NumOfSubBands = SBC_BENCHMARK_NUM_OF_SUBBANDS;
+  params.s16NumOfBlocks = SBC_BENCHMARK_NUM_OF_BLOCKS;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.u16BitRate = 328;
+  SBC_Encoder_Init(&params);
+  params.s16BitPool = SBC_BENCHMARK_BITPOOL;
+
+  int samples_per_frame =
+      SBC_BENCHMARK_NUM_OF_SUBBANDS * SBC_BENCHMARK_NUM_OF_BLOCKS;
+  std::vector<int16_t> pcm(samples_per_frame * 2);
+  std::vector<uint8_t> frames;
+  uint8_t output[SBC_BENCHMARK_MAX_FRAME_SIZE];
+  uint32_t seed = 1;
+  for (int f = 0; f < SBC_BENCHMARK_NUM_OF_FRAMES; f++) {
+    for (int i = 0; i < samples_per_frame; i++) {
+      double t = static_cast<double>(f * samples_per_frame + i) / sample_rate;
+      seed = seed * 1103515245 + 12345;
+      int noise = static_cast<int16_t>(seed >> 16) >> 4;
+      pcm[2 * i] = 12000 * sin(2 * M_PI * 440 * t) + noise;
+      pcm[2 * i + 1] = 12000 * sin(2 * M_PI * 1250 * t) - noise;
+    }
+    uint32_t length = SBC_Encode(&params, pcm.data(), output);
+    frames.insert(frames.end(), output, output + length);
+  }
+  return frames;
+}
+
+}  // namespace
+
+// Decodes joint stereo frames at state.range(0) Hz with the
+// OI_CODEC_SBC_SIMD_* kernels state.range(1), on one core, in media packets of
+// SBC_BENCHMARK_FRAMES_PER_PACKET frames as the A2DP sink does. Besides frames
+// per second, reports how many times faster than real time the stream is
+// decoded.
+static void BM_SbcDecoder(State& state) {
+  int sample_rate = state.range(0);
+  uint8_t simd = kSimd[state.range(1)];
+
+  if (!OI_CODEC_SBC_SetSimd(simd)) {
+    state.SkipWithError("Instruction set not supported");
+    return;
+  }
+  state.SetLabel(kSimdNames[state.range(1)]);
+
+  std::vector<uint8_t> frames = make_frames(sample_rate);
+  OI_CODEC_SBC_DECODER_CONTEXT context;
+  std::vector<uint32_t> context_data(
+      CODEC_DATA_WORDS(2, SBC_CODEC_FAST_FILTER_BUFFERS));
+  OI_CODEC_SBC_DecoderReset(&context, context_data.data(),
+                            context_data.size() * sizeof(uint32_t), 2, 2,
+                            false);
+  std::vector<int16_t> pcm(SBC_BENCHMARK_FRAMES_PER_PACKET *
+                           SBC_MAX_SAMPLES_PER_FRAME * SBC_MAX_CHANNELS);
+  int samples_per_frame =
+      SBC_BENCHMARK_NUM_OF_SUBBANDS * SBC_BENCHMARK_NUM_OF_BLOCKS;
+  int64_t decoded = 0;
+  for (auto _ : state) {
+    const OI_BYTE* data = frames.data();
+    uint32_t data_size = frames.size();
+    for (int f = 0; f < SBC_BENCHMARK_NUM_OF_FRAMES;
+         f += SBC_BENCHMARK_FRAMES_PER_PACKET) {
+      uint32_t pcm_size = pcm.size() * sizeof(int16_t);
+      OI_STATUS status = OI_CODEC_SBC_DecodeFrames(
+          &context, &data, &data_size, SBC_BENCHMARK_FRAMES_PER_PACKET,
+          pcm.data(), &pcm_size);
+      benchmark::DoNotOptimize(status);
+      decoded += pcm_size / (sizeof(int16_t) * 2 * samples_per_frame);
+    }
+  }
+
+  // Let the decoder pick the kernels again for the next run
+  OI_CODEC_SBC_SetSimd(OI_CODEC_SBC_GetBestSimd());
+  state.counters["frames_per_second"] =
+      benchmark::Counter(decoded, benchmark::Counter::kIsRate);
+  state.counters["realtime_factor"] = benchmark::Counter(
+      static_cast<double>(decoded) * samples_per_frame / sample_rate,
+      benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_SbcDecoder)
+    ->Args({44100, 0})
+    ->Args({44100, 1})
+    ->Args({44100, 2})
+    ->Args({44100, 3})
+    ->Args({48000, 0})
+    ->Args({48000, 1})
+    ->Args({48000, 2})
+    ->Args({48000, 3});
+
+BENCHMARK_MAIN();
@@ -395,6 +395,70 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    uint32_t* frameBytes, int16_t* pcmData,
                                    uint32_t* pcmBytes);
 
+/**
+ * Decode consecutive SBC frames, such as all the frames of an A2DP media
+ * packet, into one pcm buffer. Decoding stops at the first frame which fails
+ * to decode.
+ *
+ * @param context       Pointer to a decoder context structure. The same context
+ *                      must be used each time when decoding from the same
+ *                      stream.
+ *
+ * @param frameData     Address of a pointer to the SBC data to decode. This
+ *                      value will be updated to point past the last frame
+ *                      successfully decoded.
+ *
+ * @param frameBytes    Pointer to a uint32_t containing the number of available
+ *                      bytes of frame data. This value will be updated to
+ *                      reflect the number of bytes remaining after decoding.
+ *
+ * @param frameCount    The maximum number of frames to decode.
+ *
+ * @param pcmData       Address of an array of int16_t pairs, which will be
+ *                      populated with the decoded audio data of all the frames
+ *                      one after the other. This address is not updated.
+ *
+ * @param pcmBytes      Pointer to a uint32_t in/out parameter. On input, it
+ *                      should contain the number of bytes available for pcm
+ *                      data. On output, it will contain the number of bytes
+ *                      written by all the frames decoded.
+ *
+ * @return OI_OK if frameCount frames were decoded, otherwise the status of the
+ *         frame which failed to decode.
+ */
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, uint8_t frameCount,
+                                    int16_t* pcmData, uint32_t* pcmBytes);
+
+/* Instruction sets of the synthesis filterbank, see OI_CODEC_SBC_SetSimd() */
+#define OI_CODEC_SBC_SIMD_NONE 0
+#define OI_CODEC_SBC_SIMD_SSE41 1
+#define OI_CODEC_SBC_SIMD_AVX2 2
+#define OI_CODEC_SBC_SIMD_NEON 3
+
+/**
+ * Get the fastest instruction set supported by the CPU for the synthesis
+ * filterbank.
+ *
+ * @return one of the OI_CODEC_SBC_SIMD_* values
+ */
+uint8_t OI_CODEC_SBC_GetBestSimd(void);
+
+/**
+ * Select the instruction set used by the synthesis filterbank of all the
+ * decoders. By default the first decoder reset picks
+ * OI_CODEC_SBC_GetBestSimd(). The decoded audio is identical whatever the
+ * instruction set, and it may be called while another thread decodes: the
+ * switch takes effect at the next frame.
+ *
+ * @param simd          One of the OI_CODEC_SBC_SIMD_* values
+ *
+ * @return TRUE if the instruction set is supported by this build and by the
+ *         CPU, FALSE otherwise, in which case the selection is unchanged.
+ */
+OI_BOOL OI_CODEC_SBC_SetSimd(uint8_t simd);
+
 /**
  * Calculate the number of SBC frames but don't decode. CRC's are not checked,
  * but the Sync word is found prior to count calculation.
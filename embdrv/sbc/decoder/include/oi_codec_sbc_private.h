@@ -125,6 +125,14 @@ typedef struct {
 #define DCTII_8_SHIFT_6 (DCTII_8_SHIFT_OUT - 1)
 #define DCTII_8_SHIFT_7 (DCTII_8_SHIFT_OUT - 2)
 
+#define AAN_C4_FIX (759250125) /* S1.30  759250125   0.707107*/
+
+#define AAN_C6_FIX (410903207) /* S1.30  410903207   0.382683*/
+
+#define AAN_Q0_FIX (581104888) /* S1.30  581104888   0.541196*/
+
+#define AAN_Q1_FIX (1402911301) /* S1.30 1402911301   1.306563*/
+
 #define DCT_SHIFT 15
 
 #define DCTIII_4_SHIFT_IN 2
@@ -201,6 +209,25 @@ PRIVATE void analyze8_enhanced_generated(
     OI_UINT strideShift, int32_t subband[8]);
 #endif
 
+/* Vector versions of the 8-subband synthesis, see synthesis-simd.c */
+typedef struct {
+  /** dct2_8 of count consecutive rows of 8 subband samples, count being a
+   * multiple of 4. */
+  void (*Dct8)(SBC_BUFFER_T* RESTRICT out, int32_t const* RESTRICT in,
+               OI_UINT count);
+  /** SynthWindow80_generated of both channels at once, buffer1 being NULL for
+   * mono. NULL when the instruction set has no vector version of it. */
+  void (*Window80)(int16_t* pcm, SBC_BUFFER_T const* buffer0,
+                   SBC_BUFFER_T const* buffer1, OI_UINT strideShift);
+} OI_SBC_SYNTH_KERNELS;
+
+/** The kernels selected by OI_CODEC_SBC_SetSimd(), NULL for the C code.
+ * OI_CODEC_SBC_SetSimd() may swap them while a frame is decoded, so they are
+ * read once per frame. */
+PRIVATE const OI_SBC_SYNTH_KERNELS* OI_SBC_SynthKernels(void);
+
+PRIVATE void OI_SBC_SynthSimdInit(void);
+
 /* Decoder functions */
 
 INLINE void OI_SBC_ReadHeader(OI_CODEC_SBC_COMMON_CONTEXT* common,
@@ -71,6 +71,7 @@ INLINE OI_STATUS internal_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
   }
 
   context->common.codecInfo = OI_Codec_Copyright;
+  OI_SBC_SynthSimdInit();
   context->common.maxBitneed = 0;
   context->limitFrameFormat = FALSE;
   OI_SBC_ExpandFrameFields(&context->common.frameInfo);
@@ -350,6 +350,33 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
   return status;
 }
 
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, uint8_t frameCount,
+                                    int16_t* pcmData, uint32_t* pcmBytes) {
+  OI_STATUS status = OI_OK;
+  uint32_t pcmAvailable = *pcmBytes;
+  uint32_t pcmWritten = 0;
+  uint32_t framePcmBytes;
+
+  TRACE(("+OI_CODEC_SBC_DecodeFrames: %d frames", frameCount));
+
+  while (frameCount--) {
+    framePcmBytes = pcmAvailable - pcmWritten;
+    status = OI_CODEC_SBC_DecodeFrame(context, frameData, frameBytes,
+                                      pcmData + pcmWritten / sizeof(int16_t),
+                                      &framePcmBytes);
+    if (!OI_SUCCESS(status)) {
+      break;
+    }
+    pcmWritten += framePcmBytes;
+  }
+  *pcmBytes = pcmWritten;
+  TRACE(("-OI_CODEC_SBC_DecodeFrames: %d", status));
+
+  return status;
+}
+
 OI_STATUS OI_CODEC_SBC_SkipFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                  const OI_BYTE** frameData,
                                  uint32_t* frameBytes) {
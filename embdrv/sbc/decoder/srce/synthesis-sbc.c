@@ -312,6 +312,70 @@ PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT* context,
   context->common.filterBufferOffset = offset;
 }
 
+/*
+ * OI_SBC_SynthFrame_80 with |kernels|. The DCT does not depend on the
+ * synthesis buffer, so it is computed for all the blocks at once and then
+ * copied where DCT2_8 would have written it.
+ */
+PRIVATE void OI_SBC_SynthFrame_80_Simd(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                       const OI_SBC_SYNTH_KERNELS* kernels,
+                                       int16_t* pcm, OI_UINT blkstart,
+                                       OI_UINT blkcount) {
+  SBC_BUFFER_T dct[SBC_MAX_BLOCKS * SBC_MAX_CHANNELS * 8];
+  SBC_BUFFER_T* d = dct;
+  OI_UINT blk;
+  OI_UINT ch;
+  OI_UINT i;
+  OI_UINT nrof_channels = context->common.frameInfo.nrof_channels;
+  OI_UINT pcmStrideShift = context->common.pcmStride == 1 ? 0 : 1;
+  OI_UINT offset = context->common.filterBufferOffset;
+  int32_t* s = context->common.subdata + 8 * nrof_channels * blkstart;
+  OI_UINT rows = nrof_channels * blkcount;
+  OI_UINT vectorRows = rows & ~3u;
+
+  kernels->Dct8(dct, s, vectorRows);
+  for (i = vectorRows; i < rows; i++) {
+    DCT2_8(dct + 8 * i, s + 8 * i);
+  }
+
+  for (blk = 0; blk < blkcount; blk++) {
+    if (offset == 0) {
+      COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(
+          context->common.filterBuffer[0] + context->common.filterBufferLen -
+              72,
+          context->common.filterBuffer[0]);
+      if (nrof_channels == 2) {
+        COPY_BACKWARD_32BIT_ALIGNED_72_HALFWORDS(
+            context->common.filterBuffer[1] + context->common.filterBufferLen -
+                72,
+            context->common.filterBuffer[1]);
+      }
+      offset = context->common.filterBufferLen - 80;
+    } else {
+      offset -= 1 * 8;
+    }
+
+    for (ch = 0; ch < nrof_channels; ch++) {
+      for (i = 0; i < 8; i++) {
+        context->common.filterBuffer[ch][offset + i] = *d++;
+      }
+    }
+    if (kernels->Window80 != NULL) {
+      kernels->Window80(
+          pcm, context->common.filterBuffer[0] + offset,
+          nrof_channels == 2 ? context->common.filterBuffer[1] + offset : NULL,
+          pcmStrideShift);
+    } else {
+      for (ch = 0; ch < nrof_channels; ch++) {
+        SYNTH80(pcm + ch, context->common.filterBuffer[ch] + offset,
+                pcmStrideShift);
+      }
+    }
+    pcm += (8 << pcmStrideShift);
+  }
+  context->common.filterBufferOffset = offset;
+}
+
 PRIVATE void OI_SBC_SynthFrame_4SB(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    int16_t* pcm, OI_UINT blkstart,
                                    OI_UINT blkcount) {
@@ -415,6 +479,7 @@ PRIVATE void OI_SBC_SynthFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                OI_UINT nrof_blocks) {
   OI_UINT nrof_subbands = context->common.frameInfo.nrof_subbands;
   OI_UINT nrof_channels = context->common.frameInfo.nrof_channels;
+  const OI_SBC_SYNTH_KERNELS* kernels = OI_SBC_SynthKernels();
 
   OI_ASSERT(nrof_subbands == 4 || nrof_subbands == 8);
   if (nrof_subbands == 4) {
@@ -423,6 +488,8 @@ PRIVATE void OI_SBC_SynthFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
   } else if (context->common.frameInfo.enhanced) {
     SynthFrameEnhanced[nrof_channels](context, pcm, start_block, nrof_blocks);
 #endif /* SBC_ENHANCED */
+  } else if (kernels != NULL) {
+    OI_SBC_SynthFrame_80_Simd(context, kernels, pcm, start_block, nrof_blocks);
   } else {
     SynthFrame8SB[nrof_channels](context, pcm, start_block, nrof_blocks);
   }
@@ -0,0 +1,528 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/** @file
+@ingroup codec_internal
+*/
+
+/**@addgroup codec_internal*/
+/**@{*/
+
+/*
+ * SSE4.1, AVX2 and NEON versions of the 8-subband synthesis filterbank,
+ * selected at run time. They compute exactly the same integer arithmetic as
+ * dct2_8() and SynthWindow80_generated(), so the decoded audio does not depend
+ * on the instruction set.
+ *
+ * The DCT is vectorised across blocks and channels: each vector lane holds the
+ * same subband of a different row of 8 subband samples, and the rows are
+ * transposed in and out of the registers.
+ *
+ * The synthesis window gives each of the 8 output samples 9 or 10 products of
+ * a 16-bit window coefficient and a 16-bit buffer value, each product being
+ * scaled by its own power of two. The taps of all the outputs are gathered in
+ * two shuffles per 16 buffer values, and the per-product shifts need variable
+ * per-lane shifts, which SSE4.1 does not have; it keeps the C window.
+ */
+
+#include "oi_codec_sbc_private.h"
+
+/* The C code, once selected */
+static const OI_SBC_SYNTH_KERNELS synthKernelsNone = {NULL, NULL};
+
+/* Written by OI_CODEC_SBC_SetSimd() and read by the decoding threads, NULL
+ * until a selection is made */
+static const OI_SBC_SYNTH_KERNELS* synthKernels = NULL;
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+
+/*
+ * The taps of SynthWindow80_generated. For output sample j and row r, the two
+ * products are taken from buffer[16 * r + 4 + tapA[j]] and
+ * buffer[16 * r + 5 + tapB[j]]. The coefficients include the left shifts of
+ * the C code, and windowShift holds its right shifts.
+ */
+static const int32_t windowCoef[5][2][8] = {
+    {{0, -3263, -10385, -16457, 0, 16913, 11167, 9293},
+     {8235, 29293, 24995, 19083, 10445, -8443, -10337, -6087}},
+    {{-23167, -5229, -4944, -23641, 0, 7374, 7668, 9976},
+     {26479, 30835, 9161, -29015, -10594, -9632, -30605, -23144}},
+    {{-34794, -54042, -46126, -51556, 0, 61788, 66536, 94684},
+     {75192, 63266, 55122, 49160, 89196, 41020, 38212, 36110}},
+    {{34794, 34638, 18472, 24211, 0, -18233, 22117, 11537},
+     {26479, 26663, 12705, 23469, 10603, 9405, 16383, 3494}},
+    {{23167, 4555, 6239, 21223, 0, 1499, 7543, 1370},
+     {8235, 12419, 9251, 26913, 9539, 26189, 8603, 8721}}};
+
+static const int32_t windowShift[5][2][8] = {
+    {{0, 5, 6, 6, 0, 5, 4, 3}, {3, 5, 5, 5, 4, 7, 4, 2}},
+    {{3, 0, 0, 2, 0, 0, 0, 0}, {2, 3, 3, 4, 0, 0, 1, 0}},
+    {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}},
+    {{0, 0, 0, 1, 0, 3, 4, 1}, {2, 2, 1, 2, 0, 1, 2, 0}},
+    {{3, 1, 3, 8, 0, 1, 3, 0}, {3, 4, 4, 6, 4, 7, 6, 7}}};
+
+/* tapA = {0, 1, 2, 3, 4, 3, 2, 1} and tapB = {7, 6, 5, 4, 3, 4, 5, 6}, as byte
+ * shuffles of 8 halfwords */
+static const uint8_t windowTapA[16] = {0, 1, 2, 3, 4, 5, 6, 7,
+                                       8, 9, 6, 7, 4, 5, 2, 3};
+static const uint8_t windowTapB[16] = {14, 15, 12, 13, 10, 11, 8, 9,
+                                       6,  7,  8,  9,  10, 11, 12, 13};
+
+/*
+ * dct2_8() of the vectors in[0..7] into out[0..7], using the lane-wise
+ * operations of an instruction set. The arithmetic, including the truncating
+ * divisions by 2, follows dct2_8() step by step.
+ */
+#define DCT2_8_LANES(VEC, out, in, ADD, SUB, SHL1, HALF, MULT, SCALE) \
+  do {                                                               \
+    VEC L00, L01, L02, L03, L04, L05, L06, L07, L25;                 \
+    L00 = ADD(in[0], in[7]);                                         \
+    L01 = ADD(in[1], in[6]);                                         \
+    L02 = ADD(in[2], in[5]);                                         \
+    L03 = ADD(in[3], in[4]);                                         \
+    L04 = SUB(in[3], in[4]);                                         \
+    L05 = SUB(in[2], in[5]);                                         \
+    L06 = SUB(in[1], in[6]);                                         \
+    L07 = SUB(in[0], in[7]);                                         \
+    L00 = ADD(L00, L03);                                             \
+    L03 = SUB(L00, SHL1(L03));                                       \
+    L01 = ADD(L01, L02);                                             \
+    L02 = SUB(L01, SHL1(L02));                                       \
+    L02 = ADD(L02, L03);                                             \
+    L02 = MULT(AAN_C4_FIX, L02);                                     \
+    L00 = ADD(L00, L01);                                             \
+    L01 = SUB(L00, SHL1(L01));                                       \
+    out[0] = SCALE(L00, DCTII_8_SHIFT_0);                            \
+    out[4] = SCALE(L01, DCTII_8_SHIFT_4);                            \
+    L03 = ADD(L03, L02);                                             \
+    L02 = SUB(L03, SHL1(L02));                                       \
+    out[6] = SCALE(L02, DCTII_8_SHIFT_6);                            \
+    out[2] = SCALE(L03, DCTII_8_SHIFT_2);                            \
+    L04 = HALF(ADD(L04, L05));                                       \
+    L05 = HALF(ADD(L05, L06));                                       \
+    L06 = HALF(ADD(L06, L07));                                       \
+    L07 = HALF(L07);                                                 \
+    L05 = MULT(AAN_C4_FIX, L05);                                     \
+    L25 = MULT(AAN_C6_FIX, SUB(L06, L04));                           \
+    L04 = SUB(MULT(AAN_Q0_FIX, L04), L25);                           \
+    L06 = SUB(MULT(AAN_Q1_FIX, L06), L25);                           \
+    L07 = ADD(L07, L05);                                             \
+    L05 = SUB(L07, SHL1(L05));                                       \
+    L05 = ADD(L05, L04);                                             \
+    L04 = SUB(L05, SHL1(L04));                                       \
+    out[3] = SCALE(L04, DCTII_8_SHIFT_3 - 1);                        \
+    out[5] = SCALE(L05, DCTII_8_SHIFT_5 - 1);                        \
+    L07 = ADD(L07, L06);                                             \
+    L06 = SUB(L07, SHL1(L06));                                       \
+    out[7] = SCALE(L06, DCTII_8_SHIFT_7 - 1);                        \
+    out[1] = SCALE(L07, DCTII_8_SHIFT_1 - 1);                        \
+  } while (0)
+
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+#define SSE_ADD(x, y) _mm_add_epi32(x, y)
+#define SSE_SUB(x, y) _mm_sub_epi32(x, y)
+#define SSE_SHL1(x) _mm_slli_epi32(x, 1)
+#define SSE_HALF(x) \
+  _mm_srai_epi32(_mm_add_epi32(x, _mm_srli_epi32(x, 31)), 1)
+#define SSE_MULT(K, x) sse41_mult_dct(_mm_set1_epi32(K), x)
+#define SSE_SCALE(x, s) \
+  _mm_srai_epi32(_mm_add_epi32(x, _mm_set1_epi32(1 << ((s)-1))), s)
+
+#define AVX_ADD(x, y) _mm256_add_epi32(x, y)
+#define AVX_SUB(x, y) _mm256_sub_epi32(x, y)
+#define AVX_SHL1(x) _mm256_slli_epi32(x, 1)
+#define AVX_HALF(x) \
+  _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_srli_epi32(x, 31)), 1)
+#define AVX_MULT(K, x) avx2_mult_dct(_mm256_set1_epi32(K), x)
+#define AVX_SCALE(x, s) \
+  _mm256_srai_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(1 << ((s)-1))), s)
+
+/* FIX_MULT_DCT of dct2_8(): the high word of the 64-bit product, times 4 */
+TARGET_SSE41 static inline __m128i sse41_mult_dct(__m128i k, __m128i x) {
+  __m128i even = _mm_srli_epi64(_mm_mul_epi32(x, k), 32);
+  __m128i odd = _mm_mul_epi32(_mm_srli_epi64(x, 32), k);
+  return _mm_slli_epi32(_mm_blend_epi16(even, odd, 0xCC), 2);
+}
+
+TARGET_AVX2 static inline __m256i avx2_mult_dct(__m256i k, __m256i x) {
+  __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(x, k), 32);
+  __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), k);
+  return _mm256_slli_epi32(_mm256_blend_epi32(even, odd, 0xAA), 2);
+}
+
+TARGET_SSE41 static inline void sse41_transpose4(__m128i* v) {
+  __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]);
+  __m128i t1 = _mm_unpacklo_epi32(v[2], v[3]);
+  __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]);
+  __m128i t3 = _mm_unpackhi_epi32(v[2], v[3]);
+  v[0] = _mm_unpacklo_epi64(t0, t1);
+  v[1] = _mm_unpackhi_epi64(t0, t1);
+  v[2] = _mm_unpacklo_epi64(t2, t3);
+  v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+TARGET_AVX2 static inline void avx2_transpose4(__m256i* v) {
+  __m256i t0 = _mm256_unpacklo_epi32(v[0], v[1]);
+  __m256i t1 = _mm256_unpacklo_epi32(v[2], v[3]);
+  __m256i t2 = _mm256_unpackhi_epi32(v[0], v[1]);
+  __m256i t3 = _mm256_unpackhi_epi32(v[2], v[3]);
+  v[0] = _mm256_unpacklo_epi64(t0, t1);
+  v[1] = _mm256_unpackhi_epi64(t0, t1);
+  v[2] = _mm256_unpacklo_epi64(t2, t3);
+  v[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+/* The (int16_t) cast of dct2_8(): keep the low halfword, sign extended */
+#define SSE_TRUNCATE_INT16(x) _mm_srai_epi32(_mm_slli_epi32(x, 16), 16)
+#define AVX_TRUNCATE_INT16(x) _mm256_srai_epi32(_mm256_slli_epi32(x, 16), 16)
+
+TARGET_SSE41 static void dct2_8_sse41(SBC_BUFFER_T* RESTRICT out,
+                                      int32_t const* RESTRICT in,
+                                      OI_UINT count) {
+  __m128i x[8];
+  __m128i y[8];
+  OI_UINT row;
+  OI_UINT i;
+
+  for (row = 0; row < count; row += 4) {
+    for (i = 0; i < 4; i++) {
+      x[i] = _mm_loadu_si128((const __m128i*)(in + 8 * (row + i)));
+      x[4 + i] = _mm_loadu_si128((const __m128i*)(in + 8 * (row + i) + 4));
+    }
+    sse41_transpose4(x);
+    sse41_transpose4(x + 4);
+    DCT2_8_LANES(__m128i, y, x, SSE_ADD, SSE_SUB, SSE_SHL1, SSE_HALF,
+                 SSE_MULT, SSE_SCALE);
+    sse41_transpose4(y);
+    sse41_transpose4(y + 4);
+    for (i = 0; i < 4; i++) {
+      _mm_storeu_si128((__m128i*)(out + 8 * (row + i)),
+                       _mm_packs_epi32(SSE_TRUNCATE_INT16(y[i]),
+                                       SSE_TRUNCATE_INT16(y[4 + i])));
+    }
+  }
+}
+
+TARGET_AVX2 static void dct2_8_avx2(SBC_BUFFER_T* RESTRICT out,
+                                    int32_t const* RESTRICT in,
+                                    OI_UINT count) {
+  __m256i x[8];
+  __m256i y[8];
+  __m256i pcm;
+  OI_UINT row;
+  OI_UINT i;
+
+  /* Rows row + i and row + 4 + i share the registers, one per 128-bit lane */
+  for (row = 0; row + 8 <= count; row += 8) {
+    for (i = 0; i < 4; i++) {
+      const int32_t* lo = in + 8 * (row + i);
+      const int32_t* hi = in + 8 * (row + 4 + i);
+      x[i] = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)lo)),
+          _mm_loadu_si128((const __m128i*)hi), 1);
+      x[4 + i] = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(lo + 4))),
+          _mm_loadu_si128((const __m128i*)(hi + 4)), 1);
+    }
+    avx2_transpose4(x);
+    avx2_transpose4(x + 4);
+    DCT2_8_LANES(__m256i, y, x, AVX_ADD, AVX_SUB, AVX_SHL1, AVX_HALF,
+                 AVX_MULT, AVX_SCALE);
+    avx2_transpose4(y);
+    avx2_transpose4(y + 4);
+    for (i = 0; i < 4; i++) {
+      pcm = _mm256_packs_epi32(AVX_TRUNCATE_INT16(y[i]),
+                               AVX_TRUNCATE_INT16(y[4 + i]));
+      _mm_storeu_si128((__m128i*)(out + 8 * (row + i)),
+                       _mm256_castsi256_si128(pcm));
+      _mm_storeu_si128((__m128i*)(out + 8 * (row + 4 + i)),
+                       _mm256_extracti128_si256(pcm, 1));
+    }
+  }
+  if (row < count) {
+    dct2_8_sse41(out + 8 * row, in + 8 * row, count - row);
+  }
+}
+
+/* SynthWindow80_generated() of one channel, saturated to 16 bits */
+TARGET_AVX2 static inline __m128i synth_window80_avx2_channel(
+    SBC_BUFFER_T const* buffer) {
+  const __m128i tapA = _mm_loadu_si128((const __m128i*)windowTapA);
+  const __m128i tapB = _mm_loadu_si128((const __m128i*)windowTapB);
+  __m256i sum = _mm256_setzero_si256();
+  __m256i a, b;
+  OI_UINT r;
+
+  for (r = 0; r < 5; r++) {
+    a = _mm256_cvtepi16_epi32(_mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(buffer + 16 * r + 4)), tapA));
+    b = _mm256_cvtepi16_epi32(_mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(buffer + 16 * r + 5)), tapB));
+    a = _mm256_mullo_epi32(
+        a, _mm256_loadu_si256((const __m256i*)windowCoef[r][0]));
+    b = _mm256_mullo_epi32(
+        b, _mm256_loadu_si256((const __m256i*)windowCoef[r][1]));
+    a = _mm256_srav_epi32(
+        a, _mm256_loadu_si256((const __m256i*)windowShift[r][0]));
+    b = _mm256_srav_epi32(
+        b, _mm256_loadu_si256((const __m256i*)windowShift[r][1]));
+    sum = _mm256_add_epi32(sum, _mm256_add_epi32(a, b));
+  }
+
+  /* pcm /= 32768, rounding toward zero like the C division */
+  sum = _mm256_add_epi32(sum, _mm256_and_si256(_mm256_srai_epi32(sum, 31),
+                                               _mm256_set1_epi32(0x7FFF)));
+  sum = _mm256_srai_epi32(sum, 15);
+  return _mm_packs_epi32(_mm256_castsi256_si128(sum),
+                         _mm256_extracti128_si256(sum, 1));
+}
+
+TARGET_AVX2 static void synth_window80_avx2(int16_t* pcm,
+                                            SBC_BUFFER_T const* buffer0,
+                                            SBC_BUFFER_T const* buffer1,
+                                            OI_UINT strideShift) {
+  __m128i pcm0 = synth_window80_avx2_channel(buffer0);
+  __m128i pcm1;
+  int16_t samples[8];
+  OI_UINT i;
+
+  if (buffer1 == NULL) {
+    if (strideShift == 0) {
+      _mm_storeu_si128((__m128i*)pcm, pcm0);
+    } else {
+      _mm_storeu_si128((__m128i*)samples, pcm0);
+      for (i = 0; i < 8; i++) {
+        pcm[i << strideShift] = samples[i];
+      }
+    }
+    return;
+  }
+
+  pcm1 = synth_window80_avx2_channel(buffer1);
+  if (strideShift == 0) {
+    /* Overlapping channels, the second one wins as in the C code */
+    _mm_storeu_si128((__m128i*)pcm, pcm0);
+    _mm_storeu_si128((__m128i*)(pcm + 1), pcm1);
+  } else {
+    _mm_storeu_si128((__m128i*)pcm, _mm_unpacklo_epi16(pcm0, pcm1));
+    _mm_storeu_si128((__m128i*)(pcm + 8), _mm_unpackhi_epi16(pcm0, pcm1));
+  }
+}
+
+static const OI_SBC_SYNTH_KERNELS synthKernelsSse41 = {dct2_8_sse41, NULL};
+
+static const OI_SBC_SYNTH_KERNELS synthKernelsAvx2 = {dct2_8_avx2,
+                                                      synth_window80_avx2};
+
+#elif defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#define NEON_ADD(x, y) vaddq_s32(x, y)
+#define NEON_SUB(x, y) vsubq_s32(x, y)
+#define NEON_SHL1(x) vshlq_n_s32(x, 1)
+#define NEON_HALF(x)                                                     \
+  vshrq_n_s32(                                                           \
+      vaddq_s32(x, vreinterpretq_s32_u32(                                \
+                       vshrq_n_u32(vreinterpretq_u32_s32(x), 31))),      \
+      1)
+#define NEON_MULT(K, x) neon_mult_dct(K, x)
+#define NEON_SCALE(x, s) vshrq_n_s32(vaddq_s32(x, vdupq_n_s32(1 << ((s)-1))), s)
+
+/* FIX_MULT_DCT of dct2_8(): the high word of the 64-bit product, times 4 */
+static inline int32x4_t neon_mult_dct(int32_t k, int32x4_t x) {
+  int32x2_t lo = vshrn_n_s64(vmull_n_s32(vget_low_s32(x), k), 32);
+  int32x2_t hi = vshrn_n_s64(vmull_n_s32(vget_high_s32(x), k), 32);
+  return vshlq_n_s32(vcombine_s32(lo, hi), 2);
+}
+
+static inline void neon_transpose4(int32x4_t* v) {
+  int32x4x2_t t0 = vtrnq_s32(v[0], v[1]);
+  int32x4x2_t t1 = vtrnq_s32(v[2], v[3]);
+  v[0] = vcombine_s32(vget_low_s32(t0.val[0]), vget_low_s32(t1.val[0]));
+  v[1] = vcombine_s32(vget_low_s32(t0.val[1]), vget_low_s32(t1.val[1]));
+  v[2] = vcombine_s32(vget_high_s32(t0.val[0]), vget_high_s32(t1.val[0]));
+  v[3] = vcombine_s32(vget_high_s32(t0.val[1]), vget_high_s32(t1.val[1]));
+}
+
+static void dct2_8_neon(SBC_BUFFER_T* RESTRICT out, int32_t const* RESTRICT in,
+                        OI_UINT count) {
+  int32x4_t x[8];
+  int32x4_t y[8];
+  OI_UINT row;
+  OI_UINT i;
+
+  for (row = 0; row < count; row += 4) {
+    for (i = 0; i < 4; i++) {
+      x[i] = vld1q_s32(in + 8 * (row + i));
+      x[4 + i] = vld1q_s32(in + 8 * (row + i) + 4);
+    }
+    neon_transpose4(x);
+    neon_transpose4(x + 4);
+    DCT2_8_LANES(int32x4_t, y, x, NEON_ADD, NEON_SUB, NEON_SHL1, NEON_HALF,
+                 NEON_MULT, NEON_SCALE);
+    neon_transpose4(y);
+    neon_transpose4(y + 4);
+    /* vmovn keeps the low halfword, like the (int16_t) cast of dct2_8() */
+    for (i = 0; i < 4; i++) {
+      vst1q_s16(out + 8 * (row + i),
+                vcombine_s16(vmovn_s32(y[i]), vmovn_s32(y[4 + i])));
+    }
+  }
+}
+
+/* SynthWindow80_generated() of one channel, saturated to 16 bits */
+static inline int16x8_t synth_window80_neon_channel(
+    SBC_BUFFER_T const* buffer) {
+  const uint8x16_t tapA = vld1q_u8(windowTapA);
+  const uint8x16_t tapB = vld1q_u8(windowTapB);
+  int32x4_t lo = vdupq_n_s32(0);
+  int32x4_t hi = vdupq_n_s32(0);
+  int16x8_t a, b;
+  OI_UINT r;
+  OI_UINT t;
+
+  for (r = 0; r < 5; r++) {
+    a = vreinterpretq_s16_u8(vqtbl1q_u8(
+        vreinterpretq_u8_s16(vld1q_s16(buffer + 16 * r + 4)), tapA));
+    b = vreinterpretq_s16_u8(vqtbl1q_u8(
+        vreinterpretq_u8_s16(vld1q_s16(buffer + 16 * r + 5)), tapB));
+    for (t = 0; t < 2; t++) {
+      const int32_t* coef = windowCoef[r][t];
+      const int32_t* shift = windowShift[r][t];
+      int16x8_t v = t == 0 ? a : b;
+      lo = vaddq_s32(
+          lo, vshlq_s32(vmulq_s32(vmovl_s16(vget_low_s16(v)), vld1q_s32(coef)),
+                        vnegq_s32(vld1q_s32(shift))));
+      hi = vaddq_s32(hi, vshlq_s32(vmulq_s32(vmovl_high_s16(v),
+                                             vld1q_s32(coef + 4)),
+                                   vnegq_s32(vld1q_s32(shift + 4))));
+    }
+  }
+
+  /* pcm /= 32768, rounding toward zero like the C division */
+  lo = vaddq_s32(lo, vandq_s32(vshrq_n_s32(lo, 31), vdupq_n_s32(0x7FFF)));
+  hi = vaddq_s32(hi, vandq_s32(vshrq_n_s32(hi, 31), vdupq_n_s32(0x7FFF)));
+  return vcombine_s16(vqshrn_n_s32(lo, 15), vqshrn_n_s32(hi, 15));
+}
+
+static void synth_window80_neon(int16_t* pcm, SBC_BUFFER_T const* buffer0,
+                                SBC_BUFFER_T const* buffer1,
+                                OI_UINT strideShift) {
+  int16x8x2_t stereo;
+  int16_t samples[8];
+  OI_UINT i;
+
+  stereo.val[0] = synth_window80_neon_channel(buffer0);
+  if (buffer1 == NULL) {
+    if (strideShift == 0) {
+      vst1q_s16(pcm, stereo.val[0]);
+    } else {
+      vst1q_s16(samples, stereo.val[0]);
+      for (i = 0; i < 8; i++) {
+        pcm[i << strideShift] = samples[i];
+      }
+    }
+    return;
+  }
+
+  stereo.val[1] = synth_window80_neon_channel(buffer1);
+  if (strideShift == 0) {
+    /* Overlapping channels, the second one wins as in the C code */
+    vst1q_s16(pcm, stereo.val[0]);
+    vst1q_s16(pcm + 1, stereo.val[1]);
+  } else {
+    vst2q_s16(pcm, stereo);
+  }
+}
+
+static const OI_SBC_SYNTH_KERNELS synthKernelsNeon = {dct2_8_neon,
+                                                      synth_window80_neon};
+
+#endif
+
+uint8_t OI_CODEC_SBC_GetBestSimd(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (__builtin_cpu_supports("avx2")) return OI_CODEC_SBC_SIMD_AVX2;
+  if (__builtin_cpu_supports("sse4.1")) return OI_CODEC_SBC_SIMD_SSE41;
+#elif defined(__aarch64__)
+  return OI_CODEC_SBC_SIMD_NEON;
+#endif
+  return OI_CODEC_SBC_SIMD_NONE;
+}
+
+/* The kernels of |simd|, if this build and the CPU support it */
+static OI_BOOL synth_kernels(uint8_t simd,
+                             const OI_SBC_SYNTH_KERNELS** kernels) {
+  switch (simd) {
+    case OI_CODEC_SBC_SIMD_NONE:
+      *kernels = &synthKernelsNone;
+      return TRUE;
+#if defined(__x86_64__) || defined(__i386__)
+    case OI_CODEC_SBC_SIMD_SSE41:
+      if (!__builtin_cpu_supports("sse4.1")) return FALSE;
+      *kernels = &synthKernelsSse41;
+      return TRUE;
+    case OI_CODEC_SBC_SIMD_AVX2:
+      if (!__builtin_cpu_supports("avx2")) return FALSE;
+      *kernels = &synthKernelsAvx2;
+      return TRUE;
+#elif defined(__aarch64__)
+    case OI_CODEC_SBC_SIMD_NEON:
+      *kernels = &synthKernelsNeon;
+      return TRUE;
+#endif
+    default:
+      return FALSE;
+  }
+}
+
+OI_BOOL OI_CODEC_SBC_SetSimd(uint8_t simd) {
+  const OI_SBC_SYNTH_KERNELS* kernels;
+
+  if (!synth_kernels(simd, &kernels)) return FALSE;
+  __atomic_store_n(&synthKernels, kernels, __ATOMIC_RELEASE);
+  return TRUE;
+}
+
+PRIVATE const OI_SBC_SYNTH_KERNELS* OI_SBC_SynthKernels(void) {
+  const OI_SBC_SYNTH_KERNELS* kernels =
+      __atomic_load_n(&synthKernels, __ATOMIC_ACQUIRE);
+  return kernels == &synthKernelsNone ? NULL : kernels;
+}
+
+PRIVATE void OI_SBC_SynthSimdInit(void) {
+  const OI_SBC_SYNTH_KERNELS* kernels;
+  const OI_SBC_SYNTH_KERNELS* unselected = NULL;
+
+  /* Only if nothing is selected yet, even by a concurrent
+   * OI_CODEC_SBC_SetSimd() */
+  if (!synth_kernels(OI_CODEC_SBC_GetBestSimd(), &kernels)) return;
+  __atomic_compare_exchange_n(&synthKernels, &unselected, kernels, FALSE,
+                              __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+}
+
+/**@}*/
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "oi_codec_sbc.h"
+#include "sbc_encoder.h"
+
+namespace {
+
+constexpr int kNumOfFrames = 24;
+
+struct Config {
+  int16_t num_of_subbands;
+  int16_t num_of_blocks;
+  int16_t channel_mode;
+  int16_t bitpool;
+};
+
+// Tones with noise, full scale square waves and silence, to go through every
+// scale factor and the saturating ends of the synthesis filterbank.
+std::vector<int16_t> make_pcm(size_t num_of_samples) {
+  std::vector<int16_t> pcm(num_of_samples);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < pcm.size(); i++) {
+    seed = seed * 1103515245 + 12345;
+    int16_t noise = static_cast<int16_t>(seed >> 16);
+    switch ((i / 1024) % 4) {
+      case 0:
+        pcm[i] = 20000 * sin(0.05 * i) + (noise >> 3);
+        break;
+      case 1:
+        pcm[i] = noise;
+        break;
+      case 2:
+        pcm[i] = (noise & 1) ? 32767 : -32768;
+        break;
+      default:
+        pcm[i] = noise >> (i % 16);
+        break;
+    }
+  }
+  return pcm;
+}
+
+std::vector<uint8_t> encode(const Config& config) {
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = SBC_sf44100;
+  params.s16ChannelMode = config.channel_mode;
+  params.s16NumOfSubBands = config.num_of_subbands;
+  params.s16NumOfBlocks = config.num_of_blocks;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.u16BitRate = 328;
+  SBC_Encoder_Init(&params);
+  params.s16BitPool = config.bitpool;
+
+  size_t samples_per_frame =
+      config.num_of_subbands * config.num_of_blocks * params.s16NumOfChannels;
+  std::vector<int16_t> pcm = make_pcm(samples_per_frame * kNumOfFrames);
+  std::vector<uint8_t> frames;
+  uint8_t output[1024];
+  for (int f = 0; f < kNumOfFrames; f++) {
+    uint32_t length =
+        SBC_Encode(&params, &pcm[f * samples_per_frame], output);
+    frames.insert(frames.end(), output, output + length);
+  }
+  return frames;
+}
+
+// Decodes all the frames one at a time, or with a single
+// OI_CODEC_SBC_DecodeFrames() call.
+std::vector<int16_t> decode(const std::vector<uint8_t>& frames,
+                            uint8_t pcm_stride, bool batch) {
+  // The reset does not clear the synthesis buffers
+  OI_CODEC_SBC_DECODER_CONTEXT context;
+  std::vector<uint32_t> context_data(
+      CODEC_DATA_WORDS(2, SBC_CODEC_FAST_FILTER_BUFFERS));
+  EXPECT_EQ(OI_OK,
+            OI_CODEC_SBC_DecoderReset(
+                &context, context_data.data(),
+                context_data.size() * sizeof(uint32_t), 2, pcm_stride, false));
+
+  std::vector<int16_t> pcm(kNumOfFrames * SBC_MAX_SAMPLES_PER_FRAME * 2);
+  const OI_BYTE* data = frames.data();
+  uint32_t data_size = frames.size();
+  uint32_t pcm_used = 0;
+  if (batch) {
+    pcm_used = pcm.size() * sizeof(int16_t);
+    EXPECT_EQ(OI_OK,
+              OI_CODEC_SBC_DecodeFrames(&context, &data, &data_size,
+                                        kNumOfFrames, pcm.data(), &pcm_used));
+  } else {
+    for (int f = 0; f < kNumOfFrames; f++) {
+      uint32_t pcm_size = pcm.size() * sizeof(int16_t) - pcm_used;
+      EXPECT_EQ(OI_OK, OI_CODEC_SBC_DecodeFrame(
+                           &context, &data, &data_size,
+                           &pcm[pcm_used / sizeof(int16_t)], &pcm_size));
+      pcm_used += pcm_size;
+    }
+  }
+  EXPECT_EQ(0u, data_size);
+  pcm.resize(pcm_used / sizeof(int16_t));
+  return pcm;
+}
+
+std::vector<Config> all_configs() {
+  const int16_t modes[] = {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO};
+  std::vector<Config> configs;
+  for (int16_t subbands : {4, 8}) {
+    for (int16_t blocks : {4, 8, 12, 16}) {
+      for (int16_t mode : modes) {
+        for (int16_t bitpool : {2, 35, 53, 250}) {
+          int16_t max_bitpool =
+              (mode == SBC_STEREO || mode == SBC_JOINT_STEREO ? 32 : 16) *
+              subbands;
+          configs.push_back(
+              {subbands, blocks, mode, std::min(bitpool, max_bitpool)});
+        }
+      }
+    }
+  }
+  return configs;
+}
+
+}  // namespace
+
+class SbcDecoderSimdTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    OI_CODEC_SBC_SetSimd(OI_CODEC_SBC_GetBestSimd());
+  }
+};
+
+TEST_F(SbcDecoderSimdTest, no_simd_is_always_supported) {
+  EXPECT_TRUE(OI_CODEC_SBC_SetSimd(OI_CODEC_SBC_SIMD_NONE));
+  EXPECT_FALSE(OI_CODEC_SBC_SetSimd(0xff));
+  EXPECT_TRUE(OI_CODEC_SBC_SetSimd(OI_CODEC_SBC_GetBestSimd()));
+}
+
+TEST_F(SbcDecoderSimdTest, pcm_is_bit_exact) {
+  const uint8_t simds[] = {OI_CODEC_SBC_SIMD_SSE41, OI_CODEC_SBC_SIMD_AVX2,
+                           OI_CODEC_SBC_SIMD_NEON};
+
+  for (const Config& config : all_configs()) {
+    std::vector<uint8_t> frames = encode(config);
+    for (uint8_t pcm_stride : {1, 2}) {
+      ASSERT_TRUE(OI_CODEC_SBC_SetSimd(OI_CODEC_SBC_SIMD_NONE));
+      std::vector<int16_t> expected = decode(frames, pcm_stride, false);
+      for (uint8_t simd : simds) {
+        if (!OI_CODEC_SBC_SetSimd(simd)) continue;
+        SCOPED_TRACE(testing::Message()
+                     << "simd " << static_cast<int>(simd) << " subbands "
+                     << config.num_of_subbands << " blocks "
+                     << config.num_of_blocks << " mode " << config.channel_mode
+                     << " bitpool " << config.bitpool << " stride "
+                     << static_cast<int>(pcm_stride));
+        EXPECT_EQ(expected, decode(frames, pcm_stride, false));
+      }
+    }
+  }
+}
+
+TEST_F(SbcDecoderSimdTest, simd_can_be_switched_while_decoding) {
+  uint8_t best = OI_CODEC_SBC_GetBestSimd();
+  if (best == OI_CODEC_SBC_SIMD_NONE) return;
+  std::vector<uint8_t> frames = encode({8, 16, SBC_JOINT_STEREO, 53});
+  ASSERT_TRUE(OI_CODEC_SBC_SetSimd(OI_CODEC_SBC_SIMD_NONE));
+  std::vector<int16_t> expected = decode(frames, 2, false);
+
+  std::atomic<bool> done(false);
+  std::thread switcher([&done, best]() {
+    for (int i = 0; !done; i++) {
+      OI_CODEC_SBC_SetSimd(i % 2 ? best : OI_CODEC_SBC_SIMD_NONE);
+    }
+  });
+  for (int i = 0; i < 50; i++) {
+    EXPECT_EQ(expected, decode(frames, 2, i % 2));
+  }
+  done = true;
+  switcher.join();
+}
+
+TEST_F(SbcDecoderSimdTest, batch_decode_matches_frame_decode) {
+  for (const Config& config : all_configs()) {
+    std::vector<uint8_t> frames = encode(config);
+    SCOPED_TRACE(testing::Message()
+                 << "subbands " << config.num_of_subbands << " blocks "
+                 << config.num_of_blocks << " mode " << config.channel_mode
+                 << " bitpool " << config.bitpool);
+    EXPECT_EQ(decode(frames, 2, false), decode(frames, 2, true));
+  }
+}
+
+TEST_F(SbcDecoderSimdTest, batch_decode_stops_at_the_first_error) {
+  std::vector<uint8_t> frames = encode({8, 16, SBC_JOINT_STEREO, 53});
+  OI_CODEC_SBC_DECODER_CONTEXT context;
+  std::vector<uint32_t> context_data(
+      CODEC_DATA_WORDS(2, SBC_CODEC_FAST_FILTER_BUFFERS));
+  ASSERT_EQ(OI_OK, OI_CODEC_SBC_DecoderReset(
+                       &context, context_data.data(),
+                       context_data.size() * sizeof(uint32_t), 2, 2, false));
+
+  // Room for two frames only
+  std::vector<int16_t> pcm(2 * 8 * 16 * 2);
+  const OI_BYTE* data = frames.data();
+  uint32_t data_size = frames.size();
+  uint32_t pcm_used = pcm.size() * sizeof(int16_t);
+  EXPECT_EQ(OI_CODEC_SBC_NOT_ENOUGH_AUDIO_DATA,
+            OI_CODEC_SBC_DecodeFrames(&context, &data, &data_size, 3,
+                                      pcm.data(), &pcm_used));
+  EXPECT_EQ(pcm.size() * sizeof(int16_t), pcm_used);
+  EXPECT_EQ(frames.size() / kNumOfFrames * (kNumOfFrames - 2), data_size);
+}
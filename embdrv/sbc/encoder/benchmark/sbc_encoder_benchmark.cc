@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "sbc_encoder.h"
+
+using ::benchmark::State;
+
+// The A2DP high quality configuration: joint stereo, 8 subbands, 16 blocks,
+// loudness allocation and bitpool 53.
+#define SBC_BENCHMARK_BITPOOL 53
+#define SBC_BENCHMARK_NUM_OF_SUBBANDS 8
+#define SBC_BENCHMARK_NUM_OF_BLOCKS 16
+#define SBC_BENCHMARK_NUM_OF_FRAMES 256
+// Larger than any frame of that configuration
+#define SBC_BENCHMARK_MAX_FRAME_SIZE 512
+
+namespace {
+
+const int16_t kSimd[] = {SBC_SIMD_NONE, SBC_SIMD_SSE41, SBC_SIMD_AVX2,
+                         SBC_SIMD_NEON};
+const char* const kSimdNames[] = {"scalar", "sse4.1", "avx2", "neon"};
+
+// A few seconds of two tones and some noise, so that the scale factors and
+// the joint stereo decisions vary from frame to frame.
+std::vector<int16_t> make_pcm(int sample_rate) {
+  int samples_per_frame =
+      SBC_BENCHMARK_NUM_OF_SUBBANDS * SBC_BENCHMARK_NUM_OF_BLOCKS;
+  std::vector<int16_t> pcm(SBC_BENCHMARK_NUM_OF_FRAMES * samples_per_frame * 2);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < pcm.size() / 2; i++) {
+    double t = static_cast<double>(i) / sample_rate;
+    seed = seed * 1103515245 + 12345;
+    int noise = static_cast<int16_t>(seed >> 16) >> 4;
+    pcm[2 * i] = 12000 * sin(2 * M_PI * 440 * t) + noise;
+    pcm[2 * i + 1] = 12000 * sin(2 * M_PI * 1250 * t) - noise;
+  }
+  return pcm;
+}
+
+}  // namespace
+
+// Encodes joint stereo frames at state.range(0) Hz with the SBC_SIMD_*
+// kernels state.range(1), on one core. Besides frames per second, reports how
+// many times faster than real time the stream is encoded.
+static void BM_SbcEncoder(State& state) {
+  int sample_rate = state.range(0);
+  int16_t simd = kSimd[state.range(1)];
+
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = sample_rate == 48000 ? SBC_sf48000 : SBC_sf44100;
+  params.s16ChannelMode = SBC_JOINT_STEREO;
+  params.s16NumOfSubBands = SBC_BENCHMARK_NUM_OF_SUBBANDS;
+  params.s16NumOfBlocks = SBC_BENCHMARK_NUM_OF_BLOCKS;
+  params.s16AllocationMethod = SBC_LOUDNESS;
+  params.u16BitRate = 328;
+  SBC_Encoder_Init(&params);
+  params.s16BitPool = SBC_BENCHMARK_BITPOOL;
+  if (!SBC_Encoder_SetSimd(simd)) {
+    state.SkipWithError("Instruction set not supported");
+    return;
+  }
+  state.SetLabel(kSimdNames[state.range(1)]);
+
+  std::vector<int16_t> pcm = make_pcm(sample_rate);
+  int samples_per_frame =
+      SBC_BENCHMARK_NUM_OF_SUBBANDS * SBC_BENCHMARK_NUM_OF_BLOCKS;
+  uint8_t output[SBC_BENCHMARK_MAX_FRAME_SIZE];
+  int64_t frames = 0;
+  for (auto _ : state) {
+    for (int f = 0; f < SBC_BENCHMARK_NUM_OF_FRAMES; f++) {
+      uint32_t length = SBC_Encode(
+          &params, &pcm[f * samples_per_frame * 2], output);
+      benchmark::DoNotOptimize(length);
+    }
+    frames += SBC_BENCHMARK_NUM_OF_FRAMES;
+  }
+
+  // Let the encoder pick the kernels again for the next run
+  SBC_Encoder_SetSimd(SBC_Encoder_GetBestSimd());
+  state.counters["frames_per_second"] =
+      benchmark::Counter(frames, benchmark::Counter::kIsRate);
+  state.counters["realtime_factor"] = benchmark::Counter(
+      static_cast<double>(frames) * samples_per_frame / sample_rate,
+      benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_SbcEncoder)
+    ->Args({44100, 0})
+    ->Args({44100, 1})
+    ->Args({44100, 2})
+    ->Args({44100, 3})
+    ->Args({48000, 0})
+    ->Args({48000, 1})
+    ->Args({48000, 2})
+    ->Args({48000, 3});
+
+BENCHMARK_MAIN();
@@ -25,6 +25,7 @@
 #ifndef SBC_FUNCDECLARE_H
 #define SBC_FUNCDECLARE_H
 
+#include <stddef.h>
 #include "sbc_encoder.h"
 /* Global data */
 #if (SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE)
@@ -53,4 +54,45 @@ extern void EncQuantizer(SBC_ENC_PARAMS*);
 #if (SBC_DSP_OPT == TRUE)
 int32_t SBC_Multiply_32_16_Simplified(int32_t s32In2Temp, int32_t s32In1Temp);
 #endif
+
+#if (SBC_SIMD_OPT == TRUE)
+/* The windowing coefficients as s32DCTY[i] = sum over k of
+ * gas16WindowFor8SBs[k][i] * s16X[ChOffset + i + 16 * k], and the same with 8
+ * instead of 16 for 4 subbands */
+extern const int16_t gas16WindowFor4SBs[5][8];
+extern const int16_t gas16WindowFor8SBs[5][16];
+
+/* Vector versions of the encoder stages. Each gives exactly the results of
+ * the scalar code it replaces. */
+typedef struct {
+  /* Windowing of one block of one channel, from s16X + ChOffset into the 8
+   * or 16 values of s32DCTY */
+  void (*Window4)(const int16_t* ps16X, int32_t* ps32DCTY);
+  void (*Window8)(const int16_t* ps16X, int32_t* ps32DCTY);
+  /* SBC_FastIDCT4/8 of |s32Count| consecutive windowed blocks, a multiple of
+   * 4, into consecutive subband samples */
+  void (*Dct4)(const int32_t* ps32DCTY, int32_t* ps32SbBuf, int32_t s32Count);
+  void (*Dct8)(const int32_t* ps32DCTY, int32_t* ps32SbBuf, int32_t s32Count);
+  /* Largest absolute value of each of the |s32NumOfColumns| subbands, a
+   * multiple of 4, over the blocks of s32SbBuffer */
+  void (*MaxAbs)(const int32_t* ps32SbBuf, int32_t s32NumOfBlocks,
+                 int32_t s32NumOfColumns, int32_t* ps32Max);
+  /* Same for the joint stereo sum and difference of each subband */
+  void (*MaxAbsJoint)(const int32_t* ps32SbBuf, int32_t s32NumOfBlocks,
+                      int32_t s32NumOfSubBands, int32_t* ps32MaxSum,
+                      int32_t* ps32MaxDiff);
+  /* Quantizer of EncPacking for every sample of s32SbBuffer */
+  void (*Quantize)(const int32_t* ps32SbBuf, int32_t s32NumOfBlocks,
+                   int32_t s32NumOfColumns, const int16_t* ps16ScaleFactor,
+                   const int16_t* ps16Bits, uint16_t* pu16Quantized);
+} SBC_ENC_SIMD_KERNELS;
+
+/* The kernels in use, NULL for the scalar code. SBC_Encoder_SetSimd() may
+ * swap them during SBC_Encode(), so a function reads them once and uses them
+ * for all of its work. */
+extern const SBC_ENC_SIMD_KERNELS* SbcEncSimdKernels(void);
+
+/* Pick the kernels, unless SBC_Encoder_SetSimd() already did */
+extern void SbcEncSimdInit(void);
+#endif
 #endif
@@ -58,6 +58,12 @@
 #define SBC_STEREO 2
 #define SBC_JOINT_STEREO 3
 
+/* Vector instruction sets for SBC_Encoder_SetSimd() */
+#define SBC_SIMD_NONE 0
+#define SBC_SIMD_SSE41 1
+#define SBC_SIMD_AVX2 2
+#define SBC_SIMD_NEON 3
+
 #define SBC_BLOCK_0 4
 #define SBC_BLOCK_1 8
 #define SBC_BLOCK_2 12
@@ -138,6 +144,21 @@
 #define SBC_FAST_DCT TRUE
 #endif /*SBC_FAST_DCT */
 
+/* Set SBC_SIMD_OPT to TRUE to run the windowing, matrixing, scale factor and
+ * quantizer stages with SSE4.1/AVX2 or NEON kernels picked at run time. The
+ * kernels give the same frames as the scalar code, and only exist for the
+ * 16 bit windowing and DCT multiplications of the SBC_IPAQ_OPT code. */
+#ifndef SBC_SIMD_OPT
+#define SBC_SIMD_OPT TRUE
+#endif /* SBC_SIMD_OPT */
+#if (SBC_ARM_ASM_OPT == TRUE || SBC_DSP_OPT == TRUE ||                 \
+     SBC_IPAQ_OPT == FALSE || SBC_IS_64_MULT_IN_WINDOW_ACCU == TRUE || \
+     SBC_FAST_DCT == FALSE || SBC_IS_64_MULT_IN_IDCT == TRUE ||        \
+     SBC_IS_64_MULT_IN_QUANTIZER == FALSE)
+#undef SBC_SIMD_OPT
+#define SBC_SIMD_OPT FALSE
+#endif
+
 /* In case we do not use joint stereo mode the flag save some RAM and ROM in
  * case it is set to FALSE */
 #ifndef SBC_JOINT_STE_INCLUDED
@@ -197,6 +218,15 @@ extern uint32_t SBC_Encode(SBC_ENC_PARAMS* strEncParams, int16_t* input,
                            uint8_t* output);
 extern void SBC_Encoder_Init(SBC_ENC_PARAMS* strEncParams);
 
+/* Return the best of the SBC_SIMD_* instruction sets the CPU supports. */
+extern int16_t SBC_Encoder_GetBestSimd(void);
+
+/* Make the encoder use the SBC_SIMD_* instruction set |simd|, overriding the
+ * one SBC_Encoder_Init() picks. The frames do not depend on it, and it may be
+ * called while another thread encodes: the switch takes effect per encoding
+ * stage. Return false if the CPU or the build does not support it. */
+extern bool SBC_Encoder_SetSimd(int16_t simd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -197,10 +197,65 @@
 #define WIND_8_SUBBANDS_8_2 (int16_t)0x12CF /* 40 = 0x12CF6C75 */
 #endif
 
+#if (SBC_SIMD_OPT == TRUE)
+const int16_t gas16WindowFor4SBs[5][8] = {
+    {0, WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_3_0,
+     WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_2_4,
+     WIND_4_SUBBANDS_1_4},
+    {WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_2_1,
+     WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_3,
+     WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_1_3},
+    {WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_2, WIND_4_SUBBANDS_2_2,
+     WIND_4_SUBBANDS_3_2, WIND_4_SUBBANDS_4_2, WIND_4_SUBBANDS_3_2,
+     WIND_4_SUBBANDS_2_2, WIND_4_SUBBANDS_1_2},
+    {-WIND_4_SUBBANDS_0_2, WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_2_3,
+     WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_3_1,
+     WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_1_1},
+    {-WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_1_4, WIND_4_SUBBANDS_2_4,
+     WIND_4_SUBBANDS_3_4, WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_3_0,
+     WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_1_0},
+};
+const int16_t gas16WindowFor8SBs[5][16] = {
+    {0, WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_3_0,
+     WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_6_0,
+     WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_7_4,
+     WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_5_4, WIND_8_SUBBANDS_4_4,
+     WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_2_4, WIND_8_SUBBANDS_1_4},
+    {WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_2_1,
+     WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_5_1,
+     WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_8_1,
+     WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_5_3,
+     WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_2_3,
+     WIND_8_SUBBANDS_1_3},
+    {WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_2, WIND_8_SUBBANDS_2_2,
+     WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_5_2,
+     WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_8_2,
+     WIND_8_SUBBANDS_7_2, WIND_8_SUBBANDS_6_2, WIND_8_SUBBANDS_5_2,
+     WIND_8_SUBBANDS_4_2, WIND_8_SUBBANDS_3_2, WIND_8_SUBBANDS_2_2,
+     WIND_8_SUBBANDS_1_2},
+    {-WIND_8_SUBBANDS_0_2, WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_2_3,
+     WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_5_3,
+     WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_8_1,
+     WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_5_1,
+     WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_2_1,
+     WIND_8_SUBBANDS_1_1},
+    {-WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_1_4, WIND_8_SUBBANDS_2_4,
+     WIND_8_SUBBANDS_3_4, WIND_8_SUBBANDS_4_4, WIND_8_SUBBANDS_5_4,
+     WIND_8_SUBBANDS_6_4, WIND_8_SUBBANDS_7_4, WIND_8_SUBBANDS_8_0,
+     WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_5_0,
+     WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_2_0,
+     WIND_8_SUBBANDS_1_0},
+};
+#endif
+
 #if (SBC_USE_ARM_PRAGMA == TRUE)
 #pragma arm section zidata = "sbc_s32_analysis_section"
 #endif
 static int32_t s32DCTY[16] = {0};
+#if (SBC_SIMD_OPT == TRUE)
+/* Windowed blocks of a frame, matrixed together by the vector kernels */
+static int32_t s32DCTYs[SBC_MAX_NUM_OF_BLOCKS * SBC_MAX_NUM_OF_CHANNELS * 16];
+#endif
 static int32_t s32X[ENC_VX_BUFFER_SIZE / 2];
 static int16_t* s16X =
     (int16_t*)s32X; /* s16X must be 32 bits aligned cf  SHIFTUP_X8_2*/
@@ -1199,6 +1254,10 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t Offset, Offset2, ChOffset;
+#if (SBC_SIMD_OPT == TRUE)
+  const SBC_ENC_SIMD_KERNELS* pstrSimd = SbcEncSimdKernels();
+  int32_t* ps32DCTY = s32DCTYs;
+#endif
 #if (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
@@ -1257,6 +1316,13 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
+#if (SBC_SIMD_OPT == TRUE)
+      if (pstrSimd != NULL) {
+        pstrSimd->Window4(s16X + ChOffset, ps32DCTY);
+        ps32DCTY += 2 * SUB_BANDS_4;
+        continue;
+      }
+#endif
       WINDOW_PARTIAL_4
 
       SBC_FastIDCT4(s32DCTY, ps32SbBuf);
@@ -1279,6 +1345,12 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+#if (SBC_SIMD_OPT == TRUE)
+  if (pstrSimd != NULL) {
+    pstrSimd->Dct4(s32DCTYs, pstrEncParams->s32SbBuffer,
+                   s32NumOfBlocks * s32NumOfChannels);
+  }
+#endif
 }
 
 /* ////////////////////////////////////////////////////////////////////////// */
@@ -1290,6 +1362,10 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   int32_t s32NumOfChannels, s32NumOfBlocks;
   int32_t i, *ps32X, *ps32X2;
   int32_t ChOffset;
+#if (SBC_SIMD_OPT == TRUE)
+  const SBC_ENC_SIMD_KERNELS* pstrSimd = SbcEncSimdKernels();
+  int32_t* ps32DCTY = s32DCTYs;
+#endif
 #if (SBC_ARM_ASM_OPT == TRUE)
   register int32_t s32Hi, s32Hi2;
 #else
@@ -1370,6 +1446,13 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
+#if (SBC_SIMD_OPT == TRUE)
+      if (pstrSimd != NULL) {
+        pstrSimd->Window8(s16X + ChOffset, ps32DCTY);
+        ps32DCTY += 2 * SUB_BANDS_8;
+        continue;
+      }
+#endif
       WINDOW_PARTIAL_8
 
       SBC_FastIDCT8(s32DCTY, ps32SbBuf);
@@ -1392,6 +1475,12 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
       }
     }
   }
+#if (SBC_SIMD_OPT == TRUE)
+  if (pstrSimd != NULL) {
+    pstrSimd->Dct8(s32DCTYs, pstrEncParams->s32SbBuffer,
+                   s32NumOfBlocks * s32NumOfChannels);
+  }
+#endif
 }
 
 void SbcAnalysisInit(void) {
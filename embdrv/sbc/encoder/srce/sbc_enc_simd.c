@@ -0,0 +1,720 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the SSE4.1, AVX2 and NEON kernels of the windowing,
+ *  matrixing, scale factor and quantizer stages, and picks the ones the CPU
+ *  supports.
+ *
+ *  The kernels do the integer operations of the scalar code in the same
+ *  order, so the encoded frames are the same whichever is used: the
+ *  windowing sums are exact, the DCT runs SBC_FastIDCT4/8 on 4 or 8 blocks
+ *  at once, one per lane, and the quantizer multiplication is widened to 64
+ *  bits as in Mult64.
+ *
+ ******************************************************************************/
+
+#include "sbc_dct.h"
+#include "sbc_enc_func_declare.h"
+#include "sbc_encoder.h"
+
+#if (SBC_SIMD_OPT == TRUE)
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SBC_SIMD_X86
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define SBC_SIMD_ARM_NEON
+#endif
+#endif
+
+#if defined(SBC_SIMD_X86) || defined(SBC_SIMD_ARM_NEON)
+/* SBC_FastIDCT8 of the vectors in[0..15] into out[0..7], each lane being one
+ * block. ADD, SUB, SHR1 (arithmetic shift right by 1), SHL1 and MULT (the
+ * SBC_IDCT_MULT of a constant) are the lane-wise operations of the kernel. */
+#define SBC_SIMD_FAST_IDCT8(VEC, in, out, ADD, SUB, SHR1, SHL1, MULT) \
+  {                                                                   \
+    VEC x0, x1, x2, x3, x4, x5, x6, x7, temp;                         \
+    VEC res_even0, res_even1, res_even2, res_even3;                   \
+    VEC res_odd0, res_odd1, res_odd2, res_odd3;                       \
+    x0 = MULT(SBC_COS_PI_SUR_4, in[4]);                               \
+    x1 = SHR1(ADD(in[3], in[5]));                                     \
+    x2 = SHR1(ADD(in[2], in[6]));                                     \
+    x3 = SHR1(ADD(in[1], in[7]));                                     \
+    x4 = SHR1(ADD(in[0], in[8]));                                     \
+    x5 = SHR1(SUB(in[9], in[15]));                                    \
+    x6 = SHR1(SUB(in[10], in[14]));                                   \
+    x7 = SHR1(SUB(in[11], in[13]));                                   \
+    temp = x0;                                                        \
+    x0 = MULT(SBC_COS_PI_SUR_4, ADD(x0, x4));                         \
+    x4 = MULT(SBC_COS_PI_SUR_4, SUB(temp, x4));                       \
+    x2 = SUB(x2, x6);                                                 \
+    x6 = MULT(SBC_COS_PI_SUR_4, SHL1(x6));                            \
+    temp = x2;                                                        \
+    x2 = MULT(SBC_COS_PI_SUR_8, ADD(x2, x6));                         \
+    x6 = MULT(SBC_COS_3PI_SUR_8, SUB(temp, x6));                      \
+    res_even0 = ADD(x0, x2);                                          \
+    res_even1 = ADD(x4, x6);                                          \
+    res_even2 = SUB(x4, x6);                                          \
+    res_even3 = SUB(x0, x2);                                          \
+    x7 = SHL1(x7);                                                    \
+    x5 = SUB(SHL1(x5), x7);                                           \
+    x3 = SUB(SHL1(x3), x5);                                           \
+    x1 = SUB(x1, SHR1(x3));                                           \
+    x5 = MULT(SBC_COS_PI_SUR_4, x5);                                  \
+    temp = x1;                                                        \
+    x1 = ADD(x1, x5);                                                 \
+    x5 = SUB(temp, x5);                                               \
+    x3 = SUB(x3, x7);                                                 \
+    x7 = MULT(SBC_COS_PI_SUR_4, SHL1(x7));                            \
+    temp = x3;                                                        \
+    x3 = MULT(SBC_COS_PI_SUR_8, ADD(x3, x7));                         \
+    x7 = MULT(SBC_COS_3PI_SUR_8, SUB(temp, x7));                      \
+    res_odd0 = MULT(SBC_COS_PI_SUR_16, ADD(x1, x3));                  \
+    res_odd1 = MULT(SBC_COS_3PI_SUR_16, ADD(x5, x7));                 \
+    res_odd2 = MULT(SBC_COS_5PI_SUR_16, SUB(x5, x7));                 \
+    res_odd3 = MULT(SBC_COS_7PI_SUR_16, SUB(x1, x3));                 \
+    out[0] = ADD(res_even0, res_odd0);                                \
+    out[1] = ADD(res_even1, res_odd1);                                \
+    out[2] = ADD(res_even2, res_odd2);                                \
+    out[3] = ADD(res_even3, res_odd3);                                \
+    out[7] = SUB(res_even0, res_odd0);                                \
+    out[6] = SUB(res_even1, res_odd1);                                \
+    out[5] = SUB(res_even2, res_odd2);                                \
+    out[4] = SUB(res_even3, res_odd3);                                \
+  }
+
+/* SBC_FastIDCT4 of the vectors in[0..7] into out[0..3], as above */
+#define SBC_SIMD_FAST_IDCT4(VEC, in, out, ADD, SUB, SHR1, MULT)   \
+  {                                                               \
+    VEC temp, x2, tmp0, tmp1, tmp2, tmp3, tmp4, tmp5, tmp6, tmp7; \
+    x2 = SHR1(in[2]);                                             \
+    temp = ADD(in[0], in[4]);                                     \
+    tmp0 = MULT((SBC_COS_PI_SUR_4 >> 1), temp);                   \
+    tmp1 = SUB(x2, tmp0);                                         \
+    tmp0 = ADD(tmp0, x2);                                         \
+    temp = ADD(in[1], in[3]);                                     \
+    tmp3 = MULT((SBC_COS_3PI_SUR_8 >> 1), temp);                  \
+    tmp2 = MULT((SBC_COS_PI_SUR_8 >> 1), temp);                   \
+    temp = SUB(in[5], in[7]);                                     \
+    tmp5 = MULT((SBC_COS_3PI_SUR_8 >> 1), temp);                  \
+    tmp4 = MULT((SBC_COS_PI_SUR_8 >> 1), temp);                   \
+    tmp6 = ADD(tmp2, tmp5);                                       \
+    tmp7 = SUB(tmp3, tmp4);                                       \
+    out[0] = ADD(tmp0, tmp6);                                     \
+    out[1] = ADD(tmp1, tmp7);                                     \
+    out[2] = SUB(tmp1, tmp7);                                     \
+    out[3] = SUB(tmp0, tmp6);                                     \
+  }
+
+/* Parameters of the quantizer of EncPacking for 16 consecutive samples of
+ * s32SbBuffer, which repeat every 4, 8 or 16 samples.
+ *
+ * The quantized value is bits 14 + scale factor and up of
+ * (s32Temp1 * u16Levels), which are bits 29 and up of
+ * (s32Temp1 * (u16Levels << (15 - scale factor))). The multiplier fits in 31
+ * bits, and the shift is then the same in every lane. */
+static void SbcQuantizerParams(int32_t s32NumOfColumns,
+                               const int16_t* ps16ScaleFactor,
+                               const int16_t* ps16Bits, int32_t* ps32Offset,
+                               int32_t* ps32Multiplier) {
+  int32_t s32Lane, s32Col;
+  uint16_t u16Levels;
+
+  for (s32Lane = 0; s32Lane < 16; s32Lane++) {
+    s32Col = s32Lane % s32NumOfColumns;
+    u16Levels = (uint16_t)(((uint32_t)1 << ps16Bits[s32Col]) - 1);
+    ps32Offset[s32Lane] =
+        (int32_t)((uint32_t)1 << (ps16ScaleFactor[s32Col] + 13));
+    ps32Multiplier[s32Lane] = (int32_t)u16Levels
+                              << (15 - ps16ScaleFactor[s32Col]);
+  }
+}
+#endif
+
+#if defined(SBC_SIMD_X86)
+#define SBC_SSE41_SHR1(v) _mm_srai_epi32(v, 1)
+#define SBC_SSE41_SHL1(v) _mm_slli_epi32(v, 1)
+#define SBC_AVX2_SHR1(v) _mm256_srai_epi32(v, 1)
+#define SBC_AVX2_SHL1(v) _mm256_slli_epi32(v, 1)
+
+/* (int32_t)(((int64_t)s32Coeff * v) >> 15) in each lane */
+TARGET_SSE41 static inline __m128i SbcSse41Mult(int32_t s32Coeff, __m128i v) {
+  __m128i coeff = _mm_set1_epi32(s32Coeff);
+  __m128i even = _mm_srli_epi64(_mm_mul_epi32(v, coeff), 15);
+  __m128i odd = _mm_slli_epi64(_mm_mul_epi32(_mm_srli_epi64(v, 32), coeff), 17);
+  return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+TARGET_AVX2 static inline __m256i SbcAvx2Mult(int32_t s32Coeff, __m256i v) {
+  __m256i coeff = _mm256_set1_epi32(s32Coeff);
+  __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(v, coeff), 15);
+  __m256i odd =
+      _mm256_slli_epi64(_mm256_mul_epi32(_mm256_srli_epi64(v, 32), coeff), 17);
+  return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+TARGET_SSE41 static inline void SbcSse41Transpose(__m128i* v) {
+  __m128i t0 = _mm_unpacklo_epi32(v[0], v[1]);
+  __m128i t1 = _mm_unpacklo_epi32(v[2], v[3]);
+  __m128i t2 = _mm_unpackhi_epi32(v[0], v[1]);
+  __m128i t3 = _mm_unpackhi_epi32(v[2], v[3]);
+  v[0] = _mm_unpacklo_epi64(t0, t1);
+  v[1] = _mm_unpackhi_epi64(t0, t1);
+  v[2] = _mm_unpacklo_epi64(t2, t3);
+  v[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+/* Transposes the 4x4 blocks of both halves */
+TARGET_AVX2 static inline void SbcAvx2Transpose(__m256i* v) {
+  __m256i t0 = _mm256_unpacklo_epi32(v[0], v[1]);
+  __m256i t1 = _mm256_unpacklo_epi32(v[2], v[3]);
+  __m256i t2 = _mm256_unpackhi_epi32(v[0], v[1]);
+  __m256i t3 = _mm256_unpackhi_epi32(v[2], v[3]);
+  v[0] = _mm256_unpacklo_epi64(t0, t1);
+  v[1] = _mm256_unpackhi_epi64(t0, t1);
+  v[2] = _mm256_unpacklo_epi64(t2, t3);
+  v[3] = _mm256_unpackhi_epi64(t2, t3);
+}
+
+/* Loads columns |s32Col| to |s32Col| + 3 of the rows |s32Row| to |s32Row| + 7
+ * of a matrix, the first 4 rows in the lower halves */
+TARGET_AVX2 static inline __m256i SbcAvx2LoadRows(const int32_t* ps32Row,
+                                                  int32_t s32Stride) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)ps32Row)),
+      _mm_loadu_si128((const __m128i*)(ps32Row + 4 * s32Stride)), 1);
+}
+
+/* Windowing: each pair of taps is one _mm_madd_epi16 of the interleaved
+ * samples and coefficients. The sums are exact, as in the scalar code. */
+TARGET_SSE41 static inline void SbcSse41Window(const int16_t* ps16X,
+                                               const int16_t* ps16Coeff,
+                                               int32_t s32Stride,
+                                               int32_t* ps32DCTY) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i x[5], w[5], lo, hi;
+  int32_t k;
+
+  for (k = 0; k < 5; k++) {
+    x[k] = _mm_loadu_si128((const __m128i*)(ps16X + k * s32Stride));
+    w[k] = _mm_loadu_si128((const __m128i*)(ps16Coeff + k * s32Stride));
+  }
+  lo = _mm_madd_epi16(_mm_unpacklo_epi16(x[0], x[1]),
+                      _mm_unpacklo_epi16(w[0], w[1]));
+  hi = _mm_madd_epi16(_mm_unpackhi_epi16(x[0], x[1]),
+                      _mm_unpackhi_epi16(w[0], w[1]));
+  lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x[2], x[3]),
+                                        _mm_unpacklo_epi16(w[2], w[3])));
+  hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x[2], x[3]),
+                                        _mm_unpackhi_epi16(w[2], w[3])));
+  lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(x[4], zero),
+                                        _mm_unpacklo_epi16(w[4], zero)));
+  hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(x[4], zero),
+                                        _mm_unpackhi_epi16(w[4], zero)));
+  _mm_storeu_si128((__m128i*)ps32DCTY, lo);
+  _mm_storeu_si128((__m128i*)(ps32DCTY + 4), hi);
+}
+
+TARGET_SSE41 static void SbcSse41Window4(const int16_t* ps16X,
+                                         int32_t* ps32DCTY) {
+  SbcSse41Window(ps16X, &gas16WindowFor4SBs[0][0], 8, ps32DCTY);
+}
+
+TARGET_SSE41 static void SbcSse41Window8(const int16_t* ps16X,
+                                         int32_t* ps32DCTY) {
+  SbcSse41Window(ps16X, &gas16WindowFor8SBs[0][0], 16, ps32DCTY);
+  SbcSse41Window(ps16X + 8, &gas16WindowFor8SBs[0][8], 16, ps32DCTY + 8);
+}
+
+TARGET_SSE41 static void SbcSse41Dct4(const int32_t* ps32DCTY,
+                                      int32_t* ps32SbBuf, int32_t s32Count) {
+  __m128i in[8], out[4];
+  int32_t s32Row, k, r;
+
+  for (s32Row = 0; s32Row < s32Count; s32Row += 4) {
+    for (k = 0; k < 8; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = _mm_loadu_si128(
+            (const __m128i*)(ps32DCTY + (s32Row + r) * 8 + k));
+      }
+      SbcSse41Transpose(&in[k]);
+    }
+    SBC_SIMD_FAST_IDCT4(__m128i, in, out, _mm_add_epi32, _mm_sub_epi32,
+                        SBC_SSE41_SHR1, SbcSse41Mult);
+    SbcSse41Transpose(out);
+    for (r = 0; r < 4; r++) {
+      _mm_storeu_si128((__m128i*)(ps32SbBuf + (s32Row + r) * 4), out[r]);
+    }
+  }
+}
+
+TARGET_SSE41 static void SbcSse41Dct8(const int32_t* ps32DCTY,
+                                      int32_t* ps32SbBuf, int32_t s32Count) {
+  __m128i in[16], out[8];
+  int32_t s32Row, k, r;
+
+  for (s32Row = 0; s32Row < s32Count; s32Row += 4) {
+    for (k = 0; k < 16; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = _mm_loadu_si128(
+            (const __m128i*)(ps32DCTY + (s32Row + r) * 16 + k));
+      }
+      SbcSse41Transpose(&in[k]);
+    }
+    SBC_SIMD_FAST_IDCT8(__m128i, in, out, _mm_add_epi32, _mm_sub_epi32,
+                        SBC_SSE41_SHR1, SBC_SSE41_SHL1, SbcSse41Mult);
+    SbcSse41Transpose(&out[0]);
+    SbcSse41Transpose(&out[4]);
+    for (r = 0; r < 4; r++) {
+      _mm_storeu_si128((__m128i*)(ps32SbBuf + (s32Row + r) * 8), out[r]);
+      _mm_storeu_si128((__m128i*)(ps32SbBuf + (s32Row + r) * 8 + 4),
+                       out[4 + r]);
+    }
+  }
+}
+
+/* Same as SbcSse41Dct4/8 on 8 blocks at once, the last 4 if any with SSE4.1 */
+TARGET_AVX2 static void SbcAvx2Dct4(const int32_t* ps32DCTY,
+                                    int32_t* ps32SbBuf, int32_t s32Count) {
+  __m256i in[8], out[4];
+  int32_t s32Row, k, r;
+
+  for (s32Row = 0; s32Row + 8 <= s32Count; s32Row += 8) {
+    for (k = 0; k < 8; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = SbcAvx2LoadRows(ps32DCTY + (s32Row + r) * 8 + k, 8);
+      }
+      SbcAvx2Transpose(&in[k]);
+    }
+    SBC_SIMD_FAST_IDCT4(__m256i, in, out, _mm256_add_epi32, _mm256_sub_epi32,
+                        SBC_AVX2_SHR1, SbcAvx2Mult);
+    SbcAvx2Transpose(out);
+    for (r = 0; r < 4; r++) {
+      _mm_storeu_si128((__m128i*)(ps32SbBuf + (s32Row + r) * 4),
+                       _mm256_castsi256_si128(out[r]));
+      _mm_storeu_si128((__m128i*)(ps32SbBuf + (s32Row + r + 4) * 4),
+                       _mm256_extracti128_si256(out[r], 1));
+    }
+  }
+  if (s32Row < s32Count) {
+    SbcSse41Dct4(ps32DCTY + s32Row * 8, ps32SbBuf + s32Row * 4,
+                 s32Count - s32Row);
+  }
+}
+
+TARGET_AVX2 static void SbcAvx2Dct8(const int32_t* ps32DCTY,
+                                    int32_t* ps32SbBuf, int32_t s32Count) {
+  __m256i in[16], out[8];
+  int32_t s32Row, k, r;
+
+  for (s32Row = 0; s32Row + 8 <= s32Count; s32Row += 8) {
+    for (k = 0; k < 16; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = SbcAvx2LoadRows(ps32DCTY + (s32Row + r) * 16 + k, 16);
+      }
+      SbcAvx2Transpose(&in[k]);
+    }
+    SBC_SIMD_FAST_IDCT8(__m256i, in, out, _mm256_add_epi32, _mm256_sub_epi32,
+                        SBC_AVX2_SHR1, SBC_AVX2_SHL1, SbcAvx2Mult);
+    SbcAvx2Transpose(&out[0]);
+    SbcAvx2Transpose(&out[4]);
+    for (r = 0; r < 4; r++) {
+      _mm256_storeu_si256(
+          (__m256i*)(ps32SbBuf + (s32Row + r) * 8),
+          _mm256_permute2x128_si256(out[r], out[4 + r], 0x20));
+      _mm256_storeu_si256(
+          (__m256i*)(ps32SbBuf + (s32Row + r + 4) * 8),
+          _mm256_permute2x128_si256(out[r], out[4 + r], 0x31));
+    }
+  }
+  if (s32Row < s32Count) {
+    SbcSse41Dct8(ps32DCTY + s32Row * 16, ps32SbBuf + s32Row * 8,
+                 s32Count - s32Row);
+  }
+}
+
+TARGET_SSE41 static void SbcSse41MaxAbs(const int32_t* ps32SbBuf,
+                                        int32_t s32NumOfBlocks,
+                                        int32_t s32NumOfColumns,
+                                        int32_t* ps32Max) {
+  int32_t s32Col, s32Blk;
+  const int32_t* ps32Sb;
+  __m128i max;
+
+  for (s32Col = 0; s32Col < s32NumOfColumns; s32Col += 4) {
+    ps32Sb = ps32SbBuf + s32Col;
+    max = _mm_setzero_si128();
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      max = _mm_max_epi32(
+          max, _mm_abs_epi32(_mm_loadu_si128((const __m128i*)ps32Sb)));
+      ps32Sb += s32NumOfColumns;
+    }
+    _mm_storeu_si128((__m128i*)(ps32Max + s32Col), max);
+  }
+}
+
+TARGET_SSE41 static void SbcSse41MaxAbsJoint(const int32_t* ps32SbBuf,
+                                             int32_t s32NumOfBlocks,
+                                             int32_t s32NumOfSubBands,
+                                             int32_t* ps32MaxSum,
+                                             int32_t* ps32MaxDiff) {
+  int32_t s32Sb, s32Blk;
+  const int32_t* ps32Sb;
+  __m128i left, right, max_sum, max_diff;
+
+  for (s32Sb = 0; s32Sb < s32NumOfSubBands; s32Sb += 4) {
+    ps32Sb = ps32SbBuf + s32Sb;
+    max_sum = _mm_setzero_si128();
+    max_diff = _mm_setzero_si128();
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      left = _mm_loadu_si128((const __m128i*)ps32Sb);
+      right = _mm_loadu_si128((const __m128i*)(ps32Sb + s32NumOfSubBands));
+      max_sum = _mm_max_epi32(
+          max_sum,
+          _mm_abs_epi32(_mm_srai_epi32(_mm_add_epi32(left, right), 1)));
+      max_diff = _mm_max_epi32(
+          max_diff,
+          _mm_abs_epi32(_mm_srai_epi32(_mm_sub_epi32(left, right), 1)));
+      ps32Sb += s32NumOfSubBands << 1;
+    }
+    _mm_storeu_si128((__m128i*)(ps32MaxSum + s32Sb), max_sum);
+    _mm_storeu_si128((__m128i*)(ps32MaxDiff + s32Sb), max_diff);
+  }
+}
+
+/* Quantizes 4 samples, leaving each value in the low 16 bits of its lane */
+TARGET_SSE41 static inline __m128i SbcSse41Quantize4(const int32_t* ps32Sb,
+                                                     const int32_t* ps32Offset,
+                                                     const int32_t* ps32Mult) {
+  __m128i mult = _mm_loadu_si128((const __m128i*)ps32Mult);
+  __m128i temp = _mm_add_epi32(
+      _mm_srai_epi32(_mm_loadu_si128((const __m128i*)ps32Sb), 2),
+      _mm_loadu_si128((const __m128i*)ps32Offset));
+  __m128i even = _mm_srli_epi64(_mm_mul_epi32(temp, mult), 29);
+  __m128i odd = _mm_slli_epi64(
+      _mm_mul_epi32(_mm_srli_epi64(temp, 32), _mm_srli_epi64(mult, 32)), 3);
+  return _mm_and_si128(_mm_blend_epi16(even, odd, 0xCC),
+                       _mm_set1_epi32(0xFFFF));
+}
+
+TARGET_SSE41 static void SbcSse41Quantize(const int32_t* ps32SbBuf,
+                                          int32_t s32NumOfBlocks,
+                                          int32_t s32NumOfColumns,
+                                          const int16_t* ps16ScaleFactor,
+                                          const int16_t* ps16Bits,
+                                          uint16_t* pu16Quantized) {
+  int32_t as32Offset[16], as32Mult[16];
+  int32_t s32Sample, s32Lane;
+  int32_t s32NumOfSamples = s32NumOfBlocks * s32NumOfColumns;
+
+  SbcQuantizerParams(s32NumOfColumns, ps16ScaleFactor, ps16Bits, as32Offset,
+                     as32Mult);
+  for (s32Sample = 0; s32Sample < s32NumOfSamples; s32Sample += 16) {
+    for (s32Lane = 0; s32Lane < 16; s32Lane += 8) {
+      __m128i lo = SbcSse41Quantize4(ps32SbBuf + s32Sample + s32Lane,
+                                     as32Offset + s32Lane, as32Mult + s32Lane);
+      __m128i hi =
+          SbcSse41Quantize4(ps32SbBuf + s32Sample + s32Lane + 4,
+                            as32Offset + s32Lane + 4, as32Mult + s32Lane + 4);
+      _mm_storeu_si128((__m128i*)(pu16Quantized + s32Sample + s32Lane),
+                       _mm_packus_epi32(lo, hi));
+    }
+  }
+}
+
+TARGET_AVX2 static inline __m256i SbcAvx2Quantize8(const int32_t* ps32Sb,
+                                                   const int32_t* ps32Offset,
+                                                   const int32_t* ps32Mult) {
+  __m256i mult = _mm256_loadu_si256((const __m256i*)ps32Mult);
+  __m256i temp = _mm256_add_epi32(
+      _mm256_srai_epi32(_mm256_loadu_si256((const __m256i*)ps32Sb), 2),
+      _mm256_loadu_si256((const __m256i*)ps32Offset));
+  __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(temp, mult), 29);
+  __m256i odd = _mm256_slli_epi64(
+      _mm256_mul_epi32(_mm256_srli_epi64(temp, 32),
+                       _mm256_srli_epi64(mult, 32)),
+      3);
+  return _mm256_and_si256(_mm256_blend_epi32(even, odd, 0xAA),
+                          _mm256_set1_epi32(0xFFFF));
+}
+
+TARGET_AVX2 static void SbcAvx2Quantize(const int32_t* ps32SbBuf,
+                                        int32_t s32NumOfBlocks,
+                                        int32_t s32NumOfColumns,
+                                        const int16_t* ps16ScaleFactor,
+                                        const int16_t* ps16Bits,
+                                        uint16_t* pu16Quantized) {
+  int32_t as32Offset[16], as32Mult[16];
+  int32_t s32Sample;
+  int32_t s32NumOfSamples = s32NumOfBlocks * s32NumOfColumns;
+
+  SbcQuantizerParams(s32NumOfColumns, ps16ScaleFactor, ps16Bits, as32Offset,
+                     as32Mult);
+  for (s32Sample = 0; s32Sample < s32NumOfSamples; s32Sample += 16) {
+    __m256i lo =
+        SbcAvx2Quantize8(ps32SbBuf + s32Sample, as32Offset, as32Mult);
+    __m256i hi = SbcAvx2Quantize8(ps32SbBuf + s32Sample + 8, as32Offset + 8,
+                                  as32Mult + 8);
+    /* _mm256_packus_epi32 packs each half on its own */
+    _mm256_storeu_si256(
+        (__m256i*)(pu16Quantized + s32Sample),
+        _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8));
+  }
+}
+
+static const SBC_ENC_SIMD_KERNELS strSbcEncSse41 = {
+    SbcSse41Window4, SbcSse41Window8, SbcSse41Dct4,     SbcSse41Dct8,
+    SbcSse41MaxAbs,  SbcSse41MaxAbsJoint, SbcSse41Quantize,
+};
+
+/* The windowing and scale factor stages are too short to gain from AVX2 */
+static const SBC_ENC_SIMD_KERNELS strSbcEncAvx2 = {
+    SbcSse41Window4, SbcSse41Window8,     SbcAvx2Dct4,    SbcAvx2Dct8,
+    SbcSse41MaxAbs,  SbcSse41MaxAbsJoint, SbcAvx2Quantize,
+};
+#endif
+
+#if defined(SBC_SIMD_ARM_NEON)
+#define SBC_NEON_SHR1(v) vshrq_n_s32(v, 1)
+#define SBC_NEON_SHL1(v) vshlq_n_s32(v, 1)
+
+/* (int32_t)(((int64_t)s32Coeff * v) >> 15) in each lane */
+static inline int32x4_t SbcNeonMult(int32_t s32Coeff, int32x4_t v) {
+  int32x2_t coeff = vdup_n_s32(s32Coeff);
+  return vcombine_s32(vshrn_n_s64(vmull_s32(vget_low_s32(v), coeff), 15),
+                      vshrn_n_s64(vmull_s32(vget_high_s32(v), coeff), 15));
+}
+
+static inline void SbcNeonTranspose(int32x4_t* v) {
+  int32x4x2_t t01 = vtrnq_s32(v[0], v[1]);
+  int32x4x2_t t23 = vtrnq_s32(v[2], v[3]);
+  v[0] = vcombine_s32(vget_low_s32(t01.val[0]), vget_low_s32(t23.val[0]));
+  v[1] = vcombine_s32(vget_low_s32(t01.val[1]), vget_low_s32(t23.val[1]));
+  v[2] = vcombine_s32(vget_high_s32(t01.val[0]), vget_high_s32(t23.val[0]));
+  v[3] = vcombine_s32(vget_high_s32(t01.val[1]), vget_high_s32(t23.val[1]));
+}
+
+/* Windowing of 4 values of s32DCTY, the sums are exact as in the scalar code */
+static inline void SbcNeonWindow(const int16_t* ps16X, const int16_t* ps16Coeff,
+                                 int32_t s32Stride, int32_t* ps32DCTY) {
+  int32x4_t sum = vmull_s16(vld1_s16(ps16X), vld1_s16(ps16Coeff));
+  int32_t k;
+
+  for (k = 1; k < 5; k++) {
+    sum = vmlal_s16(sum, vld1_s16(ps16X + k * s32Stride),
+                    vld1_s16(ps16Coeff + k * s32Stride));
+  }
+  vst1q_s32(ps32DCTY, sum);
+}
+
+static void SbcNeonWindow4(const int16_t* ps16X, int32_t* ps32DCTY) {
+  int32_t i;
+
+  for (i = 0; i < 8; i += 4) {
+    SbcNeonWindow(ps16X + i, &gas16WindowFor4SBs[0][i], 8, ps32DCTY + i);
+  }
+}
+
+static void SbcNeonWindow8(const int16_t* ps16X, int32_t* ps32DCTY) {
+  int32_t i;
+
+  for (i = 0; i < 16; i += 4) {
+    SbcNeonWindow(ps16X + i, &gas16WindowFor8SBs[0][i], 16, ps32DCTY + i);
+  }
+}
+
+static void SbcNeonDct4(const int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                        int32_t s32Count) {
+  int32x4_t in[8], out[4];
+  int32_t s32Row, k, r;
+
+  for (s32Row = 0; s32Row < s32Count; s32Row += 4) {
+    for (k = 0; k < 8; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = vld1q_s32(ps32DCTY + (s32Row + r) * 8 + k);
+      }
+      SbcNeonTranspose(&in[k]);
+    }
+    SBC_SIMD_FAST_IDCT4(int32x4_t, in, out, vaddq_s32, vsubq_s32,
+                        SBC_NEON_SHR1, SbcNeonMult);
+    SbcNeonTranspose(out);
+    for (r = 0; r < 4; r++) {
+      vst1q_s32(ps32SbBuf + (s32Row + r) * 4, out[r]);
+    }
+  }
+}
+
+static void SbcNeonDct8(const int32_t* ps32DCTY, int32_t* ps32SbBuf,
+                        int32_t s32Count) {
+  int32x4_t in[16], out[8];
+  int32_t s32Row, k, r;
+
+  for (s32Row = 0; s32Row < s32Count; s32Row += 4) {
+    for (k = 0; k < 16; k += 4) {
+      for (r = 0; r < 4; r++) {
+        in[k + r] = vld1q_s32(ps32DCTY + (s32Row + r) * 16 + k);
+      }
+      SbcNeonTranspose(&in[k]);
+    }
+    SBC_SIMD_FAST_IDCT8(int32x4_t, in, out, vaddq_s32, vsubq_s32,
+                        SBC_NEON_SHR1, SBC_NEON_SHL1, SbcNeonMult);
+    SbcNeonTranspose(&out[0]);
+    SbcNeonTranspose(&out[4]);
+    for (r = 0; r < 4; r++) {
+      vst1q_s32(ps32SbBuf + (s32Row + r) * 8, out[r]);
+      vst1q_s32(ps32SbBuf + (s32Row + r) * 8 + 4, out[4 + r]);
+    }
+  }
+}
+
+static void SbcNeonMaxAbs(const int32_t* ps32SbBuf, int32_t s32NumOfBlocks,
+                          int32_t s32NumOfColumns, int32_t* ps32Max) {
+  int32_t s32Col, s32Blk;
+  const int32_t* ps32Sb;
+  int32x4_t max;
+
+  for (s32Col = 0; s32Col < s32NumOfColumns; s32Col += 4) {
+    ps32Sb = ps32SbBuf + s32Col;
+    max = vdupq_n_s32(0);
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      max = vmaxq_s32(max, vabsq_s32(vld1q_s32(ps32Sb)));
+      ps32Sb += s32NumOfColumns;
+    }
+    vst1q_s32(ps32Max + s32Col, max);
+  }
+}
+
+static void SbcNeonMaxAbsJoint(const int32_t* ps32SbBuf, int32_t s32NumOfBlocks,
+                               int32_t s32NumOfSubBands, int32_t* ps32MaxSum,
+                               int32_t* ps32MaxDiff) {
+  int32_t s32Sb, s32Blk;
+  const int32_t* ps32Sb;
+  int32x4_t left, right, max_sum, max_diff;
+
+  for (s32Sb = 0; s32Sb < s32NumOfSubBands; s32Sb += 4) {
+    ps32Sb = ps32SbBuf + s32Sb;
+    max_sum = vdupq_n_s32(0);
+    max_diff = vdupq_n_s32(0);
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      left = vld1q_s32(ps32Sb);
+      right = vld1q_s32(ps32Sb + s32NumOfSubBands);
+      max_sum =
+          vmaxq_s32(max_sum, vabsq_s32(vshrq_n_s32(vaddq_s32(left, right), 1)));
+      max_diff = vmaxq_s32(max_diff,
+                           vabsq_s32(vshrq_n_s32(vsubq_s32(left, right), 1)));
+      ps32Sb += s32NumOfSubBands << 1;
+    }
+    vst1q_s32(ps32MaxSum + s32Sb, max_sum);
+    vst1q_s32(ps32MaxDiff + s32Sb, max_diff);
+  }
+}
+
+static void SbcNeonQuantize(const int32_t* ps32SbBuf, int32_t s32NumOfBlocks,
+                            int32_t s32NumOfColumns,
+                            const int16_t* ps16ScaleFactor,
+                            const int16_t* ps16Bits, uint16_t* pu16Quantized) {
+  int32_t as32Offset[16], as32Mult[16];
+  int32_t s32Sample, s32Lane;
+  int32_t s32NumOfSamples = s32NumOfBlocks * s32NumOfColumns;
+  int32x4_t temp, mult, quantized;
+
+  SbcQuantizerParams(s32NumOfColumns, ps16ScaleFactor, ps16Bits, as32Offset,
+                     as32Mult);
+  for (s32Sample = 0; s32Sample < s32NumOfSamples; s32Sample += 16) {
+    for (s32Lane = 0; s32Lane < 16; s32Lane += 4) {
+      mult = vld1q_s32(as32Mult + s32Lane);
+      temp =
+          vaddq_s32(vshrq_n_s32(vld1q_s32(ps32SbBuf + s32Sample + s32Lane), 2),
+                    vld1q_s32(as32Offset + s32Lane));
+      quantized = vcombine_s32(
+          vshrn_n_s64(vmull_s32(vget_low_s32(temp), vget_low_s32(mult)), 29),
+          vshrn_n_s64(vmull_s32(vget_high_s32(temp), vget_high_s32(mult)),
+                      29));
+      vst1_u16(pu16Quantized + s32Sample + s32Lane,
+               vmovn_u32(vreinterpretq_u32_s32(quantized)));
+    }
+  }
+}
+
+static const SBC_ENC_SIMD_KERNELS strSbcEncNeon = {
+    SbcNeonWindow4, SbcNeonWindow8,     SbcNeonDct4,    SbcNeonDct8,
+    SbcNeonMaxAbs,  SbcNeonMaxAbsJoint, SbcNeonQuantize,
+};
+#endif
+
+#if (SBC_SIMD_OPT == TRUE)
+/* Written by SBC_Encoder_SetSimd() and read by the encoding thread */
+static const SBC_ENC_SIMD_KERNELS* pstrSbcEncSimd = NULL;
+static bool bSbcEncSimdSet = false;
+
+const SBC_ENC_SIMD_KERNELS* SbcEncSimdKernels(void) {
+  return __atomic_load_n(&pstrSbcEncSimd, __ATOMIC_ACQUIRE);
+}
+
+void SbcEncSimdInit(void) {
+  if (!__atomic_load_n(&bSbcEncSimdSet, __ATOMIC_ACQUIRE))
+    SBC_Encoder_SetSimd(SBC_Encoder_GetBestSimd());
+}
+#endif
+
+int16_t SBC_Encoder_GetBestSimd(void) {
+#if defined(SBC_SIMD_X86)
+  if (__builtin_cpu_supports("avx2")) return SBC_SIMD_AVX2;
+  if (__builtin_cpu_supports("sse4.1")) return SBC_SIMD_SSE41;
+#elif defined(SBC_SIMD_ARM_NEON)
+  return SBC_SIMD_NEON;
+#endif
+  return SBC_SIMD_NONE;
+}
+
+bool SBC_Encoder_SetSimd(int16_t simd) {
+#if (SBC_SIMD_OPT == TRUE)
+  const SBC_ENC_SIMD_KERNELS* pstrKernels;
+
+  switch (simd) {
+    case SBC_SIMD_NONE:
+      pstrKernels = NULL;
+      break;
+#if defined(SBC_SIMD_X86)
+    case SBC_SIMD_SSE41:
+      if (!__builtin_cpu_supports("sse4.1")) return false;
+      pstrKernels = &strSbcEncSse41;
+      break;
+    case SBC_SIMD_AVX2:
+      if (!__builtin_cpu_supports("avx2")) return false;
+      pstrKernels = &strSbcEncAvx2;
+      break;
+#elif defined(SBC_SIMD_ARM_NEON)
+    case SBC_SIMD_NEON:
+      pstrKernels = &strSbcEncNeon;
+      break;
+#endif
+    default:
+      return false;
+  }
+  __atomic_store_n(&pstrSbcEncSimd, pstrKernels, __ATOMIC_RELEASE);
+  __atomic_store_n(&bSbcEncSimdSet, true, __ATOMIC_RELEASE);
+  return true;
+#else
+  return simd == SBC_SIMD_NONE;
+#endif
+}
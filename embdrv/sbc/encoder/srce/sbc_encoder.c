@@ -29,11 +29,6 @@
 
 int16_t EncMaxShiftCounter;
 
-#if (SBC_JOINT_STE_INCLUDED == TRUE)
-int32_t s32LRDiff[SBC_MAX_NUM_OF_BLOCKS] = {0};
-int32_t s32LRSum[SBC_MAX_NUM_OF_BLOCKS] = {0};
-#endif
-
 uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
                     uint8_t* output) {
   int32_t s32Ch;                 /* counter for ch*/
@@ -48,9 +43,13 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
 #if (SBC_JOINT_STE_INCLUDED == TRUE)
   int32_t s32MaxValue2;
   uint32_t u32CountSum, u32CountDiff;
-  int32_t *pSum, *pDiff;
+  int32_t s32Sum, s32Diff;
 #endif
   register int32_t s32NumOfSubBands = pstrEncParams->s16NumOfSubBands;
+#if (SBC_SIMD_OPT == TRUE)
+  const SBC_ENC_SIMD_KERNELS* pstrSimd = SbcEncSimdKernels();
+  int32_t as32MaxValue[SBC_BLK], as32MaxValue2[SBC_MAX_NUM_OF_SUBBANDS];
+#endif
 
   /* SBC ananlysis filter*/
   if (s32NumOfSubBands == 4)
@@ -61,13 +60,26 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   /* compute the scale factor, and save the max */
   ps16ScfL = pstrEncParams->as16ScaleFactor;
   s32Ch = pstrEncParams->s16NumOfChannels * s32NumOfSubBands;
+#if (SBC_SIMD_OPT == TRUE)
+  if (pstrSimd != NULL) {
+    pstrSimd->MaxAbs(pstrEncParams->s32SbBuffer, s32NumOfBlocks, s32Ch,
+                     as32MaxValue);
+  }
+#endif
 
   for (s32Sb = 0; s32Sb < s32Ch; s32Sb++) {
-    SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-    s32MaxValue = 0;
-    for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
-      if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
-      SbBuffer += s32Ch;
+#if (SBC_SIMD_OPT == TRUE)
+    if (pstrSimd != NULL) {
+      s32MaxValue = as32MaxValue[s32Sb];
+    } else
+#endif
+    {
+      SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
+      s32MaxValue = 0;
+      for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
+        if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
+        SbBuffer += s32Ch;
+      }
     }
 
     u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
@@ -84,21 +96,31 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   if (pstrEncParams->s16ChannelMode == SBC_JOINT_STEREO) {
     /* Calculate sum and differance  scale factors for making JS decision   */
     ps16ScfL = pstrEncParams->as16ScaleFactor;
+#if (SBC_SIMD_OPT == TRUE)
+    if (pstrSimd != NULL) {
+      pstrSimd->MaxAbsJoint(pstrEncParams->s32SbBuffer, s32NumOfBlocks,
+                            s32NumOfSubBands, as32MaxValue, as32MaxValue2);
+    }
+#endif
     /* calculate the scale factor of Joint stereo max sum and diff */
     for (s32Sb = 0; s32Sb < s32NumOfSubBands - 1; s32Sb++) {
-      SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-      s32MaxValue2 = 0;
-      s32MaxValue = 0;
-      pSum = s32LRSum;
-      pDiff = s32LRDiff;
-      for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
-        *pSum = (*SbBuffer + *(SbBuffer + s32NumOfSubBands)) >> 1;
-        if (abs32(*pSum) > s32MaxValue) s32MaxValue = abs32(*pSum);
-        pSum++;
-        *pDiff = (*SbBuffer - *(SbBuffer + s32NumOfSubBands)) >> 1;
-        if (abs32(*pDiff) > s32MaxValue2) s32MaxValue2 = abs32(*pDiff);
-        pDiff++;
-        SbBuffer += s32Ch;
+#if (SBC_SIMD_OPT == TRUE)
+      if (pstrSimd != NULL) {
+        s32MaxValue = as32MaxValue[s32Sb];
+        s32MaxValue2 = as32MaxValue2[s32Sb];
+      } else
+#endif
+      {
+        SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
+        s32MaxValue2 = 0;
+        s32MaxValue = 0;
+        for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+          s32Sum = (*SbBuffer + *(SbBuffer + s32NumOfSubBands)) >> 1;
+          if (abs32(s32Sum) > s32MaxValue) s32MaxValue = abs32(s32Sum);
+          s32Diff = (*SbBuffer - *(SbBuffer + s32NumOfSubBands)) >> 1;
+          if (abs32(s32Diff) > s32MaxValue2) s32MaxValue2 = abs32(s32Diff);
+          SbBuffer += s32Ch;
+        }
       }
       u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
       for (; u32Count < 15; u32Count++) {
@@ -120,16 +142,14 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
         *(ps16ScfL + s32NumOfSubBands) = (int16_t)u32CountDiff;
 
         SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-        pSum = s32LRSum;
-        pDiff = s32LRDiff;
 
         for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
-          *SbBuffer = *pSum;
-          *(SbBuffer + s32NumOfSubBands) = *pDiff;
+          s32Sum = (*SbBuffer + *(SbBuffer + s32NumOfSubBands)) >> 1;
+          s32Diff = (*SbBuffer - *(SbBuffer + s32NumOfSubBands)) >> 1;
+          *SbBuffer = s32Sum;
+          *(SbBuffer + s32NumOfSubBands) = s32Diff;
 
           SbBuffer += s32NumOfSubBands << 1;
-          pSum++;
-          pDiff++;
         }
 
         pstrEncParams->as16Join[s32Sb] = 1;
@@ -255,4 +275,7 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS* pstrEncParams) {
   }
 
   SbcAnalysisInit();
+#if (SBC_SIMD_OPT == TRUE)
+  SbcEncSimdInit();
+#endif
 }
@@ -77,6 +77,10 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
 #if (SBC_ARM_ASM_OPT != TRUE)
   int64_t s64OutTemp;
 #endif
+#endif
+#if (SBC_SIMD_OPT == TRUE)
+  const SBC_ENC_SIMD_KERNELS* pstrSimd = SbcEncSimdKernels();
+  uint16_t au16Quantized[SBC_MAX_NUM_OF_BLOCKS * SBC_BLK];
 #endif
 
   pu8PacketPtr = output;           /*Initialize the ptr*/
@@ -128,28 +132,43 @@ uint32_t EncPacking(SBC_ENC_PARAMS* pstrEncParams, uint8_t* output) {
   ps32SbPtr = pstrEncParams->s32SbBuffer;
   /*Temp=*pu8PacketPtr;*/
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
+#if (SBC_SIMD_OPT == TRUE)
+  if (pstrSimd != NULL) {
+    pstrSimd->Quantize(ps32SbPtr, s32NumOfBlocks, s32Sb,
+                       pstrEncParams->as16ScaleFactor, pstrEncParams->as16Bits,
+                       au16Quantized);
+  }
+#endif
   for (s32Blk = s32NumOfBlocks - 1; s32Blk >= 0; s32Blk--) {
     ps16GenPtr = pstrEncParams->as16Bits;
     ps16ScfPtr = pstrEncParams->as16ScaleFactor;
     for (s32Ch = s32Sb - 1; s32Ch >= 0; s32Ch--) {
       s32LoopCount = *ps16GenPtr++;
       if (s32LoopCount != 0) {
+#if (SBC_SIMD_OPT == TRUE)
+        if (pstrSimd != NULL) {
+          u32QuantizedSbValue0 =
+              au16Quantized[ps32SbPtr - pstrEncParams->s32SbBuffer];
+        } else
+#endif
 #if (SBC_IS_64_MULT_IN_QUANTIZER == TRUE)
-        /* finding level from reconstruction part of decoder */
-        u32SfRaisedToPow2 = ((uint32_t)1 << ((*ps16ScfPtr) + 1));
-        u16Levels = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
+        {
+          /* finding level from reconstruction part of decoder */
+          u32SfRaisedToPow2 = ((uint32_t)1 << ((*ps16ScfPtr) + 1));
+          u16Levels = (uint16_t)(((uint32_t)1 << s32LoopCount) - 1);
 
-        /* quantizer */
-        s32Temp1 = (*ps32SbPtr >> 2) + (int32_t)(u32SfRaisedToPow2 << 12);
-        s32Temp2 = u16Levels;
+          /* quantizer */
+          s32Temp1 = (*ps32SbPtr >> 2) + (int32_t)(u32SfRaisedToPow2 << 12);
+          s32Temp2 = u16Levels;
 
-        Mult64(s32Temp1, s32Temp2, s32Low, s32Hi);
+          Mult64(s32Temp1, s32Temp2, s32Low, s32Hi);
 
-        s32Low1 = s32Low >> ((*ps16ScfPtr) + 2);
-        s32Low1 &= ((uint32_t)1 << (32 - ((*ps16ScfPtr) + 2))) - 1;
-        s32Hi1 = s32Hi << (32 - ((*ps16ScfPtr) + 2));
+          s32Low1 = s32Low >> ((*ps16ScfPtr) + 2);
+          s32Low1 &= ((uint32_t)1 << (32 - ((*ps16ScfPtr) + 2))) - 1;
+          s32Hi1 = s32Hi << (32 - ((*ps16ScfPtr) + 2));
 
-        u32QuantizedSbValue0 = (uint16_t)((s32Low1 | s32Hi1) >> 12);
+          u32QuantizedSbValue0 = (uint16_t)((s32Low1 | s32Hi1) >> 12);
+        }
 #else
         /* finding level from reconstruction part of decoder */
         u32SfRaisedToPow2 = ((uint32_t)1 << *ps16ScfPtr);
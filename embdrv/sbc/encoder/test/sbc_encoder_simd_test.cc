@@ -0,0 +1,161 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "sbc_encoder.h"
+
+namespace {
+
+constexpr int kNumOfFrames = 24;
+
+struct Config {
+  int16_t sampling_freq;
+  int16_t channel_mode;
+  int16_t num_of_subbands;
+  int16_t num_of_blocks;
+  int16_t allocation_method;
+  int16_t bitpool;
+};
+
+// Tones with noise, full scale square waves and silence, to go through every
+// scale factor and the saturating ends of the quantizer.
+std::vector<int16_t> make_pcm(size_t num_of_samples) {
+  std::vector<int16_t> pcm(num_of_samples);
+  uint32_t seed = 1;
+  for (size_t i = 0; i < pcm.size(); i++) {
+    seed = seed * 1103515245 + 12345;
+    int16_t noise = static_cast<int16_t>(seed >> 16);
+    switch ((i / 1024) % 4) {
+      case 0:
+        pcm[i] = 20000 * sin(0.05 * i) + (noise >> 3);
+        break;
+      case 1:
+        pcm[i] = noise;
+        break;
+      case 2:
+        pcm[i] = (noise & 1) ? 32767 : -32768;
+        break;
+      default:
+        pcm[i] = noise >> (i % 16);
+        break;
+    }
+  }
+  return pcm;
+}
+
+// Encodes with the kernels in use, which another thread may switch.
+std::vector<uint8_t> encode(const Config& config) {
+  SBC_ENC_PARAMS params;
+  memset(&params, 0, sizeof(params));
+  params.s16SamplingFreq = config.sampling_freq;
+  params.s16ChannelMode = config.channel_mode;
+  params.s16NumOfSubBands = config.num_of_subbands;
+  params.s16NumOfBlocks = config.num_of_blocks;
+  params.s16AllocationMethod = config.allocation_method;
+  params.u16BitRate = 328;
+  SBC_Encoder_Init(&params);
+  params.s16BitPool = config.bitpool;
+
+  size_t samples_per_frame =
+      config.num_of_subbands * config.num_of_blocks * params.s16NumOfChannels;
+  std::vector<int16_t> pcm = make_pcm(samples_per_frame * kNumOfFrames);
+  std::vector<uint8_t> frames;
+  uint8_t output[1024];
+  for (int f = 0; f < kNumOfFrames; f++) {
+    uint32_t length =
+        SBC_Encode(&params, &pcm[f * samples_per_frame], output);
+    frames.insert(frames.end(), output, output + length);
+  }
+  return frames;
+}
+
+std::vector<uint8_t> encode(const Config& config, int16_t simd) {
+  EXPECT_TRUE(SBC_Encoder_SetSimd(simd));
+  return encode(config);
+}
+
+}  // namespace
+
+class SbcEncoderSimdTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    SBC_Encoder_SetSimd(SBC_Encoder_GetBestSimd());
+  }
+};
+
+TEST_F(SbcEncoderSimdTest, no_simd_is_always_supported) {
+  EXPECT_TRUE(SBC_Encoder_SetSimd(SBC_SIMD_NONE));
+  EXPECT_FALSE(SBC_Encoder_SetSimd(-1));
+  EXPECT_TRUE(SBC_Encoder_SetSimd(SBC_Encoder_GetBestSimd()));
+}
+
+TEST_F(SbcEncoderSimdTest, frames_are_bit_exact) {
+  const int16_t simds[] = {SBC_SIMD_SSE41, SBC_SIMD_AVX2, SBC_SIMD_NEON};
+  const int16_t modes[] = {SBC_MONO, SBC_DUAL, SBC_STEREO, SBC_JOINT_STEREO};
+  const int16_t bitpools[] = {2, 35, 53, 250};
+
+  for (int16_t simd : simds) {
+    if (!SBC_Encoder_SetSimd(simd)) continue;
+    for (int16_t subbands : {4, 8}) {
+      for (int16_t blocks : {4, 8, 12, 16}) {
+        for (int16_t mode : modes) {
+          for (int16_t allocation : {SBC_LOUDNESS, SBC_SNR}) {
+            for (int16_t bitpool : bitpools) {
+              int16_t max_bitpool =
+                  (mode == SBC_STEREO || mode == SBC_JOINT_STEREO ? 32 : 16) *
+                  subbands;
+              Config config = {SBC_sf44100, mode, subbands, blocks, allocation,
+                               std::min(bitpool, max_bitpool)};
+              SCOPED_TRACE(testing::Message()
+                           << "simd " << simd << " subbands " << subbands
+                           << " blocks " << blocks << " mode " << mode
+                           << " allocation " << allocation << " bitpool "
+                           << config.bitpool);
+              EXPECT_EQ(encode(config, SBC_SIMD_NONE), encode(config, simd));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(SbcEncoderSimdTest, simd_can_be_switched_while_encoding) {
+  int16_t best = SBC_Encoder_GetBestSimd();
+  if (best == SBC_SIMD_NONE) return;
+  Config config = {SBC_sf44100, SBC_JOINT_STEREO, 8, 16, SBC_LOUDNESS, 53};
+  std::vector<uint8_t> expected = encode(config, SBC_SIMD_NONE);
+
+  std::atomic<bool> done(false);
+  std::thread switcher([&done, best]() {
+    for (int i = 0; !done; i++) {
+      SBC_Encoder_SetSimd(i % 2 ? best : SBC_SIMD_NONE);
+    }
+  });
+  for (int i = 0; i < 50; i++) {
+    EXPECT_EQ(expected, encode(config));
+  }
+  done = true;
+  switcher.join();
+}
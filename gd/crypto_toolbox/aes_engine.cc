@@ -0,0 +1,640 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Included relative to this file, which is also built by the legacy stack
+#include "aes_engine.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <wmmintrin.h>
+#define AES_ENGINE_AESNI
+#define TARGET_AESNI __attribute__((target("aes,sse2")))
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define AES_ENGINE_ARMV8_CE
+#if defined(__clang__)
+#define TARGET_ARMV8_CE __attribute__((target("crypto")))
+#else
+#define TARGET_ARMV8_CE __attribute__((target("+crypto")))
+#endif
+#endif
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+namespace {
+
+constexpr size_t kRounds = 10;
+constexpr size_t kRoundKeyWords = 4 * (kRounds + 1);
+constexpr size_t kRoundKeyBytes = 4 * kRoundKeyWords;
+constexpr size_t kBitslicedLanes = 4;
+constexpr size_t kBitslicedGroupWords = 8 * (kRounds + 1);
+
+// The bitsliced implementation below follows the "ct64" construction: four blocks are spread over eight 64-bit words,
+// one word per bit of each byte, and the S-box is evaluated as the Boyar-Peralta boolean circuit, so no memory access
+// depends on the key or the data.
+
+void ortho(uint64_t* q) {
+#define SWAPN(cl, ch, s, x, y)                                \
+  do {                                                        \
+    uint64_t a = (x), b = (y);                                \
+    (x) = (a & (uint64_t)(cl)) | ((b & (uint64_t)(cl)) << (s)); \
+    (y) = ((a & (uint64_t)(ch)) >> (s)) | (b & (uint64_t)(ch)); \
+  } while (0)
+#define SWAP2(x, y) SWAPN(0x5555555555555555, 0xAAAAAAAAAAAAAAAA, 1, x, y)
+#define SWAP4(x, y) SWAPN(0x3333333333333333, 0xCCCCCCCCCCCCCCCC, 2, x, y)
+#define SWAP8(x, y) SWAPN(0x0F0F0F0F0F0F0F0F, 0xF0F0F0F0F0F0F0F0, 4, x, y)
+
+  SWAP2(q[0], q[1]);
+  SWAP2(q[2], q[3]);
+  SWAP2(q[4], q[5]);
+  SWAP2(q[6], q[7]);
+
+  SWAP4(q[0], q[2]);
+  SWAP4(q[1], q[3]);
+  SWAP4(q[4], q[6]);
+  SWAP4(q[5], q[7]);
+
+  SWAP8(q[0], q[4]);
+  SWAP8(q[1], q[5]);
+  SWAP8(q[2], q[6]);
+  SWAP8(q[3], q[7]);
+
+#undef SWAP8
+#undef SWAP4
+#undef SWAP2
+#undef SWAPN
+}
+
+void interleave_in(uint64_t* q0, uint64_t* q1, const uint32_t* w) {
+  uint64_t x0 = w[0], x1 = w[1], x2 = w[2], x3 = w[3];
+  x0 |= (x0 << 16);
+  x1 |= (x1 << 16);
+  x2 |= (x2 << 16);
+  x3 |= (x3 << 16);
+  x0 &= 0x0000FFFF0000FFFF;
+  x1 &= 0x0000FFFF0000FFFF;
+  x2 &= 0x0000FFFF0000FFFF;
+  x3 &= 0x0000FFFF0000FFFF;
+  x0 |= (x0 << 8);
+  x1 |= (x1 << 8);
+  x2 |= (x2 << 8);
+  x3 |= (x3 << 8);
+  x0 &= 0x00FF00FF00FF00FF;
+  x1 &= 0x00FF00FF00FF00FF;
+  x2 &= 0x00FF00FF00FF00FF;
+  x3 &= 0x00FF00FF00FF00FF;
+  *q0 = x0 | (x2 << 8);
+  *q1 = x1 | (x3 << 8);
+}
+
+void interleave_out(uint32_t* w, uint64_t q0, uint64_t q1) {
+  uint64_t x0 = q0 & 0x00FF00FF00FF00FF;
+  uint64_t x1 = q1 & 0x00FF00FF00FF00FF;
+  uint64_t x2 = (q0 >> 8) & 0x00FF00FF00FF00FF;
+  uint64_t x3 = (q1 >> 8) & 0x00FF00FF00FF00FF;
+  x0 |= (x0 >> 8);
+  x1 |= (x1 >> 8);
+  x2 |= (x2 >> 8);
+  x3 |= (x3 >> 8);
+  x0 &= 0x0000FFFF0000FFFF;
+  x1 &= 0x0000FFFF0000FFFF;
+  x2 &= 0x0000FFFF0000FFFF;
+  x3 &= 0x0000FFFF0000FFFF;
+  w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16);
+  w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16);
+  w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16);
+  w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16);
+}
+
+void bitslice_sbox(uint64_t* q) {
+  uint64_t x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4];
+  uint64_t x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+  // Top linear transformation
+  uint64_t y14 = x3 ^ x5;
+  uint64_t y13 = x0 ^ x6;
+  uint64_t y9 = x0 ^ x3;
+  uint64_t y8 = x0 ^ x5;
+  uint64_t t0 = x1 ^ x2;
+  uint64_t y1 = t0 ^ x7;
+  uint64_t y4 = y1 ^ x3;
+  uint64_t y12 = y13 ^ y14;
+  uint64_t y2 = y1 ^ x0;
+  uint64_t y5 = y1 ^ x6;
+  uint64_t y3 = y5 ^ y8;
+  uint64_t t1 = x4 ^ y12;
+  uint64_t y15 = t1 ^ x5;
+  uint64_t y20 = t1 ^ x1;
+  uint64_t y6 = y15 ^ x7;
+  uint64_t y10 = y15 ^ t0;
+  uint64_t y11 = y20 ^ y9;
+  uint64_t y7 = x7 ^ y11;
+  uint64_t y17 = y10 ^ y11;
+  uint64_t y19 = y10 ^ y8;
+  uint64_t y16 = t0 ^ y11;
+  uint64_t y21 = y13 ^ y16;
+  uint64_t y18 = x0 ^ y16;
+
+  // Non-linear section
+  uint64_t t2 = y12 & y15;
+  uint64_t t3 = y3 & y6;
+  uint64_t t4 = t3 ^ t2;
+  uint64_t t5 = y4 & x7;
+  uint64_t t6 = t5 ^ t2;
+  uint64_t t7 = y13 & y16;
+  uint64_t t8 = y5 & y1;
+  uint64_t t9 = t8 ^ t7;
+  uint64_t t10 = y2 & y7;
+  uint64_t t11 = t10 ^ t7;
+  uint64_t t12 = y9 & y11;
+  uint64_t t13 = y14 & y17;
+  uint64_t t14 = t13 ^ t12;
+  uint64_t t15 = y8 & y10;
+  uint64_t t16 = t15 ^ t12;
+  uint64_t t17 = t4 ^ t14;
+  uint64_t t18 = t6 ^ t16;
+  uint64_t t19 = t9 ^ t14;
+  uint64_t t20 = t11 ^ t16;
+  uint64_t t21 = t17 ^ y20;
+  uint64_t t22 = t18 ^ y19;
+  uint64_t t23 = t19 ^ y21;
+  uint64_t t24 = t20 ^ y18;
+
+  uint64_t t25 = t21 ^ t22;
+  uint64_t t26 = t21 & t23;
+  uint64_t t27 = t24 ^ t26;
+  uint64_t t28 = t25 & t27;
+  uint64_t t29 = t28 ^ t22;
+  uint64_t t30 = t23 ^ t24;
+  uint64_t t31 = t22 ^ t26;
+  uint64_t t32 = t31 & t30;
+  uint64_t t33 = t32 ^ t24;
+  uint64_t t34 = t23 ^ t33;
+  uint64_t t35 = t27 ^ t33;
+  uint64_t t36 = t24 & t35;
+  uint64_t t37 = t36 ^ t34;
+  uint64_t t38 = t27 ^ t36;
+  uint64_t t39 = t29 & t38;
+  uint64_t t40 = t25 ^ t39;
+
+  uint64_t t41 = t40 ^ t37;
+  uint64_t t42 = t29 ^ t33;
+  uint64_t t43 = t29 ^ t40;
+  uint64_t t44 = t33 ^ t37;
+  uint64_t t45 = t42 ^ t41;
+  uint64_t z0 = t44 & y15;
+  uint64_t z1 = t37 & y6;
+  uint64_t z2 = t33 & x7;
+  uint64_t z3 = t43 & y16;
+  uint64_t z4 = t40 & y1;
+  uint64_t z5 = t29 & y7;
+  uint64_t z6 = t42 & y11;
+  uint64_t z7 = t45 & y17;
+  uint64_t z8 = t41 & y10;
+  uint64_t z9 = t44 & y12;
+  uint64_t z10 = t37 & y3;
+  uint64_t z11 = t33 & y4;
+  uint64_t z12 = t43 & y13;
+  uint64_t z13 = t40 & y5;
+  uint64_t z14 = t29 & y2;
+  uint64_t z15 = t42 & y9;
+  uint64_t z16 = t45 & y14;
+  uint64_t z17 = t41 & y8;
+
+  // Bottom linear transformation
+  uint64_t t46 = z15 ^ z16;
+  uint64_t t47 = z10 ^ z11;
+  uint64_t t48 = z5 ^ z13;
+  uint64_t t49 = z9 ^ z10;
+  uint64_t t50 = z2 ^ z12;
+  uint64_t t51 = z2 ^ z5;
+  uint64_t t52 = z7 ^ z8;
+  uint64_t t53 = z0 ^ z3;
+  uint64_t t54 = z6 ^ z7;
+  uint64_t t55 = z16 ^ z17;
+  uint64_t t56 = z12 ^ t48;
+  uint64_t t57 = t50 ^ t53;
+  uint64_t t58 = z4 ^ t46;
+  uint64_t t59 = z3 ^ t54;
+  uint64_t t60 = t46 ^ t57;
+  uint64_t t61 = z14 ^ t57;
+  uint64_t t62 = t52 ^ t58;
+  uint64_t t63 = t49 ^ t58;
+  uint64_t t64 = z4 ^ t59;
+  uint64_t t65 = t61 ^ t62;
+  uint64_t t66 = z1 ^ t63;
+  uint64_t s0 = t59 ^ t63;
+  uint64_t s6 = t56 ^ ~t62;
+  uint64_t s7 = t48 ^ ~t60;
+  uint64_t t67 = t64 ^ t65;
+  uint64_t s3 = t53 ^ t66;
+  uint64_t s4 = t51 ^ t66;
+  uint64_t s5 = t47 ^ t65;
+  uint64_t s1 = t64 ^ ~s3;
+  uint64_t s2 = t55 ^ ~t67;
+
+  q[7] = s0;
+  q[6] = s1;
+  q[5] = s2;
+  q[4] = s3;
+  q[3] = s4;
+  q[2] = s5;
+  q[1] = s6;
+  q[0] = s7;
+}
+
+void add_round_key(uint64_t* q, const uint64_t* sk) {
+  for (int i = 0; i < 8; i++) q[i] ^= sk[i];
+}
+
+void shift_rows(uint64_t* q) {
+  for (int i = 0; i < 8; i++) {
+    uint64_t x = q[i];
+    q[i] = (x & 0x000000000000FFFF) | ((x & 0x00000000FFF00000) >> 4) | ((x & 0x00000000000F0000) << 12) |
+           ((x & 0x0000FF0000000000) >> 8) | ((x & 0x000000FF00000000) << 8) | ((x & 0xF000000000000000) >> 12) |
+           ((x & 0x0FFF000000000000) << 4);
+  }
+}
+
+inline uint64_t rotr32(uint64_t x) { return (x << 32) | (x >> 32); }
+
+void mix_columns(uint64_t* q) {
+  uint64_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+  uint64_t q4 = q[4], q5 = q[5], q6 = q[6], q7 = q[7];
+  uint64_t r0 = (q0 >> 16) | (q0 << 48);
+  uint64_t r1 = (q1 >> 16) | (q1 << 48);
+  uint64_t r2 = (q2 >> 16) | (q2 << 48);
+  uint64_t r3 = (q3 >> 16) | (q3 << 48);
+  uint64_t r4 = (q4 >> 16) | (q4 << 48);
+  uint64_t r5 = (q5 >> 16) | (q5 << 48);
+  uint64_t r6 = (q6 >> 16) | (q6 << 48);
+  uint64_t r7 = (q7 >> 16) | (q7 << 48);
+
+  q[0] = q7 ^ r7 ^ r0 ^ rotr32(q0 ^ r0);
+  q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ rotr32(q1 ^ r1);
+  q[2] = q1 ^ r1 ^ r2 ^ rotr32(q2 ^ r2);
+  q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ rotr32(q3 ^ r3);
+  q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ rotr32(q4 ^ r4);
+  q[5] = q4 ^ r4 ^ r5 ^ rotr32(q5 ^ r5);
+  q[6] = q5 ^ r5 ^ r6 ^ rotr32(q6 ^ r6);
+  q[7] = q6 ^ r6 ^ r7 ^ rotr32(q7 ^ r7);
+}
+
+void bitsliced_encrypt(const uint64_t* sk, uint64_t* q) {
+  add_round_key(q, sk);
+  for (size_t round = 1; round < kRounds; round++) {
+    bitslice_sbox(q);
+    shift_rows(q);
+    mix_columns(q);
+    add_round_key(q, sk + 8 * round);
+  }
+  bitslice_sbox(q);
+  shift_rows(q);
+  add_round_key(q, sk + 8 * kRounds);
+}
+
+uint32_t sub_word(uint32_t x) {
+  uint64_t q[8] = {x};
+  ortho(q);
+  bitslice_sbox(q);
+  ortho(q);
+  return (uint32_t)q[0];
+}
+
+uint32_t load_le32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void store_le32(uint8_t* p, uint32_t x) {
+  p[0] = x;
+  p[1] = x >> 8;
+  p[2] = x >> 16;
+  p[3] = x >> 24;
+}
+
+// FIPS-197 key expansion, on little endian words, with |sub| as SubWord()
+void expand_key(const uint8_t key[16], uint32_t w[kRoundKeyWords], uint32_t (*sub)(uint32_t)) {
+  static const uint8_t kRcon[kRounds] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+  for (size_t i = 0; i < 4; i++) w[i] = load_le32(key + 4 * i);
+  for (size_t i = 4; i < kRoundKeyWords; i++) {
+    uint32_t tmp = w[i - 1];
+    if (i % 4 == 0) {
+      tmp = (tmp << 24) | (tmp >> 8);
+      tmp = sub(tmp) ^ kRcon[i / 4 - 1];
+    }
+    w[i] = w[i - 4] ^ tmp;
+  }
+}
+
+#if defined(AES_ENGINE_AESNI)
+TARGET_AESNI inline __m128i expand_step_aesni(__m128i k, __m128i assist) {
+  k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+  k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+  k = _mm_xor_si128(k, _mm_slli_si128(k, 4));
+  return _mm_xor_si128(k, _mm_shuffle_epi32(assist, 0xff));
+}
+
+// FIPS-197 key expansion with AESKEYGENASSIST, whose round constant has to be an immediate
+TARGET_AESNI void expand_key_hardware(const uint8_t key[16], uint8_t* round_keys) {
+  __m128i* rk = reinterpret_cast<__m128i*>(round_keys);
+  __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+  _mm_storeu_si128(rk, k);
+#define EXPAND_ROUND(r, rcon)                                        \
+  do {                                                               \
+    k = expand_step_aesni(k, _mm_aeskeygenassist_si128(k, (rcon))); \
+    _mm_storeu_si128(rk + (r), k);                                   \
+  } while (0)
+  EXPAND_ROUND(1, 0x01);
+  EXPAND_ROUND(2, 0x02);
+  EXPAND_ROUND(3, 0x04);
+  EXPAND_ROUND(4, 0x08);
+  EXPAND_ROUND(5, 0x10);
+  EXPAND_ROUND(6, 0x20);
+  EXPAND_ROUND(7, 0x40);
+  EXPAND_ROUND(8, 0x80);
+  EXPAND_ROUND(9, 0x1B);
+  EXPAND_ROUND(10, 0x36);
+#undef EXPAND_ROUND
+}
+
+TARGET_AESNI void encrypt_aesni(const uint8_t* round_keys, size_t num_keys, const uint8_t in[16], uint8_t* out) {
+  const __m128i* rk = reinterpret_cast<const __m128i*>(round_keys);
+  const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  __m128i* o = reinterpret_cast<__m128i*>(out);
+  size_t i = 0;
+
+  // Four independent keys keep the AES unit's pipeline busy
+  for (; i + 4 <= num_keys; i += 4) {
+    const __m128i* k0 = rk + 11 * i;
+    const __m128i* k1 = k0 + 11;
+    const __m128i* k2 = k1 + 11;
+    const __m128i* k3 = k2 + 11;
+    __m128i s0 = _mm_xor_si128(m, _mm_loadu_si128(k0));
+    __m128i s1 = _mm_xor_si128(m, _mm_loadu_si128(k1));
+    __m128i s2 = _mm_xor_si128(m, _mm_loadu_si128(k2));
+    __m128i s3 = _mm_xor_si128(m, _mm_loadu_si128(k3));
+    for (size_t r = 1; r < kRounds; r++) {
+      s0 = _mm_aesenc_si128(s0, _mm_loadu_si128(k0 + r));
+      s1 = _mm_aesenc_si128(s1, _mm_loadu_si128(k1 + r));
+      s2 = _mm_aesenc_si128(s2, _mm_loadu_si128(k2 + r));
+      s3 = _mm_aesenc_si128(s3, _mm_loadu_si128(k3 + r));
+    }
+    _mm_storeu_si128(o + i, _mm_aesenclast_si128(s0, _mm_loadu_si128(k0 + 10)));
+    _mm_storeu_si128(o + i + 1, _mm_aesenclast_si128(s1, _mm_loadu_si128(k1 + 10)));
+    _mm_storeu_si128(o + i + 2, _mm_aesenclast_si128(s2, _mm_loadu_si128(k2 + 10)));
+    _mm_storeu_si128(o + i + 3, _mm_aesenclast_si128(s3, _mm_loadu_si128(k3 + 10)));
+  }
+  for (; i < num_keys; i++) {
+    const __m128i* k = rk + 11 * i;
+    __m128i s = _mm_xor_si128(m, _mm_loadu_si128(k));
+    for (size_t r = 1; r < kRounds; r++) s = _mm_aesenc_si128(s, _mm_loadu_si128(k + r));
+    _mm_storeu_si128(o + i, _mm_aesenclast_si128(s, _mm_loadu_si128(k + 10)));
+  }
+}
+
+TARGET_AESNI void cbc_mac_aesni(const uint8_t* round_keys, const uint8_t* blocks, size_t num_blocks,
+                                uint8_t state[16]) {
+  const __m128i* rk = reinterpret_cast<const __m128i*>(round_keys);
+  __m128i k[kRounds + 1];
+  for (size_t r = 0; r <= kRounds; r++) k[r] = _mm_loadu_si128(rk + r);
+
+  // The state stays in a register across blocks
+  __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+  for (size_t i = 0; i < num_blocks; i++) {
+    s = _mm_xor_si128(s, _mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * i)));
+    s = _mm_xor_si128(s, k[0]);
+    for (size_t r = 1; r < kRounds; r++) s = _mm_aesenc_si128(s, k[r]);
+    s = _mm_aesenclast_si128(s, k[kRounds]);
+  }
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), s);
+}
+
+bool has_hardware_aes() { return __builtin_cpu_supports("aes"); }
+#endif
+
+#if defined(AES_ENGINE_ARMV8_CE)
+// With all four columns equal ShiftRows has no effect, so a round with a zero key is SubBytes alone
+TARGET_ARMV8_CE uint32_t sub_word_armv8_ce(uint32_t x) {
+  uint8x16_t v = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(x)), vdupq_n_u8(0));
+  return vgetq_lane_u32(vreinterpretq_u32_u8(v), 0);
+}
+
+void expand_key_hardware(const uint8_t key[16], uint8_t* round_keys) {
+  uint32_t expanded[kRoundKeyWords];
+  expand_key(key, expanded, sub_word_armv8_ce);
+  for (size_t i = 0; i < kRoundKeyWords; i++) store_le32(round_keys + 4 * i, expanded[i]);
+}
+
+TARGET_ARMV8_CE void encrypt_armv8_ce(const uint8_t* round_keys, size_t num_keys, const uint8_t in[16],
+                                      uint8_t* out) {
+  const uint8x16_t m = vld1q_u8(in);
+  size_t i = 0;
+
+  // vaeseq_u8 adds the round key before SubBytes and ShiftRows, so the last round key is added separately
+  for (; i + 4 <= num_keys; i += 4) {
+    const uint8_t* k0 = round_keys + kRoundKeyBytes * i;
+    const uint8_t* k1 = k0 + kRoundKeyBytes;
+    const uint8_t* k2 = k1 + kRoundKeyBytes;
+    const uint8_t* k3 = k2 + kRoundKeyBytes;
+    uint8x16_t s0 = m, s1 = m, s2 = m, s3 = m;
+    for (size_t r = 0; r < kRounds - 1; r++) {
+      s0 = vaesmcq_u8(vaeseq_u8(s0, vld1q_u8(k0 + 16 * r)));
+      s1 = vaesmcq_u8(vaeseq_u8(s1, vld1q_u8(k1 + 16 * r)));
+      s2 = vaesmcq_u8(vaeseq_u8(s2, vld1q_u8(k2 + 16 * r)));
+      s3 = vaesmcq_u8(vaeseq_u8(s3, vld1q_u8(k3 + 16 * r)));
+    }
+    s0 = veorq_u8(vaeseq_u8(s0, vld1q_u8(k0 + 144)), vld1q_u8(k0 + 160));
+    s1 = veorq_u8(vaeseq_u8(s1, vld1q_u8(k1 + 144)), vld1q_u8(k1 + 160));
+    s2 = veorq_u8(vaeseq_u8(s2, vld1q_u8(k2 + 144)), vld1q_u8(k2 + 160));
+    s3 = veorq_u8(vaeseq_u8(s3, vld1q_u8(k3 + 144)), vld1q_u8(k3 + 160));
+    vst1q_u8(out + 16 * i, s0);
+    vst1q_u8(out + 16 * (i + 1), s1);
+    vst1q_u8(out + 16 * (i + 2), s2);
+    vst1q_u8(out + 16 * (i + 3), s3);
+  }
+  for (; i < num_keys; i++) {
+    const uint8_t* k = round_keys + kRoundKeyBytes * i;
+    uint8x16_t s = m;
+    for (size_t r = 0; r < kRounds - 1; r++) s = vaesmcq_u8(vaeseq_u8(s, vld1q_u8(k + 16 * r)));
+    s = veorq_u8(vaeseq_u8(s, vld1q_u8(k + 144)), vld1q_u8(k + 160));
+    vst1q_u8(out + 16 * i, s);
+  }
+}
+
+TARGET_ARMV8_CE void cbc_mac_armv8_ce(const uint8_t* round_keys, const uint8_t* blocks, size_t num_blocks,
+                                      uint8_t state[16]) {
+  uint8x16_t k[kRounds + 1];
+  for (size_t r = 0; r <= kRounds; r++) k[r] = vld1q_u8(round_keys + 16 * r);
+
+  uint8x16_t s = vld1q_u8(state);
+  for (size_t i = 0; i < num_blocks; i++) {
+    s = veorq_u8(s, vld1q_u8(blocks + 16 * i));
+    for (size_t r = 0; r < kRounds - 1; r++) s = vaesmcq_u8(vaeseq_u8(s, k[r]));
+    s = veorq_u8(vaeseq_u8(s, k[kRounds - 1]), k[kRounds]);
+  }
+  vst1q_u8(state, s);
+}
+
+bool has_hardware_aes() { return (getauxval(AT_HWCAP) & HWCAP_AES) != 0; }
+#endif
+
+// Sets |out| to |in| * x in GF(2^128), for the CMAC subkeys. |in| is big endian, as in RFC 4493.
+void double_block(const uint8_t* in, uint8_t* out) {
+  uint8_t msb = in[0] >> 7;
+  for (size_t i = 0; i < AesEngine::kBlockSize - 1; i++) out[i] = (in[i] << 1) | (in[i + 1] >> 7);
+  out[AesEngine::kBlockSize - 1] = (in[AesEngine::kBlockSize - 1] << 1) ^ (0x87 & (0 - msb));
+}
+
+}  // namespace
+
+AesEngine::AesEngine(bool allow_hardware) : backend_(Backend::kBitsliced) {
+  if (!allow_hardware) return;
+#if defined(AES_ENGINE_AESNI)
+  if (has_hardware_aes()) backend_ = Backend::kAesNi;
+#elif defined(AES_ENGINE_ARMV8_CE)
+  if (has_hardware_aes()) backend_ = Backend::kArmv8Ce;
+#endif
+}
+
+void AesEngine::SetKeys(const uint8_t* keys, size_t num_keys) {
+  num_keys_ = num_keys;
+  // resize() keeps the capacity, so an engine reused for one key at a time does not allocate
+  if (backend_ != Backend::kBitsliced) {
+#if defined(AES_ENGINE_AESNI) || defined(AES_ENGINE_ARMV8_CE)
+    round_keys_.resize(kRoundKeyBytes * num_keys_);
+    for (size_t i = 0; i < num_keys_; i++) expand_key_hardware(keys + kBlockSize * i, &round_keys_[kRoundKeyBytes * i]);
+#endif
+    return;
+  }
+
+  // Each group holds the round keys of four keys in the same lanes as the blocks they are applied to. Missing keys of
+  // the last group are zero.
+  size_t groups = (num_keys_ + kBitslicedLanes - 1) / kBitslicedLanes;
+  bitsliced_keys_.resize(kBitslicedGroupWords * groups);
+  for (size_t g = 0; g < groups; g++) {
+    uint32_t expanded[kBitslicedLanes][kRoundKeyWords] = {};
+    for (size_t lane = 0; lane < kBitslicedLanes && g * kBitslicedLanes + lane < num_keys_; lane++) {
+      expand_key(keys + kBlockSize * (g * kBitslicedLanes + lane), expanded[lane], sub_word);
+    }
+    for (size_t round = 0; round <= kRounds; round++) {
+      uint64_t q[8];
+      for (size_t lane = 0; lane < kBitslicedLanes; lane++) {
+        interleave_in(&q[lane], &q[lane + 4], &expanded[lane][4 * round]);
+      }
+      ortho(q);
+      memcpy(&bitsliced_keys_[kBitslicedGroupWords * g + 8 * round], q, sizeof(q));
+    }
+  }
+}
+
+void AesEngine::EncryptAll(const uint8_t* in, uint8_t* out) const {
+  switch (backend_) {
+#if defined(AES_ENGINE_AESNI)
+    case Backend::kAesNi:
+      encrypt_aesni(round_keys_.data(), num_keys_, in, out);
+      break;
+#endif
+#if defined(AES_ENGINE_ARMV8_CE)
+    case Backend::kArmv8Ce:
+      encrypt_armv8_ce(round_keys_.data(), num_keys_, in, out);
+      break;
+#endif
+    default: {
+      uint32_t w[4];
+      for (size_t i = 0; i < 4; i++) w[i] = load_le32(in + 4 * i);
+      uint64_t block[8];
+      for (size_t lane = 0; lane < kBitslicedLanes; lane++) interleave_in(&block[lane], &block[lane + 4], w);
+      ortho(block);
+
+      for (size_t key = 0; key < num_keys_; key += kBitslicedLanes) {
+        uint64_t q[8];
+        memcpy(q, block, sizeof(q));
+        bitsliced_encrypt(&bitsliced_keys_[kBitslicedGroupWords * (key / kBitslicedLanes)], q);
+        ortho(q);
+        for (size_t lane = 0; lane < kBitslicedLanes && key + lane < num_keys_; lane++) {
+          uint32_t result[4];
+          interleave_out(result, q[lane], q[lane + 4]);
+          for (size_t i = 0; i < 4; i++) store_le32(out + kBlockSize * (key + lane) + 4 * i, result[i]);
+        }
+      }
+      break;
+    }
+  }
+}
+
+void AesEngine::CbcMac(size_t key_index, const uint8_t* blocks, size_t num_blocks, uint8_t* state) const {
+  switch (backend_) {
+#if defined(AES_ENGINE_AESNI)
+    case Backend::kAesNi:
+      cbc_mac_aesni(&round_keys_[kRoundKeyBytes * key_index], blocks, num_blocks, state);
+      break;
+#endif
+#if defined(AES_ENGINE_ARMV8_CE)
+    case Backend::kArmv8Ce:
+      cbc_mac_armv8_ce(&round_keys_[kRoundKeyBytes * key_index], blocks, num_blocks, state);
+      break;
+#endif
+    default: {
+      // Blocks depend on each other, so only the lane of the key is used
+      const uint64_t* sk = &bitsliced_keys_[kBitslicedGroupWords * (key_index / kBitslicedLanes)];
+      size_t lane = key_index % kBitslicedLanes;
+      uint32_t w[4];
+      for (size_t i = 0; i < 4; i++) w[i] = load_le32(state + 4 * i);
+      for (size_t b = 0; b < num_blocks; b++) {
+        for (size_t i = 0; i < 4; i++) w[i] ^= load_le32(blocks + kBlockSize * b + 4 * i);
+        uint64_t q[8] = {0};
+        interleave_in(&q[lane], &q[lane + 4], w);
+        ortho(q);
+        bitsliced_encrypt(sk, q);
+        ortho(q);
+        interleave_out(w, q[lane], q[lane + 4]);
+      }
+      for (size_t i = 0; i < 4; i++) store_le32(state + 4 * i, w[i]);
+      break;
+    }
+  }
+}
+
+void AesEngine::Cmac(const uint8_t* message, size_t length, uint8_t* mac) const {
+  uint8_t k1[kBlockSize] = {0};
+  uint8_t k2[kBlockSize];
+  CbcMac(0, k1, 1, k1);
+  double_block(k1, k1);
+  double_block(k1, k2);
+
+  // All blocks but the last go through in one call
+  size_t num_blocks = length == 0 ? 1 : (length + kBlockSize - 1) / kBlockSize;
+  size_t last_length = length - kBlockSize * (num_blocks - 1);
+  memset(mac, 0, kBlockSize);
+  CbcMac(0, message, num_blocks - 1, mac);
+
+  uint8_t last[kBlockSize] = {0};
+  if (last_length > 0) memcpy(last, message + kBlockSize * (num_blocks - 1), last_length);
+  const uint8_t* subkey = k1;
+  if (last_length < kBlockSize) {
+    last[last_length] = 0x80;
+    subkey = k2;
+  }
+  for (size_t i = 0; i < kBlockSize; i++) last[i] ^= subkey[i];
+  CbcMac(0, last, 1, mac);
+}
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
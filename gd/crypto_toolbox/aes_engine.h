@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bluetooth {
+namespace crypto_toolbox {
+
+// AES-128 behind aes_128() and aes_cmac() in both the legacy stack (stack/crypto_toolbox) and gd (crypto_toolbox).
+//
+// Key schedules are expanded once in SetKeys(). Encryption uses AES-NI or the ARMv8 crypto extensions when the CPU has
+// them, and otherwise a constant time bitsliced implementation that processes four blocks at a time.
+//
+// This file must not depend on either stack. Keys and blocks are in FIPS-197 byte order; the little endian Octet16
+// values used by both toolboxes have to be reversed first.
+class AesEngine {
+ public:
+  static constexpr size_t kBlockSize = 16;
+
+  // |allow_hardware| false forces the portable implementation, for tests
+  explicit AesEngine(bool allow_hardware = true);
+
+  // Replaces the key set with the |num_keys| keys of kBlockSize bytes at |keys|
+  void SetKeys(const uint8_t* keys, size_t num_keys);
+
+  size_t Size() const {
+    return num_keys_;
+  }
+
+  // Encrypts the block at |in| under every key. |out| must hold Size() blocks.
+  void EncryptAll(const uint8_t* in, uint8_t* out) const;
+
+  // Sets |state| to E(|state| ^ block) under key |key_index|, for each of the |num_blocks| blocks at |blocks| in turn
+  void CbcMac(size_t key_index, const uint8_t* blocks, size_t num_blocks, uint8_t* state) const;
+
+  // Sets |mac| to the RFC 4493 AES-CMAC of the |length| bytes at |message|, under the first key
+  void Cmac(const uint8_t* message, size_t length, uint8_t* mac) const;
+
+ private:
+  enum class Backend { kBitsliced, kAesNi, kArmv8Ce };
+
+  Backend backend_;
+  size_t num_keys_ = 0;
+  // Expanded keys, 176 bytes per key, used by the hardware backends
+  std::vector<uint8_t> round_keys_;
+  // Bitsliced expanded keys, 11 rounds of 8 words per group of four keys
+  std::vector<uint64_t> bitsliced_keys_;
+};
+
+}  // namespace crypto_toolbox
+}  // namespace bluetooth
@@ -20,6 +20,7 @@
 #include <netinet/in.h>
 #include <bitset>
 #include <chrono>
+#include <cstring>
 
 #include "os/log.h"
 
@@ -90,7 +91,6 @@ void SnoopLogger::capture(const HciPacket& packet, Direction direction, PacketTy
   uint64_t timestamp_us =
       std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch())
           .count();
-  std::lock_guard<std::mutex> lock(file_mutex_);
   std::bitset<32> flags = 0;
   switch (type) {
     case PacketType::CMD:
@@ -117,18 +117,76 @@ void SnoopLogger::capture(const HciPacket& packet, Direction direction, PacketTy
                                     .dropped_packets = 0,
                                     .timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA),
                                     .type = static_cast<uint8_t>(type)};
-  btsnoop_ostream_.write(reinterpret_cast<const char*>(&header), sizeof(btsnoop_packet_header_t));
-  btsnoop_ostream_.write(reinterpret_cast<const char*>(packet.data()), packet.size());
-  if (AlwaysFlush) btsnoop_ostream_.flush();
+  size_t record_size = sizeof(btsnoop_packet_header_t) + packet.size();
+  {
+    std::lock_guard<std::mutex> lock(staging_mutex_);
+    if (!writer_running_ || staging_buffer_.size() + record_size > kMaxStagedBytes) {
+      dropped_packets_++;
+      return;
+    }
+    header.dropped_packets = htonl(dropped_packets_);
+    size_t offset = staging_buffer_.size();
+    staging_buffer_.resize(offset + record_size);
+    std::memcpy(staging_buffer_.data() + offset, &header, sizeof(btsnoop_packet_header_t));
+    std::memcpy(staging_buffer_.data() + offset + sizeof(btsnoop_packet_header_t), packet.data(), packet.size());
+    staged_packets_++;
+  }
+  staging_cv_.notify_one();
+}
+
+void SnoopLogger::write_staged_packets() {
+  std::vector<uint8_t> batch;
+  std::unique_lock<std::mutex> lock(staging_mutex_);
+  while (true) {
+    staging_cv_.wait(lock, [this] { return !staging_buffer_.empty() || !writer_running_; });
+    if (staging_buffer_.empty()) break;
+    // Swap so capture() keeps staging into a buffer that already has capacity while this batch is written
+    batch.swap(staging_buffer_);
+    writing_packets_ = staged_packets_;
+    staged_packets_ = 0;
+    lock.unlock();
+    btsnoop_ostream_.write(reinterpret_cast<const char*>(batch.data()), batch.size());
+    if (AlwaysFlush) btsnoop_ostream_.flush();
+    batch.clear();
+    lock.lock();
+    writing_packets_ = 0;
+  }
+  if (dropped_packets_ > 0) {
+    LOG_WARN("Dropped %u snoop packets", dropped_packets_);
+  }
+}
+
+size_t SnoopLogger::GetQueueDepth() {
+  std::lock_guard<std::mutex> lock(staging_mutex_);
+  return staged_packets_ + writing_packets_;
+}
+
+uint32_t SnoopLogger::GetDroppedPackets() {
+  std::lock_guard<std::mutex> lock(staging_mutex_);
+  return dropped_packets_;
 }
 
 void SnoopLogger::ListDependencies(ModuleList* list) {
   // We have no dependencies
 }
 
-void SnoopLogger::Start() {}
+void SnoopLogger::Start() {
+  std::lock_guard<std::mutex> lock(staging_mutex_);
+  staging_buffer_.reserve(kMaxStagedBytes);
+  writer_running_ = true;
+  writer_thread_ = std::thread(&SnoopLogger::write_staged_packets, this);
+}
 
-void SnoopLogger::Stop() {}
+void SnoopLogger::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(staging_mutex_);
+    writer_running_ = false;
+  }
+  staging_cv_.notify_one();
+  // The writer drains whatever is still staged before it exits
+  writer_thread_.join();
+  btsnoop_ostream_.flush();
+}
 
 std::string SnoopLogger::file_path = SnoopLogger::DefaultFilePath;
 
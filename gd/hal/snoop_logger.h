@@ -16,10 +16,14 @@
 
 #pragma once
 
+#include <condition_variable>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "hal/hci_hal.h"
 #include "module.h"
@@ -50,8 +54,19 @@ class SnoopLogger : public ::bluetooth::Module {
     OUTGOING,
   };
 
+  // Stages the packet for the writer thread; never blocks on file I/O
   void capture(const HciPacket& packet, Direction direction, PacketType type);
 
+  // Upper bound on packet bytes staged but not yet written. Packets that do not fit are dropped and reported in the
+  // dropped_packets field of the next record written.
+  static constexpr size_t kMaxStagedBytes = 1024 * 1024;
+
+  // Packets captured but not yet written to the file
+  size_t GetQueueDepth();
+
+  // Packets dropped since the module started because they did not fit in the staging buffer
+  uint32_t GetDroppedPackets();
+
  protected:
   void ListDependencies(ModuleList* list) override;
   void Start() override;
@@ -60,8 +75,17 @@ class SnoopLogger : public ::bluetooth::Module {
  private:
   SnoopLogger();
   static std::string file_path;
+  void write_staged_packets();
+
   std::ofstream btsnoop_ostream_;
-  std::mutex file_mutex_;
+  std::thread writer_thread_;
+  std::mutex staging_mutex_;
+  std::condition_variable staging_cv_;
+  std::vector<uint8_t> staging_buffer_;
+  size_t staged_packets_ = 0;
+  size_t writing_packets_ = 0;
+  bool writer_running_ = false;
+  uint32_t dropped_packets_ = 0;
 };
 
 }  // namespace hal
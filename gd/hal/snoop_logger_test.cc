@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hal/snoop_logger.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "os/thread.h"
+
+using ::bluetooth::os::Thread;
+
+namespace bluetooth {
+namespace hal {
+namespace {
+
+constexpr size_t kFileHeaderSize = 16;
+constexpr size_t kRecordHeaderSize = 25;
+constexpr size_t kDroppedPacketsOffset = 12;
+
+class SnoopLoggerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    file_path_ = ::testing::TempDir() + "snoop_logger_test_btsnoop_hci.log";
+    std::remove(file_path_.c_str());
+    SnoopLogger::SetFilePath(file_path_);
+    thread_ = new Thread("test_thread", Thread::Priority::NORMAL);
+    snoop_logger_ = fake_registry_.Start<SnoopLogger>(thread_);
+  }
+
+  void TearDown() override {
+    if (snoop_logger_ != nullptr) {
+      fake_registry_.StopAll();
+    }
+    delete thread_;
+    SnoopLogger::SetFilePath(SnoopLogger::DefaultFilePath);
+    std::remove(file_path_.c_str());
+  }
+
+  // Stops the module, which writes out everything staged, and returns the file
+  std::vector<uint8_t> StopAndReadFile() {
+    fake_registry_.StopAll();
+    snoop_logger_ = nullptr;
+    std::ifstream file(file_path_, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  void Capture(size_t size) {
+    snoop_logger_->capture(HciPacket(size, 0x42), SnoopLogger::Direction::OUTGOING, SnoopLogger::PacketType::ACL);
+  }
+
+  ModuleRegistry fake_registry_;
+  Thread* thread_;
+  SnoopLogger* snoop_logger_;
+  std::string file_path_;
+};
+
+TEST_F(SnoopLoggerTest, queue_drains_after_capture) {
+  constexpr size_t kPackets = 100;
+  constexpr size_t kPacketSize = 10;
+  for (size_t i = 0; i < kPackets; i++) {
+    Capture(kPacketSize);
+  }
+  EXPECT_LE(snoop_logger_->GetQueueDepth(), kPackets);
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (snoop_logger_->GetQueueDepth() > 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(0u, snoop_logger_->GetQueueDepth());
+  EXPECT_EQ(0u, snoop_logger_->GetDroppedPackets());
+
+  auto file = StopAndReadFile();
+  EXPECT_EQ(kFileHeaderSize + kPackets * (kRecordHeaderSize + kPacketSize), file.size());
+}
+
+TEST_F(SnoopLoggerTest, packets_that_do_not_fit_are_dropped_and_counted) {
+  constexpr size_t kPacketSize = 10;
+  Capture(kPacketSize);
+  // Larger than the whole staging buffer, so it can never be staged
+  Capture(SnoopLogger::kMaxStagedBytes);
+  Capture(SnoopLogger::kMaxStagedBytes);
+  EXPECT_EQ(2u, snoop_logger_->GetDroppedPackets());
+  Capture(kPacketSize);
+  EXPECT_EQ(2u, snoop_logger_->GetDroppedPackets());
+
+  auto file = StopAndReadFile();
+  ASSERT_EQ(kFileHeaderSize + 2 * (kRecordHeaderSize + kPacketSize), file.size());
+
+  // The drops are reported in the record written after them
+  uint32_t dropped;
+  std::memcpy(&dropped, &file[kFileHeaderSize + kDroppedPacketsOffset], sizeof(dropped));
+  EXPECT_EQ(0u, ntohl(dropped));
+  std::memcpy(&dropped, &file[kFileHeaderSize + kRecordHeaderSize + kPacketSize + kDroppedPacketsOffset],
+              sizeof(dropped));
+  EXPECT_EQ(2u, ntohl(dropped));
+}
+
+}  // namespace
+}  // namespace hal
+}  // namespace bluetooth
@@ -16,6 +16,8 @@
 
 #include "hci/acl_manager.h"
 
+#include <algorithm>
+#include <chrono>
 #include <future>
 #include <queue>
 #include <set>
@@ -76,8 +78,12 @@ struct AclManager::acl_connection {
   // For LE Connection parameter update from L2CAP
   common::OnceCallback<void(ErrorCode)> on_connection_update_complete_callback_;
   os::Handler* on_connection_update_complete_callback_handler_ = nullptr;
-  // Round-robin: Track if dequeue is registered for this connection
+  // Scheduler: Track if dequeue is registered for this connection
   bool is_registered_ = false;
+  // Scheduler: Fragments of the packet being sent, and when it was dequeued
+  std::list<std::unique_ptr<AclPacketBuilder>> fragments_to_send_;
+  std::chrono::steady_clock::time_point dequeue_time_;
+  AclConnectionStats stats_;
   // Credits: Track the number of packets which have been sent to the controller
   uint16_t number_of_sent_packets_ = 0;
   PacketViewForRecombination recombination_stage_{std::make_shared<std::vector<uint8_t>>()};
@@ -224,7 +230,16 @@ struct AclManager::impl {
     hci_layer_->UnregisterEventHandler(EventCode::READ_REMOTE_SUPPORTED_FEATURES_COMPLETE);
     hci_layer_->UnregisterEventHandler(EventCode::READ_REMOTE_EXTENDED_FEATURES_COMPLETE);
     hci_queue_end_->UnregisterDequeue();
+    if (enqueue_registered_) {
+      enqueue_registered_ = false;
+      hci_queue_end_->UnregisterEnqueue();
+    }
     unregister_all_connections();
+    for (auto& connection_pair : acl_connections_) {
+      if (!connection_pair.second.is_disconnected_) {
+        scheduler_->RemoveConnection(connection_pair.first);
+      }
+    }
     acl_connections_.clear();
     hci_queue_end_ = nullptr;
     handler_ = nullptr;
@@ -244,89 +259,106 @@ struct AclManager::impl {
     connection_pair->second.number_of_sent_packets_ -= credits;
     acl_packet_credits_ += credits;
     ASSERT(acl_packet_credits_ <= max_acl_packet_credits_);
-    start_round_robin();
+    update_enqueue_registration();
   }
 
-  // Round-robin scheduler
-  void start_round_robin() {
-    if (acl_packet_credits_ == 0) {
-      return;
-    }
-    if (!fragments_to_send_.empty()) {
-      send_next_fragment();
+  // Scheduler: a connection with no packet in flight has its dequeue registered. A dequeued packet is fragmented and
+  // handed to scheduler_, which picks the connection of every fragment sent to the controller.
+  void add_connection_to_scheduler(std::map<uint16_t, acl_connection>::iterator connection_pair) {
+    scheduler_->AddConnection(connection_pair->first);
+    register_dequeue(connection_pair);
+  }
+
+  void register_dequeue(std::map<uint16_t, acl_connection>::iterator connection_pair) {
+    if (connection_pair->second.is_registered_ || connection_pair->second.is_disconnected_) {
       return;
     }
-    for (auto connection_pair = acl_connections_.begin(); connection_pair != acl_connections_.end();
-         connection_pair = std::next(connection_pair)) {
-      if (connection_pair->second.is_registered_) {
-        continue;
-      }
-      connection_pair->second.is_registered_ = true;
-      connection_pair->second.queue_->GetDownEnd()->RegisterDequeue(
-          handler_, common::Bind(&impl::handle_dequeue_from_upper, common::Unretained(this), connection_pair));
-    }
+    connection_pair->second.is_registered_ = true;
+    connection_pair->second.queue_->GetDownEnd()->RegisterDequeue(
+        handler_, common::Bind(&impl::handle_dequeue_from_upper, common::Unretained(this), connection_pair));
   }
 
-  void handle_dequeue_from_upper(std::map<uint16_t, acl_connection>::iterator connection_pair) {
-    current_connection_pair_ = connection_pair;
-    buffer_packet();
+  void unregister_dequeue(acl_connection& connection) {
+    if (connection.is_registered_) {
+      connection.is_registered_ = false;
+      connection.queue_->GetDownEnd()->UnregisterDequeue();
+    }
   }
 
   void unregister_all_connections() {
-    for (auto connection_pair = acl_connections_.begin(); connection_pair != acl_connections_.end();
-         connection_pair = std::next(connection_pair)) {
-      if (connection_pair->second.is_registered_) {
-        connection_pair->second.is_registered_ = false;
-        connection_pair->second.queue_->GetDownEnd()->UnregisterDequeue();
-      }
+    for (auto& connection_pair : acl_connections_) {
+      unregister_dequeue(connection_pair.second);
     }
   }
 
-  void buffer_packet() {
-    unregister_all_connections();
+  void handle_dequeue_from_upper(std::map<uint16_t, acl_connection>::iterator connection_pair) {
+    auto& connection = connection_pair->second;
+    unregister_dequeue(connection);
     BroadcastFlag broadcast_flag = BroadcastFlag::POINT_TO_POINT;
     //   Wrap packet and enqueue it
-    uint16_t handle = current_connection_pair_->first;
+    uint16_t handle = connection_pair->first;
 
-    auto packet = current_connection_pair_->second.queue_->GetDownEnd()->TryDequeue();
+    auto packet = connection.queue_->GetDownEnd()->TryDequeue();
     ASSERT(packet != nullptr);
 
     if (packet->size() <= hci_mtu_) {
-      fragments_to_send_.push_front(AclPacketBuilder::Create(handle, PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE,
-                                                             broadcast_flag, std::move(packet)));
+      connection.fragments_to_send_.push_back(AclPacketBuilder::Create(
+          handle, PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE, broadcast_flag, std::move(packet)));
     } else {
       auto fragments = AclFragmenter(hci_mtu_, std::move(packet)).GetFragments();
       PacketBoundaryFlag packet_boundary_flag = PacketBoundaryFlag::FIRST_AUTOMATICALLY_FLUSHABLE;
       for (size_t i = 0; i < fragments.size(); i++) {
-        fragments_to_send_.push_back(
+        connection.fragments_to_send_.push_back(
             AclPacketBuilder::Create(handle, packet_boundary_flag, broadcast_flag, std::move(fragments[i])));
         packet_boundary_flag = PacketBoundaryFlag::CONTINUING_FRAGMENT;
       }
     }
-    ASSERT(fragments_to_send_.size() > 0);
+    ASSERT(connection.fragments_to_send_.size() > 0);
 
-    current_connection_pair_->second.number_of_sent_packets_ += fragments_to_send_.size();
-    send_next_fragment();
+    connection.dequeue_time_ = std::chrono::steady_clock::now();
+    scheduler_->AddReadyFragments(handle, connection.fragments_to_send_.size());
+    update_enqueue_registration();
   }
 
-  void send_next_fragment() {
-    hci_queue_end_->RegisterEnqueue(handler_,
-                                    common::Bind(&impl::handle_enqueue_next_fragment, common::Unretained(this)));
+  // Keep the HCI enqueue registered while there are both credits and fragments to send
+  void update_enqueue_registration() {
+    bool should_enqueue = acl_packet_credits_ > 0 && scheduler_->HasReadyFragments();
+    if (should_enqueue == enqueue_registered_) {
+      return;
+    }
+    enqueue_registered_ = should_enqueue;
+    if (should_enqueue) {
+      hci_queue_end_->RegisterEnqueue(handler_,
+                                      common::Bind(&impl::handle_enqueue_next_fragment, common::Unretained(this)));
+    } else {
+      hci_queue_end_->UnregisterEnqueue();
+    }
   }
 
   std::unique_ptr<AclPacketBuilder> handle_enqueue_next_fragment() {
     ASSERT(acl_packet_credits_ > 0);
-    if (acl_packet_credits_ == 1 || fragments_to_send_.size() == 1) {
-      hci_queue_end_->UnregisterEnqueue();
-      if (fragments_to_send_.size() == 1) {
-        handler_->Post(common::BindOnce(&impl::start_round_robin, common::Unretained(this)));
-      }
-    }
-    ASSERT(fragments_to_send_.size() > 0);
-    auto raw_pointer = fragments_to_send_.front().release();
+    auto connection_pair = acl_connections_.find(scheduler_->Next());
+    ASSERT(connection_pair != acl_connections_.end());
+    auto& connection = connection_pair->second;
+    ASSERT(connection.fragments_to_send_.size() > 0);
+    auto fragment = std::move(connection.fragments_to_send_.front());
+    connection.fragments_to_send_.pop_front();
     acl_packet_credits_ -= 1;
-    fragments_to_send_.pop_front();
-    return std::unique_ptr<AclPacketBuilder>(raw_pointer);
+    connection.number_of_sent_packets_ += 1;
+
+    auto& stats = connection.stats_;
+    stats.fragments_sent++;
+    stats.max_credits_in_use = std::max(stats.max_credits_in_use, connection.number_of_sent_packets_);
+    if (connection.fragments_to_send_.empty()) {
+      auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                           connection.dequeue_time_);
+      stats.packets_sent++;
+      stats.total_latency += latency;
+      stats.max_latency = std::max(stats.max_latency, latency);
+      register_dequeue(connection_pair);
+    }
+    update_enqueue_registration();
+    return fragment;
   }
 
   void dequeue_and_route_acl_packet_to_connection() {
@@ -406,11 +438,11 @@ struct AclManager::impl {
     // TODO: Check and save other connection parameters
     uint16_t handle = connection_complete.GetConnectionHandle();
     ASSERT(acl_connections_.count(handle) == 0);
-    acl_connections_.emplace(std::piecewise_construct, std::forward_as_tuple(handle),
-                             std::forward_as_tuple(address_with_type, handler_));
-    if (acl_connections_.size() == 1 && fragments_to_send_.size() == 0) {
-      start_round_robin();
-    }
+    auto connection_pair = acl_connections_
+                               .emplace(std::piecewise_construct, std::forward_as_tuple(handle),
+                                        std::forward_as_tuple(address_with_type, handler_))
+                               .first;
+    add_connection_to_scheduler(connection_pair);
     auto role = connection_complete.GetRole();
     std::unique_ptr<AclConnection> connection_proxy(
         new AclConnection(&acl_manager_, handle, address, peer_address_type, role));
@@ -440,11 +472,11 @@ struct AclManager::impl {
     // TODO: Check and save other connection parameters
     uint16_t handle = connection_complete.GetConnectionHandle();
     ASSERT(acl_connections_.count(handle) == 0);
-    acl_connections_.emplace(std::piecewise_construct, std::forward_as_tuple(handle),
-                             std::forward_as_tuple(reporting_address_with_type, handler_));
-    if (acl_connections_.size() == 1 && fragments_to_send_.size() == 0) {
-      start_round_robin();
-    }
+    auto connection_pair = acl_connections_
+                               .emplace(std::piecewise_construct, std::forward_as_tuple(handle),
+                                        std::forward_as_tuple(reporting_address_with_type, handler_))
+                               .first;
+    add_connection_to_scheduler(connection_pair);
     auto role = connection_complete.GetRole();
     std::unique_ptr<AclConnection> connection_proxy(
         new AclConnection(&acl_manager_, handle, address, peer_address_type, role));
@@ -466,12 +498,12 @@ struct AclManager::impl {
     }
     uint16_t handle = connection_complete.GetConnectionHandle();
     ASSERT(acl_connections_.count(handle) == 0);
-    acl_connections_.emplace(
-        std::piecewise_construct, std::forward_as_tuple(handle),
-        std::forward_as_tuple(AddressWithType{address, AddressType::PUBLIC_DEVICE_ADDRESS}, handler_));
-    if (acl_connections_.size() == 1 && fragments_to_send_.size() == 0) {
-      start_round_robin();
-    }
+    auto connection_pair = acl_connections_
+                               .emplace(std::piecewise_construct, std::forward_as_tuple(handle),
+                                        std::forward_as_tuple(
+                                            AddressWithType{address, AddressType::PUBLIC_DEVICE_ADDRESS}, handler_))
+                               .first;
+    add_connection_to_scheduler(connection_pair);
     std::unique_ptr<AclConnection> connection_proxy(new AclConnection(&acl_manager_, handle, address));
     client_handler_->Post(common::BindOnce(&ConnectionCallbacks::OnConnectSuccess,
                                            common::Unretained(client_callbacks_), std::move(connection_proxy)));
@@ -502,9 +534,13 @@ struct AclManager::impl {
       acl_connection.is_disconnected_ = true;
       acl_connection.disconnect_reason_ = disconnection_complete.GetReason();
       acl_connection.call_disconnect_callback();
-      // Reclaim outstanding packets
+      // Reclaim outstanding packets, and drop the ones the controller will not take any more
       acl_packet_credits_ += acl_connection.number_of_sent_packets_;
       acl_connection.number_of_sent_packets_ = 0;
+      acl_connection.fragments_to_send_.clear();
+      unregister_dequeue(acl_connection);
+      scheduler_->RemoveConnection(handle);
+      update_enqueue_registration();
     } else {
       std::string error_code = ErrorCodeText(status);
       LOG_ERROR("Received disconnection complete with error code %s, handle 0x%02hx", error_code.c_str(), handle);
@@ -1458,10 +1494,7 @@ struct AclManager::impl {
   void cleanup(uint16_t handle) {
     ASSERT(acl_connections_.count(handle) == 1);
     auto& acl_connection = acl_connections_.find(handle)->second;
-    if (acl_connection.is_registered_) {
-      acl_connection.is_registered_ = false;
-      acl_connection.queue_->GetDownEnd()->UnregisterDequeue();
-    }
+    unregister_dequeue(acl_connection);
     acl_connections_.erase(handle);
   }
 
@@ -1883,6 +1916,53 @@ struct AclManager::impl {
     handler_->Post(BindOnce(&impl::cleanup, common::Unretained(this), handle));
   }
 
+  bool SetSchedulingPriority(uint16_t handle, AclScheduler::Priority priority, uint16_t weight) {
+    auto& connection = check_and_get_connection(handle);
+    if (connection.is_disconnected_) {
+      LOG_INFO("Already disconnected");
+      return false;
+    }
+    if (weight == 0) {
+      LOG_ERROR("Invalid weight");
+      return false;
+    }
+    handler_->Post(BindOnce(&impl::handle_set_scheduling_priority, common::Unretained(this), handle, priority, weight));
+    return true;
+  }
+
+  void handle_set_scheduling_priority(uint16_t handle, AclScheduler::Priority priority, uint16_t weight) {
+    auto connection = acl_connections_.find(handle);
+    if (connection == acl_connections_.end() || connection->second.is_disconnected_) {
+      LOG_INFO("Dropping scheduling priority of disconnected connection 0x%04hx", handle);
+      return;
+    }
+    scheduler_->SetPriority(handle, priority, weight);
+  }
+
+  void GetSchedulingStats(uint16_t handle, common::OnceCallback<void(AclConnectionStats)> callback,
+                          os::Handler* handler) {
+    handler_->Post(BindOnce(&impl::handle_get_scheduling_stats, common::Unretained(this), handle, std::move(callback),
+                            common::Unretained(handler)));
+  }
+
+  void handle_get_scheduling_stats(uint16_t handle, common::OnceCallback<void(AclConnectionStats)> callback,
+                                   os::Handler* handler) {
+    auto connection = acl_connections_.find(handle);
+    if (connection == acl_connections_.end()) {
+      LOG_INFO("Dropping scheduling stats request of finished connection 0x%04hx", handle);
+      return;
+    }
+    AclConnectionStats stats = connection->second.stats_;
+    stats.credits_in_use = connection->second.number_of_sent_packets_;
+    handler->Post(BindOnce(std::move(callback), stats));
+  }
+
+  void SetAclScheduler(std::unique_ptr<AclScheduler> scheduler) {
+    ASSERT_LOG(handler_ == nullptr, "The scheduler must be set before the module starts");
+    ASSERT(scheduler != nullptr);
+    scheduler_ = std::move(scheduler);
+  }
+
   const AclManager& acl_manager_;
 
   static constexpr uint16_t kMinimumCeLength = 0x0002;
@@ -1893,8 +1973,8 @@ struct AclManager::impl {
   uint16_t acl_packet_credits_ = 0;
   uint16_t acl_buffer_length_ = 0;
 
-  std::list<std::unique_ptr<AclPacketBuilder>> fragments_to_send_;
-  std::map<uint16_t, acl_connection>::iterator current_connection_pair_;
+  std::unique_ptr<AclScheduler> scheduler_ = std::make_unique<WeightedFairAclScheduler>();
+  bool enqueue_registered_ = false;
 
   HciLayer* hci_layer_ = nullptr;
   os::Handler* handler_ = nullptr;
@@ -2067,6 +2147,15 @@ void AclConnection::Finish() {
   return manager_->pimpl_->Finish(handle_);
 }
 
+bool AclConnection::SetSchedulingPriority(AclScheduler::Priority priority, uint16_t weight) {
+  return manager_->pimpl_->SetSchedulingPriority(handle_, priority, weight);
+}
+
+void AclConnection::GetSchedulingStats(common::OnceCallback<void(AclConnectionStats)> callback,
+                                       os::Handler* handler) {
+  return manager_->pimpl_->GetSchedulingStats(handle_, std::move(callback), handler);
+}
+
 AclManager::AclManager() : pimpl_(std::make_unique<impl>(*this)) {}
 
 void AclManager::RegisterCallbacks(ConnectionCallbacks* callbacks, os::Handler* handler) {
@@ -2123,6 +2212,10 @@ void AclManager::WriteDefaultLinkPolicySettings(uint16_t default_link_policy_set
                               default_link_policy_settings));
 }
 
+void AclManager::SetAclScheduler(std::unique_ptr<AclScheduler> scheduler) {
+  pimpl_->SetAclScheduler(std::move(scheduler));
+}
+
 void AclManager::ListDependencies(ModuleList* list) {
   list->add<HciLayer>();
   list->add<Controller>();
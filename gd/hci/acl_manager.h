@@ -16,10 +16,12 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include "common/bidi_queue.h"
 #include "common/callback.h"
+#include "hci/acl_scheduler.h"
 #include "hci/address.h"
 #include "hci/address_with_type.h"
 #include "hci/hci_layer.h"
@@ -81,6 +83,18 @@ class ConnectionManagementCallbacks {
   virtual void OnReadClockComplete(uint32_t clock, uint16_t accuracy) = 0;
 };
 
+// Outgoing data of one connection, as scheduled by AclManager
+struct AclConnectionStats {
+  uint64_t packets_sent = 0;
+  uint64_t fragments_sent = 0;
+  // Controller credits held by fragments that are not completed yet
+  uint16_t credits_in_use = 0;
+  uint16_t max_credits_in_use = 0;
+  // From dequeueing a packet from the connection queue to handing its last fragment to the HCI layer
+  std::chrono::microseconds total_latency{0};
+  std::chrono::microseconds max_latency{0};
+};
+
 class AclConnection {
  public:
   AclConnection()
@@ -155,6 +169,10 @@ class AclConnection {
   // Ask AclManager to clean me up. Must invoke after on_disconnect is called
   virtual void Finish();
 
+  // Changes how this connection shares controller buffers with the other connections
+  virtual bool SetSchedulingPriority(AclScheduler::Priority priority, uint16_t weight);
+  virtual void GetSchedulingStats(common::OnceCallback<void(AclConnectionStats)> callback, os::Handler* handler);
+
   // TODO: API to change link settings ... ?
 
  private:
@@ -239,6 +257,9 @@ class AclManager : public Module {
   virtual void ReadDefaultLinkPolicySettings();
   virtual void WriteDefaultLinkPolicySettings(uint16_t default_link_policy_settings);
 
+  // Replaces the default WeightedFairAclScheduler. Must be called before the module starts.
+  void SetAclScheduler(std::unique_ptr<AclScheduler> scheduler);
+
   static const ModuleFactory Factory;
 
  protected:
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_scheduler.h"
+
+#include "os/log.h"
+
+namespace bluetooth {
+namespace hci {
+
+void WeightedFairAclScheduler::AddConnection(uint16_t handle) {
+  ASSERT(connections_.count(handle) == 0);
+  connections_.emplace(handle, Connection());
+}
+
+void WeightedFairAclScheduler::RemoveConnection(uint16_t handle) {
+  auto connection = connections_.find(handle);
+  ASSERT(connection != connections_.end());
+  if (connection->second.ready_fragments > 0) {
+    active_list(connection->second.priority).remove(handle);
+  }
+  connections_.erase(connection);
+}
+
+void WeightedFairAclScheduler::SetPriority(uint16_t handle, Priority priority, uint16_t weight) {
+  ASSERT(weight > 0);
+  auto connection = connections_.find(handle);
+  ASSERT(connection != connections_.end());
+  if (connection->second.ready_fragments > 0 && connection->second.priority != priority) {
+    active_list(connection->second.priority).remove(handle);
+    active_list(priority).push_back(handle);
+    connection->second.deficit = 0;
+  }
+  connection->second.priority = priority;
+  connection->second.weight = weight;
+  if (connection->second.deficit > weight) {
+    connection->second.deficit = weight;
+  }
+}
+
+void WeightedFairAclScheduler::AddReadyFragments(uint16_t handle, size_t num_fragments) {
+  auto connection = connections_.find(handle);
+  ASSERT(connection != connections_.end());
+  if (num_fragments == 0) {
+    return;
+  }
+  if (connection->second.ready_fragments == 0) {
+    active_list(connection->second.priority).push_back(handle);
+  }
+  connection->second.ready_fragments += num_fragments;
+}
+
+bool WeightedFairAclScheduler::HasReadyFragments() const {
+  return !active_high_.empty() || !active_normal_.empty();
+}
+
+uint16_t WeightedFairAclScheduler::Next() {
+  auto& active = active_high_.empty() ? active_normal_ : active_high_;
+  ASSERT(!active.empty());
+  uint16_t handle = active.front();
+  auto& connection = connections_.find(handle)->second;
+  if (connection.deficit == 0) {
+    connection.deficit = connection.weight;
+  }
+  connection.deficit--;
+  connection.ready_fragments--;
+  if (connection.ready_fragments == 0) {
+    // An idle connection does not keep what is left of its quantum
+    connection.deficit = 0;
+    active.pop_front();
+  } else if (connection.deficit == 0) {
+    active.splice(active.end(), active, active.begin());
+  }
+  return handle;
+}
+
+std::list<uint16_t>& WeightedFairAclScheduler::active_list(Priority priority) {
+  return priority == Priority::HIGH ? active_high_ : active_normal_;
+}
+
+}  // namespace hci
+}  // namespace bluetooth
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+
+namespace bluetooth {
+namespace hci {
+
+// Decides which connection sends the next ACL fragment to the controller. Every fragment costs one controller credit,
+// and AclManager only asks for a fragment when it holds a credit. All methods are called on the AclManager handler.
+class AclScheduler {
+ public:
+  enum class Priority {
+    NORMAL,
+    // Latency sensitive links, such as A2DP streaming. Always served before NORMAL links.
+    HIGH,
+  };
+
+  static constexpr uint16_t kDefaultWeight = 1;
+
+  virtual ~AclScheduler() = default;
+
+  // New connections are NORMAL with kDefaultWeight
+  virtual void AddConnection(uint16_t handle) = 0;
+  // Also drops the fragments the connection had ready
+  virtual void RemoveConnection(uint16_t handle) = 0;
+  // Connections of the same priority share credits in proportion to their weight, which must be non-zero
+  virtual void SetPriority(uint16_t handle, Priority priority, uint16_t weight) = 0;
+  // The connection has num_fragments more fragments to send
+  virtual void AddReadyFragments(uint16_t handle, size_t num_fragments) = 0;
+  virtual bool HasReadyFragments() const = 0;
+  // Returns the connection that sends the next fragment and counts the fragment as sent. There must be ready fragments.
+  virtual uint16_t Next() = 0;
+};
+
+// Strict priority between classes, deficit round robin by weight within a class. The quantum of a connection is its
+// weight in fragments, so a connection with weight 3 sends up to 3 fragments in a row before the next one gets a turn.
+class WeightedFairAclScheduler : public AclScheduler {
+ public:
+  void AddConnection(uint16_t handle) override;
+  void RemoveConnection(uint16_t handle) override;
+  void SetPriority(uint16_t handle, Priority priority, uint16_t weight) override;
+  void AddReadyFragments(uint16_t handle, size_t num_fragments) override;
+  bool HasReadyFragments() const override;
+  uint16_t Next() override;
+
+ private:
+  struct Connection {
+    Priority priority = Priority::NORMAL;
+    uint16_t weight = kDefaultWeight;
+    size_t ready_fragments = 0;
+    // Fragments left in the current round, refilled with weight when the connection gets its turn
+    uint16_t deficit = 0;
+  };
+
+  std::list<uint16_t>& active_list(Priority priority);
+
+  std::map<uint16_t, Connection> connections_;
+  // Connections with ready fragments, in the order they get their turn
+  std::list<uint16_t> active_high_;
+  std::list<uint16_t> active_normal_;
+};
+
+}  // namespace hci
+}  // namespace bluetooth
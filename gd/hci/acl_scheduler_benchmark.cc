@@ -0,0 +1,134 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <vector>
+
+#include "hci/acl_scheduler.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+// Simulated time advances in slots. The controller has kCredits ACL buffers and sends one fragment per slot.
+constexpr uint16_t kCredits = 8;
+constexpr int kSlotsPerIteration = 10000;
+
+struct Traffic {
+  // A new packet every period slots, or a packet always waiting when period is 0
+  int period;
+  size_t fragments_per_packet;
+  AclScheduler::Priority priority;
+  uint16_t weight;
+};
+
+// Connection 0 is an A2DP stream, the link whose tail latency matters. The others are two bulk transfers (OPP, FTP),
+// a PAN link, two HID devices and a GATT client.
+constexpr std::array<Traffic, 7> kTraffic = {{
+    {16, 2, AclScheduler::Priority::HIGH, AclScheduler::kDefaultWeight},
+    {0, 8, AclScheduler::Priority::NORMAL, AclScheduler::kDefaultWeight},
+    {0, 8, AclScheduler::Priority::NORMAL, AclScheduler::kDefaultWeight},
+    {0, 4, AclScheduler::Priority::NORMAL, 2},
+    {7, 1, AclScheduler::Priority::NORMAL, AclScheduler::kDefaultWeight},
+    {9, 1, AclScheduler::Priority::NORMAL, AclScheduler::kDefaultWeight},
+    {20, 3, AclScheduler::Priority::NORMAL, AclScheduler::kDefaultWeight},
+}};
+
+// Mirrors AclManager: every connection has an upper queue of packet arrival times, and at most one packet at a time is
+// fragmented and handed to the scheduler.
+class Simulation {
+ public:
+  explicit Simulation(bool use_priorities) {
+    for (uint16_t handle = 0; handle < kTraffic.size(); handle++) {
+      scheduler_.AddConnection(handle);
+      if (use_priorities) {
+        scheduler_.SetPriority(handle, kTraffic[handle].priority, kTraffic[handle].weight);
+      }
+    }
+  }
+
+  void Run(int num_slots, std::vector<int>* priority_latencies) {
+    for (int i = 0; i < num_slots; i++, now_++) {
+      for (uint16_t handle = 0; handle < kTraffic.size(); handle++) {
+        const Traffic& traffic = kTraffic[handle];
+        auto& connection = connections_[handle];
+        if (traffic.period == 0 ? connection.upper_queue.empty() : now_ % traffic.period == 0) {
+          connection.upper_queue.push_back(now_);
+        }
+        if (connection.fragments_left == 0 && !connection.upper_queue.empty()) {
+          connection.fragments_left = traffic.fragments_per_packet;
+          scheduler_.AddReadyFragments(handle, traffic.fragments_per_packet);
+        }
+      }
+      while (credits_ > 0 && scheduler_.HasReadyFragments()) {
+        credits_--;
+        uint16_t handle = scheduler_.Next();
+        auto& connection = connections_[handle];
+        if (--connection.fragments_left == 0) {
+          if (handle == 0) {
+            priority_latencies->push_back(now_ - connection.upper_queue.front());
+          }
+          connection.upper_queue.pop_front();
+        }
+      }
+      if (credits_ < kCredits) {
+        credits_++;
+      }
+    }
+  }
+
+ private:
+  struct Connection {
+    std::deque<int> upper_queue;
+    size_t fragments_left = 0;
+  };
+
+  WeightedFairAclScheduler scheduler_;
+  std::array<Connection, kTraffic.size()> connections_;
+  uint16_t credits_ = kCredits;
+  int now_ = 0;
+};
+
+int Percentile(std::vector<int>* latencies, double percentile) {
+  auto nth = latencies->begin() + static_cast<size_t>(percentile * (latencies->size() - 1));
+  std::nth_element(latencies->begin(), nth, latencies->end());
+  return *nth;
+}
+
+// Latency of the A2DP link, in slots from the packet reaching AclManager to its last fragment reaching the controller.
+// Arg 0 schedules every link as NORMAL with equal weights, which is the plain round robin AclManager used to do.
+void BM_AclSchedulerMixedTraffic(State& state) {
+  Simulation simulation(state.range(0) != 0);
+  std::vector<int> latencies;
+  for (auto _ : state) {
+    simulation.Run(kSlotsPerIteration, &latencies);
+  }
+  state.SetItemsProcessed(state.iterations() * kSlotsPerIteration);
+  state.counters["a2dp_p50_slots"] = Percentile(&latencies, 0.50);
+  state.counters["a2dp_p99_slots"] = Percentile(&latencies, 0.99);
+  state.counters["a2dp_max_slots"] = *std::max_element(latencies.begin(), latencies.end());
+}
+BENCHMARK(BM_AclSchedulerMixedTraffic)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
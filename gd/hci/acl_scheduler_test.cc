@@ -0,0 +1,125 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hci/acl_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace bluetooth {
+namespace hci {
+namespace {
+
+using Priority = AclScheduler::Priority;
+
+constexpr uint16_t kHandleA = 0x0001;
+constexpr uint16_t kHandleB = 0x0002;
+constexpr uint16_t kHandleC = 0x0003;
+
+class WeightedFairAclSchedulerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    scheduler_.AddConnection(kHandleA);
+    scheduler_.AddConnection(kHandleB);
+    scheduler_.AddConnection(kHandleC);
+  }
+
+  std::vector<uint16_t> Drain(size_t max_fragments) {
+    std::vector<uint16_t> handles;
+    while (scheduler_.HasReadyFragments() && handles.size() < max_fragments) {
+      handles.push_back(scheduler_.Next());
+    }
+    return handles;
+  }
+
+  WeightedFairAclScheduler scheduler_;
+};
+
+TEST_F(WeightedFairAclSchedulerTest, nothing_ready) {
+  EXPECT_FALSE(scheduler_.HasReadyFragments());
+  scheduler_.AddReadyFragments(kHandleA, 0);
+  EXPECT_FALSE(scheduler_.HasReadyFragments());
+}
+
+TEST_F(WeightedFairAclSchedulerTest, round_robin_with_default_weights) {
+  scheduler_.AddReadyFragments(kHandleA, 3);
+  scheduler_.AddReadyFragments(kHandleB, 1);
+  scheduler_.AddReadyFragments(kHandleC, 2);
+  std::vector<uint16_t> expected = {kHandleA, kHandleB, kHandleC, kHandleA, kHandleC, kHandleA};
+  EXPECT_EQ(expected, Drain(10));
+  EXPECT_FALSE(scheduler_.HasReadyFragments());
+}
+
+TEST_F(WeightedFairAclSchedulerTest, credits_shared_by_weight) {
+  scheduler_.SetPriority(kHandleA, Priority::NORMAL, 3);
+  scheduler_.AddReadyFragments(kHandleA, 100);
+  scheduler_.AddReadyFragments(kHandleB, 100);
+  std::vector<uint16_t> expected = {kHandleA, kHandleA, kHandleA, kHandleB, kHandleA, kHandleA, kHandleA, kHandleB};
+  EXPECT_EQ(expected, Drain(8));
+}
+
+TEST_F(WeightedFairAclSchedulerTest, idle_connection_loses_rest_of_quantum) {
+  scheduler_.SetPriority(kHandleA, Priority::NORMAL, 4);
+  scheduler_.AddReadyFragments(kHandleA, 1);
+  scheduler_.AddReadyFragments(kHandleB, 10);
+  EXPECT_EQ(kHandleA, scheduler_.Next());
+  // A comes back after B got its turn, and starts a new quantum behind B
+  scheduler_.AddReadyFragments(kHandleA, 10);
+  std::vector<uint16_t> expected = {kHandleB, kHandleA, kHandleA, kHandleA, kHandleA, kHandleB};
+  EXPECT_EQ(expected, Drain(6));
+}
+
+TEST_F(WeightedFairAclSchedulerTest, high_priority_served_first) {
+  scheduler_.SetPriority(kHandleC, Priority::HIGH, AclScheduler::kDefaultWeight);
+  scheduler_.AddReadyFragments(kHandleA, 2);
+  scheduler_.AddReadyFragments(kHandleB, 2);
+  EXPECT_EQ(kHandleA, scheduler_.Next());
+  scheduler_.AddReadyFragments(kHandleC, 2);
+  std::vector<uint16_t> expected = {kHandleC, kHandleC, kHandleB, kHandleA, kHandleB};
+  EXPECT_EQ(expected, Drain(10));
+}
+
+TEST_F(WeightedFairAclSchedulerTest, priority_change_of_ready_connection) {
+  scheduler_.AddReadyFragments(kHandleA, 2);
+  scheduler_.AddReadyFragments(kHandleB, 2);
+  scheduler_.SetPriority(kHandleB, Priority::HIGH, AclScheduler::kDefaultWeight);
+  std::vector<uint16_t> expected = {kHandleB, kHandleB, kHandleA, kHandleA};
+  EXPECT_EQ(expected, Drain(10));
+
+  scheduler_.AddReadyFragments(kHandleA, 1);
+  scheduler_.AddReadyFragments(kHandleB, 1);
+  scheduler_.SetPriority(kHandleB, Priority::NORMAL, AclScheduler::kDefaultWeight);
+  expected = {kHandleA, kHandleB};
+  EXPECT_EQ(expected, Drain(10));
+}
+
+TEST_F(WeightedFairAclSchedulerTest, remove_connection_drops_ready_fragments) {
+  scheduler_.AddReadyFragments(kHandleA, 2);
+  scheduler_.AddReadyFragments(kHandleB, 2);
+  scheduler_.RemoveConnection(kHandleA);
+  std::vector<uint16_t> expected = {kHandleB, kHandleB};
+  EXPECT_EQ(expected, Drain(10));
+
+  scheduler_.RemoveConnection(kHandleC);
+  scheduler_.AddConnection(kHandleA);
+  scheduler_.AddReadyFragments(kHandleA, 1);
+  EXPECT_EQ(kHandleA, scheduler_.Next());
+}
+
+}  // namespace
+}  // namespace hci
+}  // namespace bluetooth
@@ -27,6 +27,7 @@
 #include <gtest/gtest.h>
 
 using ::testing::NiceMock;
+using ::testing::Return;
 
 namespace bluetooth {
 namespace l2cap {
@@ -130,6 +131,26 @@ TEST_F(L2capClassicLinkTest, pending_channels_get_notified_on_acl_disconnect) {
   DequeueCallback();
 }
 
+TEST_F(L2capClassicLinkTest, link_uses_the_scheduler_chosen_for_its_device) {
+  const hci::Address device({0x01, 0x02, 0x03, 0x04, 0x05, 0x06});
+  delete link_;
+  raw_acl_connection_ = new NiceMock<MockAclConnection>();
+  ON_CALL(*raw_acl_connection_, GetAddress()).WillByDefault(Return(device));
+  EXPECT_CALL(mock_parameter_provider_, GetClassicLinkSchedulerType(device))
+      .WillOnce(Return(l2cap::internal::SchedulerType::WEIGHTED_FAIR));
+  link_ = new Link(signalling_handler_, std::unique_ptr<MockAclConnection>(raw_acl_connection_),
+                   &mock_parameter_provider_, &mock_classic_dynamic_channel_service_manager_,
+                   &mock_classic_fixed_channel_service_manager_);
+  EnqueueCallbackForTest();
+
+  // The connection request still reaches the ACL queue through the weighted fair scheduler
+  link_->SendConnectionRequest(kPsm, kCid);
+
+  auto dequeue_future = dequeue_promise_.get_future();
+  dequeue_future.wait();
+  DequeueCallback();
+}
+
 }  // namespace
 }  // namespace internal
 }  // namespace classic
@@ -39,6 +39,27 @@ static const uint16_t crctab[256] = {
     0x4c80, 0x8c41, 0x4400, 0x84c1, 0x8581, 0x4540, 0x8701, 0x47c0, 0x4680, 0x8641, 0x8201, 0x42c0, 0x4380, 0x8341,
     0x4100, 0x81c1, 0x8081, 0x4040,
 };
+
+// Slicing-by-8 tables derived from crctab: slice[k][b] is the CRC contribution of byte b followed by k zero bytes.
+struct SlicingTables {
+  uint16_t slice[8][256];
+};
+
+constexpr SlicingTables MakeSlicingTables() {
+  SlicingTables tables{};
+  for (int b = 0; b < 256; b++) {
+    tables.slice[0][b] = crctab[b];
+  }
+  for (int k = 1; k < 8; k++) {
+    for (int b = 0; b < 256; b++) {
+      uint16_t prev = tables.slice[k - 1][b];
+      tables.slice[k][b] = ((prev >> 8) & 0x00ff) ^ crctab[prev & 0x00ff];
+    }
+  }
+  return tables;
+}
+
+constexpr SlicingTables kSlicingTables = MakeSlicingTables();
 }  // namespace
 
 namespace bluetooth {
@@ -52,6 +73,21 @@ void Fcs::AddByte(uint8_t byte) {
   crc = ((crc >> 8) & 0x00ff) ^ crctab[(crc & 0x00ff) ^ byte];
 }
 
+void Fcs::AddBytes(const uint8_t* data, size_t length) {
+  const auto& t = kSlicingTables.slice;
+  uint16_t value = crc;
+  while (length >= 8) {
+    value = t[7][(value & 0x00ff) ^ data[0]] ^ t[6][((value >> 8) & 0x00ff) ^ data[1]] ^ t[5][data[2]] ^
+            t[4][data[3]] ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    data += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    value = ((value >> 8) & 0x00ff) ^ crctab[(value & 0x00ff) ^ *data++];
+  }
+  crc = value;
+}
+
 uint16_t Fcs::GetChecksum() const {
   return crc;
 }
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include <vector>
+
+#include "l2cap/fcs.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace l2cap {
+namespace {
+
+std::vector<uint8_t> MakePdu(size_t size) {
+  std::vector<uint8_t> pdu(size);
+  for (size_t i = 0; i < size; i++) {
+    pdu[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return pdu;
+}
+
+void BM_FcsAddByte(State& state) {
+  auto pdu = MakePdu(state.range(0));
+  for (auto _ : state) {
+    Fcs fcs;
+    fcs.Initialize();
+    for (uint8_t byte : pdu) {
+      fcs.AddByte(byte);
+    }
+    benchmark::DoNotOptimize(fcs.GetChecksum());
+  }
+  state.SetBytesProcessed(state.iterations() * pdu.size());
+}
+BENCHMARK(BM_FcsAddByte)->Arg(16)->Arg(251)->Arg(1021)->Arg(4096);
+
+void BM_FcsAddBytes(State& state) {
+  auto pdu = MakePdu(state.range(0));
+  for (auto _ : state) {
+    Fcs fcs;
+    fcs.Initialize();
+    fcs.AddBytes(pdu.data(), pdu.size());
+    benchmark::DoNotOptimize(fcs.GetChecksum());
+  }
+  state.SetBytesProcessed(state.iterations() * pdu.size());
+}
+BENCHMARK(BM_FcsAddBytes)->Arg(16)->Arg(251)->Arg(1021)->Arg(4096);
+
+}  // namespace
+}  // namespace l2cap
+}  // namespace bluetooth
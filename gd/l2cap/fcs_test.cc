@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/fcs.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+namespace bluetooth {
+namespace l2cap {
+namespace {
+
+uint16_t ChecksumByteByByte(const uint8_t* data, size_t length) {
+  Fcs fcs;
+  fcs.Initialize();
+  for (size_t i = 0; i < length; i++) {
+    fcs.AddByte(data[i]);
+  }
+  return fcs.GetChecksum();
+}
+
+TEST(L2capFcsTest, check_value) {
+  // The L2CAP FCS is CRC-16/ARC, whose catalogued check value over "123456789" is 0xbb3d
+  const uint8_t data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+  EXPECT_EQ(0xbb3d, ChecksumByteByByte(data, sizeof(data)));
+  Fcs fcs;
+  fcs.Initialize();
+  fcs.AddBytes(data, sizeof(data));
+  EXPECT_EQ(0xbb3d, fcs.GetChecksum());
+}
+
+TEST(L2capFcsTest, add_bytes_matches_add_byte) {
+  std::vector<uint8_t> data(1100);
+  srand(42);
+  for (auto& byte : data) {
+    byte = static_cast<uint8_t>(rand());
+  }
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t length = 0; offset + length <= data.size(); length += (length < 64 ? 1 : 61)) {
+      Fcs fcs;
+      fcs.Initialize();
+      fcs.AddBytes(data.data() + offset, length);
+      ASSERT_EQ(ChecksumByteByByte(data.data() + offset, length), fcs.GetChecksum())
+          << "offset " << offset << " length " << length;
+    }
+  }
+}
+
+TEST(L2capFcsTest, add_bytes_mixed_with_add_byte) {
+  std::vector<uint8_t> data(300);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<uint8_t>(i * 7 + 3);
+  }
+  Fcs fcs;
+  fcs.Initialize();
+  fcs.AddByte(data[0]);
+  fcs.AddBytes(&data[1], 13);
+  fcs.AddByte(data[14]);
+  fcs.AddBytes(&data[15], data.size() - 15);
+  EXPECT_EQ(ChecksumByteByByte(data.data(), data.size()), fcs.GetChecksum());
+}
+
+}  // namespace
+}  // namespace l2cap
+}  // namespace bluetooth
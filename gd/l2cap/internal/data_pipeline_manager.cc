@@ -35,6 +35,7 @@ void DataPipelineManager::AttachChannel(Cid cid, std::shared_ptr<ChannelImpl> ch
 
 void DataPipelineManager::DetachChannel(Cid cid) {
   ASSERT(sender_map_.find(cid) != sender_map_.end());
+  scheduler_->OnChannelDetached(cid);
   sender_map_.erase(cid);
 }
 
@@ -48,6 +49,25 @@ void DataPipelineManager::OnPacketSent(Cid cid) {
   sender_map_.find(cid)->second.OnPacketSent();
 }
 
+void DataPipelineManager::SetChannelWeight(Cid cid, uint16_t weight) {
+  ASSERT(sender_map_.find(cid) != sender_map_.end());
+  scheduler_->SetChannelWeight(cid, weight);
+}
+
+std::unique_ptr<Scheduler> DataPipelineManager::CreateScheduler(SchedulerType scheduler_type,
+                                                                DataPipelineManager* data_pipeline_manager,
+                                                                LowerQueueUpEnd* link_queue_up_end,
+                                                                os::Handler* handler) {
+  switch (scheduler_type) {
+    case SchedulerType::FIFO:
+      return std::make_unique<Fifo>(data_pipeline_manager, link_queue_up_end, handler);
+    case SchedulerType::WEIGHTED_FAIR:
+      return std::make_unique<WeightedFair>(data_pipeline_manager, link_queue_up_end, handler);
+  }
+  LOG_ALWAYS_FATAL("Unknown scheduler type %d", static_cast<int>(scheduler_type));
+  return nullptr;
+}
+
 void DataPipelineManager::UpdateClassicConfiguration(Cid cid, classic::internal::ChannelConfigurationState config) {
   ASSERT(sender_map_.find(cid) != sender_map_.end());
   sender_map_.find(cid)->second.UpdateClassicConfiguration(config);
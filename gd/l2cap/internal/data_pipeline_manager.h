@@ -28,6 +28,7 @@
 #include "l2cap/internal/receiver.h"
 #include "l2cap/internal/scheduler.h"
 #include "l2cap/internal/scheduler_fifo.h"
+#include "l2cap/internal/scheduler_weighted_fair.h"
 #include "l2cap/l2cap_packets.h"
 #include "l2cap/mtu.h"
 #include "os/handler.h"
@@ -55,8 +56,10 @@ class DataPipelineManager {
   using LowerDequeue = UpperEnqueue;
   using LowerQueueUpEnd = common::BidiQueueEnd<LowerEnqueue, LowerDequeue>;
 
-  DataPipelineManager(os::Handler* handler, ILink* link, LowerQueueUpEnd* link_queue_up_end)
-      : handler_(handler), link_(link), scheduler_(std::make_unique<Fifo>(this, link_queue_up_end, handler)),
+  DataPipelineManager(os::Handler* handler, ILink* link, LowerQueueUpEnd* link_queue_up_end,
+                      SchedulerType scheduler_type = SchedulerType::FIFO)
+      : handler_(handler), link_(link),
+        scheduler_(CreateScheduler(scheduler_type, this, link_queue_up_end, handler)),
         receiver_(link_queue_up_end, handler, this) {}
 
   using ChannelMode = Sender::ChannelMode;
@@ -65,10 +68,15 @@ class DataPipelineManager {
   virtual void DetachChannel(Cid cid);
   virtual DataController* GetDataController(Cid cid);
   virtual void OnPacketSent(Cid cid);
+  virtual void SetChannelWeight(Cid cid, uint16_t weight);
   virtual void UpdateClassicConfiguration(Cid cid, classic::internal::ChannelConfigurationState config);
   virtual ~DataPipelineManager() = default;
 
  private:
+  static std::unique_ptr<Scheduler> CreateScheduler(SchedulerType scheduler_type,
+                                                    DataPipelineManager* data_pipeline_manager,
+                                                    LowerQueueUpEnd* link_queue_up_end, os::Handler* handler);
+
   os::Handler* handler_;
   ILink* link_;
   std::unique_ptr<Scheduler> scheduler_;
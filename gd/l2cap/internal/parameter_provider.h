@@ -18,6 +18,11 @@
 
 #include <chrono>
 
+#include "hci/address.h"
+#include "hci/address_with_type.h"
+#include "l2cap/internal/scheduler.h"
+#include "l2cap/psm.h"
+
 namespace bluetooth {
 namespace l2cap {
 namespace internal {
@@ -42,6 +47,16 @@ class ParameterProvider {
   virtual uint16_t GetLeInitialCredit() {
     return 100;
   }
+  virtual SchedulerType GetClassicLinkSchedulerType(hci::Address device) {
+    return SchedulerType::FIFO;
+  }
+  virtual SchedulerType GetLeLinkSchedulerType(hci::AddressWithType device) {
+    return SchedulerType::FIFO;
+  }
+  // Share of the link given to a dynamic channel of |psm| under SchedulerType::WEIGHTED_FAIR
+  virtual uint16_t GetDynamicChannelWeight(Psm psm) {
+    return 1;
+  }
 };
 
 }  // namespace internal
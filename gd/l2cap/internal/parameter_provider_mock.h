@@ -29,6 +29,8 @@ class MockParameterProvider : public ParameterProvider {
  public:
   MOCK_METHOD(std::chrono::milliseconds, GetClassicLinkIdleDisconnectTimeout, (), (override));
   MOCK_METHOD(std::chrono::milliseconds, GetLeLinkIdleDisconnectTimeout, (), (override));
+  MOCK_METHOD(SchedulerType, GetClassicLinkSchedulerType, (hci::Address device), (override));
+  MOCK_METHOD(SchedulerType, GetLeLinkSchedulerType, (hci::AddressWithType device), (override));
 };
 
 }  // namespace testing
@@ -32,6 +32,17 @@ namespace bluetooth {
 namespace l2cap {
 namespace internal {
 
+/**
+ * The policies a link can schedule its channels with.
+ * FIFO serves channels in the order their packets became ready.
+ * WEIGHTED_FAIR serves signalling channels first, then other fixed channels, then dynamic channels, and shares the
+ * link by channel weight within each of them.
+ */
+enum class SchedulerType {
+  FIFO,
+  WEIGHTED_FAIR,
+};
+
 /**
  * Handle the scheduling of packets through the l2cap stack.
  * For each attached channel, dequeue its outgoing packets and enqueue it to the given LinkQueueUpEnd, according to some
@@ -54,6 +65,18 @@ class Scheduler {
    */
   virtual void OnPacketsReady(Cid cid, int number_packets) {}
 
+  /**
+   * Set the share of the link given to a channel, relative to the other channels scheduled with the same priority.
+   * Ignored by schedulers without weights.
+   */
+  virtual void SetChannelWeight(Cid cid, uint16_t weight) {}
+
+  /**
+   * Callback from the data pipeline manager to indicate that the channel is detached, so the scheduler must not dequeue
+   * from it any more
+   */
+  virtual void OnChannelDetached(Cid cid) {}
+
   virtual ~Scheduler() = default;
 };
 
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include <thread>
+#include <vector>
+
+#include "l2cap/internal/data_controller.h"
+#include "l2cap/internal/data_pipeline_manager.h"
+#include "l2cap/internal/scheduler_fifo.h"
+#include "l2cap/internal/scheduler_weighted_fair.h"
+#include "os/handler.h"
+#include "os/thread.h"
+#include "packet/raw_builder.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+namespace {
+
+constexpr Cid kBulkCidA = kFirstDynamicChannel;
+constexpr Cid kBulkCidB = kFirstDynamicChannel + 1;
+constexpr int kBulkPackets = 64;
+constexpr size_t kPduSize = 1000;
+
+class BenchmarkDataController : public DataController {
+ public:
+  void OnSdu(std::unique_ptr<packet::BasePacketBuilder> sdu) override {}
+  void OnPdu(packet::PacketView<true> pdu) override {}
+  std::unique_ptr<packet::BasePacketBuilder> GetNextPacket() override {
+    auto packet = std::make_unique<packet::RawBuilder>();
+    packet->AddOctets(std::vector<uint8_t>(kPduSize));
+    return packet;
+  }
+  void EnableFcs(bool enabled) override {}
+  void SetRetransmissionAndFlowControlOptions(const RetransmissionAndFlowControlConfigurationOption& option) override {}
+};
+
+// Records the order in which the scheduler serves the channels
+class BenchmarkDataPipelineManager : public DataPipelineManager {
+ public:
+  BenchmarkDataPipelineManager(os::Handler* handler, LowerQueueUpEnd* link_queue_up_end)
+      : DataPipelineManager(handler, nullptr, link_queue_up_end) {}
+
+  DataController* GetDataController(Cid cid) override {
+    return &data_controller_;
+  }
+
+  void OnPacketSent(Cid cid) override {
+    if (cid == kClassicSignallingCid) {
+      signalling_position_ = packets_sent_;
+    } else if (cid == kBulkCidB && first_bulk_b_position_ < 0) {
+      first_bulk_b_position_ = packets_sent_;
+    }
+    packets_sent_++;
+  }
+
+  void Reset() {
+    packets_sent_ = 0;
+    signalling_position_ = -1;
+    first_bulk_b_position_ = -1;
+  }
+
+  int signalling_position_ = -1;
+  int first_bulk_b_position_ = -1;
+
+ private:
+  BenchmarkDataController data_controller_;
+  int packets_sent_ = 0;
+};
+
+// Two bulk dynamic channels fill the link, then a signalling packet arrives behind them. Reports how many packets go
+// to the link before the signalling packet and before the first packet of the second bulk channel.
+template <class SchedulerType>
+void BM_L2capSchedulerBulkAndSignalling(State& state) {
+  os::Thread thread("scheduler_thread", os::Thread::Priority::NORMAL);
+  os::Handler handler(&thread);
+  common::BidiQueue<Scheduler::LowerDequeue, Scheduler::LowerEnqueue> link_queue(10);
+  BenchmarkDataPipelineManager data_pipeline_manager(&handler, link_queue.GetUpEnd());
+  SchedulerType scheduler(&data_pipeline_manager, link_queue.GetUpEnd(), &handler);
+
+  int64_t total_signalling_position = 0;
+  int64_t total_first_bulk_b_position = 0;
+  constexpr int kPacketsPerIteration = 2 * kBulkPackets + 1;
+  for (auto _ : state) {
+    data_pipeline_manager.Reset();
+    handler.Post(common::BindOnce(
+        [](Scheduler* scheduler) {
+          scheduler->OnPacketsReady(kBulkCidA, kBulkPackets);
+          scheduler->OnPacketsReady(kBulkCidB, kBulkPackets);
+          scheduler->OnPacketsReady(kClassicSignallingCid, 1);
+        },
+        common::Unretained(&scheduler)));
+    for (int received = 0; received < kPacketsPerIteration;) {
+      if (link_queue.GetDownEnd()->TryDequeue() != nullptr) {
+        received++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    total_signalling_position += data_pipeline_manager.signalling_position_;
+    total_first_bulk_b_position += data_pipeline_manager.first_bulk_b_position_;
+  }
+
+  state.SetBytesProcessed(state.iterations() * kPacketsPerIteration * kPduSize);
+  state.counters["signalling_position"] = static_cast<double>(total_signalling_position) / state.iterations();
+  state.counters["first_bulk_b_position"] = static_cast<double>(total_first_bulk_b_position) / state.iterations();
+  handler.Clear();
+}
+BENCHMARK_TEMPLATE(BM_L2capSchedulerBulkAndSignalling, Fifo);
+BENCHMARK_TEMPLATE(BM_L2capSchedulerBulkAndSignalling, WeightedFair);
+
+}  // namespace
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
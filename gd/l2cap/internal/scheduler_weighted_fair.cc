@@ -0,0 +1,137 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/scheduler_weighted_fair.h"
+
+#include <algorithm>
+
+#include "l2cap/internal/data_pipeline_manager.h"
+#include "os/log.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+
+WeightedFair::WeightedFair(DataPipelineManager* data_pipeline_manager, LowerQueueUpEnd* link_queue_up_end,
+                           os::Handler* handler)
+    : data_pipeline_manager_(data_pipeline_manager), link_queue_up_end_(link_queue_up_end), handler_(handler) {
+  ASSERT(link_queue_up_end_ != nullptr && handler_ != nullptr);
+}
+
+WeightedFair::~WeightedFair() {
+  if (link_queue_enqueue_registered_) {
+    link_queue_up_end_->UnregisterEnqueue();
+  }
+}
+
+void WeightedFair::OnPacketsReady(Cid cid, int number_packets) {
+  if (number_packets == 0) {
+    return;
+  }
+  auto& channel = channels_[cid];
+  if (channel.ready_packets == 0) {
+    active_channels_[GetPriority(cid)].push_back(cid);
+  }
+  channel.ready_packets += number_packets;
+  try_register_link_queue_enqueue();
+}
+
+void WeightedFair::SetChannelWeight(Cid cid, uint16_t weight) {
+  ASSERT(weight > 0);
+  channels_[cid].weight = weight;
+}
+
+void WeightedFair::OnChannelDetached(Cid cid) {
+  auto channel = channels_.find(cid);
+  if (channel == channels_.end()) {
+    return;
+  }
+  if (channel->second.ready_packets > 0) {
+    active_channels_[GetPriority(cid)].remove(cid);
+  }
+  channels_.erase(channel);
+  if (!has_ready_packets() && link_queue_enqueue_registered_) {
+    link_queue_up_end_->UnregisterEnqueue();
+    link_queue_enqueue_registered_ = false;
+  }
+}
+
+WeightedFair::Priority WeightedFair::GetPriority(Cid cid) {
+  if (cid == kClassicSignallingCid || cid == kLeSignallingCid) {
+    return SIGNALLING;
+  }
+  if (cid < kFirstDynamicChannel) {
+    return FIXED;
+  }
+  return DYNAMIC;
+}
+
+bool WeightedFair::has_ready_packets() const {
+  for (const auto& active : active_channels_) {
+    if (!active.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::unique_ptr<WeightedFair::UpperDequeue> WeightedFair::link_queue_enqueue_callback() {
+  ASSERT(has_ready_packets());
+  auto& active = *std::find_if(active_channels_.begin(), active_channels_.end(),
+                               [](const std::list<Cid>& channels) { return !channels.empty(); });
+
+  // A channel that overdrew its deficit with a large PDU sits out until its quanta pay it back
+  auto* channel = &channels_[active.front()];
+  while (channel->deficit <= 0) {
+    channel->deficit += channel->weight * kQuantum;
+    if (channel->deficit <= 0) {
+      active.splice(active.end(), active, active.begin());
+      channel = &channels_[active.front()];
+    }
+  }
+
+  auto channel_id = active.front();
+  auto packet = data_pipeline_manager_->GetDataController(channel_id)->GetNextPacket();
+  channel->deficit -= packet->size();
+  channel->ready_packets--;
+  if (channel->ready_packets == 0) {
+    // An idle channel does not keep what is left of its quantum
+    channel->deficit = 0;
+    active.pop_front();
+  } else if (channel->deficit <= 0) {
+    active.splice(active.end(), active, active.begin());
+  }
+
+  data_pipeline_manager_->OnPacketSent(channel_id);
+  if (!has_ready_packets()) {
+    link_queue_up_end_->UnregisterEnqueue();
+    link_queue_enqueue_registered_ = false;
+  }
+  return packet;
+}
+
+void WeightedFair::try_register_link_queue_enqueue() {
+  if (link_queue_enqueue_registered_) {
+    return;
+  }
+  link_queue_up_end_->RegisterEnqueue(
+      handler_, common::Bind(&WeightedFair::link_queue_enqueue_callback, common::Unretained(this)));
+  link_queue_enqueue_registered_ = true;
+}
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
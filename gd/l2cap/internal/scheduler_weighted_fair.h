@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <list>
+#include <unordered_map>
+
+#include "common/bidi_queue.h"
+#include "common/bind.h"
+#include "l2cap/cid.h"
+#include "l2cap/internal/scheduler.h"
+#include "os/handler.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+class DataPipelineManager;
+
+/**
+ * Serves signalling channels, then the other fixed channels, then dynamic channels, with strict priority between the
+ * three classes. Within a class, channels share the link by deficit round robin over PDU bytes, in proportion to their
+ * weight, so a bulk channel cannot hold back the others for more than a quantum.
+ */
+class WeightedFair : public Scheduler {
+ public:
+  static constexpr uint16_t kDefaultWeight = 1;
+  // Bytes a channel of weight 1 may send in each round
+  static constexpr int kQuantum = 1024;
+
+  WeightedFair(DataPipelineManager* data_pipeline_manager, LowerQueueUpEnd* link_queue_up_end, os::Handler* handler);
+  ~WeightedFair() override;
+  void OnPacketsReady(Cid cid, int number_packets) override;
+  void SetChannelWeight(Cid cid, uint16_t weight) override;
+  void OnChannelDetached(Cid cid) override;
+
+ private:
+  enum Priority {
+    SIGNALLING = 0,
+    FIXED = 1,
+    DYNAMIC = 2,
+    NUM_PRIORITIES,
+  };
+
+  struct Channel {
+    uint16_t weight = kDefaultWeight;
+    int ready_packets = 0;
+    // Bytes left in the current round. Goes negative when a PDU is larger than what was left.
+    int deficit = 0;
+  };
+
+  static Priority GetPriority(Cid cid);
+
+  DataPipelineManager* data_pipeline_manager_;
+  LowerQueueUpEnd* link_queue_up_end_;
+  os::Handler* handler_;
+  std::unordered_map<Cid, Channel> channels_;
+  // Channels with ready packets, in the order they get their turn
+  std::array<std::list<Cid>, NUM_PRIORITIES> active_channels_;
+  bool link_queue_enqueue_registered_ = false;
+
+  bool has_ready_packets() const;
+  void try_register_link_queue_enqueue();
+  std::unique_ptr<LowerEnqueue> link_queue_enqueue_callback();
+};
+
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
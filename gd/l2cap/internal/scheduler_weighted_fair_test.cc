@@ -0,0 +1,177 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "l2cap/internal/scheduler_weighted_fair.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <future>
+#include <map>
+#include <thread>
+
+#include "l2cap/internal/data_controller_mock.h"
+#include "l2cap/internal/data_pipeline_manager_mock.h"
+#include "os/handler.h"
+#include "os/queue.h"
+#include "os/thread.h"
+#include "packet/raw_builder.h"
+
+namespace bluetooth {
+namespace l2cap {
+namespace internal {
+namespace {
+
+using ::testing::_;
+using ::testing::Invoke;
+
+constexpr Cid kDynamicCidA = kFirstDynamicChannel;
+constexpr Cid kDynamicCidB = kFirstDynamicChannel + 1;
+
+PacketView<kLittleEndian> GetPacketView(std::unique_ptr<packet::BasePacketBuilder> packet) {
+  auto bytes = std::make_shared<std::vector<uint8_t>>();
+  BitInserter i(*bytes);
+  bytes->reserve(packet->size());
+  packet->Serialize(i);
+  return packet::PacketView<packet::kLittleEndian>(bytes);
+}
+
+void sync_handler(os::Handler* handler) {
+  std::promise<void> promise;
+  auto future = promise.get_future();
+  handler->Post(common::BindOnce(&std::promise<void>::set_value, common::Unretained(&promise)));
+  auto status = future.wait_for(std::chrono::milliseconds(300));
+  EXPECT_EQ(status, std::future_status::ready);
+}
+
+// Gives basic frames of pdu_size bytes on the channel
+class MyDataController : public testing::MockDataController {
+ public:
+  std::unique_ptr<BasePacketBuilder> GetNextPacket() override {
+    auto payload = std::make_unique<packet::RawBuilder>();
+    payload->AddOctets(std::vector<uint8_t>(pdu_size - kBasicFrameHeaderSize, 0));
+    return BasicFrameBuilder::Create(cid, std::move(payload));
+  }
+
+  static constexpr size_t kBasicFrameHeaderSize = 4;
+  Cid cid = kInvalidCid;
+  size_t pdu_size = WeightedFair::kQuantum;
+};
+
+class L2capSchedulerWeightedFairTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    thread_ = new os::Thread("test_thread", os::Thread::Priority::NORMAL);
+    queue_handler_ = new os::Handler(thread_);
+    mock_data_pipeline_manager_ =
+        new ::testing::NiceMock<testing::MockDataPipelineManager>(queue_handler_, link_queue_.GetUpEnd());
+    ON_CALL(*mock_data_pipeline_manager_, GetDataController(_)).WillByDefault(Invoke([this](Cid cid) {
+      auto& data_controller = data_controllers_[cid];
+      data_controller.cid = cid;
+      return &data_controller;
+    }));
+    scheduler_ = new WeightedFair(mock_data_pipeline_manager_, link_queue_.GetUpEnd(), queue_handler_);
+  }
+
+  void TearDown() override {
+    delete scheduler_;
+    delete mock_data_pipeline_manager_;
+    queue_handler_->Clear();
+    delete queue_handler_;
+    delete thread_;
+  }
+
+  // Makes all the channels ready at once, so the scheduler sees them together
+  void PacketsReady(std::vector<std::pair<Cid, int>> cids_and_num_packets) {
+    queue_handler_->Post(common::BindOnce(
+        [](Scheduler* scheduler, std::vector<std::pair<Cid, int>> cids_and_num_packets) {
+          for (auto& cid_and_num_packets : cids_and_num_packets) {
+            scheduler->OnPacketsReady(cid_and_num_packets.first, cid_and_num_packets.second);
+          }
+        },
+        common::Unretained(scheduler_), std::move(cids_and_num_packets)));
+    sync_handler(queue_handler_);
+  }
+
+  // The scheduler fills the link queue from its handler, so wait for the packets to show up
+  std::vector<Cid> DequeueCids(size_t num_packets) {
+    std::vector<Cid> cids;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (cids.size() < num_packets && std::chrono::steady_clock::now() < deadline) {
+      auto packet = link_queue_.GetDownEnd()->TryDequeue();
+      if (packet == nullptr) {
+        std::this_thread::yield();
+        continue;
+      }
+      auto basic_frame_view = BasicFrameView::Create(GetPacketView(std::move(packet)));
+      EXPECT_TRUE(basic_frame_view.IsValid());
+      cids.push_back(basic_frame_view.GetChannelId());
+    }
+    return cids;
+  }
+
+  os::Thread* thread_ = nullptr;
+  os::Handler* queue_handler_ = nullptr;
+  common::BidiQueue<Scheduler::LowerDequeue, Scheduler::LowerEnqueue> link_queue_{10};
+  ::testing::NiceMock<testing::MockDataPipelineManager>* mock_data_pipeline_manager_ = nullptr;
+  std::map<Cid, MyDataController> data_controllers_;
+  WeightedFair* scheduler_ = nullptr;
+};
+
+TEST_F(L2capSchedulerWeightedFairTest, send_packet) {
+  EXPECT_CALL(*mock_data_pipeline_manager_, OnPacketSent(kDynamicCidA));
+  PacketsReady({{kDynamicCidA, 1}});
+  EXPECT_EQ(std::vector<Cid>({kDynamicCidA}), DequeueCids(1));
+}
+
+TEST_F(L2capSchedulerWeightedFairTest, signalling_and_fixed_channels_first) {
+  PacketsReady({{kDynamicCidA, 2}, {kLeAttributeCid, 2}, {kClassicSignallingCid, 1}});
+  std::vector<Cid> expected = {kClassicSignallingCid, kLeAttributeCid, kLeAttributeCid, kDynamicCidA, kDynamicCidA};
+  EXPECT_EQ(expected, DequeueCids(expected.size()));
+}
+
+TEST_F(L2capSchedulerWeightedFairTest, dynamic_channels_share_by_weight) {
+  scheduler_->SetChannelWeight(kDynamicCidB, 3);
+  PacketsReady({{kDynamicCidA, 5}, {kDynamicCidB, 5}});
+  std::vector<Cid> expected = {kDynamicCidA, kDynamicCidB, kDynamicCidB, kDynamicCidB, kDynamicCidA,
+                               kDynamicCidB, kDynamicCidB, kDynamicCidA, kDynamicCidA, kDynamicCidA};
+  EXPECT_EQ(expected, DequeueCids(expected.size()));
+}
+
+TEST_F(L2capSchedulerWeightedFairTest, large_pdu_uses_later_quanta) {
+  data_controllers_[kDynamicCidA].pdu_size = 3 * WeightedFair::kQuantum;
+  PacketsReady({{kDynamicCidA, 2}, {kDynamicCidB, 4}});
+  // A overdraws by two quanta with its first PDU, so B sends three PDUs before A gets its next turn
+  std::vector<Cid> expected = {kDynamicCidA, kDynamicCidB, kDynamicCidB, kDynamicCidB, kDynamicCidA, kDynamicCidB};
+  EXPECT_EQ(expected, DequeueCids(expected.size()));
+}
+
+TEST_F(L2capSchedulerWeightedFairTest, detached_channel_is_not_dequeued) {
+  queue_handler_->Post(common::BindOnce(
+      [](Scheduler* scheduler) {
+        scheduler->OnPacketsReady(kDynamicCidA, 3);
+        scheduler->OnPacketsReady(kDynamicCidB, 1);
+        scheduler->OnChannelDetached(kDynamicCidA);
+      },
+      common::Unretained(scheduler_)));
+  sync_handler(queue_handler_);
+  EXPECT_EQ(std::vector<Cid>({kDynamicCidB}), DequeueCids(1));
+  EXPECT_EQ(nullptr, link_queue_.GetDownEnd()->TryDequeue());
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace l2cap
+}  // namespace bluetooth
@@ -35,7 +35,9 @@ Link::Link(os::Handler* l2cap_handler, std::unique_ptr<hci::AclConnection> acl_c
            DynamicChannelServiceManagerImpl* dynamic_service_manager,
            FixedChannelServiceManagerImpl* fixed_service_manager)
     : l2cap_handler_(l2cap_handler), acl_connection_(std::move(acl_connection)),
-      data_pipeline_manager_(l2cap_handler, this, acl_connection_->GetAclQueueEnd()),
+      data_pipeline_manager_(l2cap_handler, this, acl_connection_->GetAclQueueEnd(),
+                             parameter_provider->GetLeLinkSchedulerType(
+                                 {acl_connection_->GetAddress(), acl_connection_->GetAddressType()})),
       parameter_provider_(parameter_provider), dynamic_service_manager_(dynamic_service_manager),
       signalling_manager_(l2cap_handler_, this, &data_pipeline_manager_, dynamic_service_manager_,
                           &dynamic_channel_allocator_) {
@@ -104,6 +106,7 @@ std::shared_ptr<l2cap::internal::DynamicChannelImpl> Link::AllocateDynamicChanne
   if (channel != nullptr) {
     data_pipeline_manager_.AttachChannel(channel->GetCid(), channel,
                                          l2cap::internal::DataPipelineManager::ChannelMode::LE_CREDIT_BASED);
+    data_pipeline_manager_.SetChannelWeight(channel->GetCid(), parameter_provider_->GetDynamicChannelWeight(psm));
     RefreshRefCount();
     channel->local_initiated_ = false;
   }
@@ -116,6 +119,7 @@ std::shared_ptr<l2cap::internal::DynamicChannelImpl> Link::AllocateReservedDynam
   if (channel != nullptr) {
     data_pipeline_manager_.AttachChannel(channel->GetCid(), channel,
                                          l2cap::internal::DataPipelineManager::ChannelMode::LE_CREDIT_BASED);
+    data_pipeline_manager_.SetChannelWeight(channel->GetCid(), parameter_provider_->GetDynamicChannelWeight(psm));
     RefreshRefCount();
     channel->local_initiated_ = true;
   }
@@ -15,7 +15,7 @@
  */
 
 template <typename T>
-Queue<T>::Queue(size_t capacity) : enqueue_(capacity), dequeue_(0){};
+Queue<T>::Queue(size_t capacity) : capacity_(capacity), enqueue_(capacity > 0 ? 1 : 0), dequeue_(0){};
 
 template <typename T>
 Queue<T>::~Queue() {
@@ -25,14 +25,24 @@ Queue<T>::~Queue() {
 
 template <typename T>
 void Queue<T>::RegisterEnqueue(Handler* handler, EnqueueCallback callback) {
+  RegisterEnqueueInternal(
+      handler, base::Bind(&Queue<T>::EnqueueCallbackInternal, base::Unretained(this), std::move(callback)));
+}
+
+template <typename T>
+void Queue<T>::RegisterEnqueueBatch(Handler* handler, EnqueueBatchCallback callback) {
+  RegisterEnqueueInternal(
+      handler, base::Bind(&Queue<T>::EnqueueBatchCallbackInternal, base::Unretained(this), std::move(callback)));
+}
+
+template <typename T>
+void Queue<T>::RegisterEnqueueInternal(Handler* handler, Closure on_ready) {
   std::lock_guard<std::mutex> lock(mutex_);
   ASSERT(enqueue_.handler_ == nullptr);
   ASSERT(enqueue_.reactable_ == nullptr);
   enqueue_.handler_ = handler;
-  enqueue_.reactable_ = enqueue_.handler_->thread_->GetReactor()->Register(
-      enqueue_.reactive_semaphore_.GetFd(),
-      base::Bind(&Queue<T>::EnqueueCallbackInternal, base::Unretained(this), std::move(callback)),
-      base::Closure());
+  enqueue_.reactable_ = enqueue_.handler_->thread_->GetReactor()->Register(enqueue_.reactive_semaphore_.GetFd(),
+                                                                           std::move(on_ready), base::Closure());
 }
 
 template <typename T>
@@ -71,22 +81,82 @@ std::unique_ptr<T> Queue<T>::TryDequeue() {
     return nullptr;
   }
 
-  dequeue_.reactive_semaphore_.Decrease();
-
+  size_t old_size = queue_.size();
   std::unique_ptr<T> data = std::move(queue_.front());
   queue_.pop();
 
-  enqueue_.reactive_semaphore_.Increase();
+  UpdateReadinessLocked(old_size);
 
   return data;
 }
 
+template <typename T>
+std::vector<std::unique_ptr<T>> Queue<T>::TryDequeueBatch(size_t max) {
+  std::vector<std::unique_ptr<T>> batch;
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  size_t old_size = queue_.size();
+  size_t count = std::min(max, old_size);
+  if (count == 0) {
+    return batch;
+  }
+
+  batch.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    batch.push_back(std::move(queue_.front()));
+    queue_.pop();
+  }
+
+  UpdateReadinessLocked(old_size);
+
+  return batch;
+}
+
 template <typename T>
 void Queue<T>::EnqueueCallbackInternal(EnqueueCallback callback) {
   std::unique_ptr<T> data = callback.Run();
   ASSERT(data != nullptr);
   std::lock_guard<std::mutex> lock(mutex_);
-  enqueue_.reactive_semaphore_.Decrease();
+  ASSERT(queue_.size() < capacity_);
+  size_t old_size = queue_.size();
   queue_.push(std::move(data));
-  dequeue_.reactive_semaphore_.Increase();
+  UpdateReadinessLocked(old_size);
+}
+
+template <typename T>
+void Queue<T>::EnqueueBatchCallbackInternal(EnqueueBatchCallback callback) {
+  size_t room;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    room = capacity_ - queue_.size();
+  }
+  // Only the registered enqueue end adds data, so |room| can only grow while the callback runs.
+  std::vector<std::unique_ptr<T>> batch = callback.Run(room);
+  ASSERT(!batch.empty());
+  ASSERT(batch.size() <= room);
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t old_size = queue_.size();
+  for (auto& data : batch) {
+    ASSERT(data != nullptr);
+    queue_.push(std::move(data));
+  }
+  UpdateReadinessLocked(old_size);
+}
+
+template <typename T>
+void Queue<T>::UpdateReadinessLocked(size_t old_size) {
+  size_t new_size = queue_.size();
+  if (old_size == new_size) {
+    return;
+  }
+  if (old_size == 0) {
+    dequeue_.reactive_semaphore_.Increase();
+  } else if (new_size == 0) {
+    dequeue_.reactive_semaphore_.Decrease();
+  }
+  if (old_size == capacity_) {
+    enqueue_.reactive_semaphore_.Increase();
+  } else if (new_size == capacity_) {
+    enqueue_.reactive_semaphore_.Decrease();
+  }
 }
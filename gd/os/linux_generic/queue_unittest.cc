@@ -721,6 +721,51 @@ TEST_F(QueueTest, pass_smart_pointer_and_unregister) {
   future.wait();
 }
 
+TEST_F(QueueTest, enqueue_batch_and_dequeue_batch) {
+  Queue<std::string> queue(kQueueSize);
+
+  // Hand over more data than fits, the batch callback must be told how much room is left
+  std::promise<size_t> enqueue_promise;
+  auto enqueue_future = enqueue_promise.get_future();
+  queue.RegisterEnqueueBatch(enqueue_handler_,
+                             common::Bind(
+                                 [](Queue<std::string>* queue, std::promise<size_t>* promise, size_t max) {
+                                   queue->UnregisterEnqueue();
+                                   std::vector<std::unique_ptr<std::string>> batch;
+                                   for (size_t i = 0; i < max; i++) {
+                                     batch.push_back(std::make_unique<std::string>(std::to_string(i)));
+                                   }
+                                   promise->set_value(max);
+                                   return batch;
+                                 },
+                                 common::Unretained(&queue), common::Unretained(&enqueue_promise)));
+  EXPECT_EQ(enqueue_future.get(), (size_t)kQueueSize);
+
+  // A single dequeue wakeup drains the whole queue in two batches
+  std::promise<std::vector<size_t>> dequeue_promise;
+  auto dequeue_future = dequeue_promise.get_future();
+  queue.RegisterDequeue(dequeue_handler_,
+                        common::Bind(
+                            [](Queue<std::string>* queue, std::promise<std::vector<size_t>>* promise) {
+                              queue->UnregisterDequeue();
+                              std::vector<size_t> sizes;
+                              auto first = queue->TryDequeueBatch(kHalfOfQueueSize);
+                              EXPECT_EQ(*first.front(), "0");
+                              sizes.push_back(first.size());
+                              auto second = queue->TryDequeueBatch(kDoubleOfQueueSize);
+                              EXPECT_EQ(*second.back(), std::to_string(kQueueSize - 1));
+                              sizes.push_back(second.size());
+                              sizes.push_back(queue->TryDequeueBatch(kQueueSize).size());
+                              promise->set_value(sizes);
+                            },
+                            common::Unretained(&queue), common::Unretained(&dequeue_promise)));
+  auto sizes = dequeue_future.get();
+  ASSERT_EQ(sizes.size(), (size_t)3);
+  EXPECT_EQ(sizes[0], (size_t)kHalfOfQueueSize);
+  EXPECT_EQ(sizes[1], (size_t)(kQueueSize - kHalfOfQueueSize));
+  EXPECT_EQ(sizes[2], (size_t)0);
+}
+
 // Create all threads for death tests in the function that dies
 class QueueDeathTest : public ::testing::Test {
  public:
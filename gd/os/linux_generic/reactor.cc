@@ -20,7 +20,6 @@
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
-#include <algorithm>
 #include <cerrno>
 #include <cstring>
 
@@ -85,7 +84,9 @@ void Reactor::Run() {
   for (;;) {
     {
       std::unique_lock<std::mutex> lock(mutex_);
-      invalidation_list_.clear();
+      if (!invalidation_set_.empty()) {
+        invalidation_set_.clear();
+      }
     }
     epoll_event events[kEpollMaxEvents];
     int count;
@@ -106,7 +107,7 @@ void Reactor::Run() {
       auto* reactable = static_cast<Reactor::Reactable*>(event.data.ptr);
       std::unique_lock<std::mutex> lock(mutex_);
       // See if this reactable has been removed in the meantime.
-      if (std::find(invalidation_list_.begin(), invalidation_list_.end(), reactable) != invalidation_list_.end()) {
+      if (invalidation_set_.count(reactable) != 0) {
         continue;
       }
 
@@ -164,7 +165,7 @@ void Reactor::Unregister(Reactor::Reactable* reactable) {
   ASSERT(reactable != nullptr);
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    invalidation_list_.push_back(reactable);
+    invalidation_set_.insert(reactable);
   }
   bool delaying_delete_until_callback_finished = false;
   {
@@ -17,9 +17,11 @@
 #pragma once
 
 #include <unistd.h>
+#include <algorithm>
 #include <functional>
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include "common/bind.h"
 #include "common/callback.h"
@@ -51,6 +53,17 @@ class IQueueDequeue {
   virtual void RegisterDequeue(Handler* handler, DequeueCallback callback) = 0;
   virtual void UnregisterDequeue() = 0;
   virtual std::unique_ptr<T> TryDequeue() = 0;
+  virtual std::vector<std::unique_ptr<T>> TryDequeueBatch(size_t max) {
+    std::vector<std::unique_ptr<T>> batch;
+    while (batch.size() < max) {
+      std::unique_ptr<T> data = TryDequeue();
+      if (data == nullptr) {
+        break;
+      }
+      batch.push_back(std::move(data));
+    }
+    return batch;
+  }
 };
 
 template <typename T>
@@ -62,6 +75,9 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
   // A function moving data form queue to dequeue end buffer, it will be continually be invoked until queue
   // is empty. TryDequeue should be use in this function to get data from queue.
   using DequeueCallback = Callback<void()>;
+  // A function moving up to |max| pieces of data from enqueue end buffer to queue at once, where |max| is the room
+  // left in the queue. It may return fewer items, but must return at least one.
+  using EnqueueBatchCallback = Callback<std::vector<std::unique_ptr<T>>(size_t max)>;
   // Create a queue with |capacity| is the maximum number of messages a queue can contain
   explicit Queue(size_t capacity);
   ~Queue();
@@ -70,6 +86,9 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
   void RegisterEnqueue(Handler* handler, EnqueueCallback callback) override;
   // Unregister current EnqueueCallback from this queue, this will cause a crash if not registered yet.
   void UnregisterEnqueue() override;
+  // Same as RegisterEnqueue, but |callback| hands over as many pieces of data as fit in the queue in one call.
+  // UnregisterEnqueue must be used to unregister it.
+  void RegisterEnqueueBatch(Handler* handler, EnqueueBatchCallback callback);
   // Register |callback| that will be called on |handler| when the queue has at least one piece of data ready
   // for dequeue. This will cause a crash if handler or callback has already been registered before.
   void RegisterDequeue(Handler* handler, DequeueCallback callback) override;
@@ -78,14 +97,26 @@ class Queue : public IQueueEnqueue<T>, public IQueueDequeue<T> {
 
   // Try to dequeue an item from this queue. Return nullptr when there is nothing in the queue.
   std::unique_ptr<T> TryDequeue() override;
+  // Try to dequeue up to |max| items from this queue in one go. Return an empty vector when there is nothing in the
+  // queue. Calling this from the DequeueCallback drains a whole burst of data per reactor wakeup.
+  std::vector<std::unique_ptr<T>> TryDequeueBatch(size_t max) override;
 
  private:
+  void RegisterEnqueueInternal(Handler* handler, Closure on_ready);
   void EnqueueCallbackInternal(EnqueueCallback callback);
+  void EnqueueBatchCallbackInternal(EnqueueBatchCallback callback);
+  // Update the readiness of both endpoints after the queue changed from |old_size| items. Must hold |mutex_|.
+  void UpdateReadinessLocked(size_t old_size);
+  // The maximum number of messages this queue can contain
+  const size_t capacity_;
   // An internal queue that holds at most |capacity| pieces of data
   std::queue<std::unique_ptr<T>> queue_;
   // A mutex that guards data in this queue
   std::mutex mutex_;
 
+  // Each endpoint's semaphore is used as a binary flag that is readable while the endpoint can make progress (the
+  // queue is not full for enqueue, not empty for dequeue). It is only written when the queue crosses one of these
+  // boundaries, so a burst of data costs one wakeup instead of one eventfd read and write per item.
   class QueueEndpoint {
    public:
 #ifdef OS_LINUX_GENERIC
@@ -17,6 +17,7 @@
 #include "benchmark/benchmark.h"
 
 #include <future>
+#include <vector>
 
 #include "os/handler.h"
 #include "os/queue.h"
@@ -203,5 +204,109 @@ BENCHMARK_REGISTER_F(BM_QueuePerformance, send_10000_packet_vary_by_packet_size)
     ->Iterations(100)
     ->UseRealTime();
 
+class BatchEnqueueEnd {
+ public:
+  using Packet = std::vector<uint8_t>;
+
+  explicit BatchEnqueueEnd(size_t batch_size, Queue<Packet>* queue, Handler* handler)
+      : batch_size_(batch_size), handler_(handler), queue_(queue) {}
+
+  void Push(size_t count, size_t packet_size) {
+    for (size_t i = 0; i < count; i++) {
+      buffer_.push(std::make_unique<Packet>(packet_size, 0xab));
+    }
+    handler_->Post(common::BindOnce(&BatchEnqueueEnd::handle_register_enqueue, common::Unretained(this)));
+  }
+
+  std::vector<std::unique_ptr<Packet>> EnqueueBatchCallbackForTest(size_t max) {
+    std::vector<std::unique_ptr<Packet>> batch;
+    size_t count = std::min({max, batch_size_, buffer_.size()});
+    batch.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+      batch.push_back(std::move(buffer_.front()));
+      buffer_.pop();
+    }
+    if (buffer_.empty()) {
+      queue_->UnregisterEnqueue();
+    }
+    return batch;
+  }
+
+ private:
+  size_t batch_size_;
+  Handler* handler_;
+  Queue<Packet>* queue_;
+  std::queue<std::unique_ptr<Packet>> buffer_;
+
+  void handle_register_enqueue() {
+    queue_->RegisterEnqueueBatch(
+        handler_, common::Bind(&BatchEnqueueEnd::EnqueueBatchCallbackForTest, common::Unretained(this)));
+  }
+};
+
+class BatchDequeueEnd {
+ public:
+  using Packet = std::vector<uint8_t>;
+
+  explicit BatchDequeueEnd(size_t batch_size, int64_t count, Queue<Packet>* queue, Handler* handler,
+                           std::promise<void>* promise)
+      : batch_size_(batch_size), count_(count), handler_(handler), queue_(queue), promise_(promise) {}
+
+  void RegisterDequeue() {
+    handler_->Post(common::BindOnce(&BatchDequeueEnd::handle_register_dequeue, common::Unretained(this)));
+  }
+
+  void DequeueCallbackForTest() {
+    auto batch = queue_->TryDequeueBatch(batch_size_);
+    count_ -= batch.size();
+    if (count_ == 0) {
+      queue_->UnregisterDequeue();
+      promise_->set_value();
+    }
+  }
+
+ private:
+  size_t batch_size_;
+  int64_t count_;
+  Handler* handler_;
+  Queue<Packet>* queue_;
+  std::promise<void>* promise_;
+
+  void handle_register_dequeue() {
+    queue_->RegisterDequeue(handler_, common::Bind(&BatchDequeueEnd::DequeueCallbackForTest, common::Unretained(this)));
+  }
+};
+
+// ACL-like traffic: 1021 byte payloads (the maximum DH5 ACL payload) through a queue of 256, moved |batch| items at
+// a time on both ends.
+BENCHMARK_DEFINE_F(BM_QueuePerformance, send_acl_packet_vary_by_batch_size)(State& state) {
+  constexpr int64_t kNumPacketsToSend = 10000;
+  constexpr size_t kAclPayloadSize = 1021;
+  constexpr size_t kQueueCapacity = 256;
+  size_t batch_size = state.range(0);
+  for (auto _ : state) {
+    Queue<BatchEnqueueEnd::Packet> queue(kQueueCapacity);
+
+    std::promise<void> dequeue_promise;
+    auto dequeue_future = dequeue_promise.get_future();
+    BatchDequeueEnd dequeue_end(batch_size, kNumPacketsToSend, &queue, dequeue_handler_, &dequeue_promise);
+    dequeue_end.RegisterDequeue();
+
+    BatchEnqueueEnd enqueue_end(batch_size, &queue, enqueue_handler_);
+    enqueue_end.Push(kNumPacketsToSend, kAclPayloadSize);
+    dequeue_future.wait();
+  }
+
+  state.SetItemsProcessed(static_cast<int_fast64_t>(state.iterations()) * kNumPacketsToSend);
+  state.SetBytesProcessed(static_cast<int_fast64_t>(state.iterations()) * kNumPacketsToSend * kAclPayloadSize);
+};
+
+BENCHMARK_REGISTER_F(BM_QueuePerformance, send_acl_packet_vary_by_batch_size)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(64)
+    ->Iterations(100)
+    ->UseRealTime();
+
 }  // namespace os
 }  // namespace bluetooth
@@ -23,6 +23,7 @@
 #include <list>
 #include <mutex>
 #include <thread>
+#include <unordered_set>
 
 #include "common/callback.h"
 #include "os/utils.h"
@@ -77,7 +78,8 @@ class Reactor {
   int epoll_fd_;
   int control_fd_;
   std::atomic<bool> is_running_;
-  std::list<Reactable*> invalidation_list_;
+  // Reactables unregistered since the last epoll_wait, their pending events must be skipped
+  std::unordered_set<Reactable*> invalidation_set_;
   std::unique_ptr<std::future<void>> executing_reactable_finished_;
 };
 
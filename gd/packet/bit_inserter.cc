@@ -44,5 +44,15 @@ void BitInserter::insert_byte(uint8_t byte) {
   insert_bits(byte, 8);
 }
 
+void BitInserter::insert_bytes(const uint8_t* data, size_t length) {
+  if (num_saved_bits_ != 0) {
+    for (size_t i = 0; i < length; i++) {
+      insert_byte(data[i]);
+    }
+    return;
+  }
+  ByteInserter::insert_bytes(data, length);
+}
+
 }  // namespace packet
 }  // namespace bluetooth
@@ -78,5 +78,36 @@ TEST(BitInserterTest, observerTest) {
   ASSERT_EQ(result.size(), copy.size());
 }
 
+TEST(BitInserterTest, insertBytesTest) {
+  std::vector<uint8_t> bytes;
+  BitInserter it(bytes);
+  std::vector<uint8_t> copy;
+  size_t bulk_calls = 0;
+
+  it.RegisterObserver(ByteObserver([&copy](uint8_t byte) { copy.push_back(byte); },
+                                   [&copy, &bulk_calls](const uint8_t* data, size_t length) {
+                                     copy.insert(copy.end(), data, data + length);
+                                     bulk_calls++;
+                                   },
+                                   []() { return 0; }));
+
+  std::vector<uint8_t> payload = {0x01, 0x02, 0x03, 0x04, 0x05};
+  it.insert_bytes(payload.data(), payload.size());
+  ASSERT_EQ(payload, bytes);
+  ASSERT_EQ(payload, copy);
+  ASSERT_EQ(1, bulk_calls);
+
+  // Not byte aligned, so the bytes are shifted one at a time
+  it.insert_bits(0b1010, 4);
+  it.insert_bytes(payload.data(), 2);
+  it.insert_bits(0b0101, 4);
+  std::vector<uint8_t> result = {0x01, 0x02, 0x03, 0x04, 0x05, 0x1a, 0x20, 0x50};
+  ASSERT_EQ(result, bytes);
+  ASSERT_EQ(result, copy);
+  ASSERT_EQ(1, bulk_calls);
+
+  it.UnregisterObserver();
+}
+
 }  // namespace packet
 }  // namespace bluetooth
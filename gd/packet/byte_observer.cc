@@ -22,10 +22,25 @@ namespace packet {
 ByteObserver::ByteObserver(const std::function<void(uint8_t)>& on_byte, const std::function<uint64_t()>& get_value)
     : on_byte_(on_byte), get_value_(get_value) {}
 
+ByteObserver::ByteObserver(const std::function<void(uint8_t)>& on_byte,
+                           const std::function<void(const uint8_t*, size_t)>& on_bytes,
+                           const std::function<uint64_t()>& get_value)
+    : on_byte_(on_byte), on_bytes_(on_bytes), get_value_(get_value) {}
+
 void ByteObserver::OnByte(uint8_t byte) {
   on_byte_(byte);
 }
 
+void ByteObserver::OnBytes(const uint8_t* data, size_t length) {
+  if (on_bytes_) {
+    on_bytes_(data, length);
+    return;
+  }
+  for (size_t i = 0; i < length; i++) {
+    on_byte_(data[i]);
+  }
+}
+
 uint64_t ByteObserver::GetValue() {
   return get_value_();
 }
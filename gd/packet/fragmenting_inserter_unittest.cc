@@ -91,6 +91,45 @@ TEST(FragmentingInserterTest, observerTest) {
   ASSERT_EQ(checksum, observer.GetValue());
 }
 
+TEST(FragmentingInserterTest, insertBytesAcrossMtu) {
+  constexpr size_t kMtu = 10;
+  std::vector<uint8_t> payload(25);
+  for (size_t i = 0; i < payload.size(); i++) {
+    payload[i] = static_cast<uint8_t>(i);
+  }
+  std::vector<std::unique_ptr<RawBuilder>> fragments;
+  FragmentingInserter it(kMtu, std::back_insert_iterator(fragments));
+
+  std::vector<uint8_t> copy;
+  size_t bulk_calls = 0;
+  it.RegisterObserver(ByteObserver([&copy](uint8_t byte) { copy.push_back(byte); },
+                                   [&copy, &bulk_calls](const uint8_t* data, size_t length) {
+                                     copy.insert(copy.end(), data, data + length);
+                                     bulk_calls++;
+                                   },
+                                   []() { return 0; }));
+
+  it.insert_byte(0xff);
+  it.insert_bytes(payload.data(), payload.size());
+  it.UnregisterObserver();
+  it.finalize();
+
+  // One call per fragment the bytes land in
+  ASSERT_EQ(3, bulk_calls);
+  ASSERT_EQ(3, fragments.size());
+  std::vector<uint8_t> bytes;
+  BitInserter bit_inserter(bytes);
+  for (const auto& fragment : fragments) {
+    fragment->Serialize(bit_inserter);
+  }
+  ASSERT_EQ(kMtu, fragments[0]->size());
+  ASSERT_EQ(kMtu, fragments[1]->size());
+  ASSERT_EQ(payload.size() + 1 - 2 * kMtu, fragments[2]->size());
+  ASSERT_EQ(copy, bytes);
+  ASSERT_EQ(0xff, bytes[0]);
+  ASSERT_TRUE(std::equal(payload.begin(), payload.end(), bytes.begin() + 1));
+}
+
 TEST(FragmentingInserterTest, testMtuBoundaries) {
   constexpr size_t kPacketSize = 1024;
   auto counts = RawBuilder();
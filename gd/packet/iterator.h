@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <forward_list>
 #include <memory>
 
@@ -70,6 +72,16 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
     FixedWidthPODType extracted_value;
     uint8_t* value_ptr = (uint8_t*)&extracted_value;
 
+    // Single fragment: copy the whole value at once instead of walking the fragments for every byte.
+    if (contiguous_ != nullptr && !(begin_ > index_) && index_ + sizeof(FixedWidthPODType) <= end_) {
+      std::memcpy(value_ptr, contiguous_ + index_, sizeof(FixedWidthPODType));
+      if (!little_endian) {
+        std::reverse(value_ptr, value_ptr + sizeof(FixedWidthPODType));
+      }
+      index_ += sizeof(FixedWidthPODType);
+      return extracted_value;
+    }
+
     for (size_t i = 0; i < sizeof(FixedWidthPODType); i++) {
       size_t index = (little_endian ? i : sizeof(FixedWidthPODType) - i - 1);
       value_ptr[index] = *((*this)++);
@@ -79,6 +91,8 @@ class Iterator : public std::iterator<std::random_access_iterator_tag, uint8_t>
 
  private:
   std::forward_list<View> data_;
+  // Start of the only view in |data_|, or nullptr if there is more than one
+  const uint8_t* contiguous_;
   size_t index_;
   size_t begin_;
   size_t end_;
@@ -25,15 +25,27 @@ namespace packet {
 
 template <bool little_endian>
 PacketView<little_endian>::PacketView(const std::forward_list<class View> fragments)
-    : fragments_(fragments), length_(0) {
-  for (auto fragment : fragments_) {
+    : fragments_(fragments), length_(0), contiguous_data_(nullptr) {
+  for (const auto& fragment : fragments_) {
     length_ += fragment.size();
   }
+  UpdateContiguousData();
 }
 
 template <bool little_endian>
 PacketView<little_endian>::PacketView(std::shared_ptr<std::vector<uint8_t>> packet)
-    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()) {}
+    : fragments_({View(packet, 0, packet->size())}), length_(packet->size()), contiguous_data_(nullptr) {
+  UpdateContiguousData();
+}
+
+template <bool little_endian>
+void PacketView<little_endian>::UpdateContiguousData() {
+  if (!fragments_.empty() && std::next(fragments_.begin()) == fragments_.end()) {
+    contiguous_data_ = fragments_.front().data();
+  } else {
+    contiguous_data_ = nullptr;
+  }
+}
 
 template <bool little_endian>
 Iterator<little_endian> PacketView<little_endian>::begin() const {
@@ -53,6 +65,9 @@ uint8_t PacketView<little_endian>::operator[](size_t index) const {
 template <bool little_endian>
 uint8_t PacketView<little_endian>::at(size_t index) const {
   ASSERT_LOG(index < length_, "Index %zu out of bounds", index);
+  if (contiguous_data_ != nullptr) {
+    return contiguous_data_[index];
+  }
   for (const auto& fragment : fragments_) {
     if (index < fragment.size()) {
       return fragment[index];
@@ -68,6 +83,16 @@ size_t PacketView<little_endian>::size() const {
   return length_;
 }
 
+template <bool little_endian>
+bool PacketView<little_endian>::IsContiguous() const {
+  return contiguous_data_ != nullptr;
+}
+
+template <bool little_endian>
+const uint8_t* PacketView<little_endian>::data() const {
+  return contiguous_data_;
+}
+
 template <bool little_endian>
 std::forward_list<View> PacketView<little_endian>::GetSubviewList(size_t begin, size_t end) const {
   ASSERT(begin <= end);
@@ -77,6 +102,10 @@ std::forward_list<View> PacketView<little_endian>::GetSubviewList(size_t begin,
   std::forward_list<View>::iterator it = view_list.before_begin();
   size_t length = end - begin;
   for (const auto& fragment : fragments_) {
+    // Don't add empty trailing views, so that a subview of one fragment stays contiguous
+    if (length == 0 && !view_list.empty()) {
+      break;
+    }
     if (begin >= fragment.size()) {
       begin -= fragment.size();
     } else {
@@ -115,6 +144,7 @@ void PacketView<little_endian>::Append(PacketView to_add) {
     insertion_point++;
   }
   length_ += to_add.length_;
+  UpdateContiguousData();
 }
 
 // Explicit instantiations for both types of PacketViews.
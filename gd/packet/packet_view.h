@@ -48,6 +48,12 @@ class PacketView {
 
   size_t size() const;
 
+  // True when the packet is stored in a single fragment, which is the case for nearly all received HCI packets.
+  bool IsContiguous() const;
+
+  // Pointer to size() contiguous bytes when IsContiguous(), nullptr otherwise.
+  const uint8_t* data() const;
+
   PacketView<true> GetLittleEndianSubview(size_t begin, size_t end) const;
 
   PacketView<false> GetBigEndianSubview(size_t begin, size_t end) const;
@@ -58,6 +64,9 @@ class PacketView {
  private:
   std::forward_list<View> fragments_;
   size_t length_;
+  // Cached start of the only fragment, or nullptr if there is more than one
+  const uint8_t* contiguous_data_;
+  void UpdateContiguousData();
   PacketView<little_endian>() = delete;
   std::forward_list<View> GetSubviewList(size_t begin, size_t end) const;
 };
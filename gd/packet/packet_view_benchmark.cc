@@ -0,0 +1,96 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include <forward_list>
+#include <memory>
+#include <vector>
+
+#include "hci/hci_packets.h"
+#include "packet/packet_view.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace packet {
+namespace {
+
+const std::vector<uint8_t> kReadBufferSizeComplete = {0x0e, 0x0b, 0x01, 0x05, 0x10, 0x00, 0x00,
+                                                      0x04, 0x3c, 0x07, 0x00, 0x08, 0x00};
+
+const std::vector<uint8_t> kLeConnectionComplete = {0x3e, 0x13, 0x01, 0x00, 0x41, 0x00, 0x00, 0x00,
+                                                    0x13, 0x8e, 0x61, 0x5f, 0x36, 0x88, 0x18, 0x00,
+                                                    0x00, 0x00, 0xf4, 0x01, 0x00};
+
+const std::vector<uint8_t> kNumberOfCompletedPackets = {0x13, 0x11, 0x04, 0x01, 0x00, 0x02, 0x00, 0x02,
+                                                        0x00, 0x01, 0x00, 0x03, 0x00, 0x05, 0x00,
+                                                        0x04, 0x00, 0x01, 0x00};
+
+// state.range(0) == 0 keeps the event in one fragment, otherwise it is split in two, as a reassembled packet would be
+PacketView<kLittleEndian> MakeView(const std::vector<uint8_t>& bytes, State& state) {
+  auto data = std::make_shared<const std::vector<uint8_t>>(bytes);
+  if (state.range(0) == 0) {
+    return PacketView<kLittleEndian>({View(data, 0, data->size())});
+  }
+  size_t half = data->size() / 2;
+  return PacketView<kLittleEndian>({View(data, 0, half), View(data, half, data->size())});
+}
+
+void BM_ParseReadBufferSizeComplete(State& state) {
+  auto packet = MakeView(kReadBufferSizeComplete, state);
+  for (auto _ : state) {
+    auto event = hci::EventPacketView::Create(packet);
+    auto complete = hci::CommandCompleteView::Create(event);
+    auto view = hci::ReadBufferSizeCompleteView::Create(complete);
+    benchmark::DoNotOptimize(view.IsValid());
+    benchmark::DoNotOptimize(view.GetAclDataPacketLength());
+    benchmark::DoNotOptimize(view.GetTotalNumAclDataPackets());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseReadBufferSizeComplete)->Arg(0)->Arg(1);
+
+void BM_ParseLeConnectionComplete(State& state) {
+  auto packet = MakeView(kLeConnectionComplete, state);
+  for (auto _ : state) {
+    auto event = hci::EventPacketView::Create(packet);
+    auto meta = hci::LeMetaEventView::Create(event);
+    auto view = hci::LeConnectionCompleteView::Create(meta);
+    benchmark::DoNotOptimize(view.IsValid());
+    benchmark::DoNotOptimize(view.GetConnectionHandle());
+    benchmark::DoNotOptimize(view.GetPeerAddress());
+    benchmark::DoNotOptimize(view.GetConnInterval());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseLeConnectionComplete)->Arg(0)->Arg(1);
+
+void BM_ParseNumberOfCompletedPackets(State& state) {
+  auto packet = MakeView(kNumberOfCompletedPackets, state);
+  for (auto _ : state) {
+    auto event = hci::EventPacketView::Create(packet);
+    auto view = hci::NumberOfCompletedPacketsView::Create(event);
+    benchmark::DoNotOptimize(view.IsValid());
+    benchmark::DoNotOptimize(view.GetCompletedPackets().size());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ParseNumberOfCompletedPackets)->Arg(0)->Arg(1);
+
+}  // namespace
+}  // namespace packet
+}  // namespace bluetooth
@@ -542,6 +542,31 @@ TEST_F(PacketViewMultiViewTest, arrayOperatorTest) {
   ASSERT_DEATH(multi_view[single_view.size()], "");
 }
 
+TEST_F(PacketViewMultiViewTest, contiguousTest) {
+  ASSERT_TRUE(single_view.IsContiguous());
+  ASSERT_EQ(0, memcmp(single_view.data(), count_all.data(), count_all.size()));
+  ASSERT_FALSE(multi_view.IsContiguous());
+  ASSERT_EQ(nullptr, multi_view.data());
+  ASSERT_TRUE(single_view.GetLittleEndianSubview(4, 8).IsContiguous());
+  ASSERT_FALSE(multi_view.GetLittleEndianSubview(0, 8).IsContiguous());
+  ASSERT_TRUE(multi_view.GetLittleEndianSubview(4, 8).IsContiguous());
+}
+
+TEST_F(PacketViewMultiViewTest, extractTestLittleEndian) {
+  auto single_itr = single_view.begin();
+  auto multi_itr = multi_view.begin();
+  ASSERT_EQ(single_itr.extract<uint16_t>(), multi_itr.extract<uint16_t>());
+  ASSERT_EQ(single_itr.extract<uint32_t>(), multi_itr.extract<uint32_t>());
+  ASSERT_EQ(single_itr.extract<uint64_t>(), multi_itr.extract<uint64_t>());
+  ASSERT_EQ(single_itr.extract<uint64_t>(), multi_itr.extract<uint64_t>());
+  ASSERT_EQ(single_itr, multi_itr);
+}
+
+TEST_F(PacketViewMultiViewAppendTest, contiguousTestAppend) {
+  ASSERT_TRUE(single_view.IsContiguous());
+  ASSERT_FALSE(multi_view.IsContiguous());
+}
+
 TEST_F(PacketViewMultiViewAppendTest, sizeTestAppend) {
   ASSERT_EQ(single_view.size(), multi_view.size());
 }
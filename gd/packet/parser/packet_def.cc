@@ -209,8 +209,12 @@ void PacketDef::GenValidator(std::ostream& s) const {
       }
       s << started_field->GetDataType() << " checksum;";
       s << "checksum.Initialize();";
+      s << "if (checksum_view.IsContiguous()) {";
+      s << "checksum.AddBytes(checksum_view.data(), checksum_view.size());";
+      s << "} else {";
       s << "for (uint8_t byte : checksum_view) { ";
       s << "checksum.AddByte(byte);}";
+      s << "}";
       s << "if (checksum.GetChecksum() != (begin() + end_sum_index).extract<"
         << util::GetTypeForSize(started_field->GetSize().bits()) << ">()) { return false; }";
 
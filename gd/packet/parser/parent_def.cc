@@ -386,6 +386,8 @@ void ParentDef::GenSerialize(std::ostream& s) const {
       s << "shared_checksum_ptr->Initialize();";
       s << "i.RegisterObserver(packet::ByteObserver(";
       s << "[shared_checksum_ptr](uint8_t byte){ shared_checksum_ptr->AddByte(byte);},";
+      s << "[shared_checksum_ptr](const uint8_t* data, size_t length){";
+      s << "shared_checksum_ptr->AddBytes(data, length);},";
       s << "[shared_checksum_ptr](){ return static_cast<uint64_t>(shared_checksum_ptr->GetChecksum());}));";
     } else if (field->GetFieldType() == PaddingField::kFieldType) {
       s << "ASSERT(unpadded_size() <= " << field->GetSize().bytes() << ");";
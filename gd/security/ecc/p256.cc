@@ -0,0 +1,561 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Included relative to this file, which is also built by the legacy stack
+#include "p256.h"
+
+#include <string.h>
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+namespace p256 {
+
+namespace {
+
+constexpr int kNumLimbs = 4;
+constexpr int kWindowBits = 4;
+constexpr int kNumWindows = 256 / kWindowBits;
+constexpr int kTableSize = 1 << kWindowBits;
+
+// Field element modulo p, in the Montgomery domain with R = 2^256, least significant limb first
+typedef uint64_t Fe[kNumLimbs];
+
+// p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+constexpr Fe kP = {0xffffffffffffffff, 0x00000000ffffffff, 0x0000000000000000, 0xffffffff00000001};
+// R^2 mod p, to convert into the Montgomery domain
+constexpr Fe kR2 = {0x0000000000000003, 0xfffffffbffffffff, 0xfffffffffffffffe, 0x00000004fffffffd};
+
+constexpr uint32_t kB[kNumWords] = {0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0,
+                                    0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8};
+constexpr uint32_t kGx[kNumWords] = {0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81,
+                                     0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2};
+constexpr uint32_t kGy[kNumWords] = {0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357,
+                                     0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2};
+
+// Projective point (X : Y : Z), for x = X / Z and y = Y / Z. Infinity is (0 : 1 : 0).
+struct ProjectivePoint {
+  Fe x;
+  Fe y;
+  Fe z;
+};
+
+// Affine point, never infinity
+struct AffinePoint {
+  Fe x;
+  Fe y;
+};
+
+#if defined(__SIZEOF_INT128__)
+
+// Returns the low limb of acc + a * b + carry, and sets carry to the high limb. This cannot overflow 128 bits.
+inline uint64_t mac(uint64_t acc, uint64_t a, uint64_t b, uint64_t* carry) {
+  unsigned __int128 r = (unsigned __int128)a * b + acc + *carry;
+  *carry = (uint64_t)(r >> 64);
+  return (uint64_t)r;
+}
+
+inline uint64_t add_carry(uint64_t a, uint64_t b, uint64_t* carry) {
+  unsigned __int128 r = (unsigned __int128)a + b + *carry;
+  *carry = (uint64_t)(r >> 64);
+  return (uint64_t)r;
+}
+
+#else
+
+inline uint64_t mul_64(uint64_t a, uint64_t b, uint64_t* hi) {
+  uint64_t a0 = (uint32_t)a, a1 = a >> 32;
+  uint64_t b0 = (uint32_t)b, b1 = b >> 32;
+  uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+  uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+  *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  return (mid << 32) | (uint32_t)p00;
+}
+
+inline uint64_t mac(uint64_t acc, uint64_t a, uint64_t b, uint64_t* carry) {
+  uint64_t hi;
+  uint64_t lo = mul_64(a, b, &hi);
+  lo += *carry;
+  hi += lo < *carry;
+  lo += acc;
+  hi += lo < acc;
+  *carry = hi;
+  return lo;
+}
+
+inline uint64_t add_carry(uint64_t a, uint64_t b, uint64_t* carry) {
+  uint64_t r = a + *carry;
+  uint64_t c = r < a;
+  r += b;
+  *carry = c | (r < b);
+  return r;
+}
+
+#endif
+
+inline uint64_t sub_borrow(uint64_t a, uint64_t b, uint64_t* borrow) {
+  uint64_t r = a - b;
+  uint64_t c = a < b;
+  uint64_t r2 = r - *borrow;
+  *borrow = c | (r < *borrow);
+  return r2;
+}
+
+// r = |hi|:a mod p, for a value below 2p. |r| may alias |a|.
+inline void fe_reduce_once(Fe r, const Fe a, uint64_t hi) {
+  Fe t;
+  uint64_t borrow = 0;
+  for (int i = 0; i < kNumLimbs; i++) t[i] = sub_borrow(a[i], kP[i], &borrow);
+  // Keep a when the subtraction wrapped, that is when hi:a < p
+  uint64_t keep_a = 0 - (uint64_t)(borrow & ~hi & 1);
+  for (int i = 0; i < kNumLimbs; i++) r[i] = (a[i] & keep_a) | (t[i] & ~keep_a);
+}
+
+void fe_add(Fe r, const Fe a, const Fe b) {
+  Fe t;
+  uint64_t carry = 0;
+  for (int i = 0; i < kNumLimbs; i++) t[i] = add_carry(a[i], b[i], &carry);
+  fe_reduce_once(r, t, carry);
+}
+
+void fe_sub(Fe r, const Fe a, const Fe b) {
+  Fe t;
+  uint64_t borrow = 0;
+  for (int i = 0; i < kNumLimbs; i++) t[i] = sub_borrow(a[i], b[i], &borrow);
+  // Add p back when the subtraction wrapped
+  uint64_t mask = 0 - borrow;
+  uint64_t carry = 0;
+  for (int i = 0; i < kNumLimbs; i++) r[i] = add_carry(t[i], kP[i] & mask, &carry);
+}
+
+// Montgomery multiplication, r = a * b / R mod p. -p^-1 mod 2^64 is 1, so the multiple of p to add at each step is
+// the low limb m itself. The limbs of p are 2^64 - 1, 2^32 - 1, 0 and 2^64 - 2^32 + 1: the low limb of m * p cancels
+// the low limb of the accumulator with a carry of m, and the zero limb needs no multiplication.
+void fe_mul(Fe r, const Fe a, const Fe b) {
+  uint64_t t[kNumLimbs + 2] = {0};
+  for (int i = 0; i < kNumLimbs; i++) {
+    uint64_t carry = 0;
+    for (int j = 0; j < kNumLimbs; j++) t[j] = mac(t[j], a[j], b[i], &carry);
+    uint64_t c2 = 0;
+    t[kNumLimbs] = add_carry(t[kNumLimbs], carry, &c2);
+    t[kNumLimbs + 1] = c2;
+
+    uint64_t m = t[0];
+    carry = m;
+    t[0] = mac(t[1], m, kP[1], &carry);
+    t[1] = add_carry(t[2], 0, &carry);
+    t[2] = mac(t[3], m, kP[3], &carry);
+    c2 = 0;
+    t[3] = add_carry(t[kNumLimbs], carry, &c2);
+    t[kNumLimbs] = t[kNumLimbs + 1] + c2;
+  }
+  fe_reduce_once(r, t, t[kNumLimbs]);
+}
+
+inline void fe_sqr(Fe r, const Fe a) {
+  fe_mul(r, a, a);
+}
+
+inline void fe_copy(Fe r, const Fe a) {
+  memcpy(r, a, sizeof(Fe));
+}
+
+// r = a if |mask| is all ones, unchanged if it is zero
+inline void fe_cmov(Fe r, const Fe a, uint64_t mask) {
+  for (int i = 0; i < kNumLimbs; i++) r[i] ^= mask & (r[i] ^ a[i]);
+}
+
+bool fe_equal(const Fe a, const Fe b) {
+  uint64_t diff = 0;
+  for (int i = 0; i < kNumLimbs; i++) diff |= a[i] ^ b[i];
+  return diff == 0;
+}
+
+// Loads a value below 2^256, reducing it modulo p, into the Montgomery domain
+void fe_from_words(Fe r, const uint32_t* words) {
+  Fe t;
+  for (int i = 0; i < kNumLimbs; i++) t[i] = (uint64_t)words[2 * i] | ((uint64_t)words[2 * i + 1] << 32);
+  fe_reduce_once(t, t, 0);
+  fe_mul(r, t, kR2);
+}
+
+void fe_to_words(uint32_t* words, const Fe a) {
+  static constexpr Fe kOne = {1, 0, 0, 0};
+  Fe t;
+  fe_mul(t, a, kOne);
+  for (int i = 0; i < kNumLimbs; i++) {
+    words[2 * i] = (uint32_t)t[i];
+    words[2 * i + 1] = (uint32_t)(t[i] >> 32);
+  }
+}
+
+// Returns true if |words| is below p
+bool words_reduced(const uint32_t* words) {
+  uint64_t borrow = 0;
+  for (int i = 0; i < kNumLimbs; i++) {
+    uint64_t limb = (uint64_t)words[2 * i] | ((uint64_t)words[2 * i + 1] << 32);
+    sub_borrow(limb, kP[i], &borrow);
+  }
+  return borrow;
+}
+
+// r = a^(p - 2) = a^-1, or 0 if a is 0. The exponent is public, so the branches on its bits are safe.
+void fe_inv(Fe r, const Fe a) {
+  Fe e;
+  memcpy(e, kP, sizeof(Fe));
+  e[0] -= 2;
+
+  Fe acc;
+  fe_copy(acc, a);
+  for (int bit = 254; bit >= 0; bit--) {
+    fe_sqr(acc, acc);
+    if ((e[bit / 64] >> (bit % 64)) & 1) fe_mul(acc, acc, a);
+  }
+  fe_copy(r, acc);
+}
+
+struct Constants {
+  Fe b;
+  Fe one;
+};
+
+const Constants& constants() {
+  static const Constants* c = [] {
+    Constants* k = new Constants;
+    fe_from_words(k->b, kB);
+    static constexpr uint32_t kOneWords[kNumWords] = {1};
+    fe_from_words(k->one, kOneWords);
+    return k;
+  }();
+  return *c;
+}
+
+void point_set_infinity(ProjectivePoint* r) {
+  memset(r->x, 0, sizeof(Fe));
+  fe_copy(r->y, constants().one);
+  memset(r->z, 0, sizeof(Fe));
+}
+
+// r = p + q, complete addition for a = -3 (RCB 2016, algorithm 4). |r| may alias either input.
+void point_add(ProjectivePoint* r, const ProjectivePoint* p, const ProjectivePoint* q) {
+  const Fe& b = constants().b;
+  Fe t0, t1, t2, t3, t4, x3, y3, z3;
+
+  fe_mul(t0, p->x, q->x);
+  fe_mul(t1, p->y, q->y);
+  fe_mul(t2, p->z, q->z);
+  fe_add(t3, p->x, p->y);
+  fe_add(t4, q->x, q->y);
+  fe_mul(t3, t3, t4);
+  fe_add(t4, t0, t1);
+  fe_sub(t3, t3, t4);
+  fe_add(t4, p->y, p->z);
+  fe_add(x3, q->y, q->z);
+  fe_mul(t4, t4, x3);
+  fe_add(x3, t1, t2);
+  fe_sub(t4, t4, x3);
+  fe_add(x3, p->x, p->z);
+  fe_add(y3, q->x, q->z);
+  fe_mul(x3, x3, y3);
+  fe_add(y3, t0, t2);
+  fe_sub(y3, x3, y3);
+  fe_mul(z3, b, t2);
+  fe_sub(x3, y3, z3);
+  fe_add(z3, x3, x3);
+  fe_add(x3, x3, z3);
+  fe_sub(z3, t1, x3);
+  fe_add(x3, t1, x3);
+  fe_mul(y3, b, y3);
+  fe_add(t1, t2, t2);
+  fe_add(t2, t1, t2);
+  fe_sub(y3, y3, t2);
+  fe_sub(y3, y3, t0);
+  fe_add(t1, y3, y3);
+  fe_add(y3, t1, y3);
+  fe_add(t1, t0, t0);
+  fe_add(t0, t1, t0);
+  fe_sub(t0, t0, t2);
+  fe_mul(t1, t4, y3);
+  fe_mul(t2, t0, y3);
+  fe_mul(y3, x3, z3);
+  fe_add(y3, y3, t2);
+  fe_mul(x3, t3, x3);
+  fe_sub(x3, x3, t1);
+  fe_mul(z3, t4, z3);
+  fe_mul(t1, t3, t0);
+  fe_add(z3, z3, t1);
+
+  fe_copy(r->x, x3);
+  fe_copy(r->y, y3);
+  fe_copy(r->z, z3);
+}
+
+// r = p + q for an affine q, complete for a = -3 (RCB 2016, algorithm 5). |r| may alias |p|.
+void point_add_mixed(ProjectivePoint* r, const ProjectivePoint* p, const AffinePoint* q) {
+  const Fe& b = constants().b;
+  Fe t0, t1, t2, t3, t4, x3, y3, z3;
+
+  fe_mul(t0, p->x, q->x);
+  fe_mul(t1, p->y, q->y);
+  fe_add(t3, q->x, q->y);
+  fe_add(t4, p->x, p->y);
+  fe_mul(t3, t3, t4);
+  fe_add(t4, t0, t1);
+  fe_sub(t3, t3, t4);
+  fe_mul(t4, q->y, p->z);
+  fe_add(t4, t4, p->y);
+  fe_mul(y3, q->x, p->z);
+  fe_add(y3, y3, p->x);
+  fe_mul(z3, b, p->z);
+  fe_sub(x3, y3, z3);
+  fe_add(z3, x3, x3);
+  fe_add(x3, x3, z3);
+  fe_sub(z3, t1, x3);
+  fe_add(x3, t1, x3);
+  fe_mul(y3, b, y3);
+  fe_add(t1, p->z, p->z);
+  fe_add(t2, t1, p->z);
+  fe_sub(y3, y3, t2);
+  fe_sub(y3, y3, t0);
+  fe_add(t1, y3, y3);
+  fe_add(y3, t1, y3);
+  fe_add(t1, t0, t0);
+  fe_add(t0, t1, t0);
+  fe_sub(t0, t0, t2);
+  fe_mul(t1, t4, y3);
+  fe_mul(t2, t0, y3);
+  fe_mul(y3, x3, z3);
+  fe_add(y3, y3, t2);
+  fe_mul(x3, t3, x3);
+  fe_sub(x3, x3, t1);
+  fe_mul(z3, t4, z3);
+  fe_mul(t1, t3, t0);
+  fe_add(z3, z3, t1);
+
+  fe_copy(r->x, x3);
+  fe_copy(r->y, y3);
+  fe_copy(r->z, z3);
+}
+
+// r = 2p, complete doubling for a = -3 (RCB 2016, algorithm 6). |r| may alias |p|.
+void point_double(ProjectivePoint* r, const ProjectivePoint* p) {
+  const Fe& b = constants().b;
+  Fe t0, t1, t2, t3, x3, y3, z3;
+
+  fe_sqr(t0, p->x);
+  fe_sqr(t1, p->y);
+  fe_sqr(t2, p->z);
+  fe_mul(t3, p->x, p->y);
+  fe_add(t3, t3, t3);
+  fe_mul(z3, p->x, p->z);
+  fe_add(z3, z3, z3);
+  fe_mul(y3, b, t2);
+  fe_sub(y3, y3, z3);
+  fe_add(x3, y3, y3);
+  fe_add(y3, x3, y3);
+  fe_sub(x3, t1, y3);
+  fe_add(y3, t1, y3);
+  fe_mul(y3, x3, y3);
+  fe_mul(x3, x3, t3);
+  fe_add(t3, t2, t2);
+  fe_add(t2, t2, t3);
+  fe_mul(z3, b, z3);
+  fe_sub(z3, z3, t2);
+  fe_sub(z3, z3, t0);
+  fe_add(t3, z3, z3);
+  fe_add(z3, z3, t3);
+  fe_add(t3, t0, t0);
+  fe_add(t0, t3, t0);
+  fe_sub(t0, t0, t2);
+  fe_mul(t0, t0, z3);
+  fe_add(y3, y3, t0);
+  fe_mul(t0, p->y, p->z);
+  fe_add(t0, t0, t0);
+  fe_mul(z3, t0, z3);
+  fe_sub(x3, x3, z3);
+  fe_mul(z3, t0, t1);
+  fe_add(z3, z3, z3);
+  fe_add(z3, z3, z3);
+
+  fe_copy(r->x, x3);
+  fe_copy(r->y, y3);
+  fe_copy(r->z, z3);
+}
+
+void point_to_words(uint32_t* out_x, uint32_t* out_y, const ProjectivePoint* p) {
+  Fe z_inv, x, y;
+  fe_inv(z_inv, p->z);
+  fe_mul(x, p->x, z_inv);
+  fe_mul(y, p->y, z_inv);
+  fe_to_words(out_x, x);
+  fe_to_words(out_y, y);
+}
+
+// All ones if |a| equals |b|, zero otherwise, without branching on either
+inline uint64_t equal_mask(uint32_t a, uint32_t b) {
+  return 0 - (((uint64_t)(a ^ b) - 1) >> 63);
+}
+
+inline uint32_t scalar_window(const uint32_t* scalar, int window) {
+  int bit = window * kWindowBits;
+  return (scalar[bit / 32] >> (bit % 32)) & (kTableSize - 1);
+}
+
+// Multiples 1..15 of 16^i G for each window i, in the Montgomery domain
+struct BaseTable {
+  AffinePoint points[kNumWindows][kTableSize - 1];
+};
+
+const BaseTable& base_table() {
+  static const BaseTable* table = [] {
+    BaseTable* t = new BaseTable;
+    ProjectivePoint* multiples = new ProjectivePoint[kNumWindows * (kTableSize - 1)];
+
+    ProjectivePoint base;
+    fe_from_words(base.x, kGx);
+    fe_from_words(base.y, kGy);
+    fe_copy(base.z, constants().one);
+    for (int i = 0; i < kNumWindows; i++) {
+      ProjectivePoint* row = &multiples[i * (kTableSize - 1)];
+      row[0] = base;
+      for (int j = 1; j < kTableSize - 1; j++) point_add(&row[j], &row[j - 1], &base);
+      // 16 * base = 15 * base + base
+      point_add(&base, &row[kTableSize - 2], &base);
+    }
+
+    // Convert to affine with a single inversion. None of the multiples is infinity, as they are all below the order.
+    int count = kNumWindows * (kTableSize - 1);
+    Fe* prefix = new Fe[count];
+    fe_copy(prefix[0], multiples[0].z);
+    for (int i = 1; i < count; i++) fe_mul(prefix[i], prefix[i - 1], multiples[i].z);
+    Fe inv;
+    fe_inv(inv, prefix[count - 1]);
+    for (int i = count - 1; i >= 0; i--) {
+      Fe z_inv;
+      if (i > 0) {
+        fe_mul(z_inv, inv, prefix[i - 1]);
+        fe_mul(inv, inv, multiples[i].z);
+      } else {
+        fe_copy(z_inv, inv);
+      }
+      AffinePoint& out = t->points[i / (kTableSize - 1)][i % (kTableSize - 1)];
+      fe_mul(out.x, multiples[i].x, z_inv);
+      fe_mul(out.y, multiples[i].y, z_inv);
+    }
+
+    delete[] prefix;
+    delete[] multiples;
+    return t;
+  }();
+  return *table;
+}
+
+bool is_base_point(const uint32_t* x, const uint32_t* y) {
+  return memcmp(x, kGx, sizeof(kGx)) == 0 && memcmp(y, kGy, sizeof(kGy)) == 0;
+}
+
+}  // namespace
+
+void BasePointMult(uint32_t* out_x, uint32_t* out_y, const uint32_t* scalar) {
+  const BaseTable& table = base_table();
+  ProjectivePoint acc;
+  point_set_infinity(&acc);
+
+  for (int i = 0; i < kNumWindows; i++) {
+    uint32_t digit = scalar_window(scalar, i);
+
+    // Entry digit - 1, read by touching all of them. A zero digit selects nothing and the sum is dropped below.
+    AffinePoint selected;
+    memset(&selected, 0, sizeof(selected));
+    for (uint32_t j = 1; j < kTableSize; j++) {
+      uint64_t mask = equal_mask(j, digit);
+      fe_cmov(selected.x, table.points[i][j - 1].x, mask);
+      fe_cmov(selected.y, table.points[i][j - 1].y, mask);
+    }
+
+    ProjectivePoint sum;
+    point_add_mixed(&sum, &acc, &selected);
+    uint64_t keep = equal_mask(digit, 0);
+    fe_cmov(sum.x, acc.x, keep);
+    fe_cmov(sum.y, acc.y, keep);
+    fe_cmov(sum.z, acc.z, keep);
+    acc = sum;
+  }
+
+  point_to_words(out_x, out_y, &acc);
+}
+
+void PointMult(uint32_t* out_x, uint32_t* out_y, const uint32_t* x, const uint32_t* y, const uint32_t* scalar) {
+  // The point is public, only the scalar is secret
+  if (is_base_point(x, y)) {
+    BasePointMult(out_x, out_y, scalar);
+    return;
+  }
+
+  // table[i] = i * P
+  ProjectivePoint table[kTableSize];
+  point_set_infinity(&table[0]);
+  fe_from_words(table[1].x, x);
+  fe_from_words(table[1].y, y);
+  fe_copy(table[1].z, constants().one);
+  for (int i = 2; i < kTableSize; i += 2) {
+    point_double(&table[i], &table[i / 2]);
+    point_add(&table[i + 1], &table[i], &table[1]);
+  }
+
+  ProjectivePoint acc;
+  point_set_infinity(&acc);
+  for (int i = kNumWindows - 1; i >= 0; i--) {
+    for (int j = 0; j < kWindowBits; j++) point_double(&acc, &acc);
+
+    uint32_t digit = scalar_window(scalar, i);
+    ProjectivePoint selected;
+    memset(&selected, 0, sizeof(selected));
+    for (uint32_t j = 0; j < kTableSize; j++) {
+      uint64_t mask = equal_mask(j, digit);
+      fe_cmov(selected.x, table[j].x, mask);
+      fe_cmov(selected.y, table[j].y, mask);
+      fe_cmov(selected.z, table[j].z, mask);
+    }
+    point_add(&acc, &acc, &selected);
+  }
+
+  point_to_words(out_x, out_y, &acc);
+}
+
+bool IsOnCurve(const uint32_t* x, const uint32_t* y) {
+  if (!words_reduced(x) || !words_reduced(y)) return false;
+
+  // y^2 = x^3 - 3x + b
+  Fe fx, fy, lhs, rhs, t;
+  fe_from_words(fx, x);
+  fe_from_words(fy, y);
+  fe_sqr(lhs, fy);
+
+  fe_sqr(rhs, fx);
+  fe_mul(rhs, rhs, fx);
+  fe_add(t, fx, fx);
+  fe_add(t, t, fx);
+  fe_sub(rhs, rhs, t);
+  fe_add(rhs, rhs, constants().b);
+
+  return fe_equal(lhs, rhs);
+}
+
+}  // namespace p256
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
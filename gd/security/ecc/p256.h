@@ -0,0 +1,52 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// P-256 arithmetic behind ECC_PointMult_Bin_NAF() and ECC_ValidatePoint(), in both the legacy stack (stack/smp) and gd
+// (security/ecc).
+//
+// Field elements use 64-bit limbs in the Montgomery domain, and points use projective coordinates with the complete
+// formulas of Renes, Costello and Batina (2016), so there are no special cases. Scalar multiplication walks fixed 4-bit
+// windows, with table lookups that touch every entry; the time taken does not depend on the scalar. Multiples of the
+// base point use a precomputed table and need no doublings.
+//
+// This file must not depend on either stack. Coordinates and scalars are 256 bit integers stored as 8 32-bit words,
+// least significant word first, as in the Point structures of both stacks.
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+namespace p256 {
+
+constexpr int kNumWords = 8;
+
+// Set (|out_x|, |out_y|) to |scalar| * (|x|, |y|). (|x|, |y|) must be on the curve, see IsOnCurve(). The result is
+// (0, 0) if it is the point at infinity.
+void PointMult(uint32_t* out_x, uint32_t* out_y, const uint32_t* x, const uint32_t* y, const uint32_t* scalar);
+
+// Set (|out_x|, |out_y|) to |scalar| * G
+void BasePointMult(uint32_t* out_x, uint32_t* out_y, const uint32_t* scalar);
+
+// Returns true if both coordinates are reduced modulo p and (|x|, |y|) is on the curve
+bool IsOnCurve(const uint32_t* x, const uint32_t* y);
+
+}  // namespace p256
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
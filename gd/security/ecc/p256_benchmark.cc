@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include <cstring>
+
+#include "security/ecc/p_256_ecc_pp.h"
+
+using ::benchmark::State;
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+namespace {
+
+// Debug private key, BT Spec 5.1 Vol 3, Part H 2.3.5.6.1
+constexpr uint32_t kPrivateKey[KEY_LENGTH_DWORDS_P256] = {0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b,
+                                                          0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+
+// Debug public key, the peer of a device using the debug keys
+Point MakePeerPublicKey() {
+  Point p = {.x = {0x0e359de6, 0xcc030148, 0xacf4fddb, 0xeff49111, 0xe9f9a5b9, 0x5e2c83a7, 0xf297be2c, 0x20b003d2},
+             .y = {0x1589d28b, 0x741c8ed0, 0x8fed3024, 0x766345c2, 0x5a52155c, 0x63329abf, 0x652aeb6d, 0xdc809c49},
+             .z = {1}};
+  return p;
+}
+
+// Key pair generation, the private key times the base point
+void BM_P256GeneratePublicKey(State& state) {
+  for (auto _ : state) {
+    Point public_key;
+    uint32_t private_key[KEY_LENGTH_DWORDS_P256];
+    memcpy(private_key, kPrivateKey, sizeof(private_key));
+    ECC_PointMult(&public_key, &curve_p256.G, private_key);
+    benchmark::DoNotOptimize(public_key);
+  }
+}
+BENCHMARK(BM_P256GeneratePublicKey);
+
+// DHKey computation, the private key times the peer public key
+void BM_P256ComputeDhKey(State& state) {
+  Point peer = MakePeerPublicKey();
+  for (auto _ : state) {
+    Point dhkey;
+    uint32_t private_key[KEY_LENGTH_DWORDS_P256];
+    memcpy(private_key, kPrivateKey, sizeof(private_key));
+    ECC_PointMult(&dhkey, &peer, private_key);
+    benchmark::DoNotOptimize(dhkey);
+  }
+}
+BENCHMARK(BM_P256ComputeDhKey);
+
+void BM_P256ValidatePoint(State& state) {
+  Point peer = MakePeerPublicKey();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ECC_ValidatePoint(peer));
+  }
+}
+BENCHMARK(BM_P256ValidatePoint);
+
+}  // namespace
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
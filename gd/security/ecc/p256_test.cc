@@ -0,0 +1,156 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "security/ecc/p256.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+
+namespace bluetooth {
+namespace security {
+namespace ecc {
+namespace p256 {
+namespace {
+
+using Words = std::array<uint32_t, kNumWords>;
+
+constexpr Words kGx = {0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81, 0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2};
+constexpr Words kGy = {0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357, 0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2};
+constexpr Words kZero = {0};
+
+// P-256 sample data, BT Spec 5.1 Vol 2, Part G 7.1.2
+constexpr Words kPrivateKeyA = {0xcd3c1abd, 0x5899b8a6, 0xeb40b799, 0x4aff607b,
+                                0xd2103f50, 0x74c9b3e3, 0xa3c55f38, 0x3f49f6d4};
+constexpr Words kPublicKeyAx = {0x0e359de6, 0xcc030148, 0xacf4fddb, 0xeff49111,
+                                0xe9f9a5b9, 0x5e2c83a7, 0xf297be2c, 0x20b003d2};
+constexpr Words kPublicKeyAy = {0x1589d28b, 0x741c8ed0, 0x8fed3024, 0x766345c2,
+                                0x5a52155c, 0x63329abf, 0x652aeb6d, 0xdc809c49};
+constexpr Words kPrivateKeyB = {0xf47fc5fd, 0x6b4fdd49, 0xf19d7cfb, 0x59cb9ac2,
+                                0xeed4e72a, 0x900afcfb, 0x32f6bb9a, 0x55188b3d};
+constexpr Words kPublicKeyBx = {0x2faaa190, 0x559077b2, 0x8615a69f, 0x47b58afd,
+                                0xf19e4c00, 0x09592284, 0x1faf1d96, 0x1ea1f0f0};
+constexpr Words kPublicKeyBy = {0x15b1214a, 0x5f89aff9, 0xe28e3676, 0x472d1130,
+                                0x9ab85160, 0x7356703a, 0x429dad37, 0x4c55f33e};
+constexpr Words kDhKey = {0x73bfa698, 0x868d34f3, 0xb4f866f1, 0x99796b13, 0x0a397d9b, 0x341010a6, 0x57c8ad05, 0xec0234a3};
+
+struct Affine {
+  Words x;
+  Words y;
+};
+
+Affine Mult(const Words& x, const Words& y, const Words& scalar) {
+  Affine r;
+  PointMult(r.x.data(), r.y.data(), x.data(), y.data(), scalar.data());
+  return r;
+}
+
+Affine BaseMult(const Words& scalar) {
+  Affine r;
+  BasePointMult(r.x.data(), r.y.data(), scalar.data());
+  return r;
+}
+
+}  // namespace
+
+TEST(P256Test, sample_data_public_keys) {
+  Affine a = BaseMult(kPrivateKeyA);
+  EXPECT_EQ(kPublicKeyAx, a.x);
+  EXPECT_EQ(kPublicKeyAy, a.y);
+
+  Affine b = BaseMult(kPrivateKeyB);
+  EXPECT_EQ(kPublicKeyBx, b.x);
+  EXPECT_EQ(kPublicKeyBy, b.y);
+}
+
+TEST(P256Test, sample_data_dhkey) {
+  EXPECT_EQ(kDhKey, Mult(kPublicKeyBx, kPublicKeyBy, kPrivateKeyA).x);
+  EXPECT_EQ(kDhKey, Mult(kPublicKeyAx, kPublicKeyAy, kPrivateKeyB).x);
+}
+
+TEST(P256Test, base_point_given_as_point_uses_same_result) {
+  Affine by_table = BaseMult(kPrivateKeyA);
+  Affine by_point = Mult(kGx, kGy, kPrivateKeyA);
+  EXPECT_EQ(by_table.x, by_point.x);
+  EXPECT_EQ(by_table.y, by_point.y);
+}
+
+TEST(P256Test, small_scalars) {
+  Words one = {1};
+  Affine g = BaseMult(one);
+  EXPECT_EQ(kGx, g.x);
+  EXPECT_EQ(kGy, g.y);
+
+  // 2G
+  Words two = {2};
+  Affine g2 = BaseMult(two);
+  EXPECT_EQ(Words({0x47669978, 0xa60b48fc, 0x77f21b35, 0xc08969e2, 0x04b51ac3, 0x8a523803, 0x8d034f7e, 0x7cf27b18}),
+            g2.x);
+  EXPECT_EQ(Words({0x227873d1, 0x9e04b79d, 0x3ce98229, 0xba7dade6, 0x9f7430db, 0x293d9ac6, 0xdb8ed040, 0x07775510}),
+            g2.y);
+
+  // 2 * A, from a point other than the base point, is (2 * a) * G
+  Affine a2 = Mult(kPublicKeyAx, kPublicKeyAy, two);
+  Affine a2_from_base =
+      BaseMult({0x9a78357a, 0xb133714d, 0xd6816f32, 0x95fec0f7, 0xa4207ea0, 0xe99367c7, 0x478abe70, 0x7e93eda9});
+  EXPECT_EQ(a2_from_base.x, a2.x);
+  EXPECT_EQ(a2_from_base.y, a2.y);
+}
+
+TEST(P256Test, scalars_around_the_order) {
+  // n - 1 gives -G = (Gx, p - Gy)
+  Words order_minus_one = {0xfc632550, 0xf3b9cac2, 0xa7179e84, 0xbce6faad, 0xffffffff, 0xffffffff, 0x00000000, 0xffffffff};
+  Affine minus_g = BaseMult(order_minus_one);
+  EXPECT_EQ(kGx, minus_g.x);
+  EXPECT_EQ(Words({0xc840ae0a, 0x3449bf97, 0x94cea131, 0xd431cca9, 0x83f061e9, 0x711814b5, 0x01e58065, 0xb01cbd1c}),
+            minus_g.y);
+
+  // n and 0 give the point at infinity, reported as (0, 0)
+  Words order = order_minus_one;
+  order[0]++;
+  Affine infinity = BaseMult(order);
+  EXPECT_EQ(kZero, infinity.x);
+  EXPECT_EQ(kZero, infinity.y);
+  infinity = Mult(kPublicKeyAx, kPublicKeyAy, kZero);
+  EXPECT_EQ(kZero, infinity.x);
+  EXPECT_EQ(kZero, infinity.y);
+
+  // n + 1 wraps around to G
+  Words order_plus_one = order;
+  order_plus_one[0]++;
+  Affine g = Mult(kPublicKeyAx, kPublicKeyAy, order_plus_one);
+  EXPECT_EQ(kPublicKeyAx, g.x);
+  EXPECT_EQ(kPublicKeyAy, g.y);
+}
+
+TEST(P256Test, is_on_curve) {
+  EXPECT_TRUE(IsOnCurve(kGx.data(), kGy.data()));
+  EXPECT_TRUE(IsOnCurve(kPublicKeyAx.data(), kPublicKeyAy.data()));
+  EXPECT_FALSE(IsOnCurve(kZero.data(), kZero.data()));
+
+  Words y = kGy;
+  y[0]++;
+  EXPECT_FALSE(IsOnCurve(kGx.data(), y.data()));
+
+  // Coordinates must be reduced
+  Words p = {0xffffffff, 0xffffffff, 0xffffffff, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xffffffff};
+  EXPECT_FALSE(IsOnCurve(p.data(), kGy.data()));
+}
+
+}  // namespace p256
+}  // namespace ecc
+}  // namespace security
+}  // namespace bluetooth
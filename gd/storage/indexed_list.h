@@ -0,0 +1,243 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bluetooth {
+namespace storage {
+
+// A std::list that also indexes its elements by the string member |Key|, so that the sections and keys of a config
+// keep their insertion order for serialization while being found in constant time. Shared by osi/include/config.h
+// and storage/legacy_osi_config.h, whose config_t must have the same layout.
+//
+// The key of an element must not be changed while it is in the list, though it may be moved out right before the
+// element is erased. When several elements have the same key, find() returns the first one.
+template <typename T, std::string T::*Key>
+class IndexedList {
+ public:
+  using value_type = T;
+  using iterator = typename std::list<T>::iterator;
+  using const_iterator = typename std::list<T>::const_iterator;
+
+  IndexedList() = default;
+  IndexedList(const IndexedList& other) : list_(other.list_) {
+    Reindex();
+  }
+  // Moving a std::list keeps its nodes, so the index stays valid
+  IndexedList(IndexedList&& other) noexcept
+      : list_(std::move(other.list_)), slots_(std::move(other.slots_)), num_indexed_(other.num_indexed_) {
+    other.clear();
+  }
+  IndexedList& operator=(const IndexedList& other) {
+    if (this != &other) {
+      list_ = other.list_;
+      Reindex();
+    }
+    return *this;
+  }
+  IndexedList& operator=(IndexedList&& other) noexcept {
+    if (this != &other) {
+      list_ = std::move(other.list_);
+      slots_ = std::move(other.slots_);
+      num_indexed_ = other.num_indexed_;
+      other.clear();
+    }
+    return *this;
+  }
+
+  iterator begin() {
+    return list_.begin();
+  }
+  iterator end() {
+    return list_.end();
+  }
+  const_iterator begin() const {
+    return list_.begin();
+  }
+  const_iterator end() const {
+    return list_.end();
+  }
+  bool empty() const {
+    return list_.empty();
+  }
+  size_t size() const {
+    return list_.size();
+  }
+  T& front() {
+    return list_.front();
+  }
+  T& back() {
+    return list_.back();
+  }
+
+  iterator find(const std::string& key) {
+    size_t slot = FindSlot(key, std::hash<std::string>{}(key));
+    return slot == kNoSlot ? list_.end() : slots_[slot].element;
+  }
+  const_iterator find(const std::string& key) const {
+    size_t slot = FindSlot(key, std::hash<std::string>{}(key));
+    return slot == kNoSlot ? list_.end() : const_iterator(slots_[slot].element);
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    list_.emplace_back(std::forward<Args>(args)...);
+    AddToIndex(std::prev(list_.end()));
+    return list_.back();
+  }
+  void push_back(const T& value) {
+    emplace_back(value);
+  }
+  void push_back(T&& value) {
+    emplace_back(std::move(value));
+  }
+
+  iterator erase(const_iterator pos) {
+    const std::string& key = (*pos).*Key;
+    size_t hash = std::hash<std::string>{}(key);
+    size_t slot = FindSlot(key, hash);
+    if (slot == kNoSlot || slots_[slot].element != pos) {
+      // Either another element with the same key is the indexed one, or the key of the element was moved out before
+      // erasing it
+      slot = kNoSlot;
+      for (size_t i = 0; i < slots_.size(); i++) {
+        if (slots_[i].used && slots_[i].element == pos) {
+          slot = i;
+          break;
+        }
+      }
+    }
+    if (slot != kNoSlot) {
+      hash = slots_[slot].hash;
+      RemoveSlot(slot);
+      // Only look for another element with the same key if there are duplicates at all
+      if (list_.size() - 1 > num_indexed_) {
+        for (auto other = list_.begin(); other != list_.end(); ++other) {
+          if (other != pos && std::hash<std::string>{}((*other).*Key) == hash &&
+              FindSlot((*other).*Key, hash) == kNoSlot) {
+            InsertSlot(other, hash);
+            break;
+          }
+        }
+      }
+    }
+    return list_.erase(pos);
+  }
+
+  void clear() {
+    slots_.clear();
+    num_indexed_ = 0;
+    list_.clear();
+  }
+
+ private:
+  // The index is a hash table with open addressing and linear probing, kept at most half full. It needs a single
+  // allocation, which keeps copying a config cheap.
+  struct Slot {
+    iterator element;
+    size_t hash = 0;
+    bool used = false;
+  };
+  static constexpr size_t kNoSlot = static_cast<size_t>(-1);
+  static constexpr size_t kMinSlots = 8;
+
+  size_t FindSlot(const std::string& key, size_t hash) const {
+    if (slots_.empty()) {
+      return kNoSlot;
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask; slots_[i].used; i = (i + 1) & mask) {
+      if (slots_[i].hash == hash && (*slots_[i].element).*Key == key) {
+        return i;
+      }
+    }
+    return kNoSlot;
+  }
+
+  void InsertSlot(iterator it, size_t hash) {
+    if (2 * (num_indexed_ + 1) > slots_.size()) {
+      Rehash(std::max(kMinSlots, 2 * slots_.size()));
+    }
+    const size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i].used) {
+      i = (i + 1) & mask;
+    }
+    slots_[i] = Slot{it, hash, true};
+    num_indexed_++;
+  }
+
+  // Shifts the following slots of the probe sequence back, so that lookups need no tombstones
+  void RemoveSlot(size_t i) {
+    const size_t mask = slots_.size() - 1;
+    for (size_t j = (i + 1) & mask; slots_[j].used; j = (j + 1) & mask) {
+      size_t home = slots_[j].hash & mask;
+      bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+      if (!stays) {
+        slots_[i] = slots_[j];
+        i = j;
+      }
+    }
+    slots_[i].used = false;
+    num_indexed_--;
+  }
+
+  void Rehash(size_t num_slots) {
+    std::vector<Slot> old_slots = std::move(slots_);
+    slots_.assign(num_slots, Slot{});
+    num_indexed_ = 0;
+    for (const Slot& slot : old_slots) {
+      if (slot.used) {
+        InsertSlot(slot.element, slot.hash);
+      }
+    }
+  }
+
+  void AddToIndex(iterator it) {
+    size_t hash = std::hash<std::string>{}((*it).*Key);
+    // Keep the first of several elements with the same key
+    if (FindSlot((*it).*Key, hash) == kNoSlot) {
+      InsertSlot(it, hash);
+    }
+  }
+
+  void Reindex() {
+    slots_.clear();
+    num_indexed_ = 0;
+    size_t num_slots = kMinSlots;
+    while (num_slots < 2 * list_.size()) {
+      num_slots *= 2;
+    }
+    slots_.assign(num_slots, Slot{});
+    for (auto it = list_.begin(); it != list_.end(); ++it) {
+      AddToIndex(it);
+    }
+  }
+
+  std::list<T> list_;
+  std::vector<Slot> slots_;
+  size_t num_indexed_ = 0;
+};
+
+}  // namespace storage
+}  // namespace bluetooth
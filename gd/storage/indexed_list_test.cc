@@ -0,0 +1,147 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "storage/indexed_list.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace bluetooth {
+namespace storage {
+namespace {
+
+struct Item {
+  std::string name;
+  int value;
+};
+
+using ItemList = IndexedList<Item, &Item::name>;
+
+std::vector<std::string> Names(const ItemList& items) {
+  std::vector<std::string> names;
+  for (const auto& item : items) {
+    names.push_back(item.name);
+  }
+  return names;
+}
+
+TEST(IndexedListTest, find_keeps_insertion_order) {
+  ItemList items;
+  items.emplace_back(Item{"c", 1});
+  items.emplace_back(Item{"a", 2});
+  items.push_back(Item{"b", 3});
+  EXPECT_EQ(Names(items), std::vector<std::string>({"c", "a", "b"}));
+  ASSERT_NE(items.find("a"), items.end());
+  EXPECT_EQ(items.find("a")->value, 2);
+  EXPECT_EQ(items.find("d"), items.end());
+}
+
+TEST(IndexedListTest, erase) {
+  ItemList items;
+  items.emplace_back(Item{"a", 1});
+  items.emplace_back(Item{"b", 2});
+  items.emplace_back(Item{"c", 3});
+  auto next = items.erase(items.find("b"));
+  EXPECT_EQ(next->name, "c");
+  EXPECT_EQ(items.find("b"), items.end());
+  EXPECT_EQ(items.find("c")->value, 3);
+  EXPECT_EQ(Names(items), std::vector<std::string>({"a", "c"}));
+  items.clear();
+  EXPECT_TRUE(items.empty());
+  EXPECT_EQ(items.find("a"), items.end());
+}
+
+TEST(IndexedListTest, erase_after_key_moved_out) {
+  ItemList items;
+  items.emplace_back(Item{"a", 1});
+  items.emplace_back(Item{"b", 2});
+  auto b = items.find("b");
+  Item moved = std::move(*b);
+  items.erase(b);
+  EXPECT_EQ(moved.name, "b");
+  EXPECT_EQ(items.find("b"), items.end());
+  EXPECT_EQ(items.size(), 1u);
+  items.emplace_back(std::move(moved));
+  EXPECT_EQ(items.find("b")->value, 2);
+}
+
+TEST(IndexedListTest, duplicate_keys) {
+  ItemList items;
+  items.emplace_back(Item{"a", 1});
+  items.emplace_back(Item{"a", 2});
+  EXPECT_EQ(items.find("a")->value, 1);
+  items.erase(items.find("a"));
+  ASSERT_NE(items.find("a"), items.end());
+  EXPECT_EQ(items.find("a")->value, 2);
+  items.erase(items.find("a"));
+  EXPECT_EQ(items.find("a"), items.end());
+}
+
+TEST(IndexedListTest, copy_has_its_own_index) {
+  ItemList items;
+  items.emplace_back(Item{"a", 1});
+  ItemList copy = items;
+  copy.find("a")->value = 2;
+  EXPECT_EQ(items.find("a")->value, 1);
+  EXPECT_EQ(copy.find("a")->value, 2);
+  items = copy;
+  EXPECT_EQ(items.find("a")->value, 2);
+}
+
+TEST(IndexedListTest, move_keeps_index) {
+  ItemList items;
+  items.emplace_back(Item{"a", 1});
+  ItemList moved = std::move(items);
+  EXPECT_EQ(moved.find("a")->value, 1);
+  EXPECT_EQ(items.find("a"), items.end());
+  items = std::move(moved);
+  EXPECT_EQ(items.find("a")->value, 1);
+  items.erase(items.find("a"));
+  EXPECT_TRUE(items.empty());
+}
+
+TEST(IndexedListTest, matches_linear_search_after_many_changes) {
+  ItemList items;
+  std::vector<std::string> reference;
+  uint32_t seed = 1;
+  for (int step = 0; step < 10000; step++) {
+    seed = seed * 1103515245 + 12345;
+    std::string name = std::to_string((seed >> 16) % 300);
+    auto it = items.find(name);
+    auto expected = std::find(reference.begin(), reference.end(), name);
+    ASSERT_EQ(it == items.end(), expected == reference.end()) << name;
+    if (it == items.end()) {
+      items.emplace_back(Item{name, step});
+      reference.push_back(name);
+    } else {
+      EXPECT_EQ(it->name, name);
+      items.erase(it);
+      reference.erase(expected);
+    }
+  }
+  EXPECT_EQ(Names(items), reference);
+  ItemList copy = items;
+  for (const auto& name : reference) {
+    ASSERT_NE(copy.find(name), copy.end());
+    EXPECT_EQ(copy.find(name)->name, name);
+  }
+}
+
+}  // namespace
+}  // namespace storage
+}  // namespace bluetooth
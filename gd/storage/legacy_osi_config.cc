@@ -26,22 +26,14 @@ namespace {
 
 bool config_parse(FILE* fp, config_t* config);
 
-template <typename T,
-          class = typename std::enable_if<std::is_same<config_t, typename std::remove_const<T>::type>::value>>
-auto section_find(T& config, const std::string& section) {
-  return std::find_if(config.sections.begin(), config.sections.end(),
-                      [&section](const section_t& sec) { return sec.name == section; });
-}
-
 const entry_t* entry_find(const config_t& config, const std::string& section, const std::string& key) {
-  auto sec = section_find(config, section);
+  auto sec = config.sections.find(section);
   if (sec == config.sections.end()) return nullptr;
 
-  for (const entry_t& entry : sec->entries) {
-    if (entry.key == key) return &entry;
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return nullptr;
 
-  return nullptr;
+  return &*entry;
 }
 
 char* trim(char* str) {
@@ -145,7 +137,7 @@ std::unique_ptr<config_t> bluetooth::legacy::osi::config::config_new_clone(const
 }
 
 bool bluetooth::legacy::osi::config::config_has_section(const config_t& config, const std::string& section) {
-  return (section_find(config, section) != config.sections.end());
+  return (config.sections.find(section) != config.sections.end());
 }
 
 bool bluetooth::legacy::osi::config::config_has_key(const config_t& config, const std::string& section,
@@ -212,7 +204,7 @@ void bluetooth::legacy::osi::config::config_set_string(config_t* config, const s
                                                        const std::string& key, const std::string& value) {
   CHECK(config);
 
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.find(section);
   if (sec == config->sections.end()) {
     config->sections.emplace_back(section_t{.name = section});
     sec = std::prev(config->sections.end());
@@ -227,11 +219,10 @@ void bluetooth::legacy::osi::config::config_set_string(config_t* config, const s
     value_no_newline = value;
   }
 
-  for (entry_t& entry : sec->entries) {
-    if (entry.key == key) {
-      entry.value = value_no_newline;
-      return;
-    }
+  auto entry = sec->entries.find(key);
+  if (entry != sec->entries.end()) {
+    entry->value = value_no_newline;
+    return;
   }
 
   sec->entries.emplace_back(entry_t{.key = key, .value = value_no_newline});
@@ -240,7 +231,7 @@ void bluetooth::legacy::osi::config::config_set_string(config_t* config, const s
 bool bluetooth::legacy::osi::config::config_remove_section(config_t* config, const std::string& section) {
   CHECK(config);
 
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.find(section);
   if (sec == config->sections.end()) return false;
 
   config->sections.erase(sec);
@@ -250,17 +241,14 @@ bool bluetooth::legacy::osi::config::config_remove_section(config_t* config, con
 bool bluetooth::legacy::osi::config::config_remove_key(config_t* config, const std::string& section,
                                                        const std::string& key) {
   CHECK(config);
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.find(section);
   if (sec == config->sections.end()) return false;
 
-  for (auto entry = sec->entries.begin(); entry != sec->entries.end(); ++entry) {
-    if (entry->key == key) {
-      sec->entries.erase(entry);
-      return true;
-    }
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return false;
 
-  return false;
+  sec->entries.erase(entry);
+  return true;
 }
 
 bool bluetooth::legacy::osi::config::config_save(const config_t& config, const std::string& filename) {
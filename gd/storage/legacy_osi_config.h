@@ -21,6 +21,8 @@
 #include <memory>
 #include <string>
 
+#include "storage/indexed_list.h"
+
 #ifndef CONFIG_DEFAULT_SECTION
 
 // The default section name to use if a key/value pair is not defined within
@@ -34,11 +36,11 @@ struct entry_t {
 
 struct section_t {
   std::string name;
-  std::list<entry_t> entries;
+  bluetooth::storage::IndexedList<entry_t, &entry_t::key> entries;
 };
 
 struct config_t {
-  std::list<section_t> sections;
+  bluetooth::storage::IndexedList<section_t, &section_t::name> sections;
 };
 
 #endif /* CONFIG_DEFAULT_SECTION */
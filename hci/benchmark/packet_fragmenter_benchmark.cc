@@ -0,0 +1,153 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "bt_types.h"
+#include "buffer_allocator.h"
+#include "hci_internals.h"
+#include "packet_fragmenter.h"
+
+using ::benchmark::State;
+
+// Payload of each L2CAP PDU and the ACL data length it is fragmented into,
+// as with a LE link using Data Length Extension.
+#define L2CAP_PDU_PAYLOAD_SIZE 1021
+#define ACL_DATA_SIZE 251
+#define L2CAP_HEADER_SIZE 4
+#define NUM_PDUS_PER_HANDLE 64
+
+namespace {
+
+struct Counters {
+  uint64_t allocations;
+  uint64_t copied_bytes;
+  uint64_t pdus;
+};
+
+Counters g_counters;
+std::vector<BT_HDR*> g_start_fragments;
+
+void* counting_alloc(size_t size) {
+  g_counters.allocations++;
+  return buffer_allocator_get_interface()->alloc(size);
+}
+
+void counting_free(void* ptr) { buffer_allocator_get_interface()->free(ptr); }
+
+const allocator_t counting_allocator = {counting_alloc, counting_free};
+
+// Reassembly is counted as copying the whole PDU unless it was completed in
+// the start fragment's own buffer.
+void on_reassembled(BT_HDR* packet) {
+  g_counters.pdus++;
+  bool in_place =
+      std::find(g_start_fragments.begin(), g_start_fragments.end(), packet) !=
+      g_start_fragments.end();
+  g_counters.copied_bytes +=
+      in_place ? packet->len - (HCI_ACL_PREAMBLE_SIZE + ACL_DATA_SIZE)
+               : packet->len;
+  buffer_allocator_get_interface()->free(packet);
+}
+
+void on_fragmented(BT_HDR* packet, bool send_transmit_finished) {}
+
+void on_transmit_finished(BT_HDR* packet, bool all_fragments_sent) {}
+
+const packet_fragmenter_callbacks_t callbacks = {
+    .fragmented = on_fragmented,
+    .reassembled = on_reassembled,
+    .transmit_finished = on_transmit_finished,
+};
+
+BT_HDR* make_fragment(uint16_t handle, bool start, const uint8_t* data,
+                      uint16_t length, size_t capacity) {
+  uint16_t packet_length = HCI_ACL_PREAMBLE_SIZE + length;
+  BT_HDR* packet = static_cast<BT_HDR*>(buffer_allocator_get_interface()->alloc(
+      std::max<size_t>(capacity, packet_length + sizeof(BT_HDR))));
+  packet->event = MSG_HC_TO_STACK_HCI_ACL;
+  packet->len = packet_length;
+  packet->offset = 0;
+  packet->layer_specific = 0;
+  uint8_t* stream = packet->data;
+  UINT16_TO_STREAM(stream, handle | (start ? 0x2000 : 0x1000));
+  UINT16_TO_STREAM(stream, length);
+  memcpy(stream, data, length);
+  return packet;
+}
+
+}  // namespace
+
+// Needed for linkage
+const controller_t* controller_get_interface() { return nullptr; }
+
+// Replays L2CAP PDUs split into ACL fragments, interleaved round-robin across
+// state.range(0) handles, through the packet fragmenter. state.range(1)
+// selects whether start fragments arrive in buffers sized for the fragment
+// (0) or for the whole PDU (1), which lets reassembly complete in place.
+static void BM_PacketFragmenterReassembly(State& state) {
+  int num_handles = state.range(0);
+  bool sized_for_pdu = state.range(1) != 0;
+  const packet_fragmenter_t* fragmenter =
+      packet_fragmenter_get_test_interface(nullptr, &counting_allocator);
+  fragmenter->init(&callbacks);
+
+  std::vector<uint8_t> pdu(L2CAP_HEADER_SIZE + L2CAP_PDU_PAYLOAD_SIZE);
+  uint8_t* stream = pdu.data();
+  UINT16_TO_STREAM(stream, L2CAP_PDU_PAYLOAD_SIZE);
+  UINT16_TO_STREAM(stream, 0x0040);
+  for (size_t i = L2CAP_HEADER_SIZE; i < pdu.size(); i++) pdu[i] = i;
+  size_t pdu_capacity = sizeof(BT_HDR) + HCI_ACL_PREAMBLE_SIZE + pdu.size();
+
+  g_counters = {};
+  for (auto _ : state) {
+    for (int n = 0; n < NUM_PDUS_PER_HANDLE; n++) {
+      g_start_fragments.clear();
+      for (size_t offset = 0; offset < pdu.size(); offset += ACL_DATA_SIZE) {
+        uint16_t length =
+            std::min<size_t>(ACL_DATA_SIZE, pdu.size() - offset);
+        for (int h = 0; h < num_handles; h++) {
+          bool start = offset == 0;
+          BT_HDR* fragment =
+              make_fragment(h + 1, start, pdu.data() + offset, length,
+                            start && sized_for_pdu ? pdu_capacity : 0);
+          if (start) g_start_fragments.push_back(fragment);
+          fragmenter->reassemble_and_dispatch(fragment);
+        }
+      }
+    }
+  }
+
+  fragmenter->cleanup();
+  state.SetItemsProcessed(g_counters.pdus);
+  state.counters["allocations_per_pdu"] =
+      static_cast<double>(g_counters.allocations) / g_counters.pdus;
+  state.counters["copied_bytes_per_pdu"] =
+      static_cast<double>(g_counters.copied_bytes) / g_counters.pdus;
+}
+
+BENCHMARK(BM_PacketFragmenterReassembly)
+    ->Args({1, 0})
+    ->Args({1, 1})
+    ->Args({4, 0})
+    ->Args({4, 1})
+    ->Args({8, 0})
+    ->Args({8, 1});
+
+BENCHMARK_MAIN();
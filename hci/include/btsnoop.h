@@ -54,3 +54,6 @@ typedef struct btsnoop_t {
 } btsnoop_t;
 
 const btsnoop_t* btsnoop_get_interface(void);
+
+// Writes the snoop writer's queue and drop counters to |fd| for dumpsys.
+void btsnoop_debug_dump(int fd);
@@ -21,3 +21,7 @@
 #include "osi/include/allocator.h"
 
 const allocator_t* buffer_allocator_get_interface();
+
+// Dump hit, miss and high-water statistics of the HCI buffer pool to the |fd|
+// file descriptor.
+void buffer_allocator_debug_dump(int fd);
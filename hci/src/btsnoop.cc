@@ -35,6 +35,7 @@
 #include <sys/time.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
@@ -45,8 +46,12 @@
 #include "hci/include/btsnoop_mem.h"
 #include "hci_layer.h"
 #include "internal_include/bt_trace.h"
+#include "osi/include/allocator.h"
+#include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
+#include "osi/include/osi.h"
 #include "osi/include/properties.h"
+#include "osi/include/thread.h"
 #include "stack/include/hcimsgs.h"
 #include "stack/include/rfcdefs.h"
 #include "stack/l2cap/l2c_int.h"
@@ -70,6 +75,15 @@
 #define DEFAULT_BTSNOOP_PATH "/data/misc/bluetooth/logs/btsnoop_hci.log"
 #define BTSNOOP_MAX_PACKETS_PROPERTY "persist.bluetooth.btsnoopsize"
 
+// Captured packets are staged in a lock-free queue of at most this many
+// records and written out by a dedicated thread, so that file and socket I/O
+// never run on the HCI path. Packets captured while the queue is full are
+// dropped and counted in the btsnoop records that follow.
+#define BTSNOOP_QUEUE_CAPACITY 1024
+
+// The maximum number of records gathered into a single writev() call.
+#define BTSNOOP_WRITE_BATCH 256
+
 typedef enum {
   kCommandPacket = 1,
   kAclPacket = 2,
@@ -96,6 +110,20 @@ static std::mutex btsnoop_mutex;
 static int32_t packets_per_file;
 static int32_t packet_counter;
 
+// A btsnoop record ready to be written: the header followed by the packet.
+typedef struct {
+  size_t length;
+  uint8_t data[];
+} snoop_record_t;
+
+static thread_t* writer_thread;
+static fixed_queue_t* record_queue;
+
+static std::atomic<uint64_t> captured_packets;
+static std::atomic<uint64_t> dropped_packets;
+static std::atomic<uint64_t> written_batches;
+static std::atomic<size_t> queue_high_water;
+
 // Channel tracking variables for filtering.
 
 // Keeps track of L2CAP channels that need to be filtered out of the snoop
@@ -171,6 +199,8 @@ static std::string get_btsnoop_last_log_path(std::string log_path);
 static void open_next_snoop_file();
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us);
+static void start_writer();
+static void stop_writer();
 
 // Module lifecycle functions
 
@@ -216,6 +246,7 @@ static future_t* start_up() {
     packets_per_file = osi_property_get_int32(BTSNOOP_MAX_PACKETS_PROPERTY,
                                               DEFAULT_BTSNOOP_SIZE);
     btsnoop_net_open();
+    start_writer();
   }
 
   return NULL;
@@ -224,6 +255,9 @@ static future_t* start_up() {
 static future_t* shut_down(void) {
   std::lock_guard<std::mutex> lock(btsnoop_mutex);
 
+  // Writes out everything still staged before the files are removed or closed
+  stop_writer();
+
   if (is_btsnoop_enabled) {
     if (is_btsnoop_filtered) {
       delete_btsnoop_files(false);
@@ -264,7 +298,7 @@ static void capture(const BT_HDR* buffer, bool is_received) {
 
   btsnoop_mem_capture(buffer, timestamp_us);
 
-  if (logfile_fd == INVALID_FD) return;
+  if (record_queue == NULL) return;
 
   switch (buffer->event & MSG_EVT_MASK) {
     case MSG_HC_TO_STACK_HCI_EVT:
@@ -463,21 +497,118 @@ static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
       blacklisted ? htonl(L2C_HEADER_SIZE) : header.length_original;
   if (blacklisted) length_he = L2C_HEADER_SIZE;
   header.flags = htonl(flags);
-  header.dropped_packets = 0;
+  header.dropped_packets = htonl(static_cast<uint32_t>(dropped_packets));
   header.timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA);
   header.type = type;
 
-  btsnoop_net_write(&header, sizeof(btsnoop_header_t));
-  btsnoop_net_write(packet, length_he - 1);
+  size_t packet_length = length_he - 1;
+  snoop_record_t* record = static_cast<snoop_record_t*>(osi_malloc(
+      sizeof(snoop_record_t) + sizeof(btsnoop_header_t) + packet_length));
+  record->length = sizeof(btsnoop_header_t) + packet_length;
+  memcpy(record->data, &header, sizeof(btsnoop_header_t));
+  memcpy(record->data + sizeof(btsnoop_header_t), packet, packet_length);
+
+  captured_packets++;
+  if (!fixed_queue_try_enqueue(record_queue, record)) {
+    dropped_packets++;
+    osi_free(record);
+    return;
+  }
+
+  size_t depth = fixed_queue_length(record_queue);
+  size_t high_water = queue_high_water;
+  while (depth > high_water &&
+         !queue_high_water.compare_exchange_weak(high_water, depth)) {
+  }
+}
+
+// Writes |count| records to the snoop socket and log file, rotating the file
+// as needed, and frees them. Runs on the writer thread, or on the thread
+// shutting the module down once the writer has stopped.
+static void write_records(snoop_record_t** records, size_t count) {
+  iovec iov[BTSNOOP_WRITE_BATCH];
+  size_t iov_count = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    btsnoop_net_write(records[i]->data, records[i]->length);
+
+    if (logfile_fd == INVALID_FD) continue;
 
-  if (logfile_fd != INVALID_FD) {
     packet_counter++;
     if (packet_counter > packets_per_file) {
+      if (iov_count > 0) {
+        TEMP_FAILURE_RETRY(writev(logfile_fd, iov, iov_count));
+        iov_count = 0;
+      }
       open_next_snoop_file();
+      if (logfile_fd == INVALID_FD) continue;
     }
 
-    iovec iov[] = {{&header, sizeof(btsnoop_header_t)},
-                   {reinterpret_cast<void*>(packet), length_he - 1}};
-    TEMP_FAILURE_RETRY(writev(logfile_fd, iov, 2));
+    iov[iov_count].iov_base = records[i]->data;
+    iov[iov_count].iov_len = records[i]->length;
+    iov_count++;
+  }
+
+  if (iov_count > 0) TEMP_FAILURE_RETRY(writev(logfile_fd, iov, iov_count));
+  written_batches++;
+
+  for (size_t i = 0; i < count; i++) osi_free(records[i]);
+}
+
+static void write_staged_records(fixed_queue_t* queue,
+                                 UNUSED_ATTR void* context) {
+  snoop_record_t* records[BTSNOOP_WRITE_BATCH];
+  size_t count = 0;
+  while (count < BTSNOOP_WRITE_BATCH) {
+    void* record = fixed_queue_try_dequeue(queue);
+    if (record == NULL) break;
+    records[count++] = static_cast<snoop_record_t*>(record);
+  }
+  if (count > 0) write_records(records, count);
+}
+
+static void start_writer() {
+  record_queue = fixed_queue_new_lockfree(BTSNOOP_QUEUE_CAPACITY, true);
+  writer_thread = thread_new("btsnoop_writer");
+  if (writer_thread == NULL) {
+    LOG(ERROR) << __func__ << ": unable to create writer thread";
+    fixed_queue_free(record_queue, NULL);
+    record_queue = NULL;
+    return;
+  }
+  fixed_queue_register_dequeue(record_queue, thread_get_reactor(writer_thread),
+                               write_staged_records, NULL);
+}
+
+static void stop_writer() {
+  if (record_queue == NULL) return;
+
+  fixed_queue_unregister_dequeue(record_queue);
+  thread_free(writer_thread);
+  writer_thread = NULL;
+
+  while (!fixed_queue_is_empty(record_queue)) {
+    write_staged_records(record_queue, NULL);
+  }
+  fixed_queue_free(record_queue, NULL);
+  record_queue = NULL;
+
+  if (dropped_packets > 0) {
+    LOG(WARNING) << __func__ << ": dropped " << dropped_packets << " of "
+                 << captured_packets << " snoop packets";
+  }
+}
+
+void btsnoop_debug_dump(int fd) {
+  dprintf(fd, "\nBTSnoop Writer:\n");
+  {
+    std::lock_guard<std::mutex> lock(btsnoop_mutex);
+    dprintf(fd, "  Queue depth/capacity: %zu / %d\n",
+            record_queue != NULL ? fixed_queue_length(record_queue) : 0,
+            BTSNOOP_QUEUE_CAPACITY);
   }
+  dprintf(fd, "  Queue high water: %zu\n", queue_high_water.load());
+  dprintf(fd, "  Captured packets: %" PRIu64 "\n", captured_packets.load());
+  dprintf(fd, "  Dropped packets: %" PRIu64 "\n", dropped_packets.load());
+  dprintf(fd, "  Write batches: %" PRIu64 "\n", written_batches.load());
 }
@@ -17,15 +17,179 @@
  ******************************************************************************/
 
 #include <base/logging.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
 
 #include "bt_common.h"
 #include "buffer_allocator.h"
+#include "osi/include/allocation_tracker.h"
+
+// Buffers are recycled through a small cache per thread and a shared depot
+// per size class. Every cached block is a live |osi_malloc| buffer at least as
+// large as its class, so buffers handed out here may still be released with
+// |osi_free| anywhere in the stack, and any |osi_malloc| buffer may be handed
+// back through |buffer_free|. While the allocation tracker is enabled the pool
+// is bypassed so that canaries and leak accounting behave as before.
+
+typedef struct {
+  size_t size;
+  size_t depot_depth;
+} size_class_t;
+
+// HCI events and LE ACL packets, a full BR/EDR ACL packet with headers, and
+// reassembled L2CAP frames.
+static const size_class_t size_classes[] = {
+    {128, 256},
+    {320, 256},
+    {1088, 128},
+    {BT_DEFAULT_BUFFER_SIZE, 32},
+};
+#define NUM_SIZE_CLASSES (sizeof(size_classes) / sizeof(size_classes[0]))
+#define THREAD_CACHE_DEPTH 32
+#define MAX_DEPOT_DEPTH 256
+
+typedef struct {
+  std::atomic<uint64_t> hits;
+  std::atomic<uint64_t> misses;
+  std::atomic<uint64_t> released;
+  std::atomic<size_t> cached;
+  std::atomic<size_t> cached_high_water;
+} size_class_stats_t;
+
+static size_class_stats_t stats[NUM_SIZE_CLASSES];
+static std::atomic<uint64_t> bypassed;
+
+typedef struct {
+  std::mutex lock;
+  void* blocks[NUM_SIZE_CLASSES][MAX_DEPOT_DEPTH];
+  size_t count[NUM_SIZE_CLASSES];
+} depot_t;
+
+static depot_t depot;
+
+static void note_cached(size_t size_class, size_t added) {
+  size_class_stats_t& s = stats[size_class];
+  size_t now = s.cached.fetch_add(added, std::memory_order_relaxed) + added;
+  size_t high = s.cached_high_water.load(std::memory_order_relaxed);
+  while (now > high && !s.cached_high_water.compare_exchange_weak(
+                           high, now, std::memory_order_relaxed)) {
+  }
+}
+
+// Returns |count| blocks of |size_class| to the depot, releasing whatever
+// does not fit.
+static void depot_put(size_t size_class, void** blocks, size_t count) {
+  size_t stored = 0;
+  {
+    std::lock_guard<std::mutex> lock(depot.lock);
+    size_t depth = size_classes[size_class].depot_depth;
+    while (stored < count && depot.count[size_class] < depth) {
+      depot.blocks[size_class][depot.count[size_class]++] = blocks[stored++];
+    }
+  }
+  if (stored == count) return;
+
+  stats[size_class].cached.fetch_sub(count - stored,
+                                     std::memory_order_relaxed);
+  stats[size_class].released.fetch_add(count - stored,
+                                       std::memory_order_relaxed);
+  for (size_t i = stored; i < count; i++) osi_free(blocks[i]);
+}
+
+// Moves up to |max| blocks of |size_class| from the depot into |blocks|.
+static size_t depot_take(size_t size_class, void** blocks, size_t max) {
+  std::lock_guard<std::mutex> lock(depot.lock);
+  size_t taken = 0;
+  while (taken < max && depot.count[size_class] > 0) {
+    blocks[taken++] = depot.blocks[size_class][--depot.count[size_class]];
+  }
+  return taken;
+}
+
+typedef struct thread_cache_t {
+  void* blocks[NUM_SIZE_CLASSES][THREAD_CACHE_DEPTH];
+  size_t count[NUM_SIZE_CLASSES];
+
+  ~thread_cache_t() {
+    for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+      depot_put(i, blocks[i], count[i]);
+      count[i] = 0;
+    }
+  }
+} thread_cache_t;
+
+static thread_local thread_cache_t thread_cache;
 
 static void* buffer_alloc(size_t size) {
   CHECK(size <= BT_DEFAULT_BUFFER_SIZE);
-  return osi_malloc(size);
+
+  if (allocation_tracker_is_enabled()) {
+    bypassed.fetch_add(1, std::memory_order_relaxed);
+    return osi_malloc(size);
+  }
+
+  size_t size_class = 0;
+  while (size_classes[size_class].size < size) size_class++;
+
+  thread_cache_t& cache = thread_cache;
+  if (cache.count[size_class] == 0) {
+    cache.count[size_class] = depot_take(
+        size_class, cache.blocks[size_class], THREAD_CACHE_DEPTH / 2);
+  }
+  if (cache.count[size_class] > 0) {
+    stats[size_class].hits.fetch_add(1, std::memory_order_relaxed);
+    stats[size_class].cached.fetch_sub(1, std::memory_order_relaxed);
+    return cache.blocks[size_class][--cache.count[size_class]];
+  }
+
+  stats[size_class].misses.fetch_add(1, std::memory_order_relaxed);
+  return osi_malloc(size_classes[size_class].size);
 }
 
-static const allocator_t interface = {buffer_alloc, osi_free};
+static void buffer_free(void* ptr) {
+  if (ptr == NULL) return;
+
+  // Zero while the allocation tracker is enabled.
+  size_t usable = osi_malloc_usable_size(ptr);
+  if (usable < size_classes[0].size) {
+    if (usable == 0) bypassed.fetch_add(1, std::memory_order_relaxed);
+    osi_free(ptr);
+    return;
+  }
+
+  size_t size_class = NUM_SIZE_CLASSES - 1;
+  while (size_classes[size_class].size > usable) size_class--;
+
+  thread_cache_t& cache = thread_cache;
+  if (cache.count[size_class] == THREAD_CACHE_DEPTH) {
+    size_t keep = THREAD_CACHE_DEPTH / 2;
+    depot_put(size_class, &cache.blocks[size_class][keep],
+              THREAD_CACHE_DEPTH - keep);
+    cache.count[size_class] = keep;
+  }
+  cache.blocks[size_class][cache.count[size_class]++] = ptr;
+  note_cached(size_class, 1);
+}
+
+static const allocator_t interface = {buffer_alloc, buffer_free};
 
 const allocator_t* buffer_allocator_get_interface() { return &interface; }
+
+void buffer_allocator_debug_dump(int fd) {
+  dprintf(fd, "\nBluetooth HCI Buffer Pool:\n");
+  dprintf(fd, "  Bypassed while tracking allocations: %" PRIu64 "\n",
+          bypassed.load(std::memory_order_relaxed));
+  dprintf(fd, "  %8s %12s %12s %12s %8s %10s\n", "Class", "Hits", "Misses",
+          "Released", "Cached", "HighWater");
+  for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+    const size_class_stats_t& s = stats[i];
+    dprintf(fd, "  %8zu %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %8zu %10zu\n",
+            size_classes[i].size, s.hits.load(std::memory_order_relaxed),
+            s.misses.load(std::memory_order_relaxed),
+            s.released.load(std::memory_order_relaxed),
+            s.cached.load(std::memory_order_relaxed),
+            s.cached_high_water.load(std::memory_order_relaxed));
+  }
+}
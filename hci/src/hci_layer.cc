@@ -42,6 +42,7 @@
 #include "common/message_loop_thread.h"
 #include "common/metrics.h"
 #include "common/once_timer.h"
+#include "common/startup_trace.h"
 #include "hci_inject.h"
 #include "hci_internals.h"
 #include "hcidefs.h"
@@ -58,6 +59,7 @@
 
 using bluetooth::common::MessageLoopThread;
 using bluetooth::common::OnceTimer;
+using bluetooth::common::StartupTrace;
 
 extern void hci_initialize();
 extern void hci_transmit(BT_HDR* packet);
@@ -126,6 +128,7 @@ static base::Callback<void(const base::Location&, BT_HDR*)> send_data_upwards;
 
 static bool filter_incoming_event(BT_HDR* packet);
 static waiting_command_t* get_waiting_command(command_opcode_t opcode);
+static void trace_command_response(const waiting_command_t* wait_entry);
 static int get_num_waiting_commands();
 
 static void hci_root_inflamed_abort();
@@ -662,6 +665,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
       }
     } else {
       update_command_response_timer();
+      trace_command_response(wait_entry);
       if (wait_entry->complete_callback) {
         wait_entry->complete_callback(packet, wait_entry->context);
       } else if (wait_entry->complete_future) {
@@ -692,6 +696,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
           __func__, opcode);
     } else {
       update_command_response_timer();
+      trace_command_response(wait_entry);
       if (wait_entry->status_callback)
         wait_entry->status_callback(status, wait_entry->command,
                                     wait_entry->context);
@@ -754,6 +759,17 @@ static void dispatch_reassembled(BT_HDR* packet) {
 
 // Misc internal functions
 
+// Adds the time a command waited for its response to the startup trace
+static void trace_command_response(const waiting_command_t* wait_entry) {
+  StartupTrace& startup_trace = StartupTrace::GetInstance();
+  if (!startup_trace.IsRecording()) return;
+
+  char name[16];
+  snprintf(name, sizeof(name), "HCI 0x%04x", wait_entry->opcode);
+  startup_trace.AddSpan("hci", name, wait_entry->timestamp,
+                        std::chrono::steady_clock::now());
+}
+
 static waiting_command_t* get_waiting_command(command_opcode_t opcode) {
   std::lock_guard<std::recursive_timed_mutex> lock(
       commands_pending_response_mutex);
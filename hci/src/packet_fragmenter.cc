@@ -22,7 +22,7 @@
 
 #include <base/logging.h>
 #include <string.h>
-#include <unordered_map>
+#include <vector>
 
 #include "bt_target.h"
 #include "buffer_allocator.h"
@@ -51,13 +51,95 @@ static const allocator_t* buffer_allocator;
 static const controller_t* controller;
 static const packet_fragmenter_callbacks_t* callbacks;
 
-static std::unordered_map<uint16_t /* handle */, BT_HDR*> partial_packets;
+// An L2CAP PDU whose start fragment has arrived but which is still waiting
+// for continuation fragments. When the start fragment's buffer is large enough
+// for the whole PDU, continuations are appended to it directly. Otherwise the
+// fragments are chained and copied into one buffer once the last one arrives.
+typedef struct {
+  uint16_t handle;
+  BT_HDR* head;         // Start fragment; NULL if this slot is unused
+  uint16_t full_length;  // HCI preamble, L2CAP header and payload
+  uint16_t received;     // Bytes of |full_length| received so far
+  bool in_place;
+  std::vector<BT_HDR*> fragments;  // Continuations, unless |in_place|
+} partial_packet_t;
+
+// Slots are probed starting at the handle's own index, so with fewer than
+// PARTIAL_PACKET_SLOTS links the first probe is almost always a hit.
+#define PARTIAL_PACKET_SLOTS 16
+static_assert((PARTIAL_PACKET_SLOTS & (PARTIAL_PACKET_SLOTS - 1)) == 0,
+              "PARTIAL_PACKET_SLOTS must be a power of two");
+static_assert(PARTIAL_PACKET_SLOTS >= MAX_L2CAP_LINKS,
+              "Need a reassembly slot for every link");
+static partial_packet_t partial_packets[PARTIAL_PACKET_SLOTS];
+
+static partial_packet_t* find_partial_packet(uint16_t handle) {
+  for (size_t i = 0; i < PARTIAL_PACKET_SLOTS; i++) {
+    partial_packet_t* partial =
+        &partial_packets[(handle + i) & (PARTIAL_PACKET_SLOTS - 1)];
+    if (partial->head != NULL && partial->handle == handle) return partial;
+  }
+  return NULL;
+}
+
+static partial_packet_t* new_partial_packet(uint16_t handle) {
+  for (size_t i = 0; i < PARTIAL_PACKET_SLOTS; i++) {
+    partial_packet_t* partial =
+        &partial_packets[(handle + i) & (PARTIAL_PACKET_SLOTS - 1)];
+    if (partial->head == NULL) {
+      partial->handle = handle;
+      return partial;
+    }
+  }
+  return NULL;
+}
+
+static void free_partial_packet(partial_packet_t* partial) {
+  buffer_allocator->free(partial->head);
+  partial->head = NULL;
+  for (BT_HDR* fragment : partial->fragments) buffer_allocator->free(fragment);
+  partial->fragments.clear();
+}
+
+// Returns the complete PDU held by |partial| in a single buffer and releases
+// the slot.
+static BT_HDR* take_partial_packet(partial_packet_t* partial) {
+  BT_HDR* head = partial->head;
+  BT_HDR* packet = head;
+
+  if (!partial->in_place) {
+    packet = (BT_HDR*)buffer_allocator->alloc(partial->full_length +
+                                              sizeof(BT_HDR));
+    packet->event = head->event;
+    packet->layer_specific = 0;
+
+    uint16_t offset = head->len;
+    memcpy(packet->data, head->data, head->len);
+    for (BT_HDR* fragment : partial->fragments) {
+      uint16_t length = fragment->len - fragment->offset;
+      memcpy(packet->data + offset, fragment->data + fragment->offset, length);
+      offset += length;
+      buffer_allocator->free(fragment);
+    }
+    partial->fragments.clear();
+    buffer_allocator->free(head);
+  }
+
+  packet->len = partial->full_length;
+  packet->offset = 0;
+  partial->head = NULL;
+  return packet;
+}
 
 static void init(const packet_fragmenter_callbacks_t* result_callbacks) {
   callbacks = result_callbacks;
 }
 
-static void cleanup() { partial_packets.clear(); }
+static void cleanup() {
+  for (partial_packet_t& partial : partial_packets) {
+    if (partial.head != NULL) free_partial_packet(&partial);
+  }
+}
 
 static void fragment_and_dispatch(BT_HDR* packet) {
   CHECK(packet != NULL);
@@ -151,16 +233,13 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
       }
       uint16_t l2cap_length;
       STREAM_TO_UINT16(l2cap_length, stream);
-      auto map_iter = partial_packets.find(handle);
-      if (map_iter != partial_packets.end()) {
+      partial_packet_t* partial = find_partial_packet(handle);
+      if (partial != NULL) {
         LOG_WARN(LOG_TAG,
                  "%s found unfinished packet for handle with start packet. "
                  "Dropping old.",
                  __func__);
-
-        BT_HDR* hdl = map_iter->second;
-        partial_packets.erase(map_iter);
-        buffer_allocator->free(hdl);
+        free_partial_packet(partial);
       }
 
       if (acl_length < L2CAP_HEADER_PDU_LEN_SIZE) {
@@ -194,58 +273,58 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
         return;
       }
 
-      BT_HDR* partial_packet =
-          (BT_HDR*)buffer_allocator->alloc(full_length + sizeof(BT_HDR));
-      partial_packet->event = packet->event;
-      partial_packet->len = full_length;
-      partial_packet->offset = packet->len;
-
-      memcpy(partial_packet->data, packet->data, packet->len);
+      partial = new_partial_packet(handle);
+      if (partial == NULL) {
+        LOG_ERROR(LOG_TAG, "%s no reassembly slot for handle 0x%04x.",
+                  __func__, handle);
+        buffer_allocator->free(packet);
+        return;
+      }
 
       // Update the ACL data size to indicate the full expected length
-      stream = partial_packet->data;
+      stream = packet->data;
       STREAM_SKIP_UINT16(stream);  // skip the handle
       UINT16_TO_STREAM(stream, full_length - HCI_ACL_PREAMBLE_SIZE);
 
-      partial_packets[handle] = partial_packet;
-
-      // Free the old packet buffer, since we don't need it anymore
-      buffer_allocator->free(packet);
+      partial->head = packet;
+      partial->full_length = full_length;
+      partial->received = packet->len;
+      partial->in_place =
+          osi_malloc_usable_size(packet) >= full_length + sizeof(BT_HDR);
     } else {
-      auto map_iter = partial_packets.find(handle);
-      if (map_iter == partial_packets.end()) {
+      partial_packet_t* partial = find_partial_packet(handle);
+      if (partial == NULL) {
         LOG_WARN(LOG_TAG,
                  "%s got continuation for unknown packet. Dropping it.",
                  __func__);
         buffer_allocator->free(packet);
         return;
       }
-      BT_HDR* partial_packet = map_iter->second;
 
       packet->offset = HCI_ACL_PREAMBLE_SIZE;
-      uint16_t projected_offset =
-          partial_packet->offset + (packet->len - HCI_ACL_PREAMBLE_SIZE);
       if ((packet->len - packet->offset) >
-          (partial_packet->len - partial_packet->offset)) {
+          (partial->full_length - partial->received)) {
         LOG_WARN(LOG_TAG,
                  "%s got packet which would exceed expected length of %d. "
                  "Truncating.",
-                 __func__, partial_packet->len);
-        packet->len = (partial_packet->len - partial_packet->offset) + packet->offset;
-        projected_offset = partial_packet->len;
+                 __func__, partial->full_length);
+        packet->len =
+            (partial->full_length - partial->received) + packet->offset;
       }
+      uint16_t length = packet->len - packet->offset;
 
-      memcpy(partial_packet->data + partial_packet->offset,
-             packet->data + packet->offset, packet->len - packet->offset);
-
-      // Free the old packet buffer, since we don't need it anymore
-      buffer_allocator->free(packet);
-      partial_packet->offset = projected_offset;
+      if (partial->in_place) {
+        memcpy(partial->head->data + partial->received,
+               packet->data + packet->offset, length);
+        // Free the old packet buffer, since we don't need it anymore
+        buffer_allocator->free(packet);
+      } else {
+        partial->fragments.push_back(packet);
+      }
+      partial->received += length;
 
-      if (partial_packet->offset == partial_packet->len) {
-        partial_packets.erase(handle);
-        partial_packet->offset = 0;
-        callbacks->reassembled(partial_packet);
+      if (partial->received == partial->full_length) {
+        callbacks->reassembled(take_partial_packet(partial));
       }
     }
   } else {
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "bt_common.h"
+#include "buffer_allocator.h"
+#include "osi/include/allocation_tracker.h"
+#include "osi/test/AllocationTestHarness.h"
+
+extern void allocation_tracker_uninit(void);
+
+class BufferAllocatorTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    allocation_tracker_uninit();
+    allocator_ = buffer_allocator_get_interface();
+  }
+
+  const allocator_t* allocator_;
+};
+
+TEST_F(BufferAllocatorTest, test_reuses_freed_buffer) {
+  void* first = allocator_->alloc(200);
+  memset(first, 0xa5, 200);
+  allocator_->free(first);
+
+  void* second = allocator_->alloc(300);
+  EXPECT_EQ(first, second);
+  memset(second, 0x5a, 300);
+  allocator_->free(second);
+}
+
+TEST_F(BufferAllocatorTest, test_small_buffer_not_reused_for_large_request) {
+  void* small = allocator_->alloc(16);
+  allocator_->free(small);
+
+  void* large = allocator_->alloc(BT_DEFAULT_BUFFER_SIZE);
+  EXPECT_NE(small, large);
+  memset(large, 0, BT_DEFAULT_BUFFER_SIZE);
+  allocator_->free(large);
+}
+
+TEST_F(BufferAllocatorTest, test_osi_free_of_pool_buffer) {
+  void* buffer = allocator_->alloc(1000);
+  memset(buffer, 0, 1000);
+  osi_free(buffer);
+}
+
+TEST_F(BufferAllocatorTest, test_free_of_osi_malloc_buffer) {
+  void* buffer = osi_malloc(700);
+  allocator_->free(buffer);
+
+  void* reused = allocator_->alloc(320);
+  EXPECT_EQ(buffer, reused);
+  memset(reused, 0, 320);
+  allocator_->free(reused);
+}
+
+TEST_F(BufferAllocatorTest, test_free_on_other_thread) {
+  const size_t count = 1000;
+  std::vector<void*> buffers;
+  for (size_t i = 0; i < count; i++) {
+    buffers.push_back(allocator_->alloc(1024));
+    memset(buffers.back(), i & 0xff, 1024);
+  }
+
+  std::thread consumer([this, &buffers]() {
+    for (void* buffer : buffers) allocator_->free(buffer);
+  });
+  consumer.join();
+
+  for (size_t i = 0; i < count; i++) {
+    buffers[i] = allocator_->alloc(1024);
+    memset(buffers[i], 0, 1024);
+  }
+  for (void* buffer : buffers) allocator_->free(buffer);
+}
+
+TEST_F(BufferAllocatorTest, test_bypassed_while_tracking) {
+  allocation_tracker_init();
+  allocation_tracker_reset();
+  ASSERT_TRUE(allocation_tracker_is_enabled());
+
+  void* buffer = allocator_->alloc(100);
+  memset(buffer, 0, 100);
+  allocator_->free(buffer);
+  EXPECT_EQ(0U, allocation_tracker_expect_no_allocations());
+
+  allocation_tracker_uninit();
+}
@@ -146,6 +146,14 @@ class HciPacketFragmenterTest : public AllocationTestHarness {
   }
   const packet_fragmenter_t* packet_fragmenter_;
 
+  size_t PartialPacketCount() const {
+    size_t count = 0;
+    for (const partial_packet_t& partial : partial_packets) {
+      if (partial.head != nullptr) count++;
+    }
+    return count;
+  }
+
   // Start acl packet
   BT_HDR* AllocateL2capPacket(size_t l2cap_length,
                               const std::vector<uint8_t> data) const {
@@ -212,10 +220,8 @@ class HciPacketFragmenterTest : public AllocationTestHarness {
   }
 
   void FlushPartialPackets() const {
-    while (!partial_packets.empty()) {
-      BT_HDR* partial_packet = partial_packets.at(kHandle);
-      partial_packets.erase(kHandle);
-      osi_free(partial_packet);
+    for (partial_packet_t& partial : partial_packets) {
+      if (partial.head != nullptr) free_partial_packet(&partial);
     }
   }
 };
@@ -303,7 +309,7 @@ TEST_F(HciPacketFragmenterTest, OnePacket_Immediate) {
     const std::vector<uint8_t> data = CreateData(packet_size);
     reassemble_and_dispatch(AllocateL2capPacket(data.size(), data));
 
-    CHECK(partial_packets.size() == 0);
+    CHECK(PartialPacketCount() == 0);
     CHECK(test_state_.reassembled.access_count_ == ++reassembled_access_count);
     auto packet = std::move(test_state_.reassembled.queue.front());
     test_state_.reassembled.queue.pop();
@@ -316,7 +322,7 @@ TEST_F(HciPacketFragmenterTest, OnePacket_ImmediateTooBig) {
   const std::vector<uint8_t> data = CreateData(packet_size);
   reassemble_and_dispatch(AllocateL2capPacket(data.size(), data));
 
-  CHECK(partial_packets.size() == 0);
+  CHECK(PartialPacketCount() == 0);
   CHECK(test_state_.reassembled.access_count_ == 0);
 }
 
@@ -326,7 +332,7 @@ TEST_F(HciPacketFragmenterTest, ThreePackets_Immediate) {
   reassemble_and_dispatch(AllocateL2capPacket(data.size(), data));
   reassemble_and_dispatch(AllocateL2capPacket(data.size(), data));
   reassemble_and_dispatch(AllocateL2capPacket(data.size(), data));
-  CHECK(partial_packets.size() == 0);
+  CHECK(PartialPacketCount() == 0);
   CHECK(test_state_.reassembled.access_count_ == 3);
 }
 
@@ -341,14 +347,14 @@ TEST_F(HciPacketFragmenterTest, OnePacket_SplitTwo) {
                                      data.cbegin() + packet_size / 2);
     reassemble_and_dispatch(AllocateL2capPacket(data.size(), part1));
 
-    CHECK(partial_packets.size() == 1);
+    CHECK(PartialPacketCount() == 1);
     CHECK(test_state_.reassembled.access_count_ == reassembled_access_count);
 
     const std::vector<uint8_t> part2(data.cbegin() + packet_size / 2,
                                      data.cend());
     reassemble_and_dispatch(AllocateL2capPacket(part2));
 
-    CHECK(partial_packets.size() == 0);
+    CHECK(PartialPacketCount() == 0);
     CHECK(test_state_.reassembled.access_count_ == ++reassembled_access_count);
 
     auto packet = std::move(test_state_.reassembled.queue.front());
@@ -364,21 +370,21 @@ TEST_F(HciPacketFragmenterTest, OnePacket_SplitALot) {
   const std::vector<uint8_t> data = CreateData(packet_size);
   const std::vector<uint8_t> first_part(data.cbegin(), data.cbegin() + stride);
   reassemble_and_dispatch(AllocateL2capPacket(data.size(), first_part));
-  CHECK(partial_packets.size() == 1);
+  CHECK(PartialPacketCount() == 1);
 
   for (size_t i = 2; i < packet_size - stride; i += stride) {
     const std::vector<uint8_t> middle_part(data.cbegin() + i,
                                            data.cbegin() + i + stride);
     reassemble_and_dispatch(AllocateL2capPacket(middle_part));
   }
-  CHECK(partial_packets.size() == 1);
+  CHECK(PartialPacketCount() == 1);
   CHECK(test_state_.reassembled.access_count_ == 0);
 
   const std::vector<uint8_t> last_part(data.cbegin() + packet_size - stride,
                                        data.cend());
   reassemble_and_dispatch(AllocateL2capPacket(last_part));
 
-  CHECK(partial_packets.size() == 0);
+  CHECK(PartialPacketCount() == 0);
   CHECK(test_state_.reassembled.access_count_ == 1);
   auto packet = std::move(test_state_.reassembled.queue.front());
   CHECK(VerifyData(Data(packet.get()), packet_size));
@@ -391,14 +397,14 @@ TEST_F(HciPacketFragmenterTest, TwoPacket_InvalidLength) {
                                         data.cbegin() + packet_size / 2);
   reassemble_and_dispatch(AllocateL2capPacket(data.size(), first_part));
 
-  CHECK(partial_packets.size() == 0);
+  CHECK(PartialPacketCount() == 0);
   CHECK(test_state_.reassembled.access_count_ == 0);
 
   const std::vector<uint8_t> second_part(data.cbegin() + packet_size / 2,
                                          data.cend());
   reassemble_and_dispatch(AllocateL2capPacket(second_part));
 
-  CHECK(partial_packets.size() == 0);
+  CHECK(PartialPacketCount() == 0);
   CHECK(test_state_.reassembled.access_count_ == 0);
 }
 
@@ -409,13 +415,13 @@ TEST_F(HciPacketFragmenterTest, TwoPacket_HugeBogusSecond) {
                                         data.cbegin() + packet_size - 1);
   reassemble_and_dispatch(AllocateL2capPacket(packet_size, first_part));
 
-  CHECK(partial_packets.size() == 1);
+  CHECK(PartialPacketCount() == 1);
   CHECK(test_state_.reassembled.access_count_ == 0);
 
   const std::vector<uint8_t> second_part(data.cbegin() + packet_size - 1,
                                          data.cend());
   reassemble_and_dispatch(AllocateL2capPacket(second_part));
 
-  CHECK(partial_packets.size() == 0);
+  CHECK(PartialPacketCount() == 0);
   CHECK(test_state_.reassembled.access_count_ == 1);
 }
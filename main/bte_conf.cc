@@ -22,21 +22,24 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <vector>
+
 #include "bta_api.h"
 #include "btif_common.h"
 #include "osi/include/compat.h"
 #include "osi/include/config.h"
 #include "osi/include/log.h"
 
-// Parses the specified Device ID configuration file and registers the
-// Device ID records with SDP.
-void bte_load_did_conf(const char* p_path) {
+// Parses the specified Device ID configuration file. Does not need the
+// controller, so it can be done while the controller is brought up.
+std::vector<tBTA_DI_RECORD> bte_parse_did_conf(const char* p_path) {
   CHECK(p_path != NULL);
 
+  std::vector<tBTA_DI_RECORD> records;
   std::unique_ptr<config_t> config = config_new(p_path);
   if (!config) {
     LOG_ERROR(LOG_TAG, "%s unable to load DID config '%s'.", __func__, p_path);
-    return;
+    return records;
   }
 
   for (int i = 1; i <= BTA_DI_NUM_MAX; ++i) {
@@ -93,11 +96,20 @@ void bte_load_did_conf(const char* p_path) {
               record.service_description);
     LOG_DEBUG(LOG_TAG, "  documentationURL    = %s", record.documentation_url);
 
+    records.push_back(record);
+  }
+  return records;
+}
+
+// Registers the Device ID records from bte_parse_did_conf() with SDP.
+void bte_set_did_records(const std::vector<tBTA_DI_RECORD>& records) {
+  for (size_t i = 0; i < records.size(); ++i) {
+    tBTA_DI_RECORD record = records[i];
     uint32_t record_handle;
     tBTA_STATUS status = BTA_DmSetLocalDiRecord(&record, &record_handle);
     if (status != BTA_SUCCESS) {
-      LOG_ERROR(LOG_TAG, "%s unable to set device ID record %d: error %d.",
-                __func__, i, status);
+      LOG_ERROR(LOG_TAG, "%s unable to set device ID record %zu: error %d.",
+                __func__, i + 1, status);
     }
   }
 }
@@ -20,6 +20,7 @@
 #include "main/shim/entry.h"
 #include "main/shim/shim.h"
 
+#include "hal/snoop_logger.h"
 #include "shim/dumpsys.h"
 
 namespace {
@@ -49,6 +50,10 @@ void bluetooth::shim::Dump(int fd) {
   }
   if (bluetooth::shim::is_gd_stack_started_up()) {
     bluetooth::shim::GetDumpsys()->Dump(fd);
+    bluetooth::hal::SnoopLogger* snoop_logger =
+        bluetooth::shim::GetSnoopLogger();
+    dprintf(fd, "%s snoop queue depth:%zu dropped packets:%u\n", kModuleName,
+            snoop_logger->GetQueueDepth(), snoop_logger->GetDroppedPackets());
   } else {
     dprintf(fd, "%s gd stack has not started up\n", kModuleName);
   }
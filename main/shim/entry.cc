@@ -18,6 +18,7 @@
 #include "osi/include/future.h"
 #include "osi/include/log.h"
 
+#include "hal/snoop_logger.h"
 #include "hci/controller.h"
 #include "hci/hci_layer.h"
 #include "hci/le_advertising_manager.h"
@@ -129,6 +130,12 @@ bluetooth::security::SecurityModule* bluetooth::shim::GetSecurityModule() {
       ->GetInstance<bluetooth::security::SecurityModule>();
 }
 
+bluetooth::hal::SnoopLogger* bluetooth::shim::GetSnoopLogger() {
+  return GetGabeldorscheStack()
+      ->GetStackManager()
+      ->GetInstance<bluetooth::hal::SnoopLogger>();
+}
+
 bluetooth::storage::LegacyModule* bluetooth::shim::GetStorage() {
   return GetGabeldorscheStack()
       ->GetStackManager()
@@ -43,6 +43,9 @@ class InquiryModule;
 class NameModule;
 class PageModule;
 }
+namespace hal {
+class SnoopLogger;
+}
 namespace hci {
 class Controller;
 class HciLayer;
@@ -76,6 +79,7 @@ neighbor::NameModule* GetName();
 neighbor::PageModule* GetPage();
 hci::LeScanningManager* GetScanning();
 bluetooth::security::SecurityModule* GetSecurityModule();
+hal::SnoopLogger* GetSnoopLogger();
 storage::LegacyModule* GetStorage();
 
 }  // namespace shim
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "osi/include/config.h"
+
+using ::benchmark::State;
+
+namespace {
+
+// Same threshold as btif_config.cc
+constexpr size_t kJournalCompactSize = 64 * 1024;
+
+const std::filesystem::path kConfigFile =
+    std::filesystem::temp_directory_path() / "config_benchmark.conf";
+
+std::string device_name(int i) {
+  char name[sizeof("00:11:22:33:44:55")];
+  snprintf(name, sizeof(name), "00:11:22:33:%02x:%02x", (i >> 8) & 0xff,
+           i & 0xff);
+  return name;
+}
+
+// Builds a config shaped like bt_config.conf with |num_devices| bonded devices
+std::unique_ptr<config_t> make_config(int num_devices) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  config_set_string(config.get(), "Info", "FileSource", "Empty");
+  config_set_string(config.get(), "Info", "TimeCreated", "2020-05-01 12:00:00");
+  config_set_string(config.get(), "Adapter", "Address", "00:11:22:33:00:00");
+  config_set_string(config.get(), "Adapter", "Name", "Phone");
+  config_set_int(config.get(), "Adapter", "ScanMode", 0);
+  config_set_int(config.get(), "Adapter", "DiscoveryTimeout", 120);
+  for (int i = 0; i < num_devices; i++) {
+    const std::string section = device_name(i);
+    config_set_string(config.get(), section, "Name", "Device " + section);
+    config_set_int(config.get(), section, "DevClass", 0x240404);
+    config_set_int(config.get(), section, "DevType", 3);
+    config_set_int(config.get(), section, "AddrType", 0);
+    config_set_int(config.get(), section, "Timestamp", 1588334400 + i);
+    config_set_int(config.get(), section, "Manufacturer", 15);
+    config_set_int(config.get(), section, "LmpVer", 9);
+    config_set_int(config.get(), section, "LmpSubVer", 0x2209);
+    config_set_string(config.get(), section, "Service",
+                      "0000110b-0000-1000-8000-00805f9b34fb "
+                      "0000110c-0000-1000-8000-00805f9b34fb "
+                      "0000110e-0000-1000-8000-00805f9b34fb "
+                      "0000111e-0000-1000-8000-00805f9b34fb");
+    config_set_int(config.get(), section, "LinkKeyType", 8);
+    config_set_int(config.get(), section, "PinLength", 0);
+    config_set_string(config.get(), section, "LinkKey",
+                      "00112233445566778899aabbccddeeff");
+    config_set_string(config.get(), section, "LE_KEY_PENC",
+                      "00112233445566778899aabbccddeeff0011223344556677"
+                      "8899aabbccdd");
+    config_set_string(config.get(), section, "LE_KEY_PID",
+                      "00112233445566778899aabbccddeeff00112233445566");
+    config_set_string(config.get(), section, "LE_KEY_LID",
+                      "00112233445566778899aabbccddeeff00112233445566");
+  }
+  return config;
+}
+
+// Touches one device the way a connection does, and returns the size of the
+// key and value that changed
+size_t change_one_key(config_t* config, int num_devices, int iteration) {
+  const std::string section = device_name(iteration % num_devices);
+  const std::string value = std::to_string(1600000000 + iteration);
+  config_set_string(config, section, "Timestamp", value);
+  return sizeof("Timestamp") - 1 + value.size();
+}
+
+size_t config_file_size(const std::filesystem::path& path) {
+  std::error_code error;
+  size_t size = std::filesystem::file_size(path, error);
+  return error ? 0 : size;
+}
+
+void set_counters(State& state, size_t bytes_written, size_t bytes_changed) {
+  state.counters["bytes_written_per_save"] =
+      static_cast<double>(bytes_written) / state.iterations();
+  state.counters["write_amplification"] =
+      static_cast<double>(bytes_written) / bytes_changed;
+}
+
+// One key changes between saves, and the whole file is rewritten
+void BM_ConfigSaveFull(State& state) {
+  const int num_devices = state.range(0);
+  std::unique_ptr<config_t> config = make_config(num_devices);
+  size_t bytes_written = 0;
+  size_t bytes_changed = 0;
+  int iteration = 0;
+  for (auto _ : state) {
+    bytes_changed += change_one_key(config.get(), num_devices, iteration++);
+    CHECK(config_save(*config, kConfigFile));
+    bytes_written += config_file_size(kConfigFile);
+  }
+  set_counters(state, bytes_written, bytes_changed);
+  std::filesystem::remove(kConfigFile);
+}
+BENCHMARK(BM_ConfigSaveFull)->Arg(100)->Arg(200);
+
+// One key changes between saves, and is appended to the journal. As in
+// btif_config_write, the file is compacted once the journal has grown past the
+// threshold, so its cost is amortized over the saves in between.
+void BM_ConfigSaveJournaled(State& state) {
+  const int num_devices = state.range(0);
+  std::unique_ptr<config_t> config = make_config(num_devices);
+  CHECK(config_save(*config, kConfigFile));
+  std::unique_ptr<config_t> saved = config_new_clone(*config);
+  config_journal_remove(kConfigFile);
+  size_t bytes_written = 0;
+  size_t bytes_changed = 0;
+  int compactions = 0;
+  int iteration = 0;
+  for (auto _ : state) {
+    bytes_changed += change_one_key(config.get(), num_devices, iteration++);
+    size_t journal_size = config_journal_size(kConfigFile);
+    CHECK(config_journal_append(*saved, *config, kConfigFile));
+    bytes_written += config_journal_size(kConfigFile) - journal_size;
+    if (journal_size >= kJournalCompactSize) {
+      CHECK(config_save(*config, kConfigFile));
+      CHECK(config_journal_remove(kConfigFile));
+      bytes_written += config_file_size(kConfigFile);
+      compactions++;
+    }
+    *saved = *config;
+  }
+  set_counters(state, bytes_written, bytes_changed);
+  state.counters["compactions"] = compactions;
+  config_journal_remove(kConfigFile);
+  std::filesystem::remove(kConfigFile);
+}
+BENCHMARK(BM_ConfigSaveJournaled)->Arg(100)->Arg(200);
+
+// Loads bt_config.conf with |num_devices| bonded devices
+void BM_ConfigParse(State& state) {
+  const int num_devices = state.range(0);
+  CHECK(config_save(*make_config(num_devices), kConfigFile));
+  for (auto _ : state) {
+    std::unique_ptr<config_t> config = config_new(kConfigFile.c_str());
+    CHECK(config != nullptr);
+    benchmark::DoNotOptimize(config);
+  }
+  std::filesystem::remove(kConfigFile);
+}
+BENCHMARK(BM_ConfigParse)->Arg(100)->Arg(200);
+
+// Reads the properties of every bonded device, as btif_storage does when it
+// loads them at boot
+void BM_ConfigQuery(State& state) {
+  const int num_devices = state.range(0);
+  std::unique_ptr<config_t> config = make_config(num_devices);
+  const std::string kKeys[] = {"Name",      "DevClass", "DevType",
+                               "AddrType",  "Service",  "LinkKeyType",
+                               "PinLength", "LinkKey",  "LE_KEY_PENC",
+                               "LE_KEY_PID"};
+  std::vector<std::string> sections;
+  for (int i = 0; i < num_devices; i++) sections.push_back(device_name(i));
+  for (auto _ : state) {
+    for (const std::string& section : sections) {
+      for (const std::string& key : kKeys) {
+        benchmark::DoNotOptimize(
+            config_get_string(*config, section, key, nullptr));
+      }
+      benchmark::DoNotOptimize(
+          config_has_key(*config, section, "LE_KEY_LCSRK"));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_devices *
+                          (std::size(kKeys) + 1));
+}
+BENCHMARK(BM_ConfigQuery)->Arg(100)->Arg(200);
+
+}  // namespace
+
+BENCHMARK_MAIN();
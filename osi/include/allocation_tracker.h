@@ -33,6 +33,10 @@ void allocation_tracker_init(void);
 // operations. Useful mostly for testing.
 void allocation_tracker_reset(void);
 
+// Returns true if the allocation tracker has been initialized and is adding
+// canaries to new allocations.
+bool allocation_tracker_is_enabled(void);
+
 // Expects that there are no allocations at the time of this call. Dumps
 // information about unfreed allocations to the log. Returns the amount of
 // unallocated memory.
@@ -41,6 +41,12 @@ void* osi_malloc(size_t size);
 void* osi_calloc(size_t size);
 void osi_free(void* ptr);
 
+// Returns the number of bytes usable through |ptr|, which must be a live buffer
+// returned by |osi_malloc| or |osi_calloc|. The result is at least the size
+// that was requested. Returns 0 while the allocation tracker is enabled, as
+// the tracker then owns the bytes past the requested size.
+size_t osi_malloc_usable_size(void* ptr);
+
 // Free a buffer that was previously allocated with function |osi_malloc|
 // or |osi_calloc| and reset the pointer to that buffer to NULL.
 // |p_ptr| is a pointer to the buffer pointer to be reset.
@@ -21,6 +21,8 @@
 #include <memory>
 #include <string>
 
+#include "gd/storage/indexed_list.h"
+
 // The default section name to use if a key/value pair is not defined within
 // a section.
 #define CONFIG_DEFAULT_SECTION "Global"
@@ -30,16 +32,21 @@ struct entry_t {
   std::string value;
 };
 
+// Sections and entries are kept in insertion order, which is the order they
+// are saved in, and indexed by name for constant time lookup.
 struct section_t {
   std::string name;
-  std::list<entry_t> entries;
+  bluetooth::storage::IndexedList<entry_t, &entry_t::key> entries;
   void Set(std::string key, std::string value);
   std::list<entry_t>::iterator Find(const std::string& key);
   bool Has(const std::string& key);
 };
 
+typedef bluetooth::storage::IndexedList<section_t, &section_t::name>
+    section_list_t;
+
 struct config_t {
-  std::list<section_t> sections;
+  section_list_t sections;
   std::list<section_t>::iterator Find(const std::string& section);
   bool Has(const std::string& section);
 };
@@ -146,3 +153,39 @@ bool config_save(const config_t& config, const std::string& filename);
 // that this could be a destructive operation: if |filename| already exists,
 // it will be overwritten.
 bool checksum_save(const std::string& checksum, const std::string& filename);
+
+// Journaled persistence. Rather than rewriting the whole file with
+// |config_save| on every change, the changes can be appended as compact
+// records to a write-ahead journal next to the file (|filename| with a
+// ".journal" suffix). Loading the file and replaying its journal gives back
+// the latest config. The file is compacted by saving it with |config_save| and
+// then removing the journal.
+//
+// Each record carries its own CRC so that a record torn by a crash or power
+// loss during the append is detected and dropped on replay, like a partial
+// temp file is dropped by |config_save|. Callers should bring the journal up
+// to date before compacting: replaying a journal onto the file it was
+// compacted into is then a no-op, so a crash between |config_save| and
+// |config_journal_remove| is harmless.
+
+// Appends to the journal of |filename| one record for each key that was set or
+// removed, and for each section that was removed, going from |saved| (the
+// config as last persisted) to |config|, and syncs the journal to disk.
+// Nothing is written when the two are the same. Returns true once the records
+// are on disk. On failure the journal is left as it was and the caller should
+// fall back to |config_save|.
+bool config_journal_append(const config_t& saved, const config_t& config,
+                           const std::string& filename);
+
+// Applies the records in the journal of |filename| to |config|, which must
+// hold the contents of |filename|. Replay stops at the first torn or corrupted
+// record, and the journal is truncated there so that later appends stay
+// readable. Returns the number of records applied, 0 if there is no journal.
+size_t config_journal_replay(config_t* config, const std::string& filename);
+
+// Returns the size in bytes of the journal of |filename|, 0 if there is none.
+size_t config_journal_size(const std::string& filename);
+
+// Removes the journal of |filename|, if any. Returns false if the journal
+// exists and could not be removed.
+bool config_journal_remove(const std::string& filename);
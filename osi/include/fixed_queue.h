@@ -23,6 +23,9 @@
 
 #include "osi/include/list.h"
 
+// Largest capacity supported by |fixed_queue_new_lockfree|.
+#define FIXED_QUEUE_LOCKFREE_MAX_CAPACITY (1 << 16)
+
 struct fixed_queue_t;
 typedef struct fixed_queue_t fixed_queue_t;
 typedef struct reactor_t reactor_t;
@@ -36,6 +39,21 @@ typedef void (*fixed_queue_cb)(fixed_queue_t* queue, void* context);
 // the returned queue with |fixed_queue_free|.
 fixed_queue_t* fixed_queue_new(size_t capacity);
 
+// Creates a new fixed queue backed by a lock-free bounded ring instead of a
+// mutex-protected list. |capacity| is rounded up to the next power of two and
+// may not exceed |FIXED_QUEUE_LOCKFREE_MAX_CAPACITY|. If |multi_producer| is
+// false, at most one thread may enqueue at a time. Elements must be dequeued
+// by a single consumer, either through |fixed_queue_register_dequeue| or by
+// calling the dequeue functions directly. Readiness is signalled through one
+// eventfd that coalesces wakeups, so a registered dequeue callback is invoked
+// repeatedly for all elements that are ready rather than once per reactor
+// wakeup. The callback may unregister or free the queue, which ends the
+// batch. |fixed_queue_try_peek_last|, |fixed_queue_try_remove_from_queue|,
+// |fixed_queue_get_list| and |fixed_queue_get_enqueue_fd| are not supported on
+// such queues. Returns NULL on failure. The caller must free the returned
+// queue with |fixed_queue_free|.
+fixed_queue_t* fixed_queue_new_lockfree(size_t capacity, bool multi_producer);
+
 // Frees a queue and (optionally) the enqueued elements.
 // |queue| is the queue to free. If the |free_cb| callback is not null,
 // it is called on each queue element to free it.
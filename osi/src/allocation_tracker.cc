@@ -23,6 +23,7 @@
 #include <base/logging.h>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include <mutex>
 #include <unordered_map>
 
@@ -41,7 +42,7 @@ static const size_t canary_size = 8;
 static char canary[canary_size];
 static std::unordered_map<void*, allocation_t*> allocations;
 static std::mutex tracker_lock;
-static bool enabled = false;
+static std::atomic_bool enabled(false);
 
 // Memory allocation statistics
 static size_t alloc_counter = 0;
@@ -77,6 +78,8 @@ void allocation_tracker_reset(void) {
   allocations.clear();
 }
 
+bool allocation_tracker_is_enabled(void) { return enabled; }
+
 size_t allocation_tracker_expect_no_allocations(void) {
   std::unique_lock<std::mutex> lock(tracker_lock);
   if (!enabled) return 0;
@@ -16,6 +16,7 @@
  *
  ******************************************************************************/
 #include <base/logging.h>
+#include <malloc.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -73,6 +74,12 @@ void osi_free(void* ptr) {
   free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
 }
 
+size_t osi_malloc_usable_size(void* ptr) {
+  CHECK(ptr != NULL);
+  if (allocation_tracker_is_enabled()) return 0;
+  return malloc_usable_size(ptr);
+}
+
 void osi_free_and_reset(void** p_ptr) {
   CHECK(p_ptr != NULL);
   osi_free(*p_ptr);
@@ -32,14 +32,12 @@
 #include <unistd.h>
 
 #include <sstream>
-#include <type_traits>
 
 void section_t::Set(std::string key, std::string value) {
-  for (entry_t& entry : entries) {
-    if (entry.key == key) {
-      entry.value = value;
-      return;
-    }
+  auto entry = entries.find(key);
+  if (entry != entries.end()) {
+    entry->value = std::move(value);
+    return;
   }
   // add a new key to the section
   entries.emplace_back(
@@ -47,9 +45,7 @@ void section_t::Set(std::string key, std::string value) {
 }
 
 std::list<entry_t>::iterator section_t::Find(const std::string& key) {
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+  return entries.find(key);
 }
 
 bool section_t::Has(const std::string& key) {
@@ -57,9 +53,7 @@ bool section_t::Has(const std::string& key) {
 }
 
 std::list<section_t>::iterator config_t::Find(const std::string& section) {
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return sections.find(section);
 }
 
 bool config_t::Has(const std::string& key) {
@@ -68,26 +62,16 @@ bool config_t::Has(const std::string& key) {
 
 static bool config_parse(FILE* fp, config_t* config);
 
-template <typename T,
-          class = typename std::enable_if<std::is_same<
-              config_t, typename std::remove_const<T>::type>::value>>
-static auto section_find(T& config, const std::string& section) {
-  return std::find_if(
-      config.sections.begin(), config.sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
-}
-
 static const entry_t* entry_find(const config_t& config,
                                  const std::string& section,
                                  const std::string& key) {
-  auto sec = section_find(config, section);
+  auto sec = config.sections.find(section);
   if (sec == config.sections.end()) return nullptr;
 
-  for (const entry_t& entry : sec->entries) {
-    if (entry.key == key) return &entry;
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return nullptr;
 
-  return nullptr;
+  return &*entry;
 }
 
 std::unique_ptr<config_t> config_new_empty(void) {
@@ -140,7 +124,7 @@ std::unique_ptr<config_t> config_new_clone(const config_t& src) {
 }
 
 bool config_has_section(const config_t& config, const std::string& section) {
-  return (section_find(config, section) != config.sections.end());
+  return (config.sections.find(section) != config.sections.end());
 }
 
 bool config_has_key(const config_t& config, const std::string& section,
@@ -208,7 +192,7 @@ void config_set_string(config_t* config, const std::string& section,
                        const std::string& key, const std::string& value) {
   CHECK(config);
 
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.find(section);
   if (sec == config->sections.end()) {
     config->sections.emplace_back(section_t{.name = section});
     sec = std::prev(config->sections.end());
@@ -223,11 +207,10 @@ void config_set_string(config_t* config, const std::string& section,
     value_no_newline = value;
   }
 
-  for (entry_t& entry : sec->entries) {
-    if (entry.key == key) {
-      entry.value = value_no_newline;
-      return;
-    }
+  auto entry = sec->entries.find(key);
+  if (entry != sec->entries.end()) {
+    entry->value = value_no_newline;
+    return;
   }
 
   sec->entries.emplace_back(entry_t{.key = key, .value = value_no_newline});
@@ -236,7 +219,7 @@ void config_set_string(config_t* config, const std::string& section,
 bool config_remove_section(config_t* config, const std::string& section) {
   CHECK(config);
 
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.find(section);
   if (sec == config->sections.end()) return false;
 
   config->sections.erase(sec);
@@ -246,18 +229,14 @@ bool config_remove_section(config_t* config, const std::string& section) {
 bool config_remove_key(config_t* config, const std::string& section,
                        const std::string& key) {
   CHECK(config);
-  auto sec = section_find(*config, section);
+  auto sec = config->sections.find(section);
   if (sec == config->sections.end()) return false;
 
-  for (auto entry = sec->entries.begin(); entry != sec->entries.end();
-       ++entry) {
-    if (entry->key == key) {
-      sec->entries.erase(entry);
-      return true;
-    }
-  }
+  auto entry = sec->entries.find(key);
+  if (entry == sec->entries.end()) return false;
 
-  return false;
+  sec->entries.erase(entry);
+  return true;
 }
 
 bool config_save(const config_t& config, const std::string& filename) {
@@ -476,6 +455,320 @@ error2:
   return false;
 }
 
+// Journal layout: a header (magic and version) followed by records. A record
+// is the length of its payload and the CRC-32 of the payload, both 32-bit
+// little endian, then the payload: an operation byte followed by the section
+// name, and for key records the key and value, each as a 16-bit little endian
+// length and the bytes.
+static const char JOURNAL_SUFFIX[] = ".journal";
+static const char JOURNAL_MAGIC[] = {'B', 'T', 'C', 'J'};
+static const uint8_t JOURNAL_VERSION = 1;
+static const size_t JOURNAL_HEADER_SIZE = sizeof(JOURNAL_MAGIC) + 1;
+static const size_t JOURNAL_RECORD_HEADER_SIZE = 8;
+
+enum journal_op_t : uint8_t {
+  JOURNAL_OP_SET = 1,
+  JOURNAL_OP_REMOVE_KEY = 2,
+  JOURNAL_OP_REMOVE_SECTION = 3,
+};
+
+static uint32_t journal_crc32(const uint8_t* data, size_t len) {
+  uint32_t crc = 0xffffffff;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+static void journal_put_u32(std::string* out, uint32_t value) {
+  for (int i = 0; i < 4; i++) out->push_back((char)(value >> (8 * i)));
+}
+
+static uint32_t journal_get_u32(const uint8_t* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static bool journal_put_string(std::string* out, const std::string& str) {
+  if (str.size() > UINT16_MAX) return false;
+  out->push_back((char)(str.size() & 0xff));
+  out->push_back((char)(str.size() >> 8));
+  out->append(str);
+  return true;
+}
+
+static bool journal_get_string(const uint8_t** data, const uint8_t* end,
+                               std::string* str) {
+  if (end - *data < 2) return false;
+  size_t len = (*data)[0] | ((*data)[1] << 8);
+  *data += 2;
+  if ((size_t)(end - *data) < len) return false;
+  str->assign((const char*)*data, len);
+  *data += len;
+  return true;
+}
+
+static bool journal_put_record(std::string* out, journal_op_t op,
+                               const std::string& section,
+                               const std::string& key = "",
+                               const std::string& value = "") {
+  std::string payload(1, (char)op);
+  if (!journal_put_string(&payload, section)) return false;
+  if (op != JOURNAL_OP_REMOVE_SECTION) {
+    if (!journal_put_string(&payload, key)) return false;
+    if (op == JOURNAL_OP_SET && !journal_put_string(&payload, value))
+      return false;
+  }
+  journal_put_u32(out, payload.size());
+  journal_put_u32(out, journal_crc32((const uint8_t*)payload.data(),
+                                     payload.size()));
+  out->append(payload);
+  return true;
+}
+
+// Applies the record in |payload| to |config|. Returns false if the payload is
+// malformed.
+static bool journal_apply_record(config_t* config, const uint8_t* payload,
+                                 size_t len) {
+  const uint8_t* end = payload + len;
+  if (len < 1) return false;
+  uint8_t op = *payload++;
+
+  std::string section, key, value;
+  if (!journal_get_string(&payload, end, &section)) return false;
+  if (op != JOURNAL_OP_REMOVE_SECTION &&
+      !journal_get_string(&payload, end, &key))
+    return false;
+  if (op == JOURNAL_OP_SET && !journal_get_string(&payload, end, &value))
+    return false;
+  if (payload != end) return false;
+
+  switch (op) {
+    case JOURNAL_OP_SET:
+      config_set_string(config, section, key, value);
+      return true;
+    case JOURNAL_OP_REMOVE_KEY:
+      config_remove_key(config, section, key);
+      return true;
+    case JOURNAL_OP_REMOVE_SECTION:
+      config_remove_section(config, section);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Serializes the changes going from |saved| to |config| into |out|.
+static bool journal_diff(const config_t& saved, const config_t& config,
+                         std::string* out) {
+  for (const section_t& saved_section : saved.sections) {
+    if (config.sections.find(saved_section.name) == config.sections.end() &&
+        !journal_put_record(out, JOURNAL_OP_REMOVE_SECTION, saved_section.name))
+      return false;
+  }
+
+  for (const section_t& section : config.sections) {
+    auto saved_section = saved.sections.find(section.name);
+    if (saved_section != saved.sections.end()) {
+      for (const entry_t& saved_entry : saved_section->entries) {
+        if (section.entries.find(saved_entry.key) == section.entries.end() &&
+            !journal_put_record(out, JOURNAL_OP_REMOVE_KEY, section.name,
+                                saved_entry.key))
+          return false;
+      }
+    }
+
+    for (const entry_t& entry : section.entries) {
+      if (saved_section != saved.sections.end()) {
+        auto saved_entry = saved_section->entries.find(entry.key);
+        if (saved_entry != saved_section->entries.end() &&
+            saved_entry->value == entry.value)
+          continue;
+      }
+      if (!journal_put_record(out, JOURNAL_OP_SET, section.name, entry.key,
+                              entry.value))
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool fsync_dir_of(const std::string& filename) {
+  const std::string directoryname = base::FilePath(filename).DirName().value();
+  int dir_fd = open(directoryname.c_str(), O_RDONLY);
+  if (dir_fd < 0) {
+    LOG(ERROR) << __func__ << ": unable to open dir '" << directoryname
+               << "': " << strerror(errno);
+    return false;
+  }
+  if (fsync(dir_fd) < 0) {
+    LOG(WARNING) << __func__ << ": unable to fsync dir '" << directoryname
+                 << "': " << strerror(errno);
+  }
+  close(dir_fd);
+  return true;
+}
+
+bool config_journal_append(const config_t& saved, const config_t& config,
+                           const std::string& filename) {
+  CHECK(!filename.empty());
+
+  std::string records;
+  if (!journal_diff(saved, config, &records)) {
+    LOG(ERROR) << __func__ << ": config entry too large for the journal";
+    return false;
+  }
+  if (records.empty()) return true;
+
+  // Steps to ensure the records get to disk:
+  //
+  // 1) Open the journal for appending (e.g. bt_config.conf.journal), creating
+  //    it with its header if needed.
+  // 2) Write all of the records with a single write().
+  // 3) Sync the journal to disk with fsync(), and the directory as well if the
+  //    journal was just created.
+  // If any step fails, truncate the journal back to where it was so that a
+  // partial record is never followed by more records.
+  const std::string journal_filename = filename + JOURNAL_SUFFIX;
+  int fd = open(journal_filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+  if (fd < 0) {
+    LOG(ERROR) << __func__ << ": unable to open file '" << journal_filename
+               << "': " << strerror(errno);
+    return false;
+  }
+
+  off_t offset = lseek(fd, 0, SEEK_END);
+  if (offset < 0) {
+    LOG(ERROR) << __func__ << ": unable to seek file '" << journal_filename
+               << "': " << strerror(errno);
+    close(fd);
+    return false;
+  }
+
+  const bool created = (offset == 0);
+  if (created) {
+    std::string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    header.push_back((char)JOURNAL_VERSION);
+    records.insert(0, header);
+  }
+
+  const char* data = records.data();
+  size_t remaining = records.size();
+  while (remaining > 0) {
+    ssize_t written = write(fd, data, remaining);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) {
+      LOG(ERROR) << __func__ << ": unable to write to file '"
+                 << journal_filename << "': " << strerror(errno);
+      goto error;
+    }
+    data += written;
+    remaining -= written;
+  }
+
+  // Unlike |config_save| the journal cannot fall back to an older copy of
+  // itself, so a failed fsync() is an error.
+  if (fsync(fd) < 0) {
+    LOG(ERROR) << __func__ << ": unable to fsync file '" << journal_filename
+               << "': " << strerror(errno);
+    goto error;
+  }
+
+  if (close(fd) < 0) {
+    LOG(ERROR) << __func__ << ": unable to close file '" << journal_filename
+               << "': " << strerror(errno);
+    fd = -1;
+    goto error;
+  }
+
+  if (created) fsync_dir_of(journal_filename);
+  return true;
+
+error:
+  if (created) {
+    unlink(journal_filename.c_str());
+  } else if (truncate(journal_filename.c_str(), offset) < 0) {
+    LOG(ERROR) << __func__ << ": unable to truncate file '" << journal_filename
+               << "': " << strerror(errno);
+  }
+  if (fd != -1) close(fd);
+  return false;
+}
+
+size_t config_journal_replay(config_t* config, const std::string& filename) {
+  CHECK(config != nullptr);
+  CHECK(!filename.empty());
+
+  const std::string journal_filename = filename + JOURNAL_SUFFIX;
+  base::FilePath path(journal_filename);
+  if (!base::PathExists(path)) return 0;
+
+  std::string journal;
+  if (!base::ReadFileToString(path, &journal)) {
+    LOG(ERROR) << __func__ << ": unable to read file '" << journal_filename
+               << "'";
+    return 0;
+  }
+
+  if (journal.size() < JOURNAL_HEADER_SIZE ||
+      memcmp(journal.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+      (uint8_t)journal[sizeof(JOURNAL_MAGIC)] != JOURNAL_VERSION) {
+    LOG(WARNING) << __func__ << ": discarding journal '" << journal_filename
+                 << "' with an unknown header";
+    config_journal_remove(filename);
+    return 0;
+  }
+
+  const uint8_t* begin = (const uint8_t*)journal.data();
+  const uint8_t* end = begin + journal.size();
+  const uint8_t* record = begin + JOURNAL_HEADER_SIZE;
+  size_t applied = 0;
+  while (end - record >= (ptrdiff_t)JOURNAL_RECORD_HEADER_SIZE) {
+    uint32_t len = journal_get_u32(record);
+    uint32_t crc = journal_get_u32(record + 4);
+    const uint8_t* payload = record + JOURNAL_RECORD_HEADER_SIZE;
+    if ((size_t)(end - payload) < len || journal_crc32(payload, len) != crc)
+      break;
+    // A record that passed its CRC but cannot be applied was written by
+    // something else; stop there like for a torn record.
+    if (!journal_apply_record(config, payload, len)) break;
+    record = payload + len;
+    applied++;
+  }
+
+  if (record != end) {
+    LOG(WARNING) << __func__ << ": dropping " << (end - record)
+                 << " bytes of torn journal after " << applied << " records";
+    if (truncate(journal_filename.c_str(), record - begin) < 0) {
+      LOG(ERROR) << __func__ << ": unable to truncate file '"
+                 << journal_filename << "': " << strerror(errno);
+    }
+  }
+  return applied;
+}
+
+size_t config_journal_size(const std::string& filename) {
+  struct stat st;
+  if (stat((filename + JOURNAL_SUFFIX).c_str(), &st) < 0) return 0;
+  return st.st_size;
+}
+
+bool config_journal_remove(const std::string& filename) {
+  const std::string journal_filename = filename + JOURNAL_SUFFIX;
+  if (unlink(journal_filename.c_str()) < 0) {
+    if (errno == ENOENT) return true;
+    LOG(ERROR) << __func__ << ": unable to remove file '" << journal_filename
+               << "': " << strerror(errno);
+    return false;
+  }
+  // Make the removal durable before the caller relies on it, e.g. before
+  // dropping the in-memory base the journal was relative to.
+  fsync_dir_of(journal_filename);
+  return true;
+}
+
 static char* trim(char* str) {
   while (isspace(*str)) ++str;
 
@@ -17,8 +17,14 @@
  ******************************************************************************/
 
 #include <base/logging.h>
+#include <errno.h>
+#include <poll.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 
 #include "osi/include/allocator.h"
@@ -28,7 +34,37 @@
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
+// Slot of the lock-free ring. |sequence| tells producers and the consumer
+// whose turn it is to touch |data| (see fixed_queue_new_lockfree).
+typedef struct {
+  std::atomic<size_t> sequence;
+  void* data;
+} ring_cell_t;
+
+typedef struct {
+  ring_cell_t* cells;
+  size_t mask;
+  bool multi_producer;
+
+  // Producer and consumer positions live on separate cache lines so that the
+  // two sides do not keep invalidating each other.
+  alignas(64) std::atomic<size_t> enqueue_pos;
+  alignas(64) std::atomic<size_t> dequeue_pos;
+
+  // Readiness is signalled through a single (non-semaphore) eventfd. Only the
+  // producer that flips |signaled| from false to true writes to it, so a burst
+  // of enqueues costs one syscall and one reactor wakeup.
+  alignas(64) std::atomic<bool> signaled;
+  int event_fd;
+
+  // Slow path for producers blocked on a full ring.
+  std::atomic<size_t> enqueue_waiters;
+  std::condition_variable* not_full;
+} ring_t;
+
 typedef struct fixed_queue_t {
+  ring_t* ring;  // Non-NULL for queues created by fixed_queue_new_lockfree
+
   list_t* list;
   semaphore_t* enqueue_sem;
   semaphore_t* dequeue_sem;
@@ -38,9 +74,22 @@ typedef struct fixed_queue_t {
   reactor_object_t* dequeue_object;
   fixed_queue_cb dequeue_ready;
   void* dequeue_context;
+  // Set while internal_dequeue_ready runs a batch of callbacks. Points to a
+  // flag on its stack that is raised when the callback unregisters or frees
+  // the queue, so that the batch stops without touching the queue again.
+  bool* dequeue_unregistered;
 } fixed_queue_t;
 
 static void internal_dequeue_ready(void* context);
+static ring_t* ring_new(size_t capacity, bool multi_producer);
+static void ring_free(ring_t* ring);
+static bool ring_try_push(ring_t* ring, void* data);
+static void* ring_try_pop(ring_t* ring);
+static void* ring_peek(ring_t* ring);
+static size_t ring_length(const ring_t* ring);
+static void ring_signal(ring_t* ring);
+static void ring_clear_signal(ring_t* ring);
+static void ring_wake_enqueue_waiters(fixed_queue_t* queue);
 
 fixed_queue_t* fixed_queue_new(size_t capacity) {
   fixed_queue_t* ret =
@@ -65,11 +114,45 @@ error:
   return NULL;
 }
 
+fixed_queue_t* fixed_queue_new_lockfree(size_t capacity, bool multi_producer) {
+  CHECK(capacity != 0);
+  CHECK(capacity <= FIXED_QUEUE_LOCKFREE_MAX_CAPACITY);
+
+  size_t ring_size = 1;
+  while (ring_size < capacity) ring_size <<= 1;
+
+  fixed_queue_t* ret =
+      static_cast<fixed_queue_t*>(osi_calloc(sizeof(fixed_queue_t)));
+
+  ret->mutex = new std::mutex;
+  ret->capacity = ring_size;
+
+  ret->ring = ring_new(ring_size, multi_producer);
+  if (!ret->ring) goto error;
+
+  return ret;
+
+error:
+  fixed_queue_free(ret, NULL);
+  return NULL;
+}
+
 void fixed_queue_free(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
   if (!queue) return;
 
   fixed_queue_unregister_dequeue(queue);
 
+  if (queue->ring) {
+    void* data;
+    while ((data = ring_try_pop(queue->ring)) != NULL) {
+      if (free_cb) free_cb(data);
+    }
+    ring_free(queue->ring);
+    delete queue->mutex;
+    osi_free(queue);
+    return;
+  }
+
   if (free_cb)
     for (const list_node_t* node = list_begin(queue->list);
          node != list_end(queue->list); node = list_next(node))
@@ -96,6 +179,8 @@ void fixed_queue_flush(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
 bool fixed_queue_is_empty(fixed_queue_t* queue) {
   if (queue == NULL) return true;
 
+  if (queue->ring) return ring_peek(queue->ring) == NULL;
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list);
 }
@@ -103,6 +188,8 @@ bool fixed_queue_is_empty(fixed_queue_t* queue) {
 size_t fixed_queue_length(fixed_queue_t* queue) {
   if (queue == NULL) return 0;
 
+  if (queue->ring) return ring_length(queue->ring);
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_length(queue->list);
 }
@@ -117,6 +204,25 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) {
+    ring_t* ring = queue->ring;
+    while (!ring_try_push(ring, data)) {
+      // The ring is full; sleep until the consumer frees up a slot. The waiter
+      // count is published before re-checking so the consumer cannot miss us.
+      std::unique_lock<std::mutex> lock(*queue->mutex);
+      ring->enqueue_waiters.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (ring_try_push(ring, data)) {
+        ring->enqueue_waiters.fetch_sub(1);
+        break;
+      }
+      ring->not_full->wait(lock);
+      ring->enqueue_waiters.fetch_sub(1);
+    }
+    ring_signal(ring);
+    return;
+  }
+
   semaphore_wait(queue->enqueue_sem);
 
   {
@@ -130,6 +236,21 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_dequeue(fixed_queue_t* queue) {
   CHECK(queue != NULL);
 
+  if (queue->ring) {
+    ring_t* ring = queue->ring;
+    void* ret;
+    while ((ret = ring_try_pop(ring)) == NULL) {
+      // Re-arm the wakeup before re-checking, then block on the eventfd.
+      ring_clear_signal(ring);
+      if ((ret = ring_try_pop(ring)) != NULL) break;
+
+      struct pollfd pfd = {.fd = ring->event_fd, .events = POLLIN};
+      OSI_NO_INTR(poll(&pfd, 1, -1));
+    }
+    ring_wake_enqueue_waiters(queue);
+    return ret;
+  }
+
   semaphore_wait(queue->dequeue_sem);
 
   void* ret = NULL;
@@ -148,6 +269,12 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) {
+    if (!ring_try_push(queue->ring, data)) return false;
+    ring_signal(queue->ring);
+    return true;
+  }
+
   if (!semaphore_try_wait(queue->enqueue_sem)) return false;
 
   {
@@ -162,6 +289,12 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    void* ret = ring_try_pop(queue->ring);
+    if (ret != NULL) ring_wake_enqueue_waiters(queue);
+    return ret;
+  }
+
   if (!semaphore_try_wait(queue->dequeue_sem)) return NULL;
 
   void* ret = NULL;
@@ -179,12 +312,15 @@ void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) return ring_peek(queue->ring);
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_front(queue->list);
 }
 
 void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
+  CHECK(queue->ring == NULL);
 
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_back(queue->list);
@@ -192,6 +328,7 @@ void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
 
 void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
   if (queue == NULL) return NULL;
+  CHECK(queue->ring == NULL);
 
   bool removed = false;
   {
@@ -212,6 +349,7 @@ void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
 
 list_t* fixed_queue_get_list(fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  CHECK(queue->ring == NULL);
 
   // NOTE: Using the list in this way is not thread-safe.
   // Using this list in any context where threads can call other functions
@@ -221,11 +359,13 @@ list_t* fixed_queue_get_list(fixed_queue_t* queue) {
 
 int fixed_queue_get_dequeue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  if (queue->ring) return queue->ring->event_fd;
   return semaphore_get_fd(queue->dequeue_sem);
 }
 
 int fixed_queue_get_enqueue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  CHECK(queue->ring == NULL);
   return semaphore_get_fd(queue->enqueue_sem);
 }
 
@@ -252,11 +392,166 @@ void fixed_queue_unregister_dequeue(fixed_queue_t* queue) {
     reactor_unregister(queue->dequeue_object);
     queue->dequeue_object = NULL;
   }
+  if (queue->dequeue_unregistered) {
+    *queue->dequeue_unregistered = true;
+    queue->dequeue_unregistered = NULL;
+  }
 }
 
 static void internal_dequeue_ready(void* context) {
   CHECK(context != NULL);
 
   fixed_queue_t* queue = static_cast<fixed_queue_t*>(context);
-  queue->dequeue_ready(queue, queue->dequeue_context);
+  ring_t* ring = queue->ring;
+  if (!ring) {
+    queue->dequeue_ready(queue, queue->dequeue_context);
+    return;
+  }
+
+  // A single wakeup may stand for many enqueued elements. Consume it and keep
+  // invoking the callback while it makes progress, bounded by the capacity so
+  // that other reactor objects are not starved by a busy producer.
+  // The callback may unregister or free the queue, after which neither
+  // |queue| nor |ring| may be touched.
+  bool unregistered = false;
+  queue->dequeue_unregistered = &unregistered;
+  ring_clear_signal(ring);
+  for (size_t budget = queue->capacity; budget > 0; budget--) {
+    if (ring_peek(ring) == NULL) break;
+
+    size_t position = ring->dequeue_pos.load(std::memory_order_relaxed);
+    queue->dequeue_ready(queue, queue->dequeue_context);
+    if (unregistered) return;
+    if (ring->dequeue_pos.load(std::memory_order_relaxed) == position) break;
+  }
+  queue->dequeue_unregistered = NULL;
+
+  // Elements are left over, either because the callback did not consume one
+  // or because the budget ran out. Stay readable like the semaphore would.
+  if (ring_peek(ring) != NULL) ring_signal(ring);
+}
+
+// The ring is the bounded queue by Dmitry Vyukov: every cell carries a
+// sequence number equal to the position that may next write (|pos|) or read
+// (|pos| + 1) it. Producers claim a position with a CAS (or a plain store
+// when there is a single producer), the consumer likewise, and neither side
+// ever takes a lock.
+static ring_t* ring_new(size_t capacity, bool multi_producer) {
+  ring_t* ring = new ring_t();
+  ring->cells = new ring_cell_t[capacity];
+  for (size_t i = 0; i < capacity; i++) {
+    ring->cells[i].sequence.store(i, std::memory_order_relaxed);
+    ring->cells[i].data = NULL;
+  }
+  ring->mask = capacity - 1;
+  ring->multi_producer = multi_producer;
+  ring->enqueue_pos.store(0, std::memory_order_relaxed);
+  ring->dequeue_pos.store(0, std::memory_order_relaxed);
+  ring->signaled.store(false, std::memory_order_relaxed);
+  ring->enqueue_waiters.store(0, std::memory_order_relaxed);
+  ring->not_full = new std::condition_variable;
+
+  ring->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (ring->event_fd == INVALID_FD) {
+    ring_free(ring);
+    return NULL;
+  }
+  return ring;
+}
+
+static void ring_free(ring_t* ring) {
+  if (!ring) return;
+
+  if (ring->event_fd != INVALID_FD) close(ring->event_fd);
+  delete ring->not_full;
+  delete[] ring->cells;
+  delete ring;
+}
+
+static bool ring_try_push(ring_t* ring, void* data) {
+  size_t pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+  ring_cell_t* cell;
+  while (true) {
+    cell = &ring->cells[pos & ring->mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0) {
+      if (!ring->multi_producer) {
+        ring->enqueue_pos.store(pos + 1, std::memory_order_relaxed);
+        break;
+      }
+      if (ring->enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return false;  // Full
+    } else {
+      pos = ring->enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  cell->data = data;
+  cell->sequence.store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+static void* ring_try_pop(ring_t* ring) {
+  size_t pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+  ring_cell_t* cell;
+  while (true) {
+    cell = &ring->cells[pos & ring->mask];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+    if (diff == 0) {
+      if (ring->dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                                                  std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      return NULL;  // Empty
+    } else {
+      pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+    }
+  }
+
+  void* data = cell->data;
+  cell->sequence.store(pos + ring->mask + 1, std::memory_order_release);
+  return data;
+}
+
+static void* ring_peek(ring_t* ring) {
+  size_t pos = ring->dequeue_pos.load(std::memory_order_relaxed);
+  ring_cell_t* cell = &ring->cells[pos & ring->mask];
+  if (cell->sequence.load(std::memory_order_acquire) != pos + 1) return NULL;
+  return cell->data;
+}
+
+static size_t ring_length(const ring_t* ring) {
+  size_t dequeue_pos = ring->dequeue_pos.load(std::memory_order_acquire);
+  size_t enqueue_pos = ring->enqueue_pos.load(std::memory_order_acquire);
+  return (enqueue_pos > dequeue_pos) ? (enqueue_pos - dequeue_pos) : 0;
+}
+
+static void ring_signal(ring_t* ring) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (ring->signaled.exchange(true)) return;
+
+  if (eventfd_write(ring->event_fd, 1ULL) == -1)
+    LOG(ERROR) << __func__ << ": unable to signal queue: " << strerror(errno);
+}
+
+// Consumes a pending wakeup. Callers must re-check the ring afterwards, since
+// elements enqueued before this point did not write to the eventfd.
+static void ring_clear_signal(ring_t* ring) {
+  eventfd_t value;
+  eventfd_read(ring->event_fd, &value);
+  ring->signaled.store(false);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+static void ring_wake_enqueue_waiters(fixed_queue_t* queue) {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (queue->ring->enqueue_waiters.load() == 0) return;
+
+  std::lock_guard<std::mutex> lock(*queue->mutex);
+  queue->ring->not_full->notify_all();
 }
@@ -36,6 +36,7 @@
 #include "osi/include/compat.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
+#include "osi/include/osi.h"
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
@@ -60,7 +61,7 @@ typedef struct {
 } work_item_t;
 
 static void* run_thread(void* start_arg);
-static void work_queue_read_cb(void* context);
+static void work_queue_ready(fixed_queue_t* queue, void* context);
 
 static const size_t DEFAULT_WORK_QUEUE_CAPACITY = 128;
 
@@ -73,7 +74,13 @@ thread_t* thread_new_sized(const char* name, size_t work_queue_capacity) {
   ret->reactor = reactor_new();
   if (!ret->reactor) goto error;
 
-  ret->work_queue = fixed_queue_new(work_queue_capacity);
+  // Work items may be posted from any thread but are only ever consumed by
+  // this one, so bounded work queues use the lock-free multi-producer ring.
+  if (work_queue_capacity <= FIXED_QUEUE_LOCKFREE_MAX_CAPACITY) {
+    ret->work_queue = fixed_queue_new_lockfree(work_queue_capacity, true);
+  } else {
+    ret->work_queue = fixed_queue_new(work_queue_capacity);
+  }
   if (!ret->work_queue) goto error;
 
   // Start is on the stack, but we use a semaphore, so it's safe
@@ -213,13 +220,10 @@ static void* run_thread(void* start_arg) {
 
   semaphore_post(start->start_sem);
 
-  int fd = fixed_queue_get_dequeue_fd(thread->work_queue);
-  void* context = thread->work_queue;
-
-  reactor_object_t* work_queue_object =
-      reactor_register(thread->reactor, fd, context, work_queue_read_cb, NULL);
+  fixed_queue_register_dequeue(thread->work_queue, thread->reactor,
+                               work_queue_ready, NULL);
   reactor_start(thread->reactor);
-  reactor_unregister(work_queue_object);
+  fixed_queue_unregister_dequeue(thread->work_queue);
 
   // Make sure we dispatch all queued work items before exiting the thread.
   // This allows a caller to safely tear down by enqueuing a teardown
@@ -243,11 +247,12 @@ static void* run_thread(void* start_arg) {
   return NULL;
 }
 
-static void work_queue_read_cb(void* context) {
-  CHECK(context != NULL);
+static void work_queue_ready(fixed_queue_t* queue,
+                             UNUSED_ATTR void* context) {
+  CHECK(queue != NULL);
 
-  fixed_queue_t* queue = (fixed_queue_t*)context;
-  work_item_t* item = static_cast<work_item_t*>(fixed_queue_dequeue(queue));
+  work_item_t* item = static_cast<work_item_t*>(fixed_queue_try_dequeue(queue));
+  if (item == NULL) return;
   item->func(item->context);
   osi_free(item);
 }
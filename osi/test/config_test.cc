@@ -249,6 +249,23 @@ TEST_F(ConfigTest, config_save_basic) {
   EXPECT_TRUE(config_save(*config, CONFIG_FILE));
 }
 
+TEST_F(ConfigTest, config_save_keeps_insertion_order) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  config_set_string(config.get(), "B", "y", "1");
+  config_set_string(config.get(), "A", "x", "2");
+  config_set_string(config.get(), "B", "x", "3");
+  config_set_string(config.get(), "C", "z", "4");
+  config_remove_section(config.get(), "A");
+  config_set_string(config.get(), "A", "x", "5");
+  config_set_string(config.get(), "B", "y", "6");
+  EXPECT_TRUE(config_save(*config, CONFIG_FILE));
+
+  std::string content;
+  EXPECT_TRUE(base::ReadFileToString(base::FilePath(CONFIG_FILE), &content));
+  EXPECT_EQ(content, "[B]\ny = 6\nx = 3\n\n[C]\nz = 4\n\n[A]\nx = 5\n\n");
+  EXPECT_EQ(config_get_int(*config, "A", "x", 0), 5);
+}
+
 TEST_F(ConfigTest, checksum_read) {
   auto tmp_dir = std::filesystem::temp_directory_path();
   auto filename = tmp_dir / "test.checksum";
@@ -275,3 +292,80 @@ TEST_F(ConfigTest, checksum_save) {
 
   EXPECT_TRUE(std::filesystem::remove(filename));
 }
+
+TEST_F(ConfigTest, config_journal_replay) {
+  std::unique_ptr<config_t> saved = config_new(CONFIG_FILE);
+  std::unique_ptr<config_t> config = config_new_clone(*saved);
+  config_set_int(config.get(), "DID", "version", 0x1437);
+  config_set_string(config.get(), "00:11:22:33:44:55", "Name", "Headset");
+  config_remove_key(config.get(), "DID", "productId");
+  config_remove_section(config.get(), CONFIG_DEFAULT_SECTION);
+  EXPECT_TRUE(config_journal_append(*saved, *config, CONFIG_FILE));
+
+  std::unique_ptr<config_t> loaded = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(loaded.get(), CONFIG_FILE), 4u);
+  EXPECT_EQ(config_get_int(*loaded, "DID", "version", 0), 0x1437);
+  EXPECT_EQ(*config_get_string(*loaded, "00:11:22:33:44:55", "Name", nullptr),
+            "Headset");
+  EXPECT_FALSE(config_has_key(*loaded, "DID", "productId"));
+  EXPECT_FALSE(config_has_section(*loaded, CONFIG_DEFAULT_SECTION));
+  EXPECT_TRUE(config_has_key(*loaded, "DID", "primaryRecord"));
+
+  EXPECT_TRUE(config_journal_remove(CONFIG_FILE));
+  EXPECT_EQ(config_journal_size(CONFIG_FILE), 0u);
+}
+
+TEST_F(ConfigTest, config_journal_append_unchanged) {
+  std::unique_ptr<config_t> config = config_new(CONFIG_FILE);
+  EXPECT_TRUE(config_journal_append(*config, *config, CONFIG_FILE));
+  EXPECT_EQ(config_journal_size(CONFIG_FILE), 0u);
+}
+
+TEST_F(ConfigTest, config_journal_torn_record) {
+  std::unique_ptr<config_t> saved = config_new(CONFIG_FILE);
+  std::unique_ptr<config_t> config = config_new_clone(*saved);
+  config_set_string(config.get(), "DID", "version", "1");
+  EXPECT_TRUE(config_journal_append(*saved, *config, CONFIG_FILE));
+  size_t intact_size = config_journal_size(CONFIG_FILE);
+
+  std::unique_ptr<config_t> torn = config_new_clone(*config);
+  config_set_string(torn.get(), "DID", "version", "2");
+  EXPECT_TRUE(config_journal_append(*config, *torn, CONFIG_FILE));
+  std::filesystem::resize_file(kConfigFile.string() + ".journal",
+                               config_journal_size(CONFIG_FILE) - 1);
+
+  std::unique_ptr<config_t> loaded = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(loaded.get(), CONFIG_FILE), 1u);
+  EXPECT_EQ(*config_get_string(*loaded, "DID", "version", nullptr), "1");
+  EXPECT_EQ(config_journal_size(CONFIG_FILE), intact_size);
+
+  // Records appended after the torn one was dropped are replayed.
+  config_set_string(torn.get(), "DID", "version", "3");
+  EXPECT_TRUE(config_journal_append(*loaded, *torn, CONFIG_FILE));
+  loaded = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(loaded.get(), CONFIG_FILE), 2u);
+  EXPECT_EQ(*config_get_string(*loaded, "DID", "version", nullptr), "3");
+
+  EXPECT_TRUE(config_journal_remove(CONFIG_FILE));
+}
+
+TEST_F(ConfigTest, config_journal_replay_after_compaction) {
+  std::unique_ptr<config_t> saved = config_new(CONFIG_FILE);
+  std::unique_ptr<config_t> config = config_new_clone(*saved);
+  config_set_string(config.get(), "DID", "version", "0x1437");
+  config_remove_key(config.get(), "DID", "productId");
+  config_set_string(config.get(), CONFIG_DEFAULT_SECTION, "first_key", "new");
+  EXPECT_TRUE(config_journal_append(*saved, *config, CONFIG_FILE));
+  EXPECT_TRUE(config_save(*config, CONFIG_FILE));
+
+  // A crash before the journal is removed replays it onto the compacted file.
+  std::unique_ptr<config_t> loaded = config_new(CONFIG_FILE);
+  EXPECT_EQ(config_journal_replay(loaded.get(), CONFIG_FILE), 3u);
+  EXPECT_EQ(*config_get_string(*loaded, "DID", "version", nullptr), "0x1437");
+  EXPECT_FALSE(config_has_key(*loaded, "DID", "productId"));
+  EXPECT_EQ(*config_get_string(*loaded, CONFIG_DEFAULT_SECTION, "first_key",
+                               nullptr),
+            "new");
+
+  EXPECT_TRUE(config_journal_remove(CONFIG_FILE));
+}
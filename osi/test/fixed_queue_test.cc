@@ -348,3 +348,210 @@ TEST_F(FixedQueueTest, test_fixed_queue_register_dequeue) {
   thread_free(worker_thread);
   fixed_queue_free(queue, NULL);
 }
+
+TEST_F(FixedQueueTest, test_fixed_queue_lockfree_new_free) {
+  // Test a queue of some size, the capacity is rounded up to a power of two
+  fixed_queue_t* queue = fixed_queue_new_lockfree(TEST_QUEUE_SIZE, false);
+  ASSERT_TRUE(queue != NULL);
+  EXPECT_EQ((size_t)16, fixed_queue_capacity(queue));
+  fixed_queue_free(queue, NULL);
+
+  // Test a corner case: queue of size 1
+  queue = fixed_queue_new_lockfree(1, true);
+  ASSERT_TRUE(queue != NULL);
+  EXPECT_EQ((size_t)1, fixed_queue_capacity(queue));
+  fixed_queue_free(queue, NULL);
+
+  // Test free-ing a non-empty queue with a callback
+  test_queue_entry_free_counter = 0;
+  queue = fixed_queue_new_lockfree(TEST_QUEUE_SIZE, true);
+  ASSERT_TRUE(queue != NULL);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  fixed_queue_free(queue, test_queue_entry_free_cb);
+  EXPECT_EQ(2, test_queue_entry_free_counter);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lockfree_enqueue_dequeue) {
+  fixed_queue_t* queue = fixed_queue_new_lockfree(TEST_QUEUE_SIZE, false);
+  ASSERT_TRUE(queue != NULL);
+  size_t capacity = fixed_queue_capacity(queue);
+
+  // Test blocking enqueue and blocking dequeue
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING);
+  EXPECT_EQ((size_t)1, fixed_queue_length(queue));
+  EXPECT_FALSE(fixed_queue_is_empty(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING, fixed_queue_dequeue(queue));
+  EXPECT_EQ((size_t)0, fixed_queue_length(queue));
+  EXPECT_TRUE(fixed_queue_is_empty(queue));
+
+  // Test that elements come out in order and peek sees the head
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_try_peek_first(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_try_dequeue(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING2, fixed_queue_try_dequeue(queue));
+  EXPECT_EQ(NULL, fixed_queue_try_peek_first(queue));
+
+  // Test non-blocking enqueue beyond queue capacity
+  for (size_t i = 0; i < capacity; i++) {
+    EXPECT_TRUE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+  }
+  EXPECT_FALSE(fixed_queue_try_enqueue(queue, (void*)DUMMY_DATA_STRING));
+  EXPECT_EQ(capacity, fixed_queue_length(queue));
+
+  // Test flushing a full queue
+  test_queue_entry_free_counter = 0;
+  fixed_queue_flush(queue, test_queue_entry_free_cb);
+  EXPECT_EQ((int)capacity, test_queue_entry_free_counter);
+  EXPECT_EQ(NULL, fixed_queue_try_dequeue(queue));
+
+  fixed_queue_free(queue, NULL);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lockfree_dequeue_fd) {
+  fixed_queue_t* queue = fixed_queue_new_lockfree(TEST_QUEUE_SIZE, false);
+  ASSERT_TRUE(queue != NULL);
+
+  int dequeue_fd = fixed_queue_get_dequeue_fd(queue);
+  EXPECT_TRUE(dequeue_fd >= 0);
+  EXPECT_FALSE(is_fd_readable(dequeue_fd));
+
+  // Several enqueues are coalesced into a single readable state
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  EXPECT_TRUE(is_fd_readable(dequeue_fd));
+
+  // Blocking dequeue drains the queue and consumes the wakeup
+  EXPECT_EQ(DUMMY_DATA_STRING1, fixed_queue_dequeue(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING2, fixed_queue_dequeue(queue));
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING3);
+  EXPECT_EQ(DUMMY_DATA_STRING3, fixed_queue_dequeue(queue));
+
+  fixed_queue_free(queue, NULL);
+}
+
+static void fixed_queue_lockfree_ready(fixed_queue_t* queue, void* context) {
+  int* remaining = static_cast<int*>(context);
+  void* msg = fixed_queue_try_dequeue(queue);
+  EXPECT_TRUE(msg != NULL);
+  if (--(*remaining) == 0) future_ready(received_message_future, msg);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lockfree_register_dequeue) {
+  static const int kMessages = 1000;
+  fixed_queue_t* queue = fixed_queue_new_lockfree(TEST_QUEUE_SIZE, true);
+  ASSERT_TRUE(queue != NULL);
+
+  received_message_future = future_new();
+  ASSERT_TRUE(received_message_future != NULL);
+
+  thread_t* worker_thread = thread_new("test_fixed_queue_worker_thread");
+  ASSERT_TRUE(worker_thread != NULL);
+
+  int remaining = kMessages;
+  fixed_queue_register_dequeue(queue, thread_get_reactor(worker_thread),
+                               fixed_queue_lockfree_ready, &remaining);
+
+  // Enqueue more messages than fit in the queue, so the producer has to block
+  // until the reactor callback drains a batch.
+  for (int i = 0; i < kMessages; i++) {
+    fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING);
+  }
+  const char* msg = (const char*)future_await(received_message_future);
+  EXPECT_EQ(DUMMY_DATA_STRING, msg);
+  EXPECT_EQ(0, remaining);
+
+  fixed_queue_unregister_dequeue(queue);
+  thread_free(worker_thread);
+  fixed_queue_free(queue, NULL);
+}
+
+static void block_worker(void* context) {
+  future_await(static_cast<future_t*>(context));
+}
+
+// Enqueues three elements while |worker_thread| is busy, so that its reactor
+// sees all of them in one wakeup.
+static void enqueue_while_worker_blocked(thread_t* worker_thread,
+                                         fixed_queue_t* queue) {
+  future_t* unblock = future_new();
+  ASSERT_TRUE(unblock != NULL);
+  thread_post(worker_thread, block_worker, unblock);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING1);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING2);
+  fixed_queue_enqueue(queue, (void*)DUMMY_DATA_STRING3);
+  future_ready(unblock, NULL);
+}
+
+static void fixed_queue_lockfree_unregister_ready(fixed_queue_t* queue,
+                                                  void* context) {
+  int* calls = static_cast<int*>(context);
+  (*calls)++;
+  void* msg = fixed_queue_try_dequeue(queue);
+  EXPECT_TRUE(msg != NULL);
+  fixed_queue_unregister_dequeue(queue);
+  future_ready(received_message_future, msg);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lockfree_unregister_in_callback) {
+  fixed_queue_t* queue = fixed_queue_new_lockfree(TEST_QUEUE_SIZE, false);
+  ASSERT_TRUE(queue != NULL);
+
+  received_message_future = future_new();
+  ASSERT_TRUE(received_message_future != NULL);
+
+  thread_t* worker_thread = thread_new("test_fixed_queue_worker_thread");
+  ASSERT_TRUE(worker_thread != NULL);
+
+  int calls = 0;
+  fixed_queue_register_dequeue(queue, thread_get_reactor(worker_thread),
+                               fixed_queue_lockfree_unregister_ready, &calls);
+
+  // All three are ready in one wakeup, but the batch must stop after the
+  // callback unregisters.
+  enqueue_while_worker_blocked(worker_thread, queue);
+  const char* msg = (const char*)future_await(received_message_future);
+  EXPECT_EQ(DUMMY_DATA_STRING1, msg);
+
+  // Let the worker finish the reactor iteration before checking
+  thread_free(worker_thread);
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(2U, fixed_queue_length(queue));
+  EXPECT_EQ(DUMMY_DATA_STRING2, fixed_queue_try_dequeue(queue));
+
+  fixed_queue_free(queue, NULL);
+}
+
+static void fixed_queue_lockfree_free_ready(fixed_queue_t* queue,
+                                            void* context) {
+  int* calls = static_cast<int*>(context);
+  (*calls)++;
+  void* msg = fixed_queue_try_dequeue(queue);
+  EXPECT_TRUE(msg != NULL);
+  fixed_queue_free(queue, test_queue_entry_free_cb);
+  future_ready(received_message_future, msg);
+}
+
+TEST_F(FixedQueueTest, test_fixed_queue_lockfree_free_in_callback) {
+  fixed_queue_t* queue = fixed_queue_new_lockfree(TEST_QUEUE_SIZE, false);
+  ASSERT_TRUE(queue != NULL);
+
+  received_message_future = future_new();
+  ASSERT_TRUE(received_message_future != NULL);
+
+  thread_t* worker_thread = thread_new("test_fixed_queue_worker_thread");
+  ASSERT_TRUE(worker_thread != NULL);
+
+  int calls = 0;
+  test_queue_entry_free_counter = 0;
+  fixed_queue_register_dequeue(queue, thread_get_reactor(worker_thread),
+                               fixed_queue_lockfree_free_ready, &calls);
+  enqueue_while_worker_blocked(worker_thread, queue);
+  const char* msg = (const char*)future_await(received_message_future);
+  EXPECT_EQ(DUMMY_DATA_STRING1, msg);
+
+  thread_free(worker_thread);
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(2, test_queue_entry_free_counter);
+}
@@ -467,6 +467,33 @@ void avdt_ad_tc_data_ind(AvdtpTransportChannel* p_tbl, BT_HDR* p_buf) {
   avdt_scb_event(p_scb, AVDT_SCB_TC_DATA_EVT, (tAVDT_SCB_EVT*)&p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         avdt_ad_tc_tx_complete
+ *
+ * Description      This function is called by the L2CAP interface layer when
+ *                  L2CAP has sent SDUs of a channel to the controller.  If
+ *                  the channel is the media channel of a stream, the SCB
+ *                  application is told how many were sent.
+ *
+ *
+ * Returns          Nothing.
+ *
+ ******************************************************************************/
+void avdt_ad_tc_tx_complete(AvdtpTransportChannel* p_tbl, uint16_t num_sdu) {
+  /* the signaling channel is not tracked */
+  if (p_tbl->tcid == 0) return;
+
+  AvdtpScb* p_scb = avdtp_cb.ad.LookupAvdtpScb(*p_tbl);
+  if (p_scb == nullptr) return;
+  if (avdt_ad_tcid_to_type(p_tbl->tcid) != AVDT_CHAN_MEDIA) return;
+
+  if (p_scb->stream_config.p_tx_complete_cback != nullptr) {
+    (*p_scb->stream_config.p_tx_complete_cback)(avdt_scb_to_hdl(p_scb),
+                                                num_sdu);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         avdt_ad_write_req
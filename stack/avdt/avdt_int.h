@@ -962,6 +962,8 @@ extern void avdt_ad_tc_open_ind(AvdtpTransportChannel* p_tbl);
 extern void avdt_ad_tc_cong_ind(AvdtpTransportChannel* p_tbl,
                                 bool is_congested);
 extern void avdt_ad_tc_data_ind(AvdtpTransportChannel* p_tbl, BT_HDR* p_buf);
+extern void avdt_ad_tc_tx_complete(AvdtpTransportChannel* p_tbl,
+                                   uint16_t num_sdu);
 extern AvdtpTransportChannel* avdt_ad_tc_tbl_by_type(uint8_t type,
                                                      AvdtpCcb* p_ccb,
                                                      AvdtpScb* p_scb);
@@ -47,6 +47,7 @@ void avdt_l2c_disconnect_ind_cback(uint16_t lcid, bool ack_needed);
 void avdt_l2c_disconnect_cfm_cback(uint16_t lcid, uint16_t result);
 void avdt_l2c_congestion_ind_cback(uint16_t lcid, bool is_congested);
 void avdt_l2c_data_ind_cback(uint16_t lcid, BT_HDR* p_buf);
+void avdt_l2c_tx_complete_cback(uint16_t lcid, uint16_t num_sdu);
 
 /* L2CAP callback function structure */
 const tL2CAP_APPL_INFO avdt_l2c_appl = {avdt_l2c_connect_ind_cback,
@@ -59,7 +60,7 @@ const tL2CAP_APPL_INFO avdt_l2c_appl = {avdt_l2c_connect_ind_cback,
                                         NULL,
                                         avdt_l2c_data_ind_cback,
                                         avdt_l2c_congestion_ind_cback,
-                                        NULL, /* tL2CA_TX_COMPLETE_CB */
+                                        avdt_l2c_tx_complete_cback,
                                         NULL /* tL2CA_CREDITS_RECEIVED_CB */};
 
 /*******************************************************************************
@@ -515,3 +516,23 @@ void avdt_l2c_data_ind_cback(uint16_t lcid, BT_HDR* p_buf) {
   } else /* prevent buffer leak */
     osi_free(p_buf);
 }
+
+/*******************************************************************************
+ *
+ * Function         avdt_l2c_tx_complete_cback
+ *
+ * Description      This is the L2CAP transmit complete callback function.
+ *
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void avdt_l2c_tx_complete_cback(uint16_t lcid, uint16_t num_sdu) {
+  AvdtpTransportChannel* p_tbl;
+
+  /* look up info for this channel */
+  p_tbl = avdt_ad_tc_tbl_by_lcid(lcid);
+  if (p_tbl != NULL) {
+    avdt_ad_tc_tx_complete(p_tbl, num_sdu);
+  }
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "btm/btm_ble_adv_cache.h"
+
+using ::benchmark::State;
+
+#define ADV_DATA_LEN 31
+#define NUM_REPORTS 20000
+
+namespace {
+
+// The cache as it was before, a list of at most 7 devices searched linearly.
+class ListAdvertisingCache {
+ public:
+  const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
+                                  std::vector<uint8_t> data) {
+    auto it = Find(addr_type, addr);
+    if (it != items.end()) {
+      it->data = std::move(data);
+      return it->data;
+    }
+    if (items.size() > cache_max) items.pop_back();
+    items.emplace_front(addr_type, addr, std::move(data));
+    return items.front().data;
+  }
+
+  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
+                                     std::vector<uint8_t> data) {
+    auto it = Find(addr_type, addr);
+    if (it != items.end()) {
+      it->data.insert(it->data.end(), data.begin(), data.end());
+      return it->data;
+    }
+    if (items.size() > cache_max) items.pop_back();
+    items.emplace_front(addr_type, addr, std::move(data));
+    return items.front().data;
+  }
+
+  void Clear(uint8_t addr_type, const RawAddress& addr) {
+    auto it = Find(addr_type, addr);
+    if (it != items.end()) items.erase(it);
+  }
+
+ private:
+  struct Item {
+    uint8_t addr_type;
+    RawAddress addr;
+    std::vector<uint8_t> data;
+
+    Item(uint8_t addr_type, const RawAddress& addr, std::vector<uint8_t> data)
+        : addr_type(addr_type), addr(addr), data(data) {}
+  };
+
+  std::list<Item>::iterator Find(uint8_t addr_type, const RawAddress& addr) {
+    for (auto it = items.begin(); it != items.end(); it++) {
+      if (it->addr_type == addr_type && it->addr == addr) return it;
+    }
+    return items.end();
+  }
+
+  const size_t cache_max = 7;
+  std::list<Item> items;
+};
+
+struct Report {
+  RawAddress addr;
+  // First report of a device's advertising data, or a continuation of it
+  bool is_start;
+  // Last report, after which the device would be reported to the upper layers
+  bool is_complete;
+  // Total length expected once the data is complete
+  size_t expected_len;
+  uint64_t time_ms;
+};
+
+// Builds a stream of reports as seen while actively scanning |num_devices|
+// advertisers. Each advertising event is followed by a scan response, or by
+// two chained packets for extended advertisers, after up to |max_lag| reports
+// from other devices.
+std::vector<Report> make_report_stream(int num_devices, int max_lag) {
+  srand(num_devices * 31 + max_lag);
+  std::multimap<int, Report> scheduled;
+  std::vector<bool> in_flight(num_devices);
+  std::vector<Report> reports;
+
+  for (int t = 0; reports.size() < NUM_REPORTS; t++) {
+    auto next = scheduled.begin();
+    if (next != scheduled.end() && next->first <= t) {
+      reports.push_back(next->second);
+      reports.back().time_ms = t / 4;
+      if (reports.back().is_complete) {
+        in_flight[reports.back().addr.address[4] << 8 |
+                  reports.back().addr.address[5]] = false;
+      }
+      scheduled.erase(next);
+      continue;
+    }
+
+    int device = rand() % num_devices;
+    if (in_flight[device]) continue;
+    in_flight[device] = true;
+
+    RawAddress addr({0x5a, 0x00, 0x00, 0x00, (uint8_t)(device >> 8),
+                     (uint8_t)device});
+    int fragments = device % 4 == 0 ? 3 : 2;
+    reports.push_back(
+        {addr, true, false, fragments * (size_t)ADV_DATA_LEN, (uint64_t)t / 4});
+    int when = t;
+    for (int i = 1; i < fragments; i++) {
+      when += 1 + rand() % (max_lag + 1);
+      scheduled.emplace(when, Report{addr, false, i == fragments - 1,
+                                     fragments * (size_t)ADV_DATA_LEN, 0});
+    }
+  }
+  return reports;
+}
+
+}  // namespace
+
+// Replays a report stream against the hashed cache. state.range(0) is the
+// number of advertisers, state.range(1) the cache capacity.
+static void BM_AdvertisingCacheReplay(State& state) {
+  std::vector<Report> reports = make_report_stream(state.range(0), 64);
+  uint8_t data[ADV_DATA_LEN] = {0x1e, 0xff};
+  AdvertisingCache cache(state.range(1), BTM_BLE_ADV_CACHE_MAX_AGE_MS);
+  uint64_t completed = 0, lost = 0;
+
+  for (auto _ : state) {
+    for (const Report& r : reports) {
+      const std::vector<uint8_t>& adv_data =
+          r.is_start ? cache.Set(0, r.addr, data, sizeof(data), r.time_ms)
+                     : cache.Append(0, r.addr, data, sizeof(data), r.time_ms);
+      if (!r.is_complete) continue;
+      if (adv_data.size() == r.expected_len) {
+        completed++;
+      } else {
+        lost++;
+      }
+      cache.Clear(0, r.addr);
+    }
+    // Devices still waiting when the stream ends, and the clock restarts
+    cache.ClearAll();
+  }
+
+  state.SetItemsProcessed(state.iterations() * reports.size());
+  state.counters["lost_ratio"] = (double)lost / (completed + lost);
+  state.counters["evicted"] =
+      (double)(cache.GetStats().evicted_full + cache.GetStats().evicted_aged) /
+      state.iterations();
+}
+
+// The same replay against the list based cache, which holds 7 devices
+static void BM_ListAdvertisingCacheReplay(State& state) {
+  std::vector<Report> reports = make_report_stream(state.range(0), 64);
+  uint8_t data[ADV_DATA_LEN] = {0x1e, 0xff};
+  ListAdvertisingCache cache;
+  uint64_t completed = 0, lost = 0;
+
+  for (auto _ : state) {
+    for (const Report& r : reports) {
+      std::vector<uint8_t> tmp(data, data + sizeof(data));
+      const std::vector<uint8_t>& adv_data =
+          r.is_start ? cache.Set(0, r.addr, std::move(tmp))
+                     : cache.Append(0, r.addr, std::move(tmp));
+      if (!r.is_complete) continue;
+      if (adv_data.size() == r.expected_len) {
+        completed++;
+      } else {
+        lost++;
+      }
+      cache.Clear(0, r.addr);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * reports.size());
+  state.counters["lost_ratio"] = (double)lost / (completed + lost);
+}
+
+BENCHMARK(BM_AdvertisingCacheReplay)
+    ->Args({8, BTM_BLE_ADV_CACHE_SIZE})
+    ->Args({64, BTM_BLE_ADV_CACHE_SIZE})
+    ->Args({256, BTM_BLE_ADV_CACHE_SIZE})
+    ->Args({256, 7});
+BENCHMARK(BM_ListAdvertisingCacheReplay)->Arg(8)->Arg(64)->Arg(256);
+
+BENCHMARK_MAIN();
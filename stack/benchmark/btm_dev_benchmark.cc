@@ -0,0 +1,167 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <base/logging.h>
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "btm_int.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+using ::benchmark::State;
+
+// The list predicates btm_find_dev and btm_find_dev_by_handle fall back to;
+// scanning with them is what every lookup cost before the indexes.
+extern bool is_address_equal(void* data, void* context);
+extern bool is_handle_equal(void* data, void* context);
+
+namespace {
+
+std::vector<RawAddress> g_addresses;
+std::vector<RawAddress> g_rpas;
+std::vector<uint16_t> g_handles;
+
+RawAddress make_address(int i) {
+  RawAddress bd_addr;
+  bd_addr.address[0] = 0x00;
+  bd_addr.address[1] = 0x11;
+  bd_addr.address[2] = 0x22;
+  bd_addr.address[3] = 0x33;
+  bd_addr.address[4] = i >> 8;
+  bd_addr.address[5] = i & 0xff;
+  return bd_addr;
+}
+
+// Builds an address resolvable with |irk|, see rpa_matches_irk
+RawAddress make_rpa(const Octet16& irk, int i) {
+  RawAddress rpa;
+  rpa.address[0] = 0x40 | (i & 0x3f);
+  rpa.address[1] = i >> 8;
+  rpa.address[2] = i & 0xff;
+  uint8_t prand[3] = {rpa.address[2], rpa.address[1], rpa.address[0]};
+  Octet16 x = crypto_toolbox::aes_128(irk, prand, 3);
+  rpa.address[3] = x[2];
+  rpa.address[4] = x[1];
+  rpa.address[5] = x[0];
+  return rpa;
+}
+
+// Fills the security database with |count| bonded LE peers, each with a
+// link, an identity address and an IRK.
+void populate(int count) {
+  if (btm_cb.sec_dev_rec == nullptr) btm_cb.sec_dev_rec = list_new(osi_free);
+  while (!list_is_empty(btm_cb.sec_dev_rec)) {
+    wipe_secrets_and_remove(
+        static_cast<tBTM_SEC_DEV_REC*>(list_front(btm_cb.sec_dev_rec)));
+  }
+  g_addresses.clear();
+  g_rpas.clear();
+  g_handles.clear();
+
+  for (int i = 0; i < count; i++) {
+    tBTM_SEC_DEV_REC* p_dev_rec = btm_sec_allocate_dev_rec();
+    p_dev_rec->bd_addr = make_address(i);
+    p_dev_rec->hci_handle = BTM_SEC_INVALID_HANDLE;
+    p_dev_rec->ble_hci_handle = 0x0040 + i;
+    p_dev_rec->device_type = BT_DEVICE_TYPE_BLE;
+    p_dev_rec->ble.key_type = BTM_LE_KEY_PID;
+    p_dev_rec->ble.keys.irk.fill(i + 1);
+
+    g_addresses.push_back(p_dev_rec->bd_addr);
+    g_handles.push_back(p_dev_rec->ble_hci_handle);
+    g_rpas.push_back(make_rpa(p_dev_rec->ble.keys.irk, i));
+  }
+}
+
+}  // namespace
+
+// Looks up each of state.range(0) records in turn, as HCI events for
+// different links would. state.range(1) selects a plain list scan (0), as
+// before the indexes, or the indexed lookup (1).
+static void BM_FindDevByAddress(State& state) {
+  populate(state.range(0));
+  bool indexed = state.range(1) != 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    RawAddress& bd_addr = g_addresses[i++ % g_addresses.size()];
+    if (indexed) {
+      benchmark::DoNotOptimize(btm_find_dev(bd_addr));
+    } else {
+      benchmark::DoNotOptimize(
+          list_foreach(btm_cb.sec_dev_rec, is_address_equal, &bd_addr));
+    }
+  }
+}
+
+static void BM_FindDevByHandle(State& state) {
+  populate(state.range(0));
+  bool indexed = state.range(1) != 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    uint16_t handle = g_handles[i++ % g_handles.size()];
+    if (indexed) {
+      benchmark::DoNotOptimize(btm_find_dev_by_handle(handle));
+    } else {
+      benchmark::DoNotOptimize(
+          list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle));
+    }
+  }
+}
+
+// Lookups by the current RPA of each peer. Resolving on the list scan costs
+// one AES operation per record tried.
+static void BM_FindDevByRpa(State& state) {
+  populate(state.range(0));
+  bool indexed = state.range(1) != 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    RawAddress& rpa = g_rpas[i++ % g_rpas.size()];
+    if (indexed) {
+      benchmark::DoNotOptimize(btm_find_dev(rpa));
+    } else {
+      benchmark::DoNotOptimize(
+          list_foreach(btm_cb.sec_dev_rec, is_address_equal, &rpa));
+    }
+  }
+}
+
+BENCHMARK(BM_FindDevByAddress)
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->Args({BTM_SEC_MAX_DEVICE_RECORDS, 0})
+    ->Args({BTM_SEC_MAX_DEVICE_RECORDS, 1});
+BENCHMARK(BM_FindDevByHandle)
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->Args({BTM_SEC_MAX_DEVICE_RECORDS, 0})
+    ->Args({BTM_SEC_MAX_DEVICE_RECORDS, 1});
+BENCHMARK(BM_FindDevByRpa)
+    ->Args({10, 0})
+    ->Args({10, 1})
+    ->Args({BTM_SEC_MAX_DEVICE_RECORDS, 0})
+    ->Args({BTM_SEC_MAX_DEVICE_RECORDS, 1});
+
+int main(int argc, char** argv) {
+  // Disable LOG() output from libchrome
+  logging::LoggingSettings log_settings;
+  log_settings.logging_dest = logging::LoggingDestination::LOG_NONE;
+  CHECK(logging::InitLogging(log_settings)) << "Failed to set up logging";
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "gd/crypto_toolbox/aes_engine.h"
+#include "stack/crypto_toolbox/aes.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+using ::benchmark::State;
+using bluetooth::crypto_toolbox::AesEngine;
+
+namespace {
+
+Octet16 make_octet16(uint8_t seed) {
+  Octet16 out;
+  for (size_t i = 0; i < OCTET16_LEN; i++) out[i] = seed + i * 7;
+  return out;
+}
+
+std::vector<uint8_t> make_message(size_t length) {
+  std::vector<uint8_t> message(length);
+  srand(length);
+  for (uint8_t& b : message) b = rand();
+  return message;
+}
+
+}  // namespace
+
+// The byte-oriented table implementation aes_128 used before, for reference
+static void BM_AesTable(State& state) {
+  Octet16 key = make_octet16(1);
+  Octet16 message = make_octet16(2);
+
+  for (auto _ : state) {
+    aes_context ctx;
+    Octet16 output;
+    aes_set_key(key.data(), key.size(), &ctx);
+    aes_encrypt(message.data(), output.data(), &ctx);
+    benchmark::DoNotOptimize(output);
+  }
+}
+
+static void BM_Aes128(State& state) {
+  Octet16 key = make_octet16(1);
+  Octet16 message = make_octet16(2);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crypto_toolbox::aes_128(key, message));
+  }
+}
+
+// aes_cmac over a message of state.range(0) bytes
+static void BM_AesCmac(State& state) {
+  Octet16 key = make_octet16(1);
+  std::vector<uint8_t> message = make_message(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        crypto_toolbox::aes_cmac(key, message.data(), message.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+
+// CMAC of state.range(0) bytes under an expanded key, with (1) or without (0)
+// hardware AES
+static void BM_AesEngineCmac(State& state) {
+  Octet16 key = make_octet16(1);
+  std::vector<uint8_t> message = make_message(state.range(0));
+  AesEngine engine(state.range(1) != 0);
+  engine.SetKeys(key.data(), 1);
+
+  for (auto _ : state) {
+    Octet16 mac;
+    engine.Cmac(message.data(), message.size(), mac.data());
+    benchmark::DoNotOptimize(mac);
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+}
+
+// SMP LE Secure Connections confirm value
+static void BM_F4(State& state) {
+  std::vector<uint8_t> u = make_message(BT_OCTET32_LEN);
+  std::vector<uint8_t> v = make_message(BT_OCTET32_LEN + 1);
+  Octet16 x = make_octet16(3);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crypto_toolbox::f4(u.data(), v.data(), x, 0));
+  }
+}
+
+// SMP LE Secure Connections MacKey and LTK generation
+static void BM_F5(State& state) {
+  std::vector<uint8_t> w = make_message(BT_OCTET32_LEN);
+  Octet16 n1 = make_octet16(4);
+  Octet16 n2 = make_octet16(5);
+  uint8_t a1[7] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00};
+  uint8_t a2[7] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x01};
+
+  for (auto _ : state) {
+    Octet16 mac_key, ltk;
+    crypto_toolbox::f5(w.data(), n1, n2, a1, a2, &mac_key, &ltk);
+    benchmark::DoNotOptimize(ltk);
+  }
+}
+
+// SMP LE Secure Connections check value
+static void BM_F6(State& state) {
+  Octet16 w = make_octet16(6);
+  Octet16 n1 = make_octet16(4);
+  Octet16 n2 = make_octet16(5);
+  Octet16 r = make_octet16(7);
+  uint8_t iocap[3] = {0x01, 0x01, 0x02};
+  uint8_t a1[7] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00};
+  uint8_t a2[7] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x01};
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crypto_toolbox::f6(w, n1, n2, r, iocap, a1, a2));
+  }
+}
+
+// SMP LE Secure Connections numeric comparison value
+static void BM_G2(State& state) {
+  std::vector<uint8_t> u = make_message(BT_OCTET32_LEN);
+  std::vector<uint8_t> v = make_message(BT_OCTET32_LEN + 1);
+  Octet16 x = make_octet16(3);
+  Octet16 y = make_octet16(8);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(crypto_toolbox::g2(u.data(), v.data(), x, y));
+  }
+}
+
+// Cross-transport key derivation, h6 (0) or h7 (1)
+static void BM_LinkKeyToLtk(State& state) {
+  Octet16 link_key = make_octet16(9);
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        crypto_toolbox::link_key_to_ltk(link_key, state.range(0) != 0));
+  }
+}
+
+BENCHMARK(BM_AesTable);
+BENCHMARK(BM_Aes128);
+BENCHMARK(BM_AesCmac)->Arg(16)->Arg(65)->Arg(512);
+BENCHMARK(BM_AesEngineCmac)
+    ->Args({65, 0})
+    ->Args({512, 0})
+    ->Args({65, 1})
+    ->Args({512, 1});
+BENCHMARK(BM_F4);
+BENCHMARK(BM_F5);
+BENCHMARK(BM_F6);
+BENCHMARK(BM_G2);
+BENCHMARK(BM_LinkKeyToLtk)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <list>
+
+#include "gatt/gatt_int.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+#define NUM_SERVICES 50
+#define NUM_ATTRIBUTES 2000
+
+tGATT_CB gatt_cb;
+
+namespace {
+
+std::list<tGATT_SVC_DB> databases;
+
+// Starts NUM_SERVICES services of NUM_ATTRIBUTES attributes in total, each a
+// run of characteristics with a value and a descriptor, as GATTS_AddService
+// would lay them out.
+void start_services() {
+  if (gatt_cb.srv_list_info != nullptr) return;
+  gatt_cb.srv_list_info = new std::list<tGATT_SRV_LIST_ELEM>();
+
+  uint16_t handle = 1;
+  int per_service = NUM_ATTRIBUTES / NUM_SERVICES;
+  for (int i = 0; i < NUM_SERVICES; i++) {
+    databases.emplace_back();
+    tGATT_SVC_DB& db = databases.back();
+    db.attr_list.reserve(per_service);
+
+    uint16_t s_hdl = handle;
+    for (int j = 0; j < per_service; j++) {
+      tGATT_ATTR attr;
+      attr.handle = handle++;
+      if (j == 0) {
+        attr.uuid = Uuid::From16Bit(GATT_UUID_PRI_SERVICE);
+      } else if (j % 3 == 1) {
+        attr.uuid = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+      } else if (j % 3 == 2) {
+        attr.uuid = Uuid::From16Bit(0x2a00 + i);
+      } else {
+        attr.uuid = Uuid::From16Bit(GATT_UUID_CHAR_CLIENT_CONFIG);
+      }
+      db.attr_list.push_back(std::move(attr));
+    }
+
+    tGATT_SRV_LIST_ELEM elem;
+    elem.s_hdl = s_hdl;
+    elem.e_hdl = handle - 1;
+    elem.p_db = &db;
+    elem.type = GATT_UUID_PRI_SERVICE;
+    gatt_cb.srv_list_info->push_back(elem);
+  }
+  gatt_sr_index_invalidate();
+}
+
+// Attribute lookup as gatts_process_attribute_req did it before the index
+const tGATT_ATTR* scan_find(uint16_t handle) {
+  for (auto& el : *gatt_cb.srv_list_info) {
+    if (el.s_hdl <= handle && el.e_hdl >= handle) {
+      for (const auto& attr : el.p_db->attr_list) {
+        if (attr.handle == handle) return &attr;
+      }
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+static void BM_HandleLookupScan(State& state) {
+  start_services();
+  uint16_t handle = 1;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scan_find(handle));
+    handle = handle % NUM_ATTRIBUTES + 1;
+  }
+}
+
+static void BM_HandleLookupIndex(State& state) {
+  start_services();
+  uint16_t handle = 1;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(gatt_sr_index_find(handle));
+    handle = handle % NUM_ATTRIBUTES + 1;
+  }
+}
+
+// Characteristic discovery of a whole server, one service at a time, as done
+// by clients: a read by type for characteristic declarations over each
+// service range. Counts the attributes matched.
+static void BM_ReadByTypeScan(State& state) {
+  start_services();
+  Uuid type = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+  for (auto _ : state) {
+    int found = 0;
+    for (const auto& range : *gatt_cb.srv_list_info) {
+      for (auto& el : *gatt_cb.srv_list_info) {
+        if (el.s_hdl > range.e_hdl || el.e_hdl < range.s_hdl) continue;
+        for (const auto& attr : el.p_db->attr_list) {
+          if (attr.handle >= range.s_hdl && attr.handle <= range.e_hdl &&
+              type == attr.uuid)
+            found++;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+}
+
+static void BM_ReadByTypeIndex(State& state) {
+  start_services();
+  Uuid type = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+  for (auto _ : state) {
+    int found = 0;
+    for (const auto& range : *gatt_cb.srv_list_info) {
+      for (const tGATT_SR_INDEX_ENTRY& entry :
+           gatt_sr_index_range_by_type(type, range.s_hdl, range.e_hdl)) {
+        benchmark::DoNotOptimize(entry.p_attr);
+        found++;
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+}
+
+// Descriptor discovery: a find information request over the few handles
+// following each characteristic value.
+static void BM_FindInfoScan(State& state) {
+  start_services();
+  for (auto _ : state) {
+    int found = 0;
+    for (uint16_t s_hdl = 3; s_hdl < NUM_ATTRIBUTES; s_hdl += 3) {
+      uint16_t e_hdl = s_hdl + 1;
+      for (auto& el : *gatt_cb.srv_list_info) {
+        if (el.s_hdl > e_hdl || el.e_hdl < s_hdl) continue;
+        for (const auto& attr : el.p_db->attr_list) {
+          if (attr.handle > e_hdl) break;
+          if (attr.handle >= s_hdl) found++;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+}
+
+static void BM_FindInfoIndex(State& state) {
+  start_services();
+  for (auto _ : state) {
+    int found = 0;
+    for (uint16_t s_hdl = 3; s_hdl < NUM_ATTRIBUTES; s_hdl += 3) {
+      for (const tGATT_SR_INDEX_ENTRY& entry :
+           gatt_sr_index_range(s_hdl, s_hdl + 1)) {
+        benchmark::DoNotOptimize(entry.p_attr);
+        found++;
+      }
+    }
+    benchmark::DoNotOptimize(found);
+  }
+}
+
+// Cost of rebuilding the index after a service is started or stopped
+static void BM_IndexRebuild(State& state) {
+  start_services();
+  for (auto _ : state) {
+    gatt_sr_index_invalidate();
+    benchmark::DoNotOptimize(gatt_sr_index_find(1));
+  }
+}
+
+BENCHMARK(BM_HandleLookupScan);
+BENCHMARK(BM_HandleLookupIndex);
+BENCHMARK(BM_ReadByTypeScan);
+BENCHMARK(BM_ReadByTypeIndex);
+BENCHMARK(BM_FindInfoScan);
+BENCHMARK(BM_FindInfoIndex);
+BENCHMARK(BM_IndexRebuild);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "stack/crypto_toolbox/aes_multi_key.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+using ::benchmark::State;
+
+namespace {
+
+std::vector<Octet16> make_irks(size_t count) {
+  std::vector<Octet16> irks(count);
+  srand(count);
+  for (Octet16& irk : irks) {
+    for (uint8_t& b : irk) b = rand();
+  }
+  return irks;
+}
+
+// An RPA that none of the IRKs resolves, so that every key is tried as for
+// most advertisements seen while scanning.
+Octet16 make_prand() {
+  Octet16 prand{0};
+  prand[0] = 0x12;
+  prand[1] = 0x34;
+  prand[2] = 0x56 | 0x40;
+  return prand;
+}
+
+}  // namespace
+
+// Resolves an RPA against state.range(0) IRKs with one aes_128 per key, as
+// btm_ble_resolve_random_addr did for each security record.
+static void BM_ResolveRpaPerKey(State& state) {
+  std::vector<Octet16> irks = make_irks(state.range(0));
+  Octet16 prand = make_prand();
+
+  for (auto _ : state) {
+    int matches = 0;
+    for (const Octet16& irk : irks) {
+      Octet16 x = crypto_toolbox::aes_128(irk, prand);
+      matches += x[0] == 0xff && x[1] == 0xff && x[2] == 0xff;
+    }
+    benchmark::DoNotOptimize(matches);
+  }
+  state.SetItemsProcessed(state.iterations() * irks.size());
+}
+
+// Resolves an RPA against state.range(0) IRKs whose key schedules were
+// expanded beforehand, with (1) or without (0) hardware AES.
+static void BM_ResolveRpaMultiKey(State& state) {
+  std::vector<Octet16> irks = make_irks(state.range(0));
+  Octet16 prand = make_prand();
+  crypto_toolbox::AesMultiKey keys(state.range(1) != 0);
+  keys.SetKeys(irks);
+  std::vector<Octet16> hashes(irks.size());
+
+  for (auto _ : state) {
+    keys.Encrypt(prand, hashes.data());
+    benchmark::DoNotOptimize(hashes.data());
+  }
+  state.SetItemsProcessed(state.iterations() * irks.size());
+}
+
+// Cost of rebuilding the table after the set of bonded devices changed
+static void BM_AesMultiKeySetKeys(State& state) {
+  std::vector<Octet16> irks = make_irks(state.range(0));
+  crypto_toolbox::AesMultiKey keys(state.range(1) != 0);
+
+  for (auto _ : state) keys.SetKeys(irks);
+  state.SetItemsProcessed(state.iterations() * irks.size());
+}
+
+BENCHMARK(BM_ResolveRpaPerKey)->Arg(1)->Arg(16)->Arg(100);
+BENCHMARK(BM_ResolveRpaMultiKey)
+    ->Args({1, 0})
+    ->Args({16, 0})
+    ->Args({100, 0})
+    ->Args({1, 1})
+    ->Args({16, 1})
+    ->Args({100, 1});
+BENCHMARK(BM_AesMultiKeySetKeys)->Args({100, 0})->Args({100, 1});
+
+BENCHMARK_MAIN();
@@ -24,6 +24,7 @@
 
 #include <base/bind.h>
 #include <string.h>
+#include <vector>
 
 #include "bt_types.h"
 #include "btm_int.h"
@@ -33,8 +34,93 @@
 #include "hcimsgs.h"
 
 #include "btm_ble_int.h"
+#include "stack/crypto_toolbox/aes_multi_key.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
+/* Size of the cache of resolved Resolvable Private Addresses, indexed by one
+ * byte of the address */
+#define BTM_BLE_RPA_CACHE_SIZE 256
+
+namespace {
+
+/* IRKs of the security records holding a peer identity key, in
+ * btm_cb.sec_dev_rec order, so that an RPA can be checked against all of them
+ * in one pass. Rebuilt on first use after btm_ble_irk_table_invalidate(). */
+struct IrkTable {
+  uint32_t generation = 1;
+  bool built = false;
+  std::vector<tBTM_SEC_DEV_REC*> records;
+  std::vector<Octet16> irks;
+  std::vector<Octet16> hashes;
+  crypto_toolbox::AesMultiKey keys;
+};
+
+IrkTable irk_table;
+
+/* Result of resolving an RPA against the IRK table of one generation: the
+ * index of the first IRK that resolves it, or -1. Unresolvable addresses are
+ * cached as well, as they are most of what a scan reports. */
+struct RpaCacheEntry {
+  RawAddress rpa;
+  uint32_t generation;
+  int index;
+};
+
+RpaCacheEntry rpa_cache[BTM_BLE_RPA_CACHE_SIZE];
+
+void build_irk_table() {
+  irk_table.records.clear();
+  irk_table.irks.clear();
+
+  list_node_t* end = list_end(btm_cb.sec_dev_rec);
+  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
+       node = list_next(node)) {
+    tBTM_SEC_DEV_REC* p_dev_rec =
+        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+    if (!(p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) continue;
+    irk_table.records.push_back(p_dev_rec);
+    irk_table.irks.push_back(p_dev_rec->ble.keys.irk);
+  }
+
+  irk_table.keys.SetKeys(irk_table.irks);
+  irk_table.hashes.resize(irk_table.irks.size());
+  irk_table.built = true;
+}
+
+/* Returns the index of the first IRK in the table resolving |rpa|, or -1 */
+int find_resolving_irk(const RawAddress& rpa) {
+  if (irk_table.irks.empty()) return -1;
+
+  /* use the 3 MSB of bd address as prand, see rpa_matches_irk() */
+  Octet16 prand{0};
+  prand[0] = rpa.address[2];
+  prand[1] = rpa.address[1];
+  prand[2] = rpa.address[0];
+  irk_table.keys.Encrypt(prand, irk_table.hashes.data());
+
+  for (size_t i = 0; i < irk_table.hashes.size(); i++) {
+    const Octet16& x = irk_table.hashes[i];
+    if (x[0] == rpa.address[5] && x[1] == rpa.address[4] &&
+        x[2] == rpa.address[3])
+      return i;
+  }
+  return -1;
+}
+
+}  // namespace
+
+/** Invalidates the IRK table and the cache of resolved RPAs. Must be called
+ * whenever a security record gains or loses a peer IRK, or is freed. */
+void btm_ble_irk_table_invalidate() {
+  irk_table.built = false;
+  irk_table.records.clear();
+  if (++irk_table.generation == 0) {
+    /* never reuse the generation of a cache entry */
+    memset(rpa_cache, 0, sizeof(rpa_cache));
+    irk_table.generation = 1;
+  }
+}
+
 /* This function generates Resolvable Private Address (RPA) from Identity
  * Resolving Key |irk| and |random|*/
 RawAddress generate_rpa_from_irk_and_rand(const Octet16& irk,
@@ -245,6 +331,16 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
   return true;
 }
 
+/** Resolves |random_bda| by checking it against every security record in
+ * turn, for when the IRK table can not be used. */
+static tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr_by_scan(
+    const RawAddress& random_bda) {
+  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
+                                (void*)&random_bda);
+  if (n == nullptr) return nullptr;
+  return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+}
+
 /** This function is called to resolve a random address.
  * Returns pointer to the security record of the device whom a random address is
  * matched to.
@@ -252,13 +348,30 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   BTM_TRACE_EVENT("%s", __func__);
 
-  /* start to resolve random address */
-  /* check for next security record */
+  if (!irk_table.built) build_irk_table();
+
+  RpaCacheEntry& entry = rpa_cache[random_bda.address[2] ^
+                                   random_bda.address[5]];
+  if (entry.generation != irk_table.generation || entry.rpa != random_bda) {
+    entry.rpa = random_bda;
+    entry.generation = irk_table.generation;
+    entry.index = find_resolving_irk(random_bda);
+  }
 
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
-                                (void*)&random_bda);
   tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
-  if (n != nullptr) p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (entry.index >= 0) {
+    p_dev_rec = irk_table.records[entry.index];
+    if (!(p_dev_rec->ble.key_type & BTM_LE_KEY_PID) ||
+        p_dev_rec->ble.keys.irk != irk_table.irks[entry.index]) {
+      /* the key changed without the table being invalidated */
+      BTM_TRACE_WARNING("%s: stale IRK table", __func__);
+      btm_ble_irk_table_invalidate();
+      p_dev_rec = btm_ble_resolve_random_addr_by_scan(random_bda);
+    } else if (!(p_dev_rec->device_type & BT_DEVICE_TYPE_BLE)) {
+      /* a later record may still match, keep the list order semantics */
+      p_dev_rec = btm_ble_resolve_random_addr_by_scan(random_bda);
+    }
+  }
 
   BTM_TRACE_EVENT("%s:  %sresolved", __func__,
                   (p_dev_rec == nullptr ? "not " : ""));
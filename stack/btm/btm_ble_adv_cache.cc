@@ -0,0 +1,132 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "btm_ble_adv_cache.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+AdvertisingCache::AdvertisingCache(size_t capacity, uint64_t max_age_ms)
+    : capacity_(capacity), max_age_ms_(max_age_ms) {
+  index_.reserve(capacity_);
+}
+
+uint64_t AdvertisingCache::Key(uint8_t addr_type, const RawAddress& addr) {
+  uint64_t key = addr_type;
+  for (uint8_t b : addr.address) key = (key << 8) | b;
+  return key;
+}
+
+const std::vector<uint8_t>& AdvertisingCache::Set(uint8_t addr_type,
+                                                  const RawAddress& addr,
+                                                  const uint8_t* data,
+                                                  size_t len, uint64_t now_ms) {
+  auto it = Lookup(Key(addr_type, addr), now_ms);
+  it->data.assign(data, data + len);
+  return it->data;
+}
+
+const std::vector<uint8_t>& AdvertisingCache::Append(uint8_t addr_type,
+                                                     const RawAddress& addr,
+                                                     const uint8_t* data,
+                                                     size_t len,
+                                                     uint64_t now_ms) {
+  auto it = Lookup(Key(addr_type, addr), now_ms);
+  it->data.insert(it->data.end(), data, data + len);
+  return it->data;
+}
+
+void AdvertisingCache::Clear(uint8_t addr_type, const RawAddress& addr) {
+  auto map_it = index_.find(Key(addr_type, addr));
+  if (map_it == index_.end()) return;
+
+  ItemList::iterator it = map_it->second;
+  index_.erase(map_it);
+  Release(it);
+}
+
+void AdvertisingCache::ClearAll() {
+  index_.clear();
+  while (!items_.empty()) Release(items_.begin());
+}
+
+AdvertisingCache::ItemList::iterator AdvertisingCache::Lookup(uint64_t key,
+                                                              uint64_t now_ms) {
+  auto map_it = index_.find(key);
+  if (map_it != index_.end()) {
+    ItemList::iterator it = map_it->second;
+    if (now_ms - it->updated_ms > max_age_ms_) {
+      // Whatever came before is too old to be completed by this packet
+      stats_.evicted_aged++;
+      stats_.misses++;
+      it->data.clear();
+    } else {
+      stats_.hits++;
+    }
+    it->updated_ms = now_ms;
+    items_.splice(items_.begin(), items_, it);
+    return it;
+  }
+
+  stats_.misses++;
+
+  // The least recently updated entries are at the back
+  while (!items_.empty() && now_ms - items_.back().updated_ms > max_age_ms_) {
+    stats_.evicted_aged++;
+    index_.erase(items_.back().key);
+    Release(std::prev(items_.end()));
+  }
+  if (items_.size() >= capacity_) {
+    stats_.evicted_full++;
+    index_.erase(items_.back().key);
+    Release(std::prev(items_.end()));
+  }
+
+  if (spare_.empty()) {
+    items_.emplace_front();
+  } else {
+    items_.splice(items_.begin(), spare_, spare_.begin());
+  }
+
+  ItemList::iterator it = items_.begin();
+  it->key = key;
+  it->updated_ms = now_ms;
+  it->data.clear();
+  index_.emplace(key, it);
+  if (items_.size() > stats_.high_water) stats_.high_water = items_.size();
+  return it;
+}
+
+void AdvertisingCache::Release(ItemList::iterator it) {
+  if (spare_.size() >= BTM_BLE_ADV_CACHE_SPARE_ENTRIES) {
+    items_.erase(it);
+    return;
+  }
+  it->data.clear();
+  spare_.splice(spare_.begin(), items_, it);
+}
+
+void AdvertisingCache::Dump(int fd) const {
+  dprintf(fd, "\nLE advertising reassembly cache:\n");
+  dprintf(fd, "  Entries: %zu (capacity %zu, high water %zu)\n", Size(),
+          capacity_, stats_.high_water);
+  dprintf(fd, "  Hits: %" PRIu64 "  Misses: %" PRIu64 "\n", stats_.hits,
+          stats_.misses);
+  dprintf(fd, "  Evicted when full: %" PRIu64 "  Evicted by age: %" PRIu64 "\n",
+          stats_.evicted_full, stats_.evicted_aged);
+}
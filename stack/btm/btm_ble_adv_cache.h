@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "types/raw_address.h"
+
+/* Maximum number of devices whose advertising data is being reassembled */
+#define BTM_BLE_ADV_CACHE_SIZE 256
+
+/* Partial advertising data older than this is dropped rather than completed */
+#define BTM_BLE_ADV_CACHE_MAX_AGE_MS 10000
+
+/* Number of released entries whose buffers are kept for reuse */
+#define BTM_BLE_ADV_CACHE_SPARE_ENTRIES 32
+
+/* Holds the advertising data of devices that are waiting for either a scan
+ * response, or chained packets on the secondary channel. Entries are found by
+ * hash of address and address type. When full, or when an entry has not been
+ * updated for |max_age_ms|, the least recently updated entry is evicted.
+ * Buffers of released entries are reused so that steady state scanning does not
+ * allocate. */
+class AdvertisingCache {
+ public:
+  struct Stats {
+    /* Set or Append found data already cached for the device */
+    uint64_t hits;
+    /* Set or Append started a new entry */
+    uint64_t misses;
+    /* Entries evicted to make room for another device */
+    uint64_t evicted_full;
+    /* Entries dropped because they were older than the maximum age */
+    uint64_t evicted_aged;
+    /* Largest number of entries held at once */
+    size_t high_water;
+  };
+
+  explicit AdvertisingCache(
+      size_t capacity = BTM_BLE_ADV_CACHE_SIZE,
+      uint64_t max_age_ms = BTM_BLE_ADV_CACHE_MAX_AGE_MS);
+
+  AdvertisingCache(const AdvertisingCache&) = delete;
+  AdvertisingCache& operator=(const AdvertisingCache&) = delete;
+
+  /* Set the data to |data|, |len| for device |addr_type, addr|. |now_ms| is the
+   * current time, in the time base used for every call. */
+  const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
+                                  const uint8_t* data, size_t len,
+                                  uint64_t now_ms);
+
+  /* Append |data|, |len| for device |addr_type, addr| */
+  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
+                                     const uint8_t* data, size_t len,
+                                     uint64_t now_ms);
+
+  /* Clear data for device |addr_type, addr| */
+  void Clear(uint8_t addr_type, const RawAddress& addr);
+
+  /* Clear data for every device */
+  void ClearAll();
+
+  size_t Size() const { return index_.size(); }
+
+  const Stats& GetStats() const { return stats_; }
+
+  void Dump(int fd) const;
+
+ private:
+  struct Item {
+    uint64_t key;
+    uint64_t updated_ms;
+    std::vector<uint8_t> data;
+  };
+
+  using ItemList = std::list<Item>;
+
+  static uint64_t Key(uint8_t addr_type, const RawAddress& addr);
+
+  /* Return the entry for |key|, moved to the front and ready to be written. A
+   * new or expired entry has empty data. */
+  ItemList::iterator Lookup(uint64_t key, uint64_t now_ms);
+  void Release(ItemList::iterator it);
+
+  const size_t capacity_;
+  const uint64_t max_age_ms_;
+  /* Most recently updated first */
+  ItemList items_;
+  /* Released entries, kept for their buffers */
+  ItemList spare_;
+  std::unordered_map<uint64_t, ItemList::iterator> index_;
+  Stats stats_ = {};
+};
@@ -26,6 +26,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unordered_map>
 
 #include "bt_common.h"
 #include "bt_types.h"
@@ -151,7 +152,58 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
   return true;
 }
 
+/* Indexes over btm_cb.sec_dev_rec used by btm_find_dev and
+ * btm_find_dev_by_handle. Record fields are updated directly all over the
+ * stack, so every entry is checked against the record before it is used and
+ * a miss falls back to scanning the list. Entries for a record are dropped
+ * before the record is freed, so they never point at freed memory. */
+namespace {
+
+struct RpaIndexEntry {
+  tBTM_SEC_DEV_REC* p_dev_rec;
+  Octet16 irk; /* IRK that resolved the address */
+};
+
+std::unordered_map<RawAddress, tBTM_SEC_DEV_REC*> address_index;
+std::unordered_map<uint16_t, tBTM_SEC_DEV_REC*> handle_index;
+std::unordered_map<RawAddress, RpaIndexEntry> rpa_index;
+
+/* Peers rotate their RPA, so resolved addresses are only kept until there are
+ * this many of them. */
+constexpr size_t kMaxRpaIndexSize = 2 * BTM_SEC_MAX_DEVICE_RECORDS;
+
+template <typename Map>
+void erase_record(Map& map, tBTM_SEC_DEV_REC* p_dev_rec) {
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->second == p_dev_rec)
+      it = map.erase(it);
+    else
+      ++it;
+  }
+}
+
+void erase_from_indexes(tBTM_SEC_DEV_REC* p_dev_rec) {
+  erase_record(address_index, p_dev_rec);
+  erase_record(handle_index, p_dev_rec);
+  for (auto it = rpa_index.begin(); it != rpa_index.end();) {
+    if (it->second.p_dev_rec == p_dev_rec)
+      it = rpa_index.erase(it);
+    else
+      ++it;
+  }
+}
+
+bool irk_resolves(const tBTM_SEC_DEV_REC* p_dev_rec, const Octet16& irk) {
+  return (p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
+         (p_dev_rec->ble.key_type & BTM_LE_KEY_PID) &&
+         p_dev_rec->ble.keys.irk == irk;
+}
+
+}  // namespace
+
 void wipe_secrets_and_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
+  erase_from_indexes(p_dev_rec);
+  btm_ble_irk_table_invalidate();
   p_dev_rec->link_key.fill(0);
   memset(&p_dev_rec->ble.keys, 0, sizeof(tBTM_SEC_BLE_KEYS));
   list_remove(btm_cb.sec_dev_rec, p_dev_rec);
@@ -337,10 +389,21 @@ bool is_handle_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
+  auto it = handle_index.find(handle);
+  if (it != handle_index.end()) {
+    tBTM_SEC_DEV_REC* p_dev_rec = it->second;
+    if (p_dev_rec->hci_handle == handle || p_dev_rec->ble_hci_handle == handle)
+      return p_dev_rec;
+    handle_index.erase(it);
+  }
+
   list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (!n) return NULL;
 
-  return NULL;
+  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  // Any record without a link has an invalid handle, keep scanning for those
+  if (handle != BTM_SEC_INVALID_HANDLE) handle_index[handle] = p_dev_rec;
+  return p_dev_rec;
 }
 
 bool is_address_equal(void* data, void* context) {
@@ -366,11 +429,37 @@ bool is_address_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
+  auto it = address_index.find(bd_addr);
+  if (it != address_index.end()) {
+    tBTM_SEC_DEV_REC* p_dev_rec = it->second;
+    if (p_dev_rec->bd_addr == bd_addr || p_dev_rec->ble.pseudo_addr == bd_addr)
+      return p_dev_rec;
+    address_index.erase(it);
+  }
+
+  auto rpa_it = rpa_index.find(bd_addr);
+  if (rpa_it != rpa_index.end()) {
+    tBTM_SEC_DEV_REC* p_dev_rec = rpa_it->second.p_dev_rec;
+    if (irk_resolves(p_dev_rec, rpa_it->second.irk)) {
+      // Same side effect as resolving the address in is_address_equal
+      btm_ble_init_pseudo_addr(p_dev_rec, bd_addr);
+      return p_dev_rec;
+    }
+    rpa_index.erase(rpa_it);
+  }
+
   list_node_t* n =
       list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (!n) return NULL;
 
-  return NULL;
+  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  if (p_dev_rec->bd_addr == bd_addr || p_dev_rec->ble.pseudo_addr == bd_addr) {
+    address_index[bd_addr] = p_dev_rec;
+  } else {
+    if (rpa_index.size() >= kMaxRpaIndexSize) rpa_index.clear();
+    rpa_index[bd_addr] = {p_dev_rec, p_dev_rec->ble.keys.irk};
+  }
+  return p_dev_rec;
 }
 
 /*******************************************************************************
@@ -401,6 +490,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
     if (p_dev_rec->bd_addr == p_target_rec->bd_addr) {
       memcpy(p_target_rec, p_dev_rec, sizeof(tBTM_SEC_DEV_REC));
       p_target_rec->ble = temp_rec.ble;
+      btm_ble_irk_table_invalidate();
       p_target_rec->ble_hci_handle = temp_rec.ble_hci_handle;
       p_target_rec->enc_key_size = temp_rec.enc_key_size;
       p_target_rec->conn_params = temp_rec.conn_params;
@@ -28,6 +28,7 @@
 #include "bte.h"
 #include "btif/include/btif_common.h"
 #include "common/message_loop_thread.h"
+#include "common/startup_trace.h"
 #include "osi/include/osi.h"
 #include "stack/btm/btm_int.h"
 #include "stack/include/btu.h"
@@ -39,6 +40,7 @@
 #include <base/threading/thread.h>
 
 using bluetooth::common::MessageLoopThread;
+using bluetooth::common::ScopedStartupTrace;
 
 /* Define BTU storage area */
 uint8_t btu_trace_level = HCI_INITIAL_TRACE_LEVEL;
@@ -110,6 +112,7 @@ bt_status_t do_in_main_thread_delayed(const base::Location& from_here,
 
 void btu_task_start_up(UNUSED_ATTR void* context) {
   LOG(INFO) << "Bluetooth chip preload is complete";
+  ScopedStartupTrace trace("stack", __func__);
 
   /* Initialize the mandatory core stack control blocks
      (BTU, BTM, L2CAP, and SDP)
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stack/crypto_toolbox/aes_multi_key.h"
+
+#include <algorithm>
+
+namespace crypto_toolbox {
+
+void AesMultiKey::SetKeys(const std::vector<Octet16>& keys) {
+  std::vector<uint8_t> keys_reversed(OCTET16_LEN * keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::reverse_copy(keys[i].begin(), keys[i].end(),
+                      &keys_reversed[OCTET16_LEN * i]);
+  }
+  engine_.SetKeys(keys_reversed.data(), keys.size());
+}
+
+void AesMultiKey::Encrypt(const Octet16& message, Octet16* out) const {
+  Octet16 message_reversed;
+  std::reverse_copy(message.begin(), message.end(), message_reversed.begin());
+  engine_.EncryptAll(message_reversed.data(), out[0].data());
+
+  for (size_t i = 0; i < engine_.Size(); i++) {
+    std::reverse(out[i].begin(), out[i].end());
+  }
+}
+
+}  // namespace crypto_toolbox
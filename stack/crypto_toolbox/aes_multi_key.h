@@ -0,0 +1,48 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "gd/crypto_toolbox/aes_engine.h"
+#include "stack/include/bt_types.h"
+
+namespace crypto_toolbox {
+
+/* Encrypts one block under each of a set of fixed keys, as needed to check a
+ * Resolvable Private Address against every known IRK. Key schedules are
+ * expanded once in SetKeys(), see bluetooth::crypto_toolbox::AesEngine. */
+class AesMultiKey {
+ public:
+  /* |allow_hardware| false forces the portable implementation, for tests */
+  explicit AesMultiKey(bool allow_hardware = true) : engine_(allow_hardware) {}
+
+  /* Replaces the key set. Keys are in the byte order used by aes_128(). */
+  void SetKeys(const std::vector<Octet16>& keys);
+
+  size_t Size() const { return engine_.Size(); }
+
+  /* Sets |out|[i] to aes_128(keys[i], |message|) for every key. |out| must
+   * hold Size() elements. */
+  void Encrypt(const Octet16& message, Octet16* out) const;
+
+ private:
+  bluetooth::crypto_toolbox::AesEngine engine_;
+};
+
+}  // namespace crypto_toolbox
@@ -283,6 +283,7 @@ uint16_t GATTS_AddService(tGATT_IF gatt_if, btgatt_db_element_t* service,
   elem.app_uuid = list.asgn_range.app_uuid128;
   elem.type = list.asgn_range.is_primary ? GATT_UUID_PRI_SERVICE
                                          : GATT_UUID_SEC_SERVICE;
+  gatt_sr_index_invalidate();
 
   if (elem.type == GATT_UUID_PRI_SERVICE) {
     Uuid* p_uuid = gatts_get_service_uuid(elem.p_db);
@@ -361,6 +362,7 @@ bool GATTS_DeleteService(tGATT_IF gatt_if, Uuid* p_svc_uuid,
     (*gatt_cb.cb_info.p_nv_save_callback)(false, &it->asgn_range);
 
   gatt_cb.hdl_list_info->erase(it);
+  gatt_sr_index_invalidate();
   return true;
 }
 
@@ -390,6 +392,7 @@ void GATTS_StopService(uint16_t service_handle) {
   }
 
   gatt_cb.srv_list_info->erase(it);
+  gatt_sr_index_invalidate();
   gatt_update_last_srv_info();
 }
 /*******************************************************************************
@@ -29,6 +29,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "btm_int.h"
 #include "gatt_int.h"
 #include "l2c_api.h"
@@ -239,8 +240,7 @@ static tGATT_STATUS read_attr_value(tGATT_ATTR& attr16, uint16_t offset,
  *
  * Description      Query attribute value by attribute type.
  *
- * Parameter        p_db: pointer to the attribute database.
- *                  p_rsp: Read By type response data.
+ * Parameter        p_rsp: Read By type response data.
  *                  s_handle: starting handle of the range we are looking for.
  *                  e_handle: ending handle of the range we are looking for.
  *                  type: Attribute type.
@@ -252,49 +252,48 @@ static tGATT_STATUS read_attr_value(tGATT_ATTR& attr16, uint16_t offset,
  *
  ******************************************************************************/
 tGATT_STATUS gatts_db_read_attr_value_by_type(
-    tGATT_TCB& tcb, tGATT_SVC_DB* p_db, uint8_t op_code, BT_HDR* p_rsp,
-    uint16_t s_handle, uint16_t e_handle, const Uuid& type, uint16_t* p_len,
+    tGATT_TCB& tcb, uint8_t op_code, BT_HDR* p_rsp, uint16_t s_handle,
+    uint16_t e_handle, const Uuid& type, uint16_t* p_len,
     tGATT_SEC_FLAG sec_flag, uint8_t key_size, uint32_t trans_id,
     uint16_t* p_cur_handle) {
   tGATT_STATUS status = GATT_NOT_FOUND;
   uint16_t len = 0;
   uint8_t* p = (uint8_t*)(p_rsp + 1) + p_rsp->len + L2CAP_MIN_OFFSET;
 
-  if (p_db) {
-    for (tGATT_ATTR& attr : p_db->attr_list) {
-      if (attr.handle >= s_handle && type == attr.uuid) {
-        if (*p_len <= 2) {
-          status = GATT_NO_RESOURCES;
-          break;
-        }
+  for (const tGATT_SR_INDEX_ENTRY& entry :
+       gatt_sr_index_range_by_type(type, s_handle, e_handle)) {
+    tGATT_ATTR& attr = *entry.p_attr;
+
+    if (*p_len <= 2) {
+      status = GATT_NO_RESOURCES;
+      break;
+    }
 
-        UINT16_TO_STREAM(p, attr.handle);
+    UINT16_TO_STREAM(p, attr.handle);
 
-        status = read_attr_value(attr, 0, &p, false, (uint16_t)(*p_len - 2),
-                                 &len, sec_flag, key_size);
+    status = read_attr_value(attr, 0, &p, false, (uint16_t)(*p_len - 2), &len,
+                             sec_flag, key_size);
 
-        if (status == GATT_PENDING) {
-          status = gatts_send_app_read_request(tcb, op_code, attr.handle, 0,
-                                               trans_id, attr.gatt_type);
+    if (status == GATT_PENDING) {
+      status = gatts_send_app_read_request(tcb, op_code, attr.handle, 0,
+                                           trans_id, attr.gatt_type);
 
-          /* one callback at a time */
-          break;
-        } else if (status == GATT_SUCCESS) {
-          if (p_rsp->offset == 0) p_rsp->offset = len + 2;
-
-          if (p_rsp->offset == len + 2) {
-            p_rsp->len += (len + 2);
-            *p_len -= (len + 2);
-          } else {
-            LOG(ERROR) << "format mismatch";
-            status = GATT_NO_RESOURCES;
-            break;
-          }
-        } else {
-          *p_cur_handle = attr.handle;
-          break;
-        }
+      /* one callback at a time */
+      break;
+    } else if (status == GATT_SUCCESS) {
+      if (p_rsp->offset == 0) p_rsp->offset = len + 2;
+
+      if (p_rsp->offset == len + 2) {
+        p_rsp->len += (len + 2);
+        *p_len -= (len + 2);
+      } else {
+        LOG(ERROR) << "format mismatch";
+        status = GATT_NO_RESOURCES;
+        break;
       }
+    } else {
+      *p_cur_handle = attr.handle;
+      break;
     }
   }
 
@@ -412,12 +411,15 @@ uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
 tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle) {
   if (!p_db) return nullptr;
 
-  for (auto& attr : p_db->attr_list) {
-    if (attr.handle == handle) return &attr;
-    if (attr.handle > handle) return nullptr;
-  }
+  /* attributes are allocated with increasing handles */
+  auto it = std::lower_bound(
+      p_db->attr_list.begin(), p_db->attr_list.end(), handle,
+      [](const tGATT_ATTR& attr, uint16_t handle) {
+        return attr.handle < handle;
+      });
+  if (it == p_db->attr_list.end() || it->handle != handle) return nullptr;
 
-  return nullptr;
+  return &*it;
 }
 
 /*******************************************************************************
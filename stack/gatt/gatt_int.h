@@ -557,10 +557,10 @@ extern uint16_t gatts_add_characteristic(tGATT_SVC_DB& db, tGATT_PERM perm,
 extern uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
                                      const bluetooth::Uuid& dscp_uuid);
 extern tGATT_STATUS gatts_db_read_attr_value_by_type(
-    tGATT_TCB& tcb, tGATT_SVC_DB* p_db, uint8_t op_code, BT_HDR* p_rsp,
-    uint16_t s_handle, uint16_t e_handle, const bluetooth::Uuid& type,
-    uint16_t* p_len, tGATT_SEC_FLAG sec_flag, uint8_t key_size,
-    uint32_t trans_id, uint16_t* p_cur_handle);
+    tGATT_TCB& tcb, uint8_t op_code, BT_HDR* p_rsp, uint16_t s_handle,
+    uint16_t e_handle, const bluetooth::Uuid& type, uint16_t* p_len,
+    tGATT_SEC_FLAG sec_flag, uint8_t key_size, uint32_t trans_id,
+    uint16_t* p_cur_handle);
 extern tGATT_STATUS gatts_read_attr_value_by_handle(
     tGATT_TCB& tcb, tGATT_SVC_DB* p_db, uint8_t op_code, uint16_t handle,
     uint16_t offset, uint8_t* p_value, uint16_t* p_len, uint16_t mtu,
@@ -574,4 +574,29 @@ extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB* p_db, bool is_long,
                                                uint8_t key_size);
 extern bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db);
 
+/* gatt_sr_index.cc */
+
+/* Attribute of a started service, as held in the server handle index */
+typedef struct {
+  uint16_t handle;
+  tGATT_SRV_LIST_ELEM* p_srv;
+  tGATT_ATTR* p_attr;
+} tGATT_SR_INDEX_ENTRY;
+
+/* Run of index entries in handle order, usable in range-based for loops */
+typedef struct {
+  const tGATT_SR_INDEX_ENTRY* first;
+  const tGATT_SR_INDEX_ENTRY* last;
+
+  const tGATT_SR_INDEX_ENTRY* begin() const { return first; }
+  const tGATT_SR_INDEX_ENTRY* end() const { return last; }
+  bool empty() const { return first == last; }
+} tGATT_SR_INDEX_SPAN;
+
+extern void gatt_sr_index_invalidate(void);
+extern const tGATT_SR_INDEX_ENTRY* gatt_sr_index_find(uint16_t handle);
+extern tGATT_SR_INDEX_SPAN gatt_sr_index_range(uint16_t s_hdl, uint16_t e_hdl);
+extern tGATT_SR_INDEX_SPAN gatt_sr_index_range_by_type(
+    const bluetooth::Uuid& type, uint16_t s_hdl, uint16_t e_hdl);
+
 #endif
@@ -140,6 +140,7 @@ void gatt_init(void) {
 
   gatt_cb.hdl_list_info = new std::list<tGATT_HDL_LIST_ELEM>();
   gatt_cb.srv_list_info = new std::list<tGATT_SRV_LIST_ELEM>();
+  gatt_sr_index_invalidate();
   gatt_profile_db_init();
 }
 
@@ -180,6 +181,7 @@ void gatt_free(void) {
   gatt_cb.hdl_list_info = nullptr;
   gatt_cb.srv_list_info->clear();
   gatt_cb.srv_list_info = nullptr;
+  gatt_sr_index_invalidate();
 }
 
 /*******************************************************************************
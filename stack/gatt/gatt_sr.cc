@@ -28,6 +28,7 @@
 
 #include <log/log.h>
 #include <string.h>
+#include <algorithm>
 
 #include "gatt_int.h"
 #include "l2c_api.h"
@@ -458,11 +459,11 @@ static tGATT_STATUS gatt_build_primary_service_rsp(
 
   uint8_t* p = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET;
 
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl < s_hdl || el.s_hdl > e_hdl ||
-        el.type != GATT_UUID_PRI_SERVICE) {
-      continue;
-    }
+  /* every service starts with its declaration */
+  for (const tGATT_SR_INDEX_ENTRY& entry : gatt_sr_index_range_by_type(
+           Uuid::From16Bit(GATT_UUID_PRI_SERVICE), s_hdl, e_hdl)) {
+    tGATT_SRV_LIST_ELEM& el = *entry.p_srv;
+    if (el.s_hdl != entry.handle || el.type != GATT_UUID_PRI_SERVICE) continue;
 
     Uuid* p_uuid = gatts_get_service_uuid(el.p_db);
     if (!p_uuid) continue;
@@ -517,52 +518,39 @@ static tGATT_STATUS gatt_build_primary_service_rsp(
  * Returns          true: if data filled sucessfully.
  *                  false: packet full, or format mismatch.
  */
-static tGATT_STATUS gatt_build_find_info_rsp(tGATT_SRV_LIST_ELEM& el,
-                                             BT_HDR* p_msg, uint16_t& len,
-                                             uint16_t s_hdl, uint16_t e_hdl) {
+static tGATT_STATUS gatt_build_find_info_rsp(const tGATT_ATTR& attr,
+                                             BT_HDR* p_msg, uint16_t& len) {
   uint8_t info_pair_len[2] = {4, 18};
 
-  if (!el.p_db) return GATT_NOT_FOUND;
-
-  /* check the attribute database */
-
   uint8_t* p = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET + p_msg->len;
 
-  for (auto& attr : el.p_db->attr_list) {
-    if (attr.handle > e_hdl) break;
-
-    if (attr.handle < s_hdl) continue;
-
-    uint8_t uuid_len = attr.uuid.GetShortestRepresentationSize();
-    if (p_msg->offset == 0)
-      p_msg->offset = (uuid_len == Uuid::kNumBytes16) ? GATT_INFO_TYPE_PAIR_16
-                                                      : GATT_INFO_TYPE_PAIR_128;
-
-    if (len < info_pair_len[p_msg->offset - 1]) return GATT_NO_RESOURCES;
-
-    if (p_msg->offset == GATT_INFO_TYPE_PAIR_16 &&
-        uuid_len == Uuid::kNumBytes16) {
-      UINT16_TO_STREAM(p, attr.handle);
-      UINT16_TO_STREAM(p, attr.uuid.As16Bit());
-    } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
-               uuid_len == Uuid::kNumBytes128) {
-      UINT16_TO_STREAM(p, attr.handle);
-      ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
-    } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
-               uuid_len == Uuid::kNumBytes32) {
-      UINT16_TO_STREAM(p, attr.handle);
-      ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
-    } else {
-      LOG(ERROR) << "format mismatch";
-      return GATT_NO_RESOURCES;
-      /* format mismatch */
-    }
-    p_msg->len += info_pair_len[p_msg->offset - 1];
-    len -= info_pair_len[p_msg->offset - 1];
-    return GATT_SUCCESS;
+  uint8_t uuid_len = attr.uuid.GetShortestRepresentationSize();
+  if (p_msg->offset == 0)
+    p_msg->offset = (uuid_len == Uuid::kNumBytes16) ? GATT_INFO_TYPE_PAIR_16
+                                                    : GATT_INFO_TYPE_PAIR_128;
+
+  if (len < info_pair_len[p_msg->offset - 1]) return GATT_NO_RESOURCES;
+
+  if (p_msg->offset == GATT_INFO_TYPE_PAIR_16 &&
+      uuid_len == Uuid::kNumBytes16) {
+    UINT16_TO_STREAM(p, attr.handle);
+    UINT16_TO_STREAM(p, attr.uuid.As16Bit());
+  } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
+             uuid_len == Uuid::kNumBytes128) {
+    UINT16_TO_STREAM(p, attr.handle);
+    ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
+  } else if (p_msg->offset == GATT_INFO_TYPE_PAIR_128 &&
+             uuid_len == Uuid::kNumBytes32) {
+    UINT16_TO_STREAM(p, attr.handle);
+    ARRAY_TO_STREAM(p, attr.uuid.To128BitLE(), (int)Uuid::kNumBytes128);
+  } else {
+    LOG(ERROR) << "format mismatch";
+    return GATT_NO_RESOURCES;
+    /* format mismatch */
   }
-
-  return GATT_NOT_FOUND;
+  p_msg->len += info_pair_len[p_msg->offset - 1];
+  len -= info_pair_len[p_msg->offset - 1];
+  return GATT_SUCCESS;
 }
 
 static tGATT_STATUS read_handles(uint16_t& len, uint8_t*& p, uint16_t& s_hdl,
@@ -694,14 +682,21 @@ static void gatts_process_find_info(tGATT_TCB& tcb, uint8_t op_code,
 
   buf_len = tcb.payload_size - 2;
 
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      reason = gatt_build_find_info_rsp(el, p_msg, buf_len, s_hdl, e_hdl);
-      if (reason == GATT_NO_RESOURCES) {
-        reason = GATT_SUCCESS;
-        break;
-      }
+  /* the first attribute in range of each service is reported */
+  tGATT_SR_INDEX_SPAN span = gatt_sr_index_range(s_hdl, e_hdl);
+  const tGATT_SR_INDEX_ENTRY* entry = span.begin();
+  while (entry != span.end()) {
+    reason = gatt_build_find_info_rsp(*entry->p_attr, p_msg, buf_len);
+    if (reason == GATT_NO_RESOURCES) {
+      reason = GATT_SUCCESS;
+      break;
     }
+
+    uint16_t srv_e_hdl = entry->p_srv->e_hdl;
+    entry = std::upper_bound(entry, span.end(), srv_e_hdl,
+                             [](uint16_t handle, const tGATT_SR_INDEX_ENTRY& e) {
+                               return handle < e.handle;
+                             });
   }
 
   *p = (uint8_t)p_msg->offset;
@@ -821,25 +816,16 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint8_t op_code,
   p_msg->len = 2;
   uint16_t buf_len = tcb.payload_size - 2;
 
-  reason = GATT_NOT_FOUND;
-  for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
-    if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      uint8_t sec_flag, key_size;
-      gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
-
-      tGATT_STATUS ret = gatts_db_read_attr_value_by_type(
-          tcb, el.p_db, op_code, p_msg, s_hdl, e_hdl, uuid, &buf_len, sec_flag,
-          key_size, 0, &err_hdl);
-      if (ret != GATT_NOT_FOUND) {
-        reason = ret;
-        if (ret == GATT_NO_RESOURCES) reason = GATT_SUCCESS;
-      }
+  uint8_t sec_flag, key_size;
+  gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
 
-      if (ret != GATT_SUCCESS && ret != GATT_NOT_FOUND) {
-        s_hdl = err_hdl;
-        break;
-      }
-    }
+  reason = gatts_db_read_attr_value_by_type(tcb, op_code, p_msg, s_hdl, e_hdl,
+                                            uuid, &buf_len, sec_flag, key_size,
+                                            0, &err_hdl);
+  if (reason == GATT_NO_RESOURCES) {
+    reason = GATT_SUCCESS;
+  } else if (reason != GATT_SUCCESS && reason != GATT_NOT_FOUND) {
+    s_hdl = err_hdl;
   }
   *p = (uint8_t)p_msg->offset;
   p_msg->offset = L2CAP_MIN_OFFSET;
@@ -1034,34 +1020,27 @@ void gatts_process_attribute_req(tGATT_TCB& tcb, uint8_t op_code, uint16_t len,
   }
 #endif
 
-  if (GATT_HANDLE_IS_VALID(handle)) {
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        for (const auto& attr : el.p_db->attr_list) {
-          if (attr.handle == handle) {
-            switch (op_code) {
-              case GATT_REQ_READ: /* read char/char descriptor value */
-              case GATT_REQ_READ_BLOB:
-                gatts_process_read_req(tcb, el, op_code, handle, len, p);
-                break;
-
-              case GATT_REQ_WRITE: /* write char/char descriptor value */
-              case GATT_CMD_WRITE:
-              case GATT_SIGN_CMD_WRITE:
-              case GATT_REQ_PREPARE_WRITE:
-                gatts_process_write_req(tcb, el, handle, op_code, len, p,
-                                        attr.gatt_type);
-                break;
-              default:
-                break;
-            }
-            status = GATT_SUCCESS;
-            break;
-          }
-        }
+  const tGATT_SR_INDEX_ENTRY* entry =
+      GATT_HANDLE_IS_VALID(handle) ? gatt_sr_index_find(handle) : nullptr;
+  if (entry != nullptr) {
+    tGATT_SRV_LIST_ELEM& el = *entry->p_srv;
+    switch (op_code) {
+      case GATT_REQ_READ: /* read char/char descriptor value */
+      case GATT_REQ_READ_BLOB:
+        gatts_process_read_req(tcb, el, op_code, handle, len, p);
+        break;
+
+      case GATT_REQ_WRITE: /* write char/char descriptor value */
+      case GATT_CMD_WRITE:
+      case GATT_SIGN_CMD_WRITE:
+      case GATT_REQ_PREPARE_WRITE:
+        gatts_process_write_req(tcb, el, handle, op_code, len, p,
+                                entry->p_attr->gatt_type);
+        break;
+      default:
         break;
-      }
     }
+    status = GATT_SUCCESS;
   }
 
   if (status != GATT_SUCCESS && op_code != GATT_CMD_WRITE &&
@@ -1168,13 +1147,12 @@ void gatts_process_value_conf(tGATT_TCB& tcb, uint8_t op_code) {
   if (continue_processing) {
     tGATTS_DATA gatts_data;
     gatts_data.handle = handle;
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        uint32_t trans_id = gatt_sr_enqueue_cmd(tcb, op_code, handle);
-        uint16_t conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, el.gatt_if);
-        gatt_sr_send_req_callback(conn_id, trans_id, GATTS_REQ_TYPE_CONF,
-                                  &gatts_data);
-      }
+    auto it = gatt_sr_find_i_rcb_by_handle(handle);
+    if (it != gatt_cb.srv_list_info->end()) {
+      uint32_t trans_id = gatt_sr_enqueue_cmd(tcb, op_code, handle);
+      uint16_t conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, it->gatt_if);
+      gatt_sr_send_req_callback(conn_id, trans_id, GATTS_REQ_TYPE_CONF,
+                                &gatts_data);
     }
   }
 }
@@ -0,0 +1,216 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the handle index of the GATT server database. It covers
+ *  the attributes of every started service, sorted by handle, with a posting
+ *  list of the same attributes per attribute type. It is rebuilt on first use
+ *  after the set of started services changes.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "gatt_int.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+struct UuidHash {
+  size_t operator()(const Uuid& uuid) const {
+    const Uuid::UUID128Bit& bytes = uuid.To128BitBE();
+    uint64_t hi, lo;
+    memcpy(&hi, bytes.data(), sizeof(hi));
+    memcpy(&lo, bytes.data() + sizeof(hi), sizeof(lo));
+    return std::hash<uint64_t>()(hi ^ (lo * 0x9E3779B97F4A7C15ULL));
+  }
+};
+
+struct ServerIndex {
+  bool valid = false;
+  /* Started services, by start handle */
+  std::vector<std::list<tGATT_SRV_LIST_ELEM>::iterator> services;
+  /* Attributes of started services, by handle */
+  std::vector<tGATT_SR_INDEX_ENTRY> attrs;
+  /* Handles of |attrs|, searched on their own to stay within a few cache
+   * lines */
+  std::vector<uint16_t> handles;
+  /* The same attributes grouped by type, each group by handle */
+  std::unordered_map<Uuid, std::vector<tGATT_SR_INDEX_ENTRY>, UuidHash>
+      by_type;
+};
+
+ServerIndex server_index;
+
+struct HandleLess {
+  bool operator()(const tGATT_SR_INDEX_ENTRY& entry, uint16_t handle) const {
+    return entry.handle < handle;
+  }
+  bool operator()(uint16_t handle, const tGATT_SR_INDEX_ENTRY& entry) const {
+    return handle < entry.handle;
+  }
+};
+
+/* Position of the first of |handles| not less than |handle|. Written without
+ * branches on the comparison, which a binary search over requests for random
+ * handles mispredicts half of the time. */
+size_t lower_bound_handle(const std::vector<uint16_t>& handles,
+                          uint16_t handle) {
+  if (handles.empty()) return 0;
+
+  const uint16_t* base = handles.data();
+  size_t n = handles.size();
+  while (n > 1) {
+    size_t half = n / 2;
+    base = (base[half - 1] < handle) ? base + half : base;
+    n -= half;
+  }
+  return (base - handles.data()) + (*base < handle);
+}
+
+void build_server_index() {
+  server_index.services.clear();
+  server_index.attrs.clear();
+  server_index.handles.clear();
+  server_index.by_type.clear();
+  server_index.valid = true;
+
+  if (gatt_cb.srv_list_info == nullptr) return;
+
+  for (auto it = gatt_cb.srv_list_info->begin();
+       it != gatt_cb.srv_list_info->end(); it++) {
+    server_index.services.push_back(it);
+    if (it->p_db == nullptr) continue;
+    for (tGATT_ATTR& attr : it->p_db->attr_list) {
+      server_index.attrs.push_back({attr.handle, &*it, &attr});
+    }
+  }
+
+  std::stable_sort(
+      server_index.services.begin(), server_index.services.end(),
+      [](const std::list<tGATT_SRV_LIST_ELEM>::iterator& a,
+         const std::list<tGATT_SRV_LIST_ELEM>::iterator& b) {
+        return a->s_hdl < b->s_hdl;
+      });
+  std::stable_sort(
+      server_index.attrs.begin(), server_index.attrs.end(),
+      [](const tGATT_SR_INDEX_ENTRY& a, const tGATT_SR_INDEX_ENTRY& b) {
+        return a.handle < b.handle;
+      });
+
+  server_index.handles.reserve(server_index.attrs.size());
+  for (const tGATT_SR_INDEX_ENTRY& entry : server_index.attrs) {
+    server_index.handles.push_back(entry.handle);
+    server_index.by_type[entry.p_attr->uuid].push_back(entry);
+  }
+}
+
+const ServerIndex& get_server_index() {
+  if (!server_index.valid) build_server_index();
+  return server_index;
+}
+
+tGATT_SR_INDEX_SPAN make_span(const std::vector<tGATT_SR_INDEX_ENTRY>& entries,
+                              uint16_t s_hdl, uint16_t e_hdl) {
+  const tGATT_SR_INDEX_ENTRY* begin = entries.data();
+  const tGATT_SR_INDEX_ENTRY* end = begin + entries.size();
+  if (s_hdl > e_hdl) return {end, end};
+
+  const tGATT_SR_INDEX_ENTRY* first =
+      std::lower_bound(begin, end, s_hdl, HandleLess());
+  const tGATT_SR_INDEX_ENTRY* last =
+      std::upper_bound(first, end, e_hdl, HandleLess());
+  return {first, last};
+}
+
+}  // namespace
+
+/** Must be called whenever a service is started or stopped, or the service
+ * databases are released */
+void gatt_sr_index_invalidate(void) {
+  server_index.valid = false;
+  server_index.services.clear();
+  server_index.attrs.clear();
+  server_index.handles.clear();
+  server_index.by_type.clear();
+}
+
+/** Returns the attribute of a started service with |handle|, or nullptr */
+const tGATT_SR_INDEX_ENTRY* gatt_sr_index_find(uint16_t handle) {
+  const ServerIndex& index = get_server_index();
+  size_t pos = lower_bound_handle(index.handles, handle);
+  if (pos == index.handles.size() || index.handles[pos] != handle)
+    return nullptr;
+  return &index.attrs[pos];
+}
+
+/** Returns the attributes of started services with handles in
+ * [|s_hdl|, |e_hdl|] */
+tGATT_SR_INDEX_SPAN gatt_sr_index_range(uint16_t s_hdl, uint16_t e_hdl) {
+  const ServerIndex& index = get_server_index();
+  const tGATT_SR_INDEX_ENTRY* end = index.attrs.data() + index.attrs.size();
+  if (s_hdl > e_hdl) return {end, end};
+
+  size_t first = lower_bound_handle(index.handles, s_hdl);
+  size_t last = e_hdl == UINT16_MAX ? index.handles.size()
+                                    : lower_bound_handle(index.handles,
+                                                         e_hdl + 1);
+  return {index.attrs.data() + first, index.attrs.data() + last};
+}
+
+/** Returns the attributes of type |type| of started services with handles in
+ * [|s_hdl|, |e_hdl|] */
+tGATT_SR_INDEX_SPAN gatt_sr_index_range_by_type(const Uuid& type,
+                                                uint16_t s_hdl,
+                                                uint16_t e_hdl) {
+  const ServerIndex& index = get_server_index();
+  auto it = index.by_type.find(type);
+  if (it == index.by_type.end()) return {nullptr, nullptr};
+  return make_span(it->second, s_hdl, e_hdl);
+}
+
+/*******************************************************************************
+ *
+ * Description      Search for a service that owns a specific handle.
+ *
+ * Returns          gatt_cb.srv_list_info->end() if not found. Otherwise the
+ *                  service.
+ *
+ ******************************************************************************/
+std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
+    uint16_t handle) {
+  const ServerIndex& index = get_server_index();
+
+  // Service ranges do not overlap, so only the last service starting at or
+  // before |handle| can hold it
+  auto it = std::upper_bound(
+      index.services.begin(), index.services.end(), handle,
+      [](uint16_t hdl, const std::list<tGATT_SRV_LIST_ELEM>::iterator& el) {
+        return hdl < el->s_hdl;
+      });
+  if (it != index.services.begin() && (*std::prev(it))->e_hdl >= handle) {
+    return *std::prev(it);
+  }
+
+  return gatt_cb.srv_list_info->end();
+}
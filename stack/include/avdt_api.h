@@ -448,6 +448,12 @@ typedef void(tAVDT_SINK_DATA_CBACK)(uint8_t handle, BT_HDR* p_pkt,
 typedef void(tAVDT_REPORT_CBACK)(uint8_t handle, AVDT_REPORT_TYPE type,
                                  tAVDT_REPORT_DATA* p_data);
 
+/* This is the transmit complete callback function.  It is executed when
+ * L2CAP has sent |num_sdu| media packets of the stream to the controller.
+ * This function is optional and only applicable for SRC endpoints.
+*/
+typedef void(tAVDT_TX_COMPLETE_CBACK)(uint8_t handle, uint16_t num_sdu);
+
 /**
  * AVDTP Stream Configuration.
  * The information is used when a stream is created.
@@ -469,6 +475,7 @@ class AvdtpStreamConfig {
         scb_index(0),
         p_sink_data_cback(nullptr),
         p_report_cback(nullptr),
+        p_tx_complete_cback(nullptr),
         mtu(0),
         flush_to(0),
         tsep(0),
@@ -481,6 +488,7 @@ class AvdtpStreamConfig {
     scb_index = 0;
     p_sink_data_cback = nullptr;
     p_report_cback = nullptr;
+    p_tx_complete_cback = nullptr;
     mtu = 0;
     flush_to = 0;
     tsep = 0;
@@ -493,6 +501,7 @@ class AvdtpStreamConfig {
   uint8_t scb_index;  // The index to the bta_av_cb.p_scb[] entry
   tAVDT_SINK_DATA_CBACK* p_sink_data_cback;  // Sink data callback function
   tAVDT_REPORT_CBACK* p_report_cback;        // Report callback function
+  tAVDT_TX_COMPLETE_CBACK* p_tx_complete_cback;  // Transmit complete callback
   uint16_t mtu;        // The L2CAP MTU of the transport channel
   uint16_t flush_to;   // The L2CAP flush timeout of the transport channel
   uint8_t tsep;        // SEP type
@@ -779,4 +779,7 @@ extern void BTM_BleSetPhy(const RawAddress& bd_addr, uint8_t tx_phys,
 
 extern void btm_ble_multi_adv_cleanup(void);
 
+/* Dump advertising reassembly cache statistics to |fd| */
+extern void btm_ble_adv_cache_debug_dump(int fd);
+
 #endif
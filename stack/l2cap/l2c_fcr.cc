@@ -50,7 +50,7 @@ static const char* SAR_types[] = {"Unsegmented", "Start", "End",
 static const char* SUP_types[] = {"RR", "REJ", "RNR", "SREJ"};
 
 /* Look-up table for the CRC calculation */
-static const unsigned short crctab[256] = {
+static constexpr uint16_t crctab[256] = {
     0x0000, 0xc0c1, 0xc181, 0x0140, 0xc301, 0x03c0, 0x0280, 0xc241, 0xc601,
     0x06c0, 0x0780, 0xc741, 0x0500, 0xc5c1, 0xc481, 0x0440, 0xcc01, 0x0cc0,
     0x0d80, 0xcd41, 0x0f00, 0xcfc1, 0xce81, 0x0e40, 0x0a00, 0xcac1, 0xcb81,
@@ -82,6 +82,26 @@ static const unsigned short crctab[256] = {
     0x4100, 0x81c1, 0x8081, 0x4040,
 };
 
+/* Slicing-by-8 tables derived from crctab: slice[k][b] is the CRC
+ * contribution of byte b followed by k zero bytes */
+struct tL2C_FCR_CRC_SLICES {
+  uint16_t slice[8][256];
+};
+
+static constexpr tL2C_FCR_CRC_SLICES l2c_fcr_make_crc_slices() {
+  tL2C_FCR_CRC_SLICES tables{};
+  for (int b = 0; b < 256; b++) tables.slice[0][b] = crctab[b];
+  for (int k = 1; k < 8; k++) {
+    for (int b = 0; b < 256; b++) {
+      uint16_t prev = tables.slice[k - 1][b];
+      tables.slice[k][b] = ((prev >> 8) & 0xff) ^ crctab[prev & 0xff];
+    }
+  }
+  return tables;
+}
+
+static constexpr tL2C_FCR_CRC_SLICES crc_slices = l2c_fcr_make_crc_slices();
+
 /*******************************************************************************
  *  Static local functions
 */
@@ -104,18 +124,28 @@ static void l2c_fcr_collect_ack_delay(tL2C_CCB* p_ccb, uint8_t num_bufs_acked);
  *
  * Function         l2c_fcr_updcrc
  *
- * Description      This function computes the CRC using the look-up table.
+ * Description      This function computes the CRC using the look-up tables.
  *
  * Returns          CRC
  *
  ******************************************************************************/
 static unsigned short l2c_fcr_updcrc(unsigned short icrc, unsigned char* icp,
                                      int icnt) {
+  const auto& t = crc_slices.slice;
   unsigned short crc = icrc;
   unsigned char* cp = icp;
   int cnt = icnt;
 
-  while (cnt--) {
+  /* Eight bytes per step; the result is identical to the byte-wise loop */
+  while (cnt >= 8) {
+    crc = t[7][(crc & 0xff) ^ cp[0]] ^ t[6][((crc >> 8) & 0xff) ^ cp[1]] ^
+          t[5][cp[2]] ^ t[4][cp[3]] ^ t[3][cp[4]] ^ t[2][cp[5]] ^
+          t[1][cp[6]] ^ t[0][cp[7]];
+    cp += 8;
+    cnt -= 8;
+  }
+
+  while (cnt-- > 0) {
     crc = ((crc >> 8) & 0xff) ^ crctab[(crc & 0xff) ^ *cp++];
   }
 
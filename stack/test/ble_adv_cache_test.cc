@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "btm/btm_ble_adv_cache.h"
+
+namespace {
+
+const uint8_t kAdvData[] = {0x02, 0x01, 0x06};
+const uint8_t kScanResp[] = {0x03, 0x09, 'h', 'i'};
+
+RawAddress make_address(uint8_t n) {
+  return RawAddress({0x11, 0x22, 0x33, 0x44, 0x55, n});
+}
+
+}  // namespace
+
+TEST(AdvertisingCacheTest, set_then_append) {
+  AdvertisingCache cache;
+  RawAddress addr = make_address(1);
+
+  cache.Set(0, addr, kAdvData, sizeof(kAdvData), 0);
+  const std::vector<uint8_t>& data =
+      cache.Append(0, addr, kScanResp, sizeof(kScanResp), 10);
+
+  std::vector<uint8_t> expected(kAdvData, kAdvData + sizeof(kAdvData));
+  expected.insert(expected.end(), kScanResp, kScanResp + sizeof(kScanResp));
+  EXPECT_EQ(expected, data);
+  EXPECT_EQ(1u, cache.GetStats().hits);
+  EXPECT_EQ(1u, cache.GetStats().misses);
+}
+
+TEST(AdvertisingCacheTest, set_replaces_partial_data) {
+  AdvertisingCache cache;
+  RawAddress addr = make_address(1);
+
+  cache.Set(0, addr, kAdvData, sizeof(kAdvData), 0);
+  const std::vector<uint8_t>& data =
+      cache.Set(0, addr, kScanResp, sizeof(kScanResp), 10);
+  EXPECT_EQ(std::vector<uint8_t>(kScanResp, kScanResp + sizeof(kScanResp)),
+            data);
+}
+
+TEST(AdvertisingCacheTest, address_type_is_part_of_key) {
+  AdvertisingCache cache;
+  RawAddress addr = make_address(1);
+
+  cache.Set(0, addr, kAdvData, sizeof(kAdvData), 0);
+  const std::vector<uint8_t>& data =
+      cache.Append(1, addr, kScanResp, sizeof(kScanResp), 0);
+  EXPECT_EQ(sizeof(kScanResp), data.size());
+  EXPECT_EQ(2u, cache.Size());
+}
+
+TEST(AdvertisingCacheTest, clear) {
+  AdvertisingCache cache;
+  RawAddress addr = make_address(1);
+
+  cache.Set(0, addr, kAdvData, sizeof(kAdvData), 0);
+  cache.Clear(0, addr);
+  EXPECT_EQ(0u, cache.Size());
+
+  const std::vector<uint8_t>& data =
+      cache.Append(0, addr, kScanResp, sizeof(kScanResp), 0);
+  EXPECT_EQ(sizeof(kScanResp), data.size());
+}
+
+TEST(AdvertisingCacheTest, evicts_least_recently_updated_when_full) {
+  AdvertisingCache cache(4, BTM_BLE_ADV_CACHE_MAX_AGE_MS);
+  for (uint8_t i = 0; i < 4; i++) {
+    cache.Set(0, make_address(i), kAdvData, sizeof(kAdvData), i);
+  }
+  // Device 0 is updated again, so device 1 is now the oldest
+  cache.Append(0, make_address(0), kScanResp, sizeof(kScanResp), 4);
+  cache.Set(0, make_address(4), kAdvData, sizeof(kAdvData), 5);
+
+  EXPECT_EQ(4u, cache.Size());
+  EXPECT_EQ(1u, cache.GetStats().evicted_full);
+
+  // Device 1 starts over, device 0 still has its data
+  EXPECT_EQ(sizeof(kScanResp),
+            cache.Append(0, make_address(1), kScanResp, sizeof(kScanResp), 6)
+                .size());
+  EXPECT_EQ(sizeof(kAdvData) + 2 * sizeof(kScanResp),
+            cache.Append(0, make_address(0), kScanResp, sizeof(kScanResp), 7)
+                .size());
+}
+
+TEST(AdvertisingCacheTest, drops_aged_entries) {
+  AdvertisingCache cache(8, 100);
+  cache.Set(0, make_address(0), kAdvData, sizeof(kAdvData), 0);
+  cache.Set(0, make_address(1), kAdvData, sizeof(kAdvData), 50);
+
+  // Partial data too old to complete
+  EXPECT_EQ(sizeof(kScanResp),
+            cache.Append(0, make_address(0), kScanResp, sizeof(kScanResp), 101)
+                .size());
+  EXPECT_EQ(1u, cache.GetStats().evicted_aged);
+
+  // A new device pushes out the entries that aged meanwhile
+  cache.Set(0, make_address(2), kAdvData, sizeof(kAdvData), 160);
+  EXPECT_EQ(2u, cache.GetStats().evicted_aged);
+  EXPECT_EQ(2u, cache.Size());
+}
+
+TEST(AdvertisingCacheTest, clear_all) {
+  AdvertisingCache cache;
+  for (uint8_t i = 0; i < 100; i++) {
+    cache.Set(0, make_address(i), kAdvData, sizeof(kAdvData), 0);
+  }
+  EXPECT_EQ(100u, cache.GetStats().high_water);
+  cache.ClearAll();
+  EXPECT_EQ(0u, cache.Size());
+  EXPECT_EQ(sizeof(kAdvData),
+            cache.Append(0, make_address(7), kAdvData, sizeof(kAdvData), 0)
+                .size());
+}
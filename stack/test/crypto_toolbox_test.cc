@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include "stack/crypto_toolbox/aes.h"
+#include "stack/crypto_toolbox/aes_multi_key.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
 #include <base/logging.h>
@@ -397,4 +398,52 @@ TEST(CryptoToolboxTest, bt_spec_example_d_12_test) {
   EXPECT_EQ(expected_ltk, ltk);
 }
 
+// AesMultiKey must agree with aes_128 for every key, whichever backend is in
+// use, including a last group that is not full
+TEST(CryptoToolboxTest, aes_multi_key_matches_aes_128) {
+  for (bool allow_hardware : {false, true}) {
+    for (size_t num_keys : {1, 4, 7, 33}) {
+      std::vector<Octet16> keys(num_keys);
+      for (size_t i = 0; i < num_keys; i++) {
+        for (size_t j = 0; j < OCTET16_LEN; j++) keys[i][j] = rand();
+      }
+      AesMultiKey multi_key(allow_hardware);
+      multi_key.SetKeys(keys);
+      ASSERT_EQ(num_keys, multi_key.Size());
+
+      for (int n = 0; n < 8; n++) {
+        Octet16 message;
+        for (size_t j = 0; j < OCTET16_LEN; j++) message[j] = rand();
+
+        std::vector<Octet16> out(num_keys);
+        multi_key.Encrypt(message, out.data());
+        for (size_t i = 0; i < num_keys; i++) {
+          EXPECT_EQ(aes_128(keys[i], message), out[i]);
+        }
+      }
+    }
+  }
+}
+
+// BT Spec 5.0 | Vol 3, Part H D.1, through AesMultiKey
+TEST(CryptoToolboxTest, aes_multi_key_bt_spec_test_d_1_test) {
+  Octet16 k{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+            0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+  Octet16 m{0};
+  Octet16 expected{0x7d, 0xf7, 0x6b, 0x0c, 0x1a, 0xb8, 0x99, 0xb3,
+                   0x3e, 0x42, 0xf0, 0x47, 0xb9, 0x1b, 0x54, 0x6f};
+
+  // aes_128 takes its arguments in little endian
+  std::reverse(std::begin(k), std::end(k));
+  std::reverse(std::begin(expected), std::end(expected));
+
+  for (bool allow_hardware : {false, true}) {
+    AesMultiKey multi_key(allow_hardware);
+    multi_key.SetKeys({k});
+    Octet16 out;
+    multi_key.Encrypt(m, &out);
+    EXPECT_EQ(expected, out);
+  }
+}
+
 }  // namespace crypto_toolbox
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <list>
+
+#include "stack/gatt/gatt_int.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+const Uuid kCharDeclaration = Uuid::From16Bit(GATT_UUID_CHAR_DECLARE);
+const Uuid kPrimaryService = Uuid::From16Bit(GATT_UUID_PRI_SERVICE);
+
+/**
+ * Test class for the GATT server handle index in stack/gatt/gatt_sr_index.cc
+ */
+class GattSrIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    saved_srv_list_info_ = gatt_cb.srv_list_info;
+    gatt_cb.srv_list_info = &srv_list_;
+    gatt_sr_index_invalidate();
+  }
+
+  void TearDown() override {
+    gatt_cb.srv_list_info = saved_srv_list_info_;
+    gatt_sr_index_invalidate();
+  }
+
+  /* Start a service at |s_hdl| with room for |num_handles|, holding a
+   * characteristic declaration and value for each of |num_chars| */
+  void StartService(uint16_t s_hdl, uint16_t num_handles, int num_chars) {
+    dbs_.emplace_back();
+    tGATT_SVC_DB& db = dbs_.back();
+    uint16_t handle = s_hdl;
+    db.attr_list.emplace_back();
+    db.attr_list.back().handle = handle++;
+    db.attr_list.back().uuid = kPrimaryService;
+    for (int i = 0; i < num_chars; i++) {
+      db.attr_list.emplace_back();
+      db.attr_list.back().handle = handle++;
+      db.attr_list.back().uuid = kCharDeclaration;
+      db.attr_list.emplace_back();
+      db.attr_list.back().handle = handle++;
+      db.attr_list.back().uuid = Uuid::From16Bit(0x2a00 + i);
+    }
+
+    auto it = srv_list_.begin();
+    while (it != srv_list_.end() && it->s_hdl < s_hdl) it++;
+    it = srv_list_.emplace(it);
+    it->s_hdl = s_hdl;
+    it->e_hdl = s_hdl + num_handles - 1;
+    it->p_db = &db;
+    it->type = GATT_UUID_PRI_SERVICE;
+    gatt_sr_index_invalidate();
+  }
+
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_;
+  std::list<tGATT_SVC_DB> dbs_;
+  std::list<tGATT_SRV_LIST_ELEM>* saved_srv_list_info_;
+};
+
+std::vector<uint16_t> handles_of(tGATT_SR_INDEX_SPAN span) {
+  std::vector<uint16_t> handles;
+  for (const tGATT_SR_INDEX_ENTRY& entry : span) {
+    EXPECT_EQ(entry.handle, entry.p_attr->handle);
+    handles.push_back(entry.handle);
+  }
+  return handles;
+}
+
+}  // namespace
+
+TEST_F(GattSrIndexTest, empty_server) {
+  EXPECT_EQ(nullptr, gatt_sr_index_find(1));
+  EXPECT_TRUE(gatt_sr_index_range(1, 0xffff).empty());
+  EXPECT_TRUE(gatt_sr_index_range_by_type(kCharDeclaration, 1, 0xffff).empty());
+  EXPECT_EQ(srv_list_.end(), gatt_sr_find_i_rcb_by_handle(1));
+}
+
+TEST_F(GattSrIndexTest, find_by_handle) {
+  StartService(20, 10, 2);
+  StartService(1, 5, 2);
+
+  const tGATT_SR_INDEX_ENTRY* entry = gatt_sr_index_find(22);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(22, entry->handle);
+  EXPECT_EQ(20, entry->p_srv->s_hdl);
+  EXPECT_EQ(Uuid::From16Bit(0x2a00), entry->p_attr->uuid);
+
+  EXPECT_EQ(nullptr, gatt_sr_index_find(0));
+  EXPECT_EQ(nullptr, gatt_sr_index_find(6));
+  EXPECT_EQ(nullptr, gatt_sr_index_find(25));
+  EXPECT_NE(nullptr, gatt_sr_index_find(5));
+}
+
+TEST_F(GattSrIndexTest, find_service_by_handle) {
+  StartService(1, 5, 2);
+  StartService(20, 10, 2);
+
+  // Handles reserved by a service without an attribute still belong to it
+  auto it = gatt_sr_find_i_rcb_by_handle(29);
+  ASSERT_NE(srv_list_.end(), it);
+  EXPECT_EQ(20, it->s_hdl);
+  EXPECT_EQ(1, gatt_sr_find_i_rcb_by_handle(1)->s_hdl);
+  EXPECT_EQ(srv_list_.end(), gatt_sr_find_i_rcb_by_handle(6));
+  EXPECT_EQ(srv_list_.end(), gatt_sr_find_i_rcb_by_handle(30));
+}
+
+TEST_F(GattSrIndexTest, range_spans_services) {
+  StartService(1, 5, 2);
+  StartService(20, 10, 2);
+
+  EXPECT_EQ(std::vector<uint16_t>({4, 5, 20, 21}),
+            handles_of(gatt_sr_index_range(4, 21)));
+  EXPECT_EQ(std::vector<uint16_t>({1, 2, 3, 4, 5, 20, 21, 22, 23, 24}),
+            handles_of(gatt_sr_index_range(0, 0xffff)));
+  EXPECT_TRUE(gatt_sr_index_range(6, 19).empty());
+  EXPECT_TRUE(gatt_sr_index_range(21, 20).empty());
+}
+
+TEST_F(GattSrIndexTest, range_by_type) {
+  StartService(1, 5, 2);
+  StartService(20, 10, 2);
+
+  EXPECT_EQ(std::vector<uint16_t>({4, 21, 23}),
+            handles_of(gatt_sr_index_range_by_type(kCharDeclaration, 3, 30)));
+  EXPECT_EQ(std::vector<uint16_t>({1, 20}),
+            handles_of(gatt_sr_index_range_by_type(kPrimaryService, 1, 20)));
+  EXPECT_TRUE(
+      gatt_sr_index_range_by_type(Uuid::From16Bit(0x2a05), 1, 0xffff).empty());
+}
+
+TEST_F(GattSrIndexTest, rebuilt_when_invalidated) {
+  StartService(1, 5, 2);
+  EXPECT_EQ(nullptr, gatt_sr_index_find(20));
+
+  StartService(20, 10, 2);
+  EXPECT_NE(nullptr, gatt_sr_index_find(20));
+
+  srv_list_.pop_back();
+  gatt_sr_index_invalidate();
+  EXPECT_EQ(nullptr, gatt_sr_index_find(20));
+  EXPECT_EQ(srv_list_.end(), gatt_sr_find_i_rcb_by_handle(20));
+}
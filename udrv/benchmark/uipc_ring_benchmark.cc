@@ -0,0 +1,191 @@
+/*
+ * Copyright 2020 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <errno.h>
+#include <math.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "uipc_ring.h"
+
+using ::benchmark::State;
+
+// 20 ms of 48 kHz 16-bit stereo, the largest A2DP source tick
+#define UIPC_BENCHMARK_TICK_BYTES 3840
+// What the audio HAL sizes its socket buffer to by default
+#define UIPC_BENCHMARK_BUFFER_SIZE (28 * 512)
+// The poll timeout the A2DP source reads the audio with
+#define UIPC_BENCHMARK_READ_TIMEOUT_MS 10
+#define UIPC_BENCHMARK_WRITE_TIMEOUT_MS 2000
+
+namespace {
+
+enum Transport { kSocket, kRing };
+
+uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+long context_switches() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+// The audio HAL side of the socket transport
+bool socket_write(int fd, const uint8_t* p, size_t len) {
+  while (len > 0) {
+    ssize_t sent = send(fd, p, len, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return false;
+    p += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+// The stack side of the socket transport, as UIPC_Read() does it
+uint32_t socket_read(int fd, uint8_t* p, uint32_t len) {
+  uint32_t n_read = 0;
+  while (n_read < len) {
+    struct pollfd pfd = {fd, POLLIN | POLLHUP, 0};
+    if (poll(&pfd, 1, UIPC_BENCHMARK_READ_TIMEOUT_MS) <= 0) break;
+    if (pfd.revents & (POLLHUP | POLLNVAL)) break;
+    ssize_t n = recv(fd, p + n_read, len - n_read, 0);
+    if (n <= 0) break;
+    n_read += n;
+  }
+  return n_read;
+}
+
+}  // namespace
+
+// Streams ticks of audio from a writer thread paced like the audio HAL, one
+// every state.range(1) milliseconds, to the benchmark thread over the UIPC
+// socket (state.range(0) == 0) or the shared memory ring (1). Reports the
+// mean, 99th percentile and standard deviation of the time from the start of
+// each write to the end of the matching read, and the context switches per
+// tick of both threads together.
+static void BM_UipcLoopback(State& state) {
+  Transport transport = static_cast<Transport>(state.range(0));
+  uint64_t period_ns = state.range(1) * 1000000;
+
+  int sockets[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0) {
+    state.SkipWithError("socketpair failed");
+    return;
+  }
+  int size = UIPC_BENCHMARK_BUFFER_SIZE;
+  setsockopt(sockets[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  setsockopt(sockets[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+  tUIPC_RING reader;
+  tUIPC_RING writer;
+  uipc_ring_init(&reader);
+  uipc_ring_init(&writer);
+  if (transport == kRing &&
+      (!uipc_ring_create(&reader, UIPC_BENCHMARK_BUFFER_SIZE) ||
+       !uipc_ring_send(sockets[1], &reader) ||
+       !uipc_ring_receive(sockets[0], &writer))) {
+    state.SkipWithError("Failed to set up the ring");
+    return;
+  }
+
+  std::atomic<bool> running(true);
+  std::thread hal([&]() {
+    std::vector<uint8_t> tick(UIPC_BENCHMARK_TICK_BYTES);
+    uint64_t next = now_ns();
+    while (running) {
+      struct timespec ts = {static_cast<time_t>(next / 1000000000),
+                            static_cast<long>(next % 1000000000)};
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+      next += period_ns;
+
+      uint64_t stamp = now_ns();
+      memcpy(tick.data(), &stamp, sizeof(stamp));
+      bool ok = transport == kRing
+                    ? uipc_ring_write(&writer, tick.data(), tick.size(),
+                                      UIPC_BENCHMARK_WRITE_TIMEOUT_MS) ==
+                          tick.size()
+                    : socket_write(sockets[0], tick.data(), tick.size());
+      if (!ok) break;
+    }
+  });
+
+  std::vector<uint8_t> tick(UIPC_BENCHMARK_TICK_BYTES);
+  std::vector<double> latencies_us;
+  long switches = context_switches();
+  for (auto _ : state) {
+    uint32_t n_read = 0;
+    while (n_read < tick.size()) {
+      n_read += transport == kRing
+                    ? uipc_ring_read(&reader, tick.data() + n_read,
+                                     tick.size() - n_read,
+                                     UIPC_BENCHMARK_READ_TIMEOUT_MS)
+                    : socket_read(sockets[1], tick.data() + n_read,
+                                  tick.size() - n_read);
+    }
+    uint64_t stamp;
+    memcpy(&stamp, tick.data(), sizeof(stamp));
+    latencies_us.push_back((now_ns() - stamp) / 1000.0);
+  }
+  switches = context_switches() - switches;
+
+  // Unblock the writer if it waits for space
+  running = false;
+  uipc_ring_shutdown(&reader);
+  shutdown(sockets[1], SHUT_RDWR);
+  hal.join();
+  uipc_ring_close(&writer);
+  uipc_ring_close(&reader);
+  close(sockets[0]);
+  close(sockets[1]);
+
+  double mean = 0;
+  for (double l : latencies_us) mean += l;
+  mean /= latencies_us.size();
+  double variance = 0;
+  for (double l : latencies_us) variance += (l - mean) * (l - mean);
+  variance /= latencies_us.size();
+  std::sort(latencies_us.begin(), latencies_us.end());
+
+  state.SetLabel(transport == kRing ? "ring" : "socket");
+  state.counters["latency_us"] = mean;
+  state.counters["p99_latency_us"] =
+      latencies_us[latencies_us.size() * 99 / 100];
+  state.counters["jitter_us"] = sqrt(variance);
+  state.counters["switches_per_tick"] =
+      static_cast<double>(switches) / latencies_us.size();
+}
+
+BENCHMARK(BM_UipcLoopback)
+    ->Args({kSocket, 2})
+    ->Args({kRing, 2})
+    ->Iterations(1000)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -18,8 +18,11 @@
 #ifndef UIPC_H
 #define UIPC_H
 
+#include <memory>
 #include <mutex>
 
+#include "uipc_ring.h"
+
 #define UIPC_CH_ID_AV_CTRL 0
 #define UIPC_CH_ID_AV_AUDIO 1
 #define UIPC_CH_NUM 2
@@ -63,6 +66,8 @@ typedef struct {
   int read_poll_tmo_ms;
   int task_evt_flags; /* event flags pending to be processed in read task */
   tUIPC_RCV_CBACK* cback;
+  /* set when the peer writes the data through shared memory */
+  std::shared_ptr<tUIPC_RING> ring;
 } tUIPC_CHAN;
 
 struct tUIPC_STATE {
@@ -127,6 +132,21 @@ bool UIPC_Send(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint16_t msg_evt,
 uint32_t UIPC_Read(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint16_t* p_msg_evt,
                    uint8_t* p_buf, uint32_t len);
 
+/**
+ * Move the data of a channel to a shared memory ring, and send the ring to
+ * the peer over another channel. The channel keeps using its socket when the
+ * ring cannot be created, in which case the peer is told so, or when the peer
+ * does not ack that it mapped the ring. The ring is dropped when the peer
+ * writes to the socket again.
+ *
+ * @param ch_id Channel ID of the data
+ * @param ring_size Bytes the peer may queue in the ring at most
+ * @param ctrl_ch_id Channel ID to send the ring over
+ * @return true if the ring is used, otherwise false
+ */
+bool UIPC_OpenRing(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint32_t ring_size,
+                   tUIPC_CH_ID ctrl_ch_id);
+
 /**
  * Control the UIPC parameter
  *
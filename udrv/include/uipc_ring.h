@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#ifndef UIPC_RING_H
+#define UIPC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Single producer, single consumer byte ring in shared memory, used to move
+ * the audio of a UIPC data channel between the audio HAL and the stack
+ * without going through a socket. The memory is a memfd, and each side
+ * signals the other through an eventfd only when the other side is waiting,
+ * so a steady stream costs no system call at all.
+ *
+ * The stack creates the ring and sends its file descriptors to the audio HAL
+ * over the control socket, and the audio HAL tells back whether it could map
+ * it; the audio HAL writes, the stack reads.
+ */
+
+#define UIPC_RING_FD_MEM 0   /* the shared memory */
+#define UIPC_RING_FD_DATA 1  /* signalled by the writer when data is added */
+#define UIPC_RING_FD_SPACE 2 /* signalled by the reader when space is freed */
+#define UIPC_RING_NUM_FDS 3
+
+/* Largest ring that can be requested */
+#define UIPC_RING_MAX_SIZE (1024 * 1024)
+
+struct tUIPC_RING_SHM;
+
+struct tUIPC_RING {
+  tUIPC_RING_SHM* shm;
+  uint8_t* data;
+  size_t map_size;
+  uint32_t capacity; /* power of two, the mask of the read/write positions */
+  uint32_t max_fill; /* bytes the writer may queue at most */
+  int fds[UIPC_RING_NUM_FDS];
+};
+
+/**
+ * Initialize a ring that is not open
+ *
+ * @param ring The ring
+ */
+void uipc_ring_init(tUIPC_RING* ring);
+
+/**
+ * Create a ring
+ *
+ * @param ring The ring, not open
+ * @param size Bytes the writer may queue at most
+ * @return true on success, otherwise false
+ */
+bool uipc_ring_create(tUIPC_RING* ring, uint32_t size);
+
+/**
+ * Wake up both sides of a ring and fail all their writes from now on. Reads
+ * still return the data already queued. Safe to call while the ring is used
+ * from another thread.
+ *
+ * @param ring The ring
+ */
+void uipc_ring_shutdown(tUIPC_RING* ring);
+
+/**
+ * Shut down a ring, unmap it and close its file descriptors
+ *
+ * @param ring The ring
+ */
+void uipc_ring_close(tUIPC_RING* ring);
+
+/**
+ * @param ring The ring
+ * @return true if the ring is open
+ */
+bool uipc_ring_is_open(const tUIPC_RING* ring);
+
+/**
+ * Write to a ring, waiting for the reader to free space if needed
+ *
+ * @param ring The ring
+ * @param p_buf Data to write
+ * @param len Bytes to write
+ * @param timeout_ms Time to wait for space at most
+ * @return number of bytes written
+ */
+uint32_t uipc_ring_write(tUIPC_RING* ring, const uint8_t* p_buf, uint32_t len,
+                         int timeout_ms);
+
+/**
+ * Read from a ring, waiting for the writer to add data if needed
+ *
+ * @param ring The ring
+ * @param p_buf Buffer for the data
+ * @param len Bytes to read
+ * @param timeout_ms Time to wait for data at most
+ * @return number of bytes read
+ */
+uint32_t uipc_ring_read(tUIPC_RING* ring, uint8_t* p_buf, uint32_t len,
+                        int timeout_ms);
+
+/**
+ * Drop all the data queued in a ring. Must be called by the reader.
+ *
+ * @param ring The ring
+ */
+void uipc_ring_flush(tUIPC_RING* ring);
+
+/**
+ * Send a ring over a Unix domain socket
+ *
+ * @param fd The socket
+ * @param ring The ring, or nullptr to tell the peer there is no ring
+ * @return true on success, otherwise false
+ */
+bool uipc_ring_send(int fd, const tUIPC_RING* ring);
+
+/**
+ * Receive a ring sent with uipc_ring_send() and map it. When the sender sent
+ * a ring, it is acked with uipc_ring_ack() whether or not it could be mapped.
+ *
+ * @param fd The socket
+ * @param ring The ring, not open
+ * @return true if a ring was received, otherwise false
+ */
+bool uipc_ring_receive(int fd, tUIPC_RING* ring);
+
+/**
+ * Tell the sender of a ring whether it is used
+ *
+ * @param fd The socket
+ * @param accepted true if the ring is mapped and written to
+ * @return true on success, otherwise false
+ */
+bool uipc_ring_ack(int fd, bool accepted);
+
+/**
+ * Wait for the receiver of a ring to ack it
+ *
+ * @param fd The socket the ring was sent over
+ * @param timeout_ms Time to wait for the ack at most
+ * @return true if the receiver uses the ring, false if it rejected the ring
+ * or did not ack it in time
+ */
+bool uipc_ring_wait_ack(int fd, int timeout_ms);
+
+#endif /* UIPC_RING_H */
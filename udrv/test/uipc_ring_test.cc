@@ -0,0 +1,172 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "uipc_ring.h"
+
+namespace {
+
+// Creates a ring on one side of a socket pair and receives it on the other
+// side, as the stack and the audio HAL do.
+class UipcRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    uipc_ring_init(&reader_);
+    uipc_ring_init(&writer_);
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets_));
+  }
+
+  void TearDown() override {
+    uipc_ring_close(&writer_);
+    uipc_ring_close(&reader_);
+    close(sockets_[0]);
+    close(sockets_[1]);
+  }
+
+  void OpenRing(uint32_t size) {
+    ASSERT_TRUE(uipc_ring_create(&reader_, size));
+    ASSERT_TRUE(uipc_ring_send(sockets_[0], &reader_));
+    ASSERT_TRUE(uipc_ring_receive(sockets_[1], &writer_));
+    ASSERT_TRUE(uipc_ring_wait_ack(sockets_[0], 0));
+  }
+
+  tUIPC_RING reader_;
+  tUIPC_RING writer_;
+  int sockets_[2];
+};
+
+std::vector<uint8_t> make_data(size_t size) {
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; i++) data[i] = i * 7 + (i >> 8);
+  return data;
+}
+
+}  // namespace
+
+TEST_F(UipcRingTest, no_ring_is_received_when_none_is_sent) {
+  ASSERT_TRUE(uipc_ring_send(sockets_[0], nullptr));
+  EXPECT_FALSE(uipc_ring_receive(sockets_[1], &writer_));
+  EXPECT_FALSE(uipc_ring_is_open(&writer_));
+  // There is nothing to ack
+  EXPECT_FALSE(uipc_ring_wait_ack(sockets_[0], 0));
+}
+
+TEST_F(UipcRingTest, ring_without_fds_is_rejected) {
+  uint32_t max_fill = 1000;
+  ASSERT_EQ((ssize_t)sizeof(max_fill),
+            send(sockets_[0], &max_fill, sizeof(max_fill), 0));
+  EXPECT_FALSE(uipc_ring_receive(sockets_[1], &writer_));
+  EXPECT_FALSE(uipc_ring_is_open(&writer_));
+  EXPECT_FALSE(uipc_ring_wait_ack(sockets_[0], 0));
+  // The rejection was taken off the socket
+  uint8_t byte;
+  EXPECT_EQ(-1, recv(sockets_[0], &byte, sizeof(byte), MSG_DONTWAIT));
+}
+
+TEST_F(UipcRingTest, invalid_sizes_are_rejected) {
+  EXPECT_FALSE(uipc_ring_create(&reader_, 0));
+  EXPECT_FALSE(uipc_ring_create(&reader_, UIPC_RING_MAX_SIZE + 1));
+  EXPECT_FALSE(uipc_ring_is_open(&reader_));
+}
+
+TEST_F(UipcRingTest, data_wraps_around) {
+  OpenRing(1000);
+  std::vector<uint8_t> data = make_data(1000 * 7);
+  std::vector<uint8_t> out(data.size());
+
+  // Chunks that do not divide the capacity, to cross its end in all places
+  size_t written = 0;
+  size_t read = 0;
+  while (read < data.size()) {
+    size_t n = std::min<size_t>(333, data.size() - written);
+    written += uipc_ring_write(&writer_, &data[written], n, 0);
+    read += uipc_ring_read(&reader_, &out[read], 311, 0);
+  }
+  EXPECT_EQ(data, out);
+}
+
+TEST_F(UipcRingTest, writer_stops_at_the_requested_size) {
+  OpenRing(1000);
+  std::vector<uint8_t> data = make_data(1500);
+  EXPECT_EQ(1000u, uipc_ring_write(&writer_, data.data(), data.size(), 0));
+  EXPECT_EQ(0u, uipc_ring_write(&writer_, data.data(), data.size(), 10));
+
+  std::vector<uint8_t> out(200);
+  EXPECT_EQ(200u, uipc_ring_read(&reader_, out.data(), out.size(), 0));
+  EXPECT_EQ(200u, uipc_ring_write(&writer_, data.data(), data.size(), 0));
+}
+
+TEST_F(UipcRingTest, read_returns_what_is_queued_after_the_timeout) {
+  OpenRing(1000);
+  std::vector<uint8_t> data = make_data(100);
+  std::vector<uint8_t> out(500);
+  EXPECT_EQ(100u, uipc_ring_write(&writer_, data.data(), data.size(), 0));
+  EXPECT_EQ(100u, uipc_ring_read(&reader_, out.data(), out.size(), 10));
+  EXPECT_EQ(0u, uipc_ring_read(&reader_, out.data(), out.size(), 0));
+}
+
+TEST_F(UipcRingTest, flush_drops_the_queued_data) {
+  OpenRing(1000);
+  std::vector<uint8_t> data = make_data(1000);
+  std::vector<uint8_t> out(1000);
+  EXPECT_EQ(1000u, uipc_ring_write(&writer_, data.data(), data.size(), 0));
+  uipc_ring_flush(&reader_);
+  EXPECT_EQ(0u, uipc_ring_read(&reader_, out.data(), out.size(), 0));
+  EXPECT_EQ(1000u, uipc_ring_write(&writer_, data.data(), data.size(), 0));
+}
+
+TEST_F(UipcRingTest, shutdown_wakes_up_a_blocked_writer) {
+  OpenRing(1000);
+  std::vector<uint8_t> data = make_data(2000);
+  std::thread reader([this]() {
+    usleep(20000);
+    uipc_ring_shutdown(&reader_);
+  });
+  // Would block for ten seconds without the shutdown
+  EXPECT_EQ(1000u, uipc_ring_write(&writer_, data.data(), data.size(), 10000));
+  reader.join();
+  EXPECT_EQ(0u, uipc_ring_write(&writer_, data.data(), data.size(), 0));
+
+  // What was queued can still be read
+  std::vector<uint8_t> out(2000);
+  EXPECT_EQ(1000u, uipc_ring_read(&reader_, out.data(), out.size(), 10000));
+}
+
+TEST_F(UipcRingTest, blocking_transfer_between_threads) {
+  OpenRing(4096);
+  std::vector<uint8_t> data = make_data(4096 * 64);
+  std::thread writer([this, &data]() {
+    for (size_t i = 0; i < data.size(); i += 1500) {
+      size_t n = std::min<size_t>(1500, data.size() - i);
+      ASSERT_EQ(n, uipc_ring_write(&writer_, &data[i], n, 5000));
+    }
+  });
+
+  std::vector<uint8_t> out(data.size());
+  for (size_t i = 0; i < out.size(); i += 1024) {
+    ASSERT_EQ(1024u, uipc_ring_read(&reader_, &out[i], 1024, 5000));
+  }
+  writer.join();
+  EXPECT_EQ(data, out);
+}
@@ -0,0 +1,208 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bt_common.h"
+#include "bt_utils.h"
+#include "osi/include/osi.h"
+#include "osi/include/socket_utils/sockets.h"
+#include "uipc.h"
+
+uint8_t btif_trace_level = BT_TRACE_LEVEL_WARNING;
+
+void LogMsg(uint32_t trace_set_mask, const char* fmt_str, ...) {}
+
+void raise_priority_a2dp(tHIGH_PRIORITY_TASK high_task) {}
+
+namespace {
+
+#if defined(OS_GENERIC)
+constexpr int kSocketNamespace = ANDROID_SOCKET_NAMESPACE_FILESYSTEM;
+#else   // !defined(OS_GENERIC)
+constexpr int kSocketNamespace = ANDROID_SOCKET_NAMESPACE_ABSTRACT;
+#endif  // defined(OS_GENERIC)
+
+tUIPC_STATE* test_uipc;
+std::atomic<int> ctrl_opened;
+std::atomic<int> data_opened;
+
+void ctrl_cback(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  if (event == UIPC_OPEN_EVT) ctrl_opened++;
+}
+
+void data_cback(tUIPC_CH_ID ch_id, tUIPC_EVENT event) {
+  if (event != UIPC_OPEN_EVT) return;
+  UIPC_Ioctl(*test_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_REG_REMOVE_ACTIVE_READSET,
+             NULL);
+  UIPC_Ioctl(*test_uipc, UIPC_CH_ID_AV_AUDIO, UIPC_SET_READ_POLL_TMO,
+             reinterpret_cast<void*>(10));
+  data_opened++;
+}
+
+std::vector<uint8_t> make_data(size_t size) {
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; i++) data[i] = i * 13 + (i >> 8);
+  return data;
+}
+
+// Opens an audio data channel and its control channel, and connects to both
+// as the audio HAL does. The channels are read as the A2DP source reads them.
+class UipcTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ctrl_opened = 0;
+    data_opened = 0;
+    ctrl_path_ = SocketName("ctrl");
+    data_path_ = SocketName("data");
+    uipc_ring_init(&ring_);
+
+    uipc_ = UIPC_Init();
+    test_uipc = uipc_.get();
+    ASSERT_TRUE(UIPC_Open(*uipc_, UIPC_CH_ID_AV_CTRL, ctrl_cback,
+                          ctrl_path_.c_str()));
+    ASSERT_TRUE(UIPC_Open(*uipc_, UIPC_CH_ID_AV_AUDIO, data_cback,
+                          data_path_.c_str()));
+    ctrl_fd_ = osi_socket_local_client(ctrl_path_.c_str(), kSocketNamespace,
+                                       SOCK_STREAM);
+    data_fd_ = osi_socket_local_client(data_path_.c_str(), kSocketNamespace,
+                                       SOCK_STREAM);
+    ASSERT_GE(ctrl_fd_, 0);
+    ASSERT_GE(data_fd_, 0);
+    for (int i = 0; i < 1000 && (ctrl_opened == 0 || data_opened == 0); i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(1, ctrl_opened);
+    ASSERT_EQ(1, data_opened);
+  }
+
+  void TearDown() override {
+    UIPC_Close(*uipc_, UIPC_CH_ID_ALL);
+    uipc_ring_close(&ring_);
+    if (ctrl_fd_ >= 0) close(ctrl_fd_);
+    if (data_fd_ >= 0) close(data_fd_);
+    unlink(ctrl_path_.c_str());
+    unlink(data_path_.c_str());
+  }
+
+  std::string SocketName(const char* channel) {
+    std::string name = "net_test_udrv_uipc_" + std::to_string(getpid()) + "_";
+#if defined(OS_GENERIC)
+    name = ::testing::TempDir() + name;
+#endif  // defined(OS_GENERIC)
+    return name + channel;
+  }
+
+  // Moves the data channel to a ring, with |peer| on the side of the audio
+  // HAL. Returns whether the stack uses the ring.
+  bool OpenRing(std::function<void()> peer) {
+    std::thread peer_thread(peer);
+    bool opened = UIPC_OpenRing(*uipc_, UIPC_CH_ID_AV_AUDIO, 4096,
+                                UIPC_CH_ID_AV_CTRL);
+    peer_thread.join();
+    return opened;
+  }
+
+  // Reads |size| bytes from the data channel, giving up after a second
+  std::vector<uint8_t> Read(size_t size) {
+    std::vector<uint8_t> data(size);
+    size_t n_read = 0;
+    for (int i = 0; i < 100 && n_read < size; i++) {
+      uint16_t event;
+      n_read += UIPC_Read(*uipc_, UIPC_CH_ID_AV_AUDIO, &event, &data[n_read],
+                          size - n_read);
+    }
+    data.resize(n_read);
+    return data;
+  }
+
+  std::unique_ptr<tUIPC_STATE> uipc_;
+  std::string ctrl_path_;
+  std::string data_path_;
+  int ctrl_fd_ = -1;
+  int data_fd_ = -1;
+  tUIPC_RING ring_;  // the side of the audio HAL
+};
+
+// Takes the ring message off the control socket without its fds, as when
+// the audio HAL is not allowed to receive them
+void receive_without_fds(int fd) {
+  uint32_t max_fill;
+  ssize_t n;
+  OSI_NO_INTR(n = recv(fd, &max_fill, sizeof(max_fill), 0));
+  ASSERT_EQ((ssize_t)sizeof(max_fill), n);
+  ASSERT_NE(0u, max_fill);
+}
+
+}  // namespace
+
+TEST_F(UipcTest, data_goes_through_the_ring_the_peer_mapped) {
+  ASSERT_TRUE(OpenRing([this] {
+    EXPECT_TRUE(uipc_ring_receive(ctrl_fd_, &ring_));
+  }));
+
+  std::vector<uint8_t> data = make_data(3000);
+  EXPECT_EQ(data.size(),
+            uipc_ring_write(&ring_, data.data(), data.size(), 100));
+  EXPECT_EQ(data, Read(data.size()));
+}
+
+TEST_F(UipcTest, data_arrives_when_the_peer_rejects_the_ring) {
+  ASSERT_FALSE(OpenRing([this] {
+    receive_without_fds(ctrl_fd_);
+    EXPECT_TRUE(uipc_ring_ack(ctrl_fd_, false));
+  }));
+
+  std::vector<uint8_t> data = make_data(3000);
+  ASSERT_EQ((ssize_t)data.size(),
+            send(data_fd_, data.data(), data.size(), MSG_NOSIGNAL));
+  EXPECT_EQ(data, Read(data.size()));
+}
+
+TEST_F(UipcTest, data_arrives_when_the_peer_does_not_ack_the_ring) {
+  ASSERT_FALSE(OpenRing([this] { receive_without_fds(ctrl_fd_); }));
+
+  std::vector<uint8_t> data = make_data(3000);
+  ASSERT_EQ((ssize_t)data.size(),
+            send(data_fd_, data.data(), data.size(), MSG_NOSIGNAL));
+  EXPECT_EQ(data, Read(data.size()));
+}
+
+TEST_F(UipcTest, data_written_to_the_socket_drops_the_ring) {
+  ASSERT_TRUE(OpenRing([this] {
+    EXPECT_TRUE(uipc_ring_receive(ctrl_fd_, &ring_));
+  }));
+
+  std::vector<uint8_t> data = make_data(3000);
+  ASSERT_EQ((ssize_t)data.size(),
+            send(data_fd_, data.data(), data.size(), MSG_NOSIGNAL));
+  EXPECT_EQ(data, Read(data.size()));
+
+  // The peer is told to stop writing to the ring
+  EXPECT_EQ(0u, uipc_ring_write(&ring_, data.data(), data.size(), 0));
+}
@@ -67,6 +67,9 @@
 
 #define UIPC_FLUSH_BUFFER_SIZE 1024
 
+/* the peer acks a ring right after receiving it */
+#define UIPC_RING_ACK_TIMEOUT_MS 500
+
 /*****************************************************************************
  *  Local type definitions
  *****************************************************************************/
@@ -79,6 +82,8 @@ typedef enum {
  *  Static functions
  *****************************************************************************/
 static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id);
+static inline void uipc_wakeup_locked(tUIPC_STATE& uipc);
+void uipc_close_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id);
 
 /*****************************************************************************
  *  Externs
@@ -189,7 +194,6 @@ static int uipc_main_init(tUIPC_STATE& uipc) {
   memset(&uipc.read_set, 0, sizeof(uipc.read_set));
   uipc.max_fd = 0;
   memset(&uipc.signal_fds, 0, sizeof(uipc.signal_fds));
-  memset(&uipc.ch, 0, sizeof(uipc.ch));
 
   /* setup interrupt socket pair */
   if (socketpair(AF_UNIX, SOCK_STREAM, 0, uipc.signal_fds) < 0) {
@@ -203,8 +207,10 @@ static int uipc_main_init(tUIPC_STATE& uipc) {
     tUIPC_CHAN* p = &uipc.ch[i];
     p->srvfd = UIPC_DISCONNECTED;
     p->fd = UIPC_DISCONNECTED;
+    p->read_poll_tmo_ms = 0;
     p->task_evt_flags = 0;
     p->cback = NULL;
+    p->ring.reset();
   }
 
   return 0;
@@ -236,6 +242,44 @@ static void uipc_check_task_flags_locked(tUIPC_STATE& uipc) {
   }
 }
 
+/* wake up the peer and stop using the ring of a channel; it is unmapped once
+ * the reads in progress are done with it */
+static void uipc_drop_ring_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
+  if (uipc.ch[ch_id].ring == nullptr) return;
+
+  BTIF_TRACE_EVENT("DROP RING (CH %d)", ch_id);
+  uipc_ring_shutdown(uipc.ch[ch_id].ring.get());
+  uipc.ch[ch_id].ring.reset();
+
+  /* the user reads the socket directly again */
+  if (uipc.ch[ch_id].fd != UIPC_DISCONNECTED) {
+    FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
+    uipc_wakeup_locked(uipc);
+  }
+}
+
+/* the data of a channel with a ring does not go through its socket, so the
+ * socket becomes readable when the peer hangs up, or when the peer went back
+ * to writing to the socket; its data is then read from the socket again */
+static void uipc_check_ring_hangup_locked(tUIPC_STATE& uipc,
+                                          tUIPC_CH_ID ch_id) {
+  char buf;
+  ssize_t n;
+
+  OSI_NO_INTR(n = recv(uipc.ch[ch_id].fd, &buf, sizeof(buf),
+                       MSG_PEEK | MSG_DONTWAIT));
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+  if (n > 0) {
+    BTIF_TRACE_WARNING("RING CH %d: peer writes to the socket", ch_id);
+    uipc_drop_ring_locked(uipc, ch_id);
+    return;
+  }
+
+  BTIF_TRACE_WARNING("RING CH %d detached remotely", ch_id);
+  FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
+  uipc_close_locked(uipc, ch_id);
+}
+
 static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
   if (ch_id >= UIPC_CH_NUM) return -1;
 
@@ -245,6 +289,9 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
   if (SAFE_FD_ISSET(uipc.ch[ch_id].srvfd, &uipc.read_set)) {
     BTIF_TRACE_EVENT("INCOMING CONNECTION ON CH %d", ch_id);
 
+    // A ring belongs to the connection it was set up on
+    uipc_drop_ring_locked(uipc, ch_id);
+
     // Close the previous connection
     if (uipc.ch[ch_id].fd != UIPC_DISCONNECTED) {
       BTIF_TRACE_EVENT("CLOSE CONNECTION (FD %d)", uipc.ch[ch_id].fd);
@@ -278,8 +325,11 @@ static int uipc_check_fd_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
   if (SAFE_FD_ISSET(uipc.ch[ch_id].fd, &uipc.read_set)) {
     // BTIF_TRACE_EVENT("INCOMING DATA ON CH %d", ch_id);
 
-    if (uipc.ch[ch_id].cback)
+    if (uipc.ch[ch_id].ring != nullptr) {
+      uipc_check_ring_hangup_locked(uipc, ch_id);
+    } else if (uipc.ch[ch_id].cback) {
       uipc.ch[ch_id].cback(ch_id, UIPC_RX_DATA_READY_EVT);
+    }
   }
   return 0;
 }
@@ -342,6 +392,11 @@ static void uipc_flush_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
     return;
   }
 
+  if (uipc.ch[ch_id].ring != nullptr) {
+    uipc_ring_flush(uipc.ch[ch_id].ring.get());
+    return;
+  }
+
   while (1) {
     int ret;
     OSI_NO_INTR(ret = poll(&pfd, 1, 1));
@@ -390,6 +445,8 @@ static int uipc_close_ch_locked(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id) {
 
   if (ch_id >= UIPC_CH_NUM) return -1;
 
+  uipc_drop_ring_locked(uipc, ch_id);
+
   if (uipc.ch[ch_id].srvfd != UIPC_DISCONNECTED) {
     BTIF_TRACE_EVENT("CLOSE SERVER (FD %d)", uipc.ch[ch_id].srvfd);
     close(uipc.ch[ch_id].srvfd);
@@ -626,6 +683,18 @@ uint32_t UIPC_Read(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
     return 0;
   }
 
+  /* the ring stays mapped until this read is done with it, even if the
+     channel gets closed meanwhile */
+  std::shared_ptr<tUIPC_RING> ring;
+  {
+    std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
+    ring = uipc.ch[ch_id].ring;
+  }
+  if (ring != nullptr) {
+    return uipc_ring_read(ring.get(), p_buf, len,
+                          uipc.ch[ch_id].read_poll_tmo_ms);
+  }
+
   int n_read = 0;
   int fd = uipc.ch[ch_id].fd;
   struct pollfd pfd;
@@ -687,6 +756,54 @@ uint32_t UIPC_Read(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id,
   return n_read;
 }
 
+/*******************************************************************************
+ *
+ * Function         UIPC_OpenRing
+ *
+ * Description      Called to move the data of a channel to a shared memory
+ *                  ring, sent to the peer over another channel.
+ *
+ * Returns          true if the ring is used, otherwise false.
+ *
+ ******************************************************************************/
+bool UIPC_OpenRing(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint32_t ring_size,
+                   tUIPC_CH_ID ctrl_ch_id) {
+  BTIF_TRACE_DEBUG("UIPC_OpenRing : ch_id %d, %d bytes", ch_id, ring_size);
+
+  if (ch_id >= UIPC_CH_NUM || ctrl_ch_id >= UIPC_CH_NUM) return false;
+
+  std::lock_guard<std::recursive_mutex> lock(uipc.mutex);
+
+  uipc_drop_ring_locked(uipc, ch_id);
+
+  std::shared_ptr<tUIPC_RING> ring(new tUIPC_RING, [](tUIPC_RING* ring) {
+    uipc_ring_close(ring);
+    delete ring;
+  });
+  uipc_ring_init(ring.get());
+  if (uipc.ch[ch_id].fd == UIPC_DISCONNECTED ||
+      !uipc_ring_create(ring.get(), ring_size)) {
+    ring.reset();
+  }
+
+  /* the peer is told when there is no ring, and keeps writing to the socket;
+   * it does as well when it cannot map the ring, or does not ack it */
+  if (!uipc_ring_send(uipc.ch[ctrl_ch_id].fd, ring.get()) || ring == nullptr ||
+      !uipc_ring_wait_ack(uipc.ch[ctrl_ch_id].fd, UIPC_RING_ACK_TIMEOUT_MS)) {
+    BTIF_TRACE_WARNING("UIPC_OpenRing : ch_id %d keeps its socket", ch_id);
+    return false;
+  }
+
+  uipc.ch[ch_id].ring = ring;
+
+  /* watch the socket for the peer hanging up, nothing else comes through it */
+  FD_SET(uipc.ch[ch_id].fd, &uipc.active_set);
+  uipc.max_fd = MAX(uipc.max_fd, uipc.ch[ch_id].fd);
+  uipc_wakeup_locked(uipc);
+
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         UIPC_Ioctl
@@ -715,8 +832,10 @@ extern bool UIPC_Ioctl(tUIPC_STATE& uipc, tUIPC_CH_ID ch_id, uint32_t request,
       break;
 
     case UIPC_REG_REMOVE_ACTIVE_READSET:
-      /* user will read data directly and not use select loop */
-      if (uipc.ch[ch_id].fd != UIPC_DISCONNECTED) {
+      /* user will read data directly and not use select loop; the socket of
+         a ring is still watched for the peer hanging up */
+      if (uipc.ch[ch_id].fd != UIPC_DISCONNECTED &&
+          uipc.ch[ch_id].ring == nullptr) {
         /* remove this channel from active set */
         FD_CLR(uipc.ch[ch_id].fd, &uipc.active_set);
 
@@ -0,0 +1,475 @@
+/******************************************************************************
+ *
+ *  Copyright 2020 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*****************************************************************************
+ *
+ *  Filename:      uipc_ring.cc
+ *
+ *  Description:   Shared memory ring transport for the UIPC data channels
+ *
+ *****************************************************************************/
+
+#define LOG_TAG "bt_uipc_ring"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#ifndef MFD_CLOEXEC
+#include <linux/memfd.h>
+#endif
+#include <atomic>
+
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "uipc_ring.h"
+
+/*****************************************************************************
+ *  Constants & Macros
+ *****************************************************************************/
+
+#define UIPC_RING_MAGIC 0x52435055 /* "UPCR" */
+
+#define UIPC_RING_CACHE_LINE 64
+
+/* Sent back by the receiver of a ring */
+#define UIPC_RING_ACK_ACCEPTED 1
+#define UIPC_RING_ACK_REJECTED 0
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2,
+              "the ring positions are shared between processes");
+
+/*****************************************************************************
+ *  Local type definitions
+ *****************************************************************************/
+
+/* The start of the shared memory, followed by the data. The writer and the
+ * reader each own one cache line. */
+struct tUIPC_RING_SHM {
+  uint32_t magic;
+  uint32_t capacity;
+  uint32_t max_fill;
+  std::atomic<uint32_t> closed;
+
+  alignas(UIPC_RING_CACHE_LINE) std::atomic<uint32_t> write_pos;
+  std::atomic<uint32_t> reader_waiting;
+
+  alignas(UIPC_RING_CACHE_LINE) std::atomic<uint32_t> read_pos;
+  std::atomic<uint32_t> writer_waiting;
+};
+
+/*****************************************************************************
+ *   Helper functions
+ *****************************************************************************/
+
+static uint64_t uipc_ring_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint32_t uipc_ring_round_up(uint32_t size) {
+  uint32_t capacity = 1;
+  while (capacity < size) capacity <<= 1;
+  return capacity;
+}
+
+static bool uipc_ring_map(tUIPC_RING* ring, size_t map_size) {
+  void* p = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 ring->fds[UIPC_RING_FD_MEM], 0);
+  if (p == MAP_FAILED) {
+    LOG_ERROR(LOG_TAG, "%s: mmap failed (%s)", __func__, strerror(errno));
+    return false;
+  }
+  ring->shm = (tUIPC_RING_SHM*)p;
+  ring->data = (uint8_t*)p + sizeof(tUIPC_RING_SHM);
+  ring->map_size = map_size;
+  return true;
+}
+
+/* Tells the other side that |pos| moved, if it is waiting for that */
+static void uipc_ring_notify(std::atomic<uint32_t>& waiting, int fd) {
+  /* Pairs with the fence in uipc_ring_wait(): either the other side sees the
+   * new position, or we see that it is waiting */
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load(std::memory_order_relaxed) &&
+      waiting.exchange(0, std::memory_order_relaxed)) {
+    uint64_t one = 1;
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(fd, &one, sizeof(one)));
+  }
+}
+
+/* Waits for the other side to move |pos| away from |seen|, until |deadline|.
+ * Returns false once the deadline has passed. */
+static bool uipc_ring_wait(tUIPC_RING* ring, std::atomic<uint32_t>& waiting,
+                           const std::atomic<uint32_t>& pos, uint32_t seen,
+                           int fd, uint64_t deadline) {
+  uint64_t now = uipc_ring_now_ms();
+  if (now >= deadline) return false;
+
+  waiting.store(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (pos.load(std::memory_order_relaxed) == seen &&
+      !ring->shm->closed.load(std::memory_order_relaxed)) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    int ret;
+    OSI_NO_INTR(ret = poll(&pfd, 1, (int)(deadline - now)));
+    if (ret > 0) {
+      uint64_t count;
+      OSI_NO_INTR(ret = read(fd, &count, sizeof(count)));
+    }
+  }
+  waiting.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+/*****************************************************************************
+ *
+ *   uipc ring functions
+ *
+ ****************************************************************************/
+
+void uipc_ring_init(tUIPC_RING* ring) {
+  ring->shm = NULL;
+  ring->data = NULL;
+  ring->map_size = 0;
+  ring->capacity = 0;
+  ring->max_fill = 0;
+  for (int i = 0; i < UIPC_RING_NUM_FDS; i++) ring->fds[i] = -1;
+}
+
+bool uipc_ring_create(tUIPC_RING* ring, uint32_t size) {
+  if (size == 0 || size > UIPC_RING_MAX_SIZE) {
+    LOG_ERROR(LOG_TAG, "%s: invalid size %u", __func__, size);
+    return false;
+  }
+
+  uint32_t capacity = uipc_ring_round_up(size);
+  size_t map_size = sizeof(tUIPC_RING_SHM) + capacity;
+
+  ring->fds[UIPC_RING_FD_MEM] = syscall(__NR_memfd_create, "bt_uipc_ring",
+                                        MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  ring->fds[UIPC_RING_FD_DATA] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  ring->fds[UIPC_RING_FD_SPACE] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  for (int i = 0; i < UIPC_RING_NUM_FDS; i++) {
+    if (ring->fds[i] < 0) {
+      LOG_ERROR(LOG_TAG, "%s: failed to create fd %d (%s)", __func__, i,
+                strerror(errno));
+      uipc_ring_close(ring);
+      return false;
+    }
+  }
+
+  /* The peer must not be able to shrink the memory under our mapping */
+  if (ftruncate(ring->fds[UIPC_RING_FD_MEM], map_size) < 0 ||
+      fcntl(ring->fds[UIPC_RING_FD_MEM], F_ADD_SEALS,
+            F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+    LOG_ERROR(LOG_TAG, "%s: failed to size the ring (%s)", __func__,
+              strerror(errno));
+    uipc_ring_close(ring);
+    return false;
+  }
+
+  if (!uipc_ring_map(ring, map_size)) {
+    uipc_ring_close(ring);
+    return false;
+  }
+
+  /* The memfd is zero filled, so are the positions and flags */
+  ring->shm->magic = UIPC_RING_MAGIC;
+  ring->shm->capacity = capacity;
+  ring->shm->max_fill = size;
+  ring->capacity = capacity;
+  ring->max_fill = size;
+  return true;
+}
+
+void uipc_ring_shutdown(tUIPC_RING* ring) {
+  if (ring->shm == NULL) return;
+
+  ring->shm->closed.store(1, std::memory_order_relaxed);
+  uipc_ring_notify(ring->shm->reader_waiting, ring->fds[UIPC_RING_FD_DATA]);
+  uipc_ring_notify(ring->shm->writer_waiting, ring->fds[UIPC_RING_FD_SPACE]);
+}
+
+void uipc_ring_close(tUIPC_RING* ring) {
+  if (ring->shm != NULL) {
+    uipc_ring_shutdown(ring);
+    munmap(ring->shm, ring->map_size);
+  }
+  for (int i = 0; i < UIPC_RING_NUM_FDS; i++) {
+    if (ring->fds[i] >= 0) close(ring->fds[i]);
+  }
+  uipc_ring_init(ring);
+}
+
+bool uipc_ring_is_open(const tUIPC_RING* ring) { return ring->shm != NULL; }
+
+uint32_t uipc_ring_write(tUIPC_RING* ring, const uint8_t* p_buf, uint32_t len,
+                         int timeout_ms) {
+  tUIPC_RING_SHM* shm = ring->shm;
+  uint32_t mask = ring->capacity - 1;
+  uint64_t deadline = uipc_ring_now_ms() + timeout_ms;
+  uint32_t write_pos = shm->write_pos.load(std::memory_order_relaxed);
+  uint32_t n_written = 0;
+
+  while (n_written < len && !shm->closed.load(std::memory_order_relaxed)) {
+    uint32_t read_pos = shm->read_pos.load(std::memory_order_acquire);
+    uint32_t used = write_pos - read_pos;
+    if (used >= ring->max_fill) {
+      if (!uipc_ring_wait(ring, shm->writer_waiting, shm->read_pos, read_pos,
+                          ring->fds[UIPC_RING_FD_SPACE], deadline)) {
+        break;
+      }
+      continue;
+    }
+
+    uint32_t n = ring->max_fill - used;
+    if (n > len - n_written) n = len - n_written;
+    uint32_t offset = write_pos & mask;
+    uint32_t first = ring->capacity - offset;
+    if (first > n) first = n;
+    memcpy(ring->data + offset, p_buf + n_written, first);
+    memcpy(ring->data, p_buf + n_written + first, n - first);
+
+    write_pos += n;
+    n_written += n;
+    shm->write_pos.store(write_pos, std::memory_order_release);
+    uipc_ring_notify(shm->reader_waiting, ring->fds[UIPC_RING_FD_DATA]);
+  }
+
+  return n_written;
+}
+
+uint32_t uipc_ring_read(tUIPC_RING* ring, uint8_t* p_buf, uint32_t len,
+                        int timeout_ms) {
+  tUIPC_RING_SHM* shm = ring->shm;
+  uint32_t mask = ring->capacity - 1;
+  uint64_t deadline = uipc_ring_now_ms() + timeout_ms;
+  uint32_t read_pos = shm->read_pos.load(std::memory_order_relaxed);
+  uint32_t n_read = 0;
+
+  while (n_read < len) {
+    uint32_t write_pos = shm->write_pos.load(std::memory_order_acquire);
+    uint32_t used = write_pos - read_pos;
+    if (used > ring->capacity) {
+      /* The writer lives in another process, do not trust it */
+      LOG_ERROR(LOG_TAG, "%s: corrupted ring, %u bytes queued", __func__,
+                used);
+      uipc_ring_shutdown(ring);
+      break;
+    }
+    if (used == 0) {
+      if (shm->closed.load(std::memory_order_relaxed) ||
+          !uipc_ring_wait(ring, shm->reader_waiting, shm->write_pos,
+                          write_pos, ring->fds[UIPC_RING_FD_DATA], deadline)) {
+        break;
+      }
+      continue;
+    }
+
+    uint32_t n = used;
+    if (n > len - n_read) n = len - n_read;
+    uint32_t offset = read_pos & mask;
+    uint32_t first = ring->capacity - offset;
+    if (first > n) first = n;
+    memcpy(p_buf + n_read, ring->data + offset, first);
+    memcpy(p_buf + n_read + first, ring->data, n - first);
+
+    read_pos += n;
+    n_read += n;
+    shm->read_pos.store(read_pos, std::memory_order_release);
+    uipc_ring_notify(shm->writer_waiting, ring->fds[UIPC_RING_FD_SPACE]);
+  }
+
+  return n_read;
+}
+
+void uipc_ring_flush(tUIPC_RING* ring) {
+  tUIPC_RING_SHM* shm = ring->shm;
+  shm->read_pos.store(shm->write_pos.load(std::memory_order_acquire),
+                      std::memory_order_release);
+  uipc_ring_notify(shm->writer_waiting, ring->fds[UIPC_RING_FD_SPACE]);
+}
+
+bool uipc_ring_send(int fd, const tUIPC_RING* ring) {
+  /* A size of zero tells the peer there is no ring, and carries no fds */
+  uint32_t max_fill = ring != NULL ? ring->max_fill : 0;
+  struct iovec iov;
+  iov.iov_base = &max_fill;
+  iov.iov_len = sizeof(max_fill);
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int) * UIPC_RING_NUM_FDS)];
+  } control;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  if (ring != NULL) {
+    memset(&control, 0, sizeof(control));
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * UIPC_RING_NUM_FDS);
+    memcpy(CMSG_DATA(cmsg), ring->fds, sizeof(int) * UIPC_RING_NUM_FDS);
+  }
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = sendmsg(fd, &msg, MSG_NOSIGNAL));
+  if (ret != sizeof(max_fill)) {
+    LOG_ERROR(LOG_TAG, "%s: sendmsg failed (%s)", __func__, strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+/* Receives and maps a ring; |p_offered| is set if the sender announced one,
+ * whether or not it could be taken */
+static bool uipc_ring_receive_offer(int fd, tUIPC_RING* ring,
+                                    bool* p_offered) {
+  uint32_t max_fill = 0;
+  struct iovec iov;
+  iov.iov_base = &max_fill;
+  iov.iov_len = sizeof(max_fill);
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(int) * UIPC_RING_NUM_FDS)];
+  } control;
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  memset(&control, 0, sizeof(control));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  ssize_t ret;
+  OSI_NO_INTR(ret = recvmsg(fd, &msg, MSG_NOSIGNAL | MSG_CMSG_CLOEXEC));
+  if (ret < 0) {
+    LOG_ERROR(LOG_TAG, "%s: recvmsg failed (%s)", __func__, strerror(errno));
+    return false;
+  }
+  *p_offered = (ret == sizeof(max_fill) && max_fill != 0) ||
+               (msg.msg_flags & MSG_CTRUNC) || CMSG_FIRSTHDR(&msg) != NULL;
+
+  /* Take ownership of whatever fds came along, so none of them leaks */
+  uipc_ring_init(ring);
+  size_t num_fds = 0;
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg != NULL && cmsg->cmsg_level == SOL_SOCKET &&
+      cmsg->cmsg_type == SCM_RIGHTS) {
+    int fds[sizeof(control.buf) / sizeof(int)];
+    num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(int) * num_fds);
+    for (size_t i = 0; i < num_fds; i++) {
+      if (i < UIPC_RING_NUM_FDS) {
+        ring->fds[i] = fds[i];
+      } else {
+        close(fds[i]);
+      }
+    }
+  }
+
+  if (ret != sizeof(max_fill) || max_fill == 0 ||
+      num_fds != UIPC_RING_NUM_FDS || (msg.msg_flags & MSG_CTRUNC)) {
+    if (max_fill != 0) {
+      LOG_ERROR(LOG_TAG, "%s: malformed ring message", __func__);
+    }
+    uipc_ring_close(ring);
+    return false;
+  }
+
+  /* Map what the memfd holds, then check it against what was announced */
+  struct stat st;
+  if (fstat(ring->fds[UIPC_RING_FD_MEM], &st) < 0 ||
+      st.st_size <= (off_t)sizeof(tUIPC_RING_SHM) ||
+      st.st_size > (off_t)(sizeof(tUIPC_RING_SHM) + UIPC_RING_MAX_SIZE * 2) ||
+      !uipc_ring_map(ring, st.st_size)) {
+    LOG_ERROR(LOG_TAG, "%s: invalid ring memory", __func__);
+    uipc_ring_close(ring);
+    return false;
+  }
+
+  uint32_t capacity = ring->shm->capacity;
+  if (ring->shm->magic != UIPC_RING_MAGIC ||
+      ring->map_size != sizeof(tUIPC_RING_SHM) + capacity ||
+      (capacity & (capacity - 1)) != 0 || max_fill > capacity ||
+      ring->shm->max_fill != max_fill) {
+    LOG_ERROR(LOG_TAG, "%s: invalid ring header", __func__);
+    uipc_ring_close(ring);
+    return false;
+  }
+  ring->capacity = capacity;
+  ring->max_fill = max_fill;
+  return true;
+}
+
+bool uipc_ring_receive(int fd, tUIPC_RING* ring) {
+  bool offered = false;
+  bool received = uipc_ring_receive_offer(fd, ring, &offered);
+
+  /* The sender uses the ring only once it is told it is mapped here */
+  if (offered && !uipc_ring_ack(fd, received) && received) {
+    uipc_ring_close(ring);
+    received = false;
+  }
+  return received;
+}
+
+bool uipc_ring_ack(int fd, bool accepted) {
+  uint8_t ack = accepted ? UIPC_RING_ACK_ACCEPTED : UIPC_RING_ACK_REJECTED;
+  ssize_t ret;
+  OSI_NO_INTR(ret = send(fd, &ack, sizeof(ack), MSG_NOSIGNAL));
+  if (ret != sizeof(ack)) {
+    LOG_ERROR(LOG_TAG, "%s: send failed (%s)", __func__, strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+bool uipc_ring_wait_ack(int fd, int timeout_ms) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  int ret;
+  OSI_NO_INTR(ret = poll(&pfd, 1, timeout_ms));
+  if (ret <= 0) {
+    LOG_WARN(LOG_TAG, "%s: no ack from the peer", __func__);
+    return false;
+  }
+
+  uint8_t ack = UIPC_RING_ACK_REJECTED;
+  ssize_t n;
+  OSI_NO_INTR(n = recv(fd, &ack, sizeof(ack), MSG_DONTWAIT));
+  return n == sizeof(ack) && ack == UIPC_RING_ACK_ACCEPTED;
+}